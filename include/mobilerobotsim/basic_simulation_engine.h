@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include "mobilerobotsim/counter_rng.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/fleet_state.h"
+#include "mobilerobotsim/hash.h"
+#include "mobilerobotsim/mobile_robot_base.h"
+#include "mobilerobotsim/robot_state.h"
+#include "mobilerobotsim/simulation_observer.h"
+#include "mobilerobotsim/system_state.h"
+#include "mobilerobotsim/thread_pool.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Simulation engine over a robot type set fixed at compile time.
+ *
+ * BasicSimulationEngine<PointRobot, PointRobotF> keeps one contiguous
+ * std::vector per robot type instead of a vector of pointers to
+ * MobileRobotBase, and calls the robots' methods with qualified names, so
+ * stepping never goes through a vtable and the inline accessors (e.g.
+ * GetPosition()) are inlined into the update loop. Use it when a build knows
+ * all of its robot types; SimulationEngine remains the open-ended option for
+ * robot types that are only known at run time.
+ *
+ * Stepping follows SimulationEngine::Step(): robots are advanced in
+ * parallel, each drawing noise from the random stream selected by the seed
+ * and its robot id, and collision and merge point events are dispatched
+ * afterwards in robot order, types in the order of the template arguments.
+ * A fleet of a single type therefore evolves bit-identically to the same
+ * fleet in a SimulationEngine. The scheduling features of SimulationEngine
+ * (sleeping, rate groups, commands, AdvanceTo()) are not provided.
+ *
+ * Robot types that override UpdateState(double, const FleetView&) read
+ * their neighbours from a snapshot of the fleet taken at the start of each
+ * step, indexed in type order and then in the order robots were added.
+ * Whether a type overrides it is known at compile time, so a fleet of types
+ * that ignore their neighbours neither takes the snapshot nor pays for the
+ * virtual call. Each robot's handle is derived from its id, so robots can
+ * recognise themselves in the view.
+ *
+ * Robots are stored by value, so references and pointers to them are
+ * invalidated when robots of the same type are added or removed.
+ *
+ * @tparam Robots Distinct robot types derived from MobileRobotBase
+ */
+template <typename... Robots>
+class BasicSimulationEngine {
+  static_assert(sizeof...(Robots) > 0, "the engine needs at least one robot type");
+  static_assert((std::is_base_of_v<MobileRobotBase, Robots> && ...),
+                "robot types must derive from MobileRobotBase");
+
+ public:
+  /**
+   * @brief Default constructor.
+   *
+   * Creates an engine with no robots, an empty environment, and time set to zero.
+   */
+  BasicSimulationEngine() : BasicSimulationEngine(std::make_unique<Environment>()) {}
+
+  /**
+   * @brief Constructor with environment.
+   *
+   * @param environment The environment to use in the simulation
+   */
+  explicit BasicSimulationEngine(std::unique_ptr<Environment> environment)
+      : time_(0.0),
+        seed_(0),
+        nextRobotId_(0),
+        pool_(std::make_unique<ThreadPool>(1)),
+        environment_(std::move(environment)) {}
+
+  /**
+   * @brief Advances the simulation by the specified time step.
+   *
+   * Updates all robots and the environment, then notifies the observers.
+   * The system state passed to OnStep() is only built if an observer needs
+   * it (see SimulationObserver::NeedsStepState()).
+   *
+   * @param dt Time step size in seconds
+   */
+  void Step(double dt) {
+    if constexpr ((ReadsFleet<Robots>::value || ...)) {
+      CaptureFleet();
+    }
+    std::apply([&](auto&... stores) { (StepStore(stores, dt), ...); }, stores_);
+
+    // Dispatch events in type and robot order so that observers see the
+    // same sequence for any thread count
+    std::apply([&](auto&... stores) { (DispatchEvents(stores), ...); }, stores_);
+
+    environment_->Update(dt);
+    time_ += dt;
+
+    stepStateNeeded_.resize(observers_.size());
+    bool needsState = false;
+    for (size_t i = 0; i < observers_.size(); ++i) {
+      stepStateNeeded_[i] = observers_[i]->NeedsStepState();
+      needsState = needsState || stepStateNeeded_[i] != 0;
+    }
+    if (needsState) {
+      const auto state = GetState();
+      for (size_t i = 0; i < observers_.size() && i < stepStateNeeded_.size(); ++i) {
+        if (stepStateNeeded_[i] != 0) {
+          observers_[i]->OnStep(*state);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Adds a robot to the simulation.
+   *
+   * The robot is given a random stream derived from the seed and a robot id
+   * that is never reused, and a handle derived from the id.
+   *
+   * @tparam Robot One of the engine's robot types
+   * @param robot The robot to add
+   * @return The index of the robot among the robots of its type
+   */
+  template <typename Robot>
+  size_t AddRobot(Robot robot) {
+    Store<Robot>& store = GetStore<Robot>();
+    const uint64_t id = nextRobotId_++;
+    robot.Robot::SetRandomStream(CounterRng(seed_, id));
+    robot.SetHandle(RobotHandle{static_cast<uint32_t>(id), static_cast<uint32_t>(id >> 32)});
+    store.robots.push_back(std::move(robot));
+    store.contacts.push_back({id, nullptr, nullptr, nullptr, nullptr});
+    return store.robots.size() - 1;
+  }
+
+  /**
+   * @brief Removes a robot from the simulation.
+   *
+   * @tparam Robot The robot's type
+   * @param index The index of the robot among the robots of its type
+   * @return True if the robot was removed, false if the index is invalid
+   */
+  template <typename Robot>
+  bool RemoveRobot(size_t index) {
+    Store<Robot>& store = GetStore<Robot>();
+    if (index >= store.robots.size()) {
+      return false;
+    }
+
+    store.robots.erase(store.robots.begin() + index);
+    store.contacts.erase(store.contacts.begin() + index);
+    return true;
+  }
+
+  /**
+   * @brief Gets a robot.
+   *
+   * @tparam Robot The robot's type
+   * @param index The index of the robot among the robots of its type
+   * @return The robot
+   */
+  template <typename Robot>
+  Robot& GetRobot(size_t index) {
+    return GetStore<Robot>().robots[index];
+  }
+
+  /**
+   * @brief Gets a robot.
+   *
+   * @tparam Robot The robot's type
+   * @param index The index of the robot among the robots of its type
+   * @return The robot
+   */
+  template <typename Robot>
+  const Robot& GetRobot(size_t index) const {
+    return GetStore<Robot>().robots[index];
+  }
+
+  /**
+   * @brief Gets all robots of one type.
+   *
+   * @tparam Robot The robot type
+   * @return The robots, in the order they were added
+   */
+  template <typename Robot>
+  const std::vector<Robot>& GetRobots() const {
+    return GetStore<Robot>().robots;
+  }
+
+  /**
+   * @brief Gets the number of robots of one type.
+   *
+   * @tparam Robot The robot type
+   * @return The number of robots of that type
+   */
+  template <typename Robot>
+  size_t GetRobotCount() const {
+    return GetStore<Robot>().robots.size();
+  }
+
+  /**
+   * @brief Gets the number of robots in the simulation.
+   *
+   * @return The number of robots of all types
+   */
+  size_t GetRobotCount() const {
+    return std::apply([](const auto&... stores) { return (stores.robots.size() + ...); },
+                      stores_);
+  }
+
+  /**
+   * @brief Calls a visitor on every robot with its concrete type.
+   *
+   * Robots are visited in type order, then in the order they were added.
+   *
+   * @param visitor Generic callable taking a robot by reference
+   */
+  template <typename Visitor>
+  void ForEachRobot(Visitor&& visitor) {
+    std::apply(
+        [&](auto&... stores) {
+          (std::for_each(stores.robots.begin(), stores.robots.end(), visitor), ...);
+        },
+        stores_);
+  }
+
+  /**
+   * @brief Calls a visitor on every robot with its concrete type.
+   *
+   * @param visitor Generic callable taking a robot by const reference
+   */
+  template <typename Visitor>
+  void ForEachRobot(Visitor&& visitor) const {
+    std::apply(
+        [&](const auto&... stores) {
+          (std::for_each(stores.robots.begin(), stores.robots.end(), visitor), ...);
+        },
+        stores_);
+  }
+
+  /**
+   * @brief Sets the number of threads used to advance robots.
+   *
+   * The thread count does not affect the results.
+   *
+   * @param threadCount The number of threads, or zero for the number of hardware threads
+   */
+  void SetThreadCount(size_t threadCount) { pool_ = std::make_unique<ThreadPool>(threadCount); }
+
+  /**
+   * @brief Gets the number of threads used to advance robots.
+   *
+   * @return The thread count
+   */
+  size_t GetThreadCount() const { return pool_->GetThreadCount(); }
+
+  /**
+   * @brief Sets the simulation seed and re-seeds every robot's random stream.
+   *
+   * @param seed The seed
+   */
+  void SetSeed(uint64_t seed) {
+    seed_ = seed;
+    std::apply([&](auto&... stores) { (Reseed(stores), ...); }, stores_);
+  }
+
+  /**
+   * @brief Gets the simulation seed.
+   *
+   * @return The seed
+   */
+  uint64_t GetSeed() const { return seed_; }
+
+  /**
+   * @brief Computes a hash of the simulation state for regression baselines.
+   *
+   * Uses the same layout as SimulationEngine::ComputeStateHash(), so a fleet
+   * of a single type hashes the same in both engines.
+   *
+   * @return The 64-bit hash
+   */
+  uint64_t ComputeStateHash() const {
+    uint64_t hash = HashBytes(&time_, sizeof(time_));
+    std::apply([&](const auto&... stores) { ((hash = HashStore(stores, hash)), ...); }, stores_);
+
+    const auto environmentState = environment_->GetState();
+    std::string typeId, state;
+    for (size_t i = 0; i < environmentState->GetElementStateCount(); ++i) {
+      environmentState->GetElementState(i, typeId, state);
+      hash = HashString(typeId, hash);
+      hash = HashString(state, hash);
+    }
+
+    return hash;
+  }
+
+  /**
+   * @brief Sets the environment for the simulation.
+   *
+   * @param environment The environment to use
+   */
+  void SetEnvironment(std::unique_ptr<Environment> environment) {
+    environment_ = std::move(environment);
+    std::apply([](auto&... stores) { (ClearContacts(stores), ...); }, stores_);
+  }
+
+  /**
+   * @brief Gets the environment.
+   *
+   * @return The environment
+   */
+  Environment& GetEnvironment() { return *environment_; }
+
+  /**
+   * @brief Gets the current simulation time.
+   *
+   * @return The current simulation time in seconds
+   */
+  double GetTime() const { return time_; }
+
+  /**
+   * @brief Registers an observer for simulation events.
+   *
+   * @param observer The observer to register
+   */
+  void RegisterObserver(SimulationObserver* observer) { observers_.push_back(observer); }
+
+  /**
+   * @brief Unregisters an observer for simulation events.
+   *
+   * @param observer The observer to unregister
+   * @return True if the observer was successfully unregistered, false otherwise
+   */
+  bool UnregisterObserver(SimulationObserver* observer) {
+    const auto it = std::find(observers_.begin(), observers_.end(), observer);
+    if (it == observers_.end()) {
+      return false;
+    }
+
+    observers_.erase(it);
+    return true;
+  }
+
+  /**
+   * @brief Gets the current state of the simulation.
+   *
+   * Robot states are in type order, then in the order the robots were added.
+   *
+   * @return A unique pointer to a SystemState object
+   */
+  std::unique_ptr<SystemState> GetState() const {
+    auto state = std::make_unique<SystemState>(time_);
+    ForEachRobot([&](const auto& robot) {
+      using Robot = std::decay_t<decltype(robot)>;
+      state->AddRobotState(robot.Robot::GetState());
+    });
+    state->SetEnvironmentState(environment_->GetState());
+    return state;
+  }
+
+ private:
+  /**
+   * @brief Per-robot contact bookkeeping, parallel to the robots of a type.
+   */
+  struct Contacts {
+    uint64_t id;                                ///< Robot id, selects the random stream
+    const EnvironmentElement* collision;        ///< Element the robot is in contact with
+    const EnvironmentElement* mergePoint;       ///< Merge point the robot is inside
+    const EnvironmentElement* collisionEvent;   ///< First element contacted this step
+    const EnvironmentElement* mergePointEvent;  ///< First merge point entered this step
+  };
+
+  /**
+   * @brief The robots of one type and their contacts.
+   */
+  template <typename Robot>
+  struct Store {
+    std::vector<Robot> robots;      ///< Robots, stored contiguously by value
+    std::vector<Contacts> contacts;  ///< Contacts, by robot index
+  };
+
+  template <typename Robot>
+  Store<Robot>& GetStore() {
+    return std::get<Store<Robot>>(stores_);
+  }
+
+  template <typename Robot>
+  const Store<Robot>& GetStore() const {
+    return std::get<Store<Robot>>(stores_);
+  }
+
+  /// Deduces the class that declares the fleet-aware UpdateState() a robot type sees
+  template <typename Class>
+  static Class* FleetUpdateClass(void (Class::*)(double, const FleetView&));
+
+  /// Whether a robot type overrides the fleet-aware UpdateState(); false if
+  /// the overload is hidden by UpdateState(double) or is the base default
+  template <typename Robot, typename = void>
+  struct ReadsFleet : std::false_type {};
+
+  template <typename Robot>
+  struct ReadsFleet<Robot, std::enable_if_t<!std::is_same_v<
+                               decltype(FleetUpdateClass(&Robot::UpdateState)), MobileRobotBase*>>>
+      : std::true_type {};
+
+  /// Records every robot at the start of a step, types in template order
+  void CaptureFleet() {
+    fleet_.Resize(GetRobotCount());
+    size_t offset = 0;
+    std::apply([&](const auto&... stores) { (CaptureStore(stores, offset), ...); }, stores_);
+  }
+
+  /// Records the robots of one type from an offset into the fleet, advancing the offset
+  template <typename Robot>
+  void CaptureStore(const Store<Robot>& store, size_t& offset) {
+    const size_t first = offset;
+    pool_->ParallelFor(store.robots.size(), [&](size_t begin, size_t end, size_t /*chunk*/) {
+      for (size_t i = begin; i < end; ++i) {
+        fleet_.Store(first + i, store.robots[i]);
+      }
+    });
+    offset += store.robots.size();
+  }
+
+  /// Advances the robots of one type; each chunk only writes its own robots
+  template <typename Robot>
+  void StepStore(Store<Robot>& store, double dt) {
+    const FleetView fleet(fleet_);
+    pool_->ParallelFor(store.robots.size(), [&](size_t begin, size_t end, size_t /*chunk*/) {
+      for (size_t i = begin; i < end; ++i) {
+        Robot& robot = store.robots[i];
+        Contacts& contacts = store.contacts[i];
+        if constexpr (ReadsFleet<Robot>::value) {
+          robot.Robot::UpdateState(dt, fleet);
+        } else {
+          robot.Robot::UpdateState(dt);
+        }
+
+        const Eigen::Vector2d position = robot.Robot::GetPosition();
+        const EnvironmentElement* collision = environment_->CheckCollision(position);
+        contacts.collisionEvent = collision != contacts.collision ? collision : nullptr;
+        contacts.collision = collision;
+
+        const EnvironmentElement* mergePoint = environment_->FindMergePoint(position);
+        contacts.mergePointEvent = mergePoint != contacts.mergePoint ? mergePoint : nullptr;
+        contacts.mergePoint = mergePoint;
+      }
+    });
+  }
+
+  /// Reports the events of one type's robots to the observers
+  template <typename Robot>
+  void DispatchEvents(const Store<Robot>& store) const {
+    for (size_t i = 0; i < store.robots.size(); ++i) {
+      const Contacts& contacts = store.contacts[i];
+      if (contacts.collisionEvent != nullptr) {
+        for (auto observer : observers_) {
+          observer->OnCollision(&store.robots[i], contacts.collisionEvent);
+        }
+      }
+      if (contacts.mergePointEvent != nullptr) {
+        for (auto observer : observers_) {
+          observer->OnMergePoint(&store.robots[i], contacts.mergePointEvent);
+        }
+      }
+    }
+  }
+
+  /// Gives every robot of one type the stream for the current seed
+  template <typename Robot>
+  void Reseed(Store<Robot>& store) {
+    for (size_t i = 0; i < store.robots.size(); ++i) {
+      store.robots[i].Robot::SetRandomStream(CounterRng(seed_, store.contacts[i].id));
+    }
+  }
+
+  /// Forgets the contacts of one type's robots after the environment changed
+  template <typename Robot>
+  static void ClearContacts(Store<Robot>& store) {
+    for (Contacts& contacts : store.contacts) {
+      contacts.collision = nullptr;
+      contacts.mergePoint = nullptr;
+    }
+  }
+
+  /// Hashes the ids and exact kinematic state of one type's robots
+  template <typename Robot>
+  static uint64_t HashStore(const Store<Robot>& store, uint64_t hash) {
+    for (size_t i = 0; i < store.robots.size(); ++i) {
+      const Eigen::Vector2d position = store.robots[i].Robot::GetPosition();
+      const Eigen::Vector2d velocity = store.robots[i].Robot::GetVelocity();
+      hash = HashBytes(&store.contacts[i].id, sizeof(uint64_t), hash);
+      hash = HashBytes(position.data(), 2 * sizeof(double), hash);
+      hash = HashBytes(velocity.data(), 2 * sizeof(double), hash);
+    }
+    return hash;
+  }
+
+  /// The current simulation time in seconds
+  double time_;
+
+  /// Robots of every type, in the order of the template arguments
+  std::tuple<Store<Robots>...> stores_;
+
+  /// Every robot at the start of the current step, if some type reads the fleet
+  FleetState fleet_;
+
+  /// Seed from which every robot's random stream is derived
+  uint64_t seed_;
+
+  /// Id given to the next robot that is added
+  uint64_t nextRobotId_;
+
+  /// Threads robots are advanced on
+  std::unique_ptr<ThreadPool> pool_;
+
+  /// The environment for the simulation
+  std::unique_ptr<Environment> environment_;
+
+  /// Collection of observers for simulation events
+  std::vector<SimulationObserver*> observers_;
+
+  /// Whether each observer asked for the state of the current step
+  std::vector<uint8_t> stepStateNeeded_;
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Appends plain values to a byte buffer.
+ *
+ * Values are written in native byte order without padding; the format is
+ * meant for caches that are read back on the machine that wrote them.
+ */
+class BinaryWriter {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param buffer The buffer to append to; must outlive the writer
+   */
+  explicit BinaryWriter(std::string& buffer) : buffer_(buffer) {}
+
+  /**
+   * @brief Appends a trivially copyable value.
+   *
+   * @param value The value
+   */
+  template <typename T>
+  void Write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "only plain values can be written");
+    buffer_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  /**
+   * @brief Appends an array of trivially copyable values, prefixed with its length.
+   *
+   * @param values The values
+   */
+  template <typename T>
+  void WriteArray(const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable_v<T>, "only plain values can be written");
+    Write(static_cast<uint64_t>(values.size()));
+    if (!values.empty()) {
+      buffer_.append(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+    }
+  }
+
+  /**
+   * @brief Appends a string, prefixed with its length.
+   *
+   * @param value The string
+   */
+  void WriteString(const std::string& value) {
+    Write(static_cast<uint64_t>(value.size()));
+    buffer_.append(value);
+  }
+
+ private:
+  std::string& buffer_;  ///< Output buffer
+};
+
+/**
+ * @brief Reads plain values written by BinaryWriter from a byte range.
+ *
+ * Every read is bounds-checked, so truncated or corrupt input makes a read
+ * fail instead of reading past the end. Reads copy the bytes, so the range
+ * may be unaligned, e.g. a memory-mapped file.
+ */
+class BinaryReader {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param data Start of the range; must outlive the reader
+   * @param size Length of the range in bytes
+   */
+  BinaryReader(const uint8_t* data, size_t size) : data_(data), remaining_(size) {}
+
+  /**
+   * @brief Reads a trivially copyable value.
+   *
+   * @param value Output parameter for the value
+   * @return True if enough bytes were left, false otherwise
+   */
+  template <typename T>
+  bool Read(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "only plain values can be read");
+    if (remaining_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, data_, sizeof(T));
+    Skip(sizeof(T));
+    return true;
+  }
+
+  /**
+   * @brief Reads an array written by BinaryWriter::WriteArray().
+   *
+   * @param values Output parameter for the values
+   * @return True if the whole array was read, false otherwise
+   */
+  template <typename T>
+  bool ReadArray(std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable_v<T>, "only plain values can be read");
+    uint64_t count = 0;
+    if (!Read(count) || count > remaining_ / sizeof(T)) {
+      return false;
+    }
+    values.resize(count);
+    if (count > 0) {
+      std::memcpy(values.data(), data_, sizeof(T) * count);
+      Skip(sizeof(T) * count);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Reads a string written by BinaryWriter::WriteString().
+   *
+   * @param value Output parameter for the string
+   * @return True if the whole string was read, false otherwise
+   */
+  bool ReadString(std::string& value) {
+    uint64_t size = 0;
+    if (!Read(size) || size > remaining_) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data_), size);
+    Skip(size);
+    return true;
+  }
+
+  /**
+   * @brief Reads a string written by BinaryWriter::WriteString() in place.
+   *
+   * @param block Output parameter for a reader over the string's bytes
+   * @return True if the whole string was available, false otherwise
+   */
+  bool ReadBlock(BinaryReader& block) {
+    uint64_t size = 0;
+    if (!Read(size) || size > remaining_) {
+      return false;
+    }
+    block = BinaryReader(data_, size);
+    Skip(size);
+    return true;
+  }
+
+  /**
+   * @brief Gets the number of bytes that have not been read.
+   *
+   * @return The remaining length in bytes
+   */
+  size_t GetRemaining() const { return remaining_; }
+
+ private:
+  /// Advances past bytes that have been consumed
+  void Skip(size_t size) {
+    data_ += size;
+    remaining_ -= size;
+  }
+
+  const uint8_t* data_;  ///< Next unread byte
+  size_t remaining_;     ///< Unread bytes
+};
+
+}  // namespace mobilerobotsim
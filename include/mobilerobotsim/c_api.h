@@ -0,0 +1,130 @@
+#pragma once
+
+/**
+ * @file c_api.h
+ * @brief Stable C interface to SimulationEngine for use from other languages.
+ *
+ * Engines are opaque pointers. Functions that can fail return true on
+ * success and false otherwise; no C++ exception crosses the interface.
+ *
+ * Fleet columns are exported as strided buffers that point into the
+ * engine's own storage, so host languages can wrap them without copying,
+ * e.g. with numpy.ndarray or Julia's unsafe_wrap. A buffer stays valid until
+ * the next call that changes the engine, such as stepping or adding a
+ * robot, and must be requested again afterwards; requesting it is cheap.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* MRS_BUILDING_LIBRARY is only defined while the library itself is built */
+#if defined(_WIN32) && defined(MRS_BUILDING_LIBRARY)
+#define MRS_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define MRS_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define MRS_API __attribute__((visibility("default")))
+#else
+#define MRS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Version of this interface; bumped on incompatible changes */
+#define MRS_API_VERSION 1
+
+/** Opaque simulation engine */
+typedef struct mrs_engine mrs_engine;
+
+/** Stable handle of a robot */
+typedef struct {
+  uint32_t index;       /**< Slot index */
+  uint32_t generation;  /**< Generation of the slot when the handle was issued */
+} mrs_robot_handle;
+
+/** Element type of an exported buffer, stored in mrs_buffer::dtype */
+typedef enum { MRS_FLOAT64 = 0, MRS_UINT32 = 1 } mrs_dtype;
+
+/**
+ * A read-only strided view of engine memory.
+ *
+ * Element (i, j) lies at (const char*)data + i * strides[0] + j * strides[1].
+ * One-dimensional buffers have ndim 1 and ignore the second entries.
+ */
+typedef struct {
+  const void* data;    /**< First element; may be null when the fleet is empty */
+  int32_t dtype;       /**< Element type, an mrs_dtype value; enums have no fixed size */
+  int32_t ndim;        /**< Number of dimensions, 1 or 2 */
+  int64_t shape[2];    /**< Extent of each dimension */
+  int64_t strides[2];  /**< Step between elements of each dimension, in bytes */
+} mrs_buffer;
+
+/** Gets the interface version the library was built with, MRS_API_VERSION. */
+MRS_API uint32_t mrs_api_version(void);
+
+/** Creates an engine with an empty environment; returns null on failure. */
+MRS_API mrs_engine* mrs_engine_create(void);
+
+/** Destroys an engine; null is ignored. */
+MRS_API void mrs_engine_destroy(mrs_engine* engine);
+
+/** Sets the number of threads used to advance robots; the results do not depend on it. */
+MRS_API bool mrs_engine_set_thread_count(mrs_engine* engine, size_t thread_count);
+
+/** Sets the seed of the robots' random streams. */
+MRS_API bool mrs_engine_set_seed(mrs_engine* engine, uint64_t seed);
+
+/** Advances the simulation by one step of dt seconds. */
+MRS_API bool mrs_engine_step(mrs_engine* engine, double dt);
+
+/** Advances the simulation to a time with steps of at least min_step and at most max_step. */
+MRS_API bool mrs_engine_advance_to(mrs_engine* engine, double time, double min_step,
+                                   double max_step);
+
+/** Gets the simulation time in seconds. */
+MRS_API double mrs_engine_get_time(const mrs_engine* engine);
+
+/** Gets the number of robots. */
+MRS_API size_t mrs_engine_get_robot_count(const mrs_engine* engine);
+
+/** Adds a point robot; its handle is written to handle if not null. */
+MRS_API bool mrs_engine_add_point_robot(mrs_engine* engine, double x, double y,
+                                        double orientation, double vx, double vy,
+                                        mrs_robot_handle* handle);
+
+/** Removes a robot; fails if the handle is stale. */
+MRS_API bool mrs_engine_remove_robot(mrs_engine* engine, mrs_robot_handle handle);
+
+/** Sets the velocity a robot steers towards, immediately. */
+MRS_API bool mrs_engine_set_target_velocity(mrs_engine* engine, mrs_robot_handle handle,
+                                            double vx, double vy);
+
+/** Schedules a target velocity for the first step that begins at or after a time. */
+MRS_API bool mrs_engine_schedule_target_velocity(mrs_engine* engine, double time,
+                                                 mrs_robot_handle handle, double vx,
+                                                 double vy);
+
+/** Saves the state of the simulation to a file. */
+MRS_API bool mrs_engine_save_state(const mrs_engine* engine, const char* filename);
+
+/** Loads the state of the simulation from a file. */
+MRS_API bool mrs_engine_load_state(mrs_engine* engine, const char* filename);
+
+/** Exports robot positions as a robot count x 2 buffer of MRS_FLOAT64, in storage order. */
+MRS_API bool mrs_engine_get_positions(mrs_engine* engine, mrs_buffer* buffer);
+
+/** Exports robot velocities as a robot count x 2 buffer of MRS_FLOAT64, in storage order. */
+MRS_API bool mrs_engine_get_velocities(mrs_engine* engine, mrs_buffer* buffer);
+
+/** Exports robot orientations as a buffer of robot count MRS_FLOAT64, in storage order. */
+MRS_API bool mrs_engine_get_orientations(mrs_engine* engine, mrs_buffer* buffer);
+
+/** Exports robot handles as a robot count x 2 buffer of MRS_UINT32 (index, generation). */
+MRS_API bool mrs_engine_get_handles(mrs_engine* engine, mrs_buffer* buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class SystemState;
+
+/**
+ * @brief Writes state snapshots to files on a background thread.
+ *
+ * The simulation thread only captures a snapshot and hands it over;
+ * serialization and file I/O run on the writer's own thread, in submission
+ * order. Each file is written under a temporary name and renamed into place
+ * when complete, so a crash never leaves a torn checkpoint behind.
+ *
+ * At most a fixed number of checkpoints are in flight, so a slow disk
+ * cannot let snapshots pile up in memory. By default a checkpoint submitted
+ * while the writer is full is skipped, so the simulation thread never
+ * stalls on I/O; with SetWaitWhenFull() it waits for the oldest checkpoint
+ * instead, throttling the simulation to the disk.
+ */
+class CheckpointWriter {
+ public:
+  /**
+   * @brief Constructor. Starts the writer thread.
+   *
+   * @param maxPending Maximum number of checkpoints in flight; at least one
+   * @param waitWhenFull Whether Submit() waits rather than skips when the writer is full
+   */
+  explicit CheckpointWriter(size_t maxPending = 1, bool waitWhenFull = false);
+
+  /**
+   * @brief Destructor. Writes every submitted checkpoint, then joins the thread.
+   */
+  ~CheckpointWriter();
+
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+  /**
+   * @brief Queues a snapshot to be written.
+   *
+   * If the maximum number of checkpoints is in flight, the snapshot is
+   * skipped, or waits for the oldest one if SetWaitWhenFull() was set.
+   *
+   * @param state The snapshot; the writer takes ownership
+   * @param filename The file to write
+   * @return Future that becomes true once the file is in place, or false if
+   *         writing failed or the snapshot was skipped
+   */
+  std::future<bool> Submit(std::unique_ptr<SystemState> state, const std::string& filename);
+
+  /**
+   * @brief Sets the maximum number of checkpoints in flight.
+   *
+   * @param maxPending The maximum; at least one
+   */
+  void SetMaxPending(size_t maxPending);
+
+  /**
+   * @brief Sets whether Submit() waits for a free slot rather than skipping the snapshot.
+   *
+   * @param wait True to wait, false to skip (default)
+   */
+  void SetWaitWhenFull(bool wait);
+
+  /**
+   * @brief Gets the number of checkpoints submitted but not yet written.
+   *
+   * @return The number of checkpoints in flight
+   */
+  size_t GetPendingCount() const;
+
+  /**
+   * @brief Gets the number of snapshots skipped because the writer was full.
+   *
+   * @return The number of skipped checkpoints
+   */
+  uint64_t GetSkippedCount() const;
+
+  /**
+   * @brief Waits until every submitted checkpoint has been written.
+   */
+  void Wait();
+
+ private:
+  /**
+   * @brief A snapshot waiting to be written.
+   */
+  struct Job {
+    std::unique_ptr<SystemState> state;  ///< The snapshot
+    std::string filename;                ///< Destination file
+    std::promise<bool> done;             ///< Fulfilled once the file is written
+  };
+
+  /// Body of the writer thread
+  void WriterLoop();
+
+  mutable std::mutex mutex_;           ///< Guards the state below
+  std::condition_variable jobReady_;   ///< Signals the writer that a job was queued
+  std::condition_variable jobDone_;    ///< Signals submitters that a job finished
+  std::deque<Job> jobs_;               ///< Queued jobs, oldest first
+  size_t pending_;                     ///< Queued jobs plus the one being written
+  size_t maxPending_;                  ///< Cap on pending_
+  bool waitWhenFull_;                  ///< Whether Submit() waits rather than skips
+  uint64_t skipped_;                   ///< Snapshots skipped because the writer was full
+  bool stopping_;                      ///< Set when the writer shuts down
+  std::thread thread_;                 ///< Writer thread; started last
+};
+
+}  // namespace mobilerobotsim
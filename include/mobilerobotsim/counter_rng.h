@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Counter-based random number stream.
+ *
+ * The n-th value of a stream is a pure function of (seed, stream, n), computed
+ * by running the counter through a SplitMix64-style mixer. Streams therefore
+ * do not depend on the order in which they are consumed, so giving every
+ * robot its own stream keeps results identical no matter how robots are
+ * spread across threads. Only integer arithmetic and correctly rounded
+ * floating point operations are used, so the values are also identical on
+ * every IEEE-754 platform.
+ */
+class CounterRng {
+ public:
+  /**
+   * @brief Constructor with seed and stream index.
+   *
+   * @param seed The simulation-wide seed
+   * @param stream The stream index, e.g. a robot's id
+   */
+  explicit CounterRng(uint64_t seed = 0, uint64_t stream = 0)
+      : key_(Mix(seed ^ Mix(stream + 0x9e3779b97f4a7c15ull))), counter_(0) {}
+
+  /**
+   * @brief Gets the next 64 random bits.
+   *
+   * @return A uniformly distributed 64-bit value
+   */
+  uint64_t NextU64() { return Mix(key_ + 0x9e3779b97f4a7c15ull * ++counter_); }
+
+  /**
+   * @brief Gets the next uniform value in [0, 1).
+   *
+   * @return A uniformly distributed double with 53 random bits
+   */
+  double NextUniform() { return static_cast<double>(NextU64() >> 11) * 0x1.0p-53; }
+
+  /**
+   * @brief Gets the next approximately standard normal value.
+   *
+   * Sums twelve uniforms (Irwin-Hall), which avoids transcendental functions
+   * whose last bit differs between math libraries. Values are bounded by
+   * +/-6, which is adequate for sensor and actuation noise.
+   *
+   * @return A value with zero mean and unit variance
+   */
+  double NextGaussian() {
+    double sum = 0.0;
+    for (int i = 0; i < 12; ++i) {
+      sum += NextUniform();
+    }
+    return sum - 6.0;
+  }
+
+  /**
+   * @brief Gets the number of 64-bit values drawn so far.
+   *
+   * @return The stream position
+   */
+  uint64_t GetCounter() const { return counter_; }
+
+  /**
+   * @brief Moves the stream to a position, e.g. when restoring a checkpoint.
+   *
+   * @param counter The stream position
+   */
+  void SetCounter(uint64_t counter) { counter_ = counter; }
+
+ private:
+  /// SplitMix64 finalizer
+  static uint64_t Mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t key_;      ///< Mixed seed and stream index
+  uint64_t counter_;  ///< Number of values drawn
+};
+
+}  // namespace mobilerobotsim
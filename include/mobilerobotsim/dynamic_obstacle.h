@@ -0,0 +1,137 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <string>
+
+#include "environment.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Circular obstacle moving at constant velocity.
+ *
+ * DynamicObstacle models moving environment geometry such as forklifts or
+ * pedestrians. It is always a dynamic element, so the Environment advances it
+ * every step and keeps it in the incrementally updated dynamic index.
+ */
+class DynamicObstacle : public EnvironmentElement {
+ public:
+  /**
+   * @brief Constructor with position, radius, and velocity.
+   *
+   * @param x Initial x-coordinate of the center
+   * @param y Initial y-coordinate of the center
+   * @param radius Radius of the obstacle
+   * @param vx Initial x velocity
+   * @param vy Initial y velocity
+   */
+  DynamicObstacle(double x, double y, double radius, double vx = 0.0, double vy = 0.0);
+
+  /**
+   * @brief Destructor.
+   */
+  ~DynamicObstacle() override;
+
+  /**
+   * @brief Gets the type identifier of the element.
+   *
+   * @return "DynamicObstacle"
+   */
+  std::string GetTypeId() const override { return "DynamicObstacle"; }
+
+  /**
+   * @brief Checks if a point lies inside the obstacle's disc.
+   *
+   * @param position The position to check for collision
+   * @return True if the position is inside the obstacle, false otherwise
+   */
+  bool CheckCollision(const Eigen::Vector2d& position) const override;
+
+  /**
+   * @brief Gets the obstacle state as a JSON object.
+   *
+   * @return JSON with the keys x, y, vx, vy and radius
+   */
+  std::string GetState() const override;
+
+  /**
+   * @brief Loads the obstacle state from a JSON object.
+   *
+   * @param state JSON as produced by GetState(); missing keys keep their value
+   * @return True if the state was successfully loaded, false otherwise
+   */
+  bool LoadState(const std::string& state) override;
+
+  /**
+   * @brief Writes the obstacle as raw doubles.
+   *
+   * @param writer The writer to append the state to
+   * @return True
+   */
+  bool SaveBinary(BinaryWriter& writer) const override;
+
+  /**
+   * @brief Loads the obstacle from raw doubles written by SaveBinary().
+   *
+   * @param reader The reader positioned at the state
+   * @return True if the state was read, false if the input is truncated
+   */
+  bool LoadBinary(BinaryReader& reader) override;
+
+  /**
+   * @brief Dynamic obstacles are always dynamic elements.
+   *
+   * @return True
+   */
+  bool IsDynamic() const override { return true; }
+
+  /**
+   * @brief Moves the obstacle along its velocity.
+   *
+   * @param dt Time step size in seconds
+   */
+  void Update(double dt) override;
+
+  /**
+   * @brief Gets the bounding box of the obstacle's disc.
+   *
+   * @return The bounding box
+   */
+  Eigen::AlignedBox2d GetBounds() const override;
+
+  /**
+   * @brief Sets the velocity of the obstacle.
+   *
+   * @param vx x velocity
+   * @param vy y velocity
+   */
+  void SetVelocity(double vx, double vy);
+
+  /**
+   * @brief Gets the center of the obstacle.
+   *
+   * @return The current center position
+   */
+  const Eigen::Vector2d& GetPosition() const { return position_; }
+
+  /**
+   * @brief Gets the velocity of the obstacle.
+   *
+   * @return The current velocity
+   */
+  const Eigen::Vector2d& GetVelocity() const { return velocity_; }
+
+  /**
+   * @brief Gets the radius of the obstacle.
+   *
+   * @return The radius
+   */
+  double GetRadius() const { return radius_; }
+
+ private:
+  Eigen::Vector2d position_;  ///< The current center of the obstacle
+  Eigen::Vector2d velocity_;  ///< The current velocity of the obstacle
+  double radius_;             ///< The radius of the obstacle
+};
+
+}  // namespace mobilerobotsim
@@ -1,14 +1,24 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <istream>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "loose_quadtree.h"
+#include "uniform_grid_index.h"
+
 namespace mobilerobotsim {
 
 // Forward declarations
+class BinaryReader;
+class BinaryWriter;
 class EnvironmentState;
+class JsonWriter;
+class SignedDistanceField;
 
 /**
  * @brief Interface for environment elements.
@@ -29,7 +39,7 @@ class EnvironmentElement {
    *
    * @return String identifier for the element type
    */
-  virtual std::string getTypeId() const = 0;
+  virtual std::string GetTypeId() const = 0;
 
   /**
    * @brief Checks if a point collides with this element.
@@ -37,14 +47,14 @@ class EnvironmentElement {
    * @param position The position to check for collision
    * @return True if the position collides with this element, false otherwise
    */
-  virtual bool checkCollision(const Eigen::Vector2d& position) const = 0;
+  virtual bool CheckCollision(const Eigen::Vector2d& position) const = 0;
 
   /**
    * @brief Gets the state of this environment element.
    *
    * @return A string representation of the element's state
    */
-  virtual std::string getState() const = 0;
+  virtual std::string GetState() const = 0;
 
   /**
    * @brief Loads the state of this environment element.
@@ -52,7 +62,79 @@ class EnvironmentElement {
    * @param state The state to load
    * @return True if the state was successfully loaded, false otherwise
    */
-  virtual bool loadState(const std::string& state) = 0;
+  virtual bool LoadState(const std::string& state) = 0;
+
+  /**
+   * @brief Writes the state of this element in a compact binary form.
+   *
+   * Caches use the binary form to restore elements without parsing JSON.
+   * Elements without one keep the default, and GetState() is cached instead.
+   *
+   * @param writer The writer to append the state to
+   * @return True if a binary state was written, false if the element has none
+   */
+  virtual bool SaveBinary(BinaryWriter& /*writer*/) const { return false; }
+
+  /**
+   * @brief Loads a state written by SaveBinary().
+   *
+   * @param reader The reader positioned at the state
+   * @return True if the state was successfully loaded, false otherwise
+   */
+  virtual bool LoadBinary(BinaryReader& /*reader*/) { return false; }
+
+  /**
+   * @brief Folds everything that determines this element's geometry into a hash.
+   *
+   * Keys caches derived from the static geometry. The default hashes
+   * GetState(); elements whose state does not capture all of their geometry
+   * must also hash the rest.
+   *
+   * @param hash The hash to continue
+   * @return The updated hash
+   */
+  virtual uint64_t HashContent(uint64_t hash) const;
+
+  /**
+   * @brief Checks whether this element changes over time.
+   *
+   * The Environment decides once, when the element is added, whether it is
+   * static or dynamic. Only dynamic elements are updated every step and
+   * re-indexed after they move; static elements are indexed once.
+   *
+   * @return True if the element is dynamic, false if it is static
+   */
+  virtual bool IsDynamic() const { return false; }
+
+  /**
+   * @brief Checks whether this element blocks robots.
+   *
+   * Non-solid elements such as merge points mark regions of interest; they
+   * are ignored by the collision queries of the Environment.
+   *
+   * @return True if the element is an obstacle, false otherwise
+   */
+  virtual bool IsSolid() const { return true; }
+
+  /**
+   * @brief Advances a dynamic element by one time step.
+   *
+   * Static elements are never updated by the Environment.
+   *
+   * @param dt Time step size in seconds
+   */
+  virtual void Update(double /*dt*/) {}
+
+  /**
+   * @brief Gets the axis-aligned bounding box of this element.
+   *
+   * Spatial indices use the box to skip elements that cannot collide with a
+   * query. An empty box means the extent is unknown, in which case the element
+   * is tested by every query.
+   *
+   * @return The bounding box, or an empty box if the extent is unknown
+   */
+  virtual Eigen::AlignedBox2d GetBounds() const { return Eigen::AlignedBox2d(); }
 
  protected:
   /**
@@ -115,7 +197,7 @@ class EnvironmentState {
    * @param typeId The type identifier of the element
    * @param state The serialized state of the element
    */
-  void addElementState(const std::string& typeId, const std::string& state);
+  void AddElementState(const std::string& typeId, const std::string& state);
 
   /**
    * @brief Gets the element state at the specified index.
@@ -125,21 +207,40 @@ class EnvironmentState {
    * @param state Output parameter for the element state
    * @return True if the element state exists, false otherwise
    */
-  bool getElementState(size_t index, std::string& typeId, std::string& state) const;
+  bool GetElementState(size_t index, std::string& typeId, std::string& state) const;
 
   /**
    * @brief Gets the number of element states.
    *
    * @return The number of element states
    */
-  size_t getElementStateCount() const;
+  size_t GetElementStateCount() const;
+
+  /**
+   * @brief Writes the environment state as a JSON object.
+   *
+   * The object has the form {"elements": [{"type": ..., "state": ...}, ...]}.
+   *
+   * @param writer The writer to write to
+   */
+  void Write(JsonWriter& writer) const;
+
+  /**
+   * @brief Reads an environment state written by Write(), replacing the current one.
+   *
+   * Elements are read one at a time, so the whole document is never held in memory.
+   *
+   * @param stream The stream to read from
+   * @return True if the stream held a valid environment state, false otherwise
+   */
+  bool Read(std::istream& stream);
 
   /**
    * @brief Serializes the environment state to a string representation.
    *
    * @return String representation of the environment state
    */
-  std::string serialize() const;
+  std::string Serialize() const;
 
   /**
    * @brief Deserializes an environment state from a string representation.
@@ -147,14 +248,19 @@ class EnvironmentState {
    * @param serialized The serialized state string
    * @return True if deserialization was successful, false otherwise
    */
-  bool deserialize(const std::string& serialized);
+  bool Deserialize(const std::string& serialized);
+
+  /**
+   * @brief Removes every element state.
+   */
+  void Clear();
 
  private:
   /// Collection of element type identifiers
-  std::vector<std::string> elementTypeIds;
+  std::vector<std::string> elementTypeIds_;
 
   /// Collection of element states
-  std::vector<std::string> elementStates;
+  std::vector<std::string> elementStates_;
 };
 
 /**
@@ -162,6 +268,12 @@ class EnvironmentState {
  *
  * Environment manages a collection of environment elements and provides
  * methods for updating, collision detection, and state management.
+ *
+ * Elements are partitioned into static and dynamic collections when they are
+ * added. Update() only visits the dynamic elements, and the static elements are
+ * indexed once by BuildStaticIndex(), since walls and lanes never move.
+ * Dynamic elements live in a loose quadtree that is updated incrementally as
+ * they move, so a step costs amortized O(log n) per moving element.
  */
 class Environment {
  public:
@@ -175,46 +287,308 @@ class Environment {
    */
   ~Environment();
 
+  /**
+   * @brief Sets the region covered by the dynamic element index.
+   *
+   * Dynamic elements outside the region are still found by collision
+   * queries, but they are not spatially indexed.
+   *
+   * @param bounds The world bounds
+   */
+  void SetWorldBounds(const Eigen::AlignedBox2d& bounds);
+
+  /**
+   * @brief Gets the region covered by the dynamic element index.
+   *
+   * @return The world bounds
+   */
+  const Eigen::AlignedBox2d& GetWorldBounds() const;
+
   /**
    * @brief Adds an environment element.
    *
+   * Adding a static element invalidates the static index; collision queries
+   * fall back to a linear scan of the static elements until
+   * BuildStaticIndex() is called again.
+   *
    * @param element The environment element to add
    */
-  void addElement(std::unique_ptr<EnvironmentElement> element);
+  void AddElement(std::unique_ptr<EnvironmentElement> element);
+
+  /**
+   * @brief Builds the spatial index over the static elements.
+   *
+   * This is the one-time build path for static geometry. Call it after the
+   * static map has been loaded and before the simulation starts.
+   *
+   * @param cellSize Bucket edge length in meters, or a non-positive value to
+   *                 derive it from the element sizes
+   */
+  void BuildStaticIndex(double cellSize = 0.0);
+
+  /**
+   * @brief Checks whether the static index is up to date.
+   *
+   * @return True if BuildStaticIndex() has been called since the last static
+   *         element was added, false otherwise
+   */
+  bool HasStaticIndex() const;
+
+  /**
+   * @brief Gets the spatial index over the static elements.
+   *
+   * Item ids of the index are the positions of the static elements in
+   * insertion order.
+   *
+   * @return The index, or nullptr if it is not up to date
+   */
+  const UniformGridIndex* GetStaticIndex() const;
+
+  /**
+   * @brief Installs a static index built earlier, e.g. restored from a cache.
+   *
+   * The index must have been built over the bounds of the current static
+   * elements in insertion order; only the item count can be checked.
+   *
+   * @param index The index
+   * @return True if the index was installed, false if its item count does not match
+   */
+  bool SetStaticIndex(UniformGridIndex index);
 
   /**
    * @brief Updates the environment based on the current time step.
    *
+   * Only dynamic elements are updated, after which their new bounds are
+   * applied incrementally to the dynamic index.
+   *
    * @param dt Time step size in seconds
    */
-  void update(double dt);
+  void Update(double dt);
 
   /**
-   * @brief Checks if a position collides with any environment element.
+   * @brief Checks if a position collides with any solid environment element.
    *
    * @param position The position to check
    * @return Pointer to the colliding element, or nullptr if no collision
    */
-  const EnvironmentElement* checkCollision(const Eigen::Vector2d& position) const;
+  const EnvironmentElement* CheckCollision(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Checks a position of any scalar type against the solid elements.
+   *
+   * Single-precision robots query through this overload; the position is
+   * widened to double once, since element geometry is stored in double.
+   *
+   * @tparam Scalar The position's scalar type
+   * @param position The position to check
+   * @return Pointer to the colliding element, or nullptr if no collision
+   */
+  template <typename Scalar>
+  const EnvironmentElement* CheckCollision(const Eigen::Matrix<Scalar, 2, 1>& position) const {
+    return CheckCollision(Eigen::Vector2d(position.template cast<double>()));
+  }
+
+  /**
+   * @brief Checks a batch of positions against the solid elements.
+   *
+   * @tparam Scalar The positions' scalar type
+   * @param positions One position per column
+   * @param hits Output parameter, resized to one colliding element (or
+   *             nullptr) per position
+   */
+  template <typename Scalar>
+  void CheckCollisionBatch(const Eigen::Matrix<Scalar, 2, Eigen::Dynamic>& positions,
+                           std::vector<const EnvironmentElement*>& hits) const {
+    hits.resize(static_cast<size_t>(positions.cols()));
+    for (Eigen::Index i = 0; i < positions.cols(); ++i) {
+      hits[static_cast<size_t>(i)] =
+          CheckCollision(Eigen::Vector2d(positions.col(i).template cast<double>()));
+    }
+  }
+
+  /**
+   * @brief Checks if a position collides with any solid static environment element.
+   *
+   * @param position The position to check
+   * @return Pointer to the colliding element, or nullptr if no collision
+   */
+  const EnvironmentElement* CheckStaticCollision(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Checks if a position collides with any solid dynamic environment element.
+   *
+   * @param position The position to check
+   * @return Pointer to the colliding element, or nullptr if no collision
+   */
+  const EnvironmentElement* CheckDynamicCollision(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Finds the static merge point containing a position.
+   *
+   * @param position The position to check
+   * @return Pointer to the merge point, or nullptr if the position is in none
+   */
+  const EnvironmentElement* FindMergePoint(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Finds the static robot sink containing a position.
+   *
+   * @param position The position to check
+   * @return Pointer to the sink, or nullptr if the position is in none
+   */
+  const EnvironmentElement* FindRobotSink(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Visits every static element whose bounds intersect a region.
+   *
+   * Elements with unknown bounds are always visited. Uses the static index
+   * when it is up to date and a linear scan otherwise.
+   *
+   * @param region The query region
+   * @param visitor Callable taking a const EnvironmentElement&; returning true stops the query
+   */
+  template <typename Visitor>
+  void ForEachStaticElement(const Eigen::AlignedBox2d& region, Visitor&& visitor) const;
+
+  /**
+   * @brief Visits every dynamic element whose bounds intersect a region.
+   *
+   * Elements with unknown bounds are always visited.
+   *
+   * @param region The query region
+   * @param visitor Callable taking a const EnvironmentElement&; returning true stops the query
+   */
+  template <typename Visitor>
+  void ForEachDynamicElement(const Eigen::AlignedBox2d& region, Visitor&& visitor) const;
+
+  /**
+   * @brief Builds the signed distance field over the static elements.
+   *
+   * The field is built once; if a cache path is given, a cache written for
+   * the same static geometry, region and resolution is loaded instead, and a
+   * freshly built field is written back to the cache.
+   *
+   * @param region The world region to cover
+   * @param resolution Cell edge length in meters
+   * @param cachePath Optional cache file
+   * @return True if the field is available, false otherwise
+   */
+  bool BuildDistanceField(const Eigen::AlignedBox2d& region, double resolution,
+                          const std::string& cachePath = "");
+
+  /**
+   * @brief Gets the signed distance field over the static elements.
+   *
+   * @return Pointer to the field, or nullptr if it has not been built
+   */
+  const SignedDistanceField* GetDistanceField() const;
+
+  /**
+   * @brief Computes a content hash of the static elements.
+   *
+   * The hash covers the type and content (see EnvironmentElement::HashContent())
+   * of every static element and is used to key caches derived from the
+   * static geometry.
+   *
+   * @return The 64-bit hash
+   */
+  uint64_t ComputeStaticHash() const;
+
+  /**
+   * @brief Gets the revision of the environment's element set.
+   *
+   * The revision changes whenever elements are added or the state is loaded,
+   * but not when dynamic elements move in Update().
+   *
+   * @return The revision counter
+   */
+  uint64_t GetRevision() const;
+
+  /**
+   * @brief Gets the number of static elements.
+   *
+   * @return The number of static elements
+   */
+  size_t GetStaticElementCount() const;
+
+  /**
+   * @brief Gets the number of dynamic elements.
+   *
+   * @return The number of dynamic elements
+   */
+  size_t GetDynamicElementCount() const;
 
   /**
    * @brief Gets the current state of the environment.
    *
+   * Element states are listed static elements first, then dynamic elements,
+   * each in insertion order.
+   *
    * @return A unique pointer to an EnvironmentState object
    */
-  std::unique_ptr<EnvironmentState> getState() const;
+  std::unique_ptr<EnvironmentState> GetState() const;
 
   /**
    * @brief Loads a previously saved environment state.
    *
+   * Element states are matched to the elements by position, in the order of
+   * GetState(); the state must list exactly the current elements with the
+   * same types, or nothing is loaded. Loading a changed static element
+   * invalidates the static index and the distance field.
+   *
    * @param state The environment state to load
    * @return True if the state was successfully loaded, false otherwise
    */
-  bool loadState(const EnvironmentState& state);
+  bool LoadState(const EnvironmentState& state);
 
  private:
-  /// Collection of environment elements
-  std::vector<std::unique_ptr<EnvironmentElement>> elements;
+  /**
+   * @brief Applies the current bounds of the dynamic elements to the dynamic index.
+   */
+  void RefreshDynamicIndex();
+
+  /// Elements that never change after being added
+  std::vector<std::unique_ptr<EnvironmentElement>> staticElements_;
+
+  /// Elements that are updated every step
+  std::vector<std::unique_ptr<EnvironmentElement>> dynamicElements_;
+
+  /// Spatial index over staticElements_, built by BuildStaticIndex()
+  UniformGridIndex staticIndex_;
+
+  /// Whether staticIndex_ covers every static element
+  bool staticIndexValid_;
+
+  /// Loose quadtree over dynamicElements_; item ids are indices into dynamicElements_
+  LooseQuadtree dynamicIndex_;
+
+  /// Signed distance to the static elements, built by BuildDistanceField()
+  std::unique_ptr<SignedDistanceField> distanceField_;
+
+  /// Incremented whenever the element set changes
+  uint64_t revision_;
 };
 
+template <typename Visitor>
+void Environment::ForEachStaticElement(const Eigen::AlignedBox2d& region,
+                                       Visitor&& visitor) const {
+  if (staticIndexValid_) {
+    staticIndex_.QueryBox(region, [&](uint32_t id) { return visitor(*staticElements_[id]); });
+    return;
+  }
+
+  for (const auto& element : staticElements_) {
+    const Eigen::AlignedBox2d bounds = element->GetBounds();
+    if ((bounds.isEmpty() || bounds.intersects(region)) && visitor(*element)) {
+      return;
+    }
+  }
+}
+
+template <typename Visitor>
+void Environment::ForEachDynamicElement(const Eigen::AlignedBox2d& region,
+                                        Visitor&& visitor) const {
+  dynamicIndex_.QueryBox(region, [&](uint32_t id) { return visitor(*dynamicElements_[id]); });
+}
+
 }  // namespace mobilerobotsim
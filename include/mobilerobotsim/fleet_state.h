@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+#include "mobile_robot_base.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Poses and velocities of every robot, by the engine's robot index.
+ *
+ * The simulation engine keeps two of these: one holding the fleet as it was
+ * at the start of the current step, which robots read, and one that the step
+ * fills in as robots finish their update. The two are swapped at the end of
+ * the step.
+ */
+struct FleetState {
+  std::vector<Eigen::Vector2d> positions;   ///< Robot positions in world coordinates
+  std::vector<Eigen::Vector2d> velocities;  ///< Robot velocities in world coordinates
+  std::vector<double> orientations;         ///< Robot orientations in radians
+  std::vector<RobotHandle> handles;         ///< Robot handles
+
+  /**
+   * @brief Resizes every column.
+   *
+   * @param count The number of robots
+   */
+  void Resize(size_t count) {
+    positions.resize(count);
+    velocities.resize(count);
+    orientations.resize(count);
+    handles.resize(count);
+  }
+
+  /**
+   * @brief Records a robot's pose and velocity.
+   *
+   * @param index The robot index
+   * @param robot The robot
+   */
+  void Store(size_t index, const MobileRobotBase& robot) {
+    positions[index] = robot.GetPosition();
+    velocities[index] = robot.GetVelocity();
+    orientations[index] = robot.GetOrientation();
+    handles[index] = robot.GetHandle();
+  }
+};
+
+/**
+ * @brief Read-only view of the fleet as it was at the start of the step.
+ *
+ * Neighbour-aware robots read other robots through the view instead of
+ * through the robots themselves, which are being updated concurrently.
+ * Because every robot sees the same snapshot, the result of a step does not
+ * depend on the order in which robots are updated or on the thread count.
+ */
+class FleetView {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param state The snapshot; must outlive the view
+   */
+  explicit FleetView(const FleetState& state) : state_(&state) {}
+
+  /**
+   * @brief Gets the number of robots.
+   *
+   * @return The number of robots
+   */
+  size_t size() const { return state_->positions.size(); }
+
+  /**
+   * @brief Gets a robot's position at the start of the step.
+   *
+   * @param index The robot index, less than size()
+   * @return The position in world coordinates
+   */
+  const Eigen::Vector2d& GetPosition(size_t index) const { return state_->positions[index]; }
+
+  /**
+   * @brief Gets a robot's velocity at the start of the step.
+   *
+   * @param index The robot index, less than size()
+   * @return The velocity in world coordinates
+   */
+  const Eigen::Vector2d& GetVelocity(size_t index) const { return state_->velocities[index]; }
+
+  /**
+   * @brief Gets a robot's orientation at the start of the step.
+   *
+   * @param index The robot index, less than size()
+   * @return The orientation in radians
+   */
+  double GetOrientation(size_t index) const { return state_->orientations[index]; }
+
+  /**
+   * @brief Gets a robot's handle, e.g. to skip the robot being updated.
+   *
+   * @param index The robot index, less than size()
+   * @return The handle
+   */
+  const RobotHandle& GetHandle(size_t index) const { return state_->handles[index]; }
+
+ private:
+  const FleetState* state_;  ///< The snapshot
+};
+
+}  // namespace mobilerobotsim
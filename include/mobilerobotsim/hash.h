@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mobilerobotsim {
+
+/// Offset basis of the 64-bit FNV-1a hash
+constexpr uint64_t kFnv1aOffsetBasis = 0xcbf29ce484222325ull;
+
+/**
+ * @brief Folds bytes into a 64-bit FNV-1a hash.
+ *
+ * FNV-1a is not cryptographic; it is used for content keys of caches and for
+ * comparing simulation states across runs.
+ *
+ * @param data The bytes to hash
+ * @param size The number of bytes
+ * @param hash The hash to continue from
+ * @return The updated hash
+ */
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = kFnv1aOffsetBasis) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/**
+ * @brief Folds a string into a 64-bit FNV-1a hash, including its length.
+ *
+ * @param value The string to hash
+ * @param hash The hash to continue from
+ * @return The updated hash
+ */
+inline uint64_t HashString(const std::string& value, uint64_t hash = kFnv1aOffsetBasis) {
+  const uint64_t length = value.size();
+  hash = HashBytes(&length, sizeof(length), hash);
+  return HashBytes(value.data(), value.size(), hash);
+}
+
+}  // namespace mobilerobotsim
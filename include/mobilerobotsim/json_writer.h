@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Streaming JSON writer.
+ *
+ * JsonWriter writes tokens straight to an output stream as they are
+ * produced, so documents of any size are written with memory bounded by the
+ * nesting depth. Commas are inserted automatically. Doubles are written in
+ * the shortest form that reads back to the same bits; non-finite values have
+ * no JSON representation and are written as null.
+ */
+class JsonWriter {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param stream The stream to write to; must outlive the writer
+   */
+  explicit JsonWriter(std::ostream& stream);
+
+  /**
+   * @brief Starts an object.
+   */
+  void BeginObject();
+
+  /**
+   * @brief Ends the innermost object.
+   */
+  void EndObject();
+
+  /**
+   * @brief Starts an array.
+   */
+  void BeginArray();
+
+  /**
+   * @brief Ends the innermost array.
+   */
+  void EndArray();
+
+  /**
+   * @brief Writes the key of the next object member.
+   *
+   * @param key The key
+   */
+  void Key(const std::string& key);
+
+  /**
+   * @brief Writes a number.
+   *
+   * @param value The value
+   */
+  void Value(double value);
+
+  /**
+   * @brief Writes an integer.
+   *
+   * @param value The value
+   */
+  void Value(int64_t value);
+
+  /**
+   * @brief Writes an unsigned integer.
+   *
+   * @param value The value
+   */
+  void Value(uint64_t value);
+
+  /**
+   * @brief Writes a boolean.
+   *
+   * @param value The value
+   */
+  void Value(bool value);
+
+  /**
+   * @brief Writes an escaped string.
+   *
+   * @param value The value
+   */
+  void Value(const std::string& value);
+
+  /**
+   * @brief Writes a string literal.
+   *
+   * @param value The value
+   */
+  void Value(const char* value) { Value(std::string(value)); }
+
+  /**
+   * @brief Writes null.
+   */
+  void Null();
+
+  /**
+   * @brief Writes a state that may already be serialized JSON.
+   *
+   * Text delimited by braces or brackets is embedded as is and must be a
+   * well-formed JSON object or array. Anything else, including JSON scalars,
+   * is written as a string, so it reads back as exactly the same text.
+   *
+   * @param json The serialized value
+   */
+  void RawValue(const std::string& json);
+
+  /**
+   * @brief Checks whether every write so far succeeded.
+   *
+   * @return True if the stream is in a good state, false otherwise
+   */
+  bool IsGood() const { return static_cast<bool>(stream_); }
+
+ private:
+  /// Writes the comma before a value or key if one is needed
+  void Separate();
+
+  std::ostream& stream_;     ///< Output stream
+  std::vector<bool> empty_;  ///< Whether each open container is still empty
+  bool afterKey_;            ///< Whether the next value belongs to a key
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <vector>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Incrementally updated loose quadtree over axis-aligned boxes.
+ *
+ * Each node's loose bounds are twice the size of its cell, so an item is
+ * stored in the deepest node whose cell holds the item's center and whose half
+ * size is at least the item's half extent. The target node therefore follows
+ * directly from the item's center and size. An item that moves within its cell
+ * is updated in O(1); otherwise it is relinked in O(depth) = O(log n) without
+ * rebuilding anything else.
+ *
+ * Items are identified by caller-chosen dense ids. Items whose center lies
+ * outside the world bounds are kept in the root, and items with an empty box
+ * are reported by every query.
+ */
+class LooseQuadtree {
+ public:
+  /**
+   * @brief Constructor with world bounds.
+   *
+   * @param worldBounds The region covered by the tree
+   * @param maxDepth The maximum depth of the tree
+   */
+  explicit LooseQuadtree(const Eigen::AlignedBox2d& worldBounds, int maxDepth = 12);
+
+  /**
+   * @brief Inserts an item.
+   *
+   * @param id The item id; ids should be dense, small integers
+   * @param box The item's bounding box
+   */
+  void Insert(uint32_t id, const Eigen::AlignedBox2d& box);
+
+  /**
+   * @brief Updates the bounding box of an item.
+   *
+   * @param id The item id
+   * @param box The item's new bounding box
+   */
+  void Update(uint32_t id, const Eigen::AlignedBox2d& box);
+
+  /**
+   * @brief Removes an item.
+   *
+   * @param id The item id
+   * @return True if the item was present, false otherwise
+   */
+  bool Remove(uint32_t id);
+
+  /**
+   * @brief Removes all items and nodes.
+   */
+  void Clear();
+
+  /**
+   * @brief Gets the number of items in the tree.
+   *
+   * @return The number of items
+   */
+  size_t GetItemCount() const { return itemCount_; }
+
+  /**
+   * @brief Gets the world bounds covered by the tree.
+   *
+   * @return The world bounds
+   */
+  const Eigen::AlignedBox2d& GetWorldBounds() const { return worldBounds_; }
+
+  /**
+   * @brief Visits every item whose box contains the given point.
+   *
+   * @param point The query point
+   * @param visitor Callable taking the item id; returning true stops the query
+   * @return True if the visitor stopped the query, false otherwise
+   */
+  template <typename Visitor>
+  bool QueryPoint(const Eigen::Vector2d& point, Visitor&& visitor) const;
+
+  /**
+   * @brief Visits every item whose box intersects the given box.
+   *
+   * @param box The query box
+   * @param visitor Callable taking the item id; returning true stops the query
+   * @return True if the visitor stopped the query, false otherwise
+   */
+  template <typename Visitor>
+  bool QueryBox(const Eigen::AlignedBox2d& box, Visitor&& visitor) const;
+
+ private:
+  /// Node sentinel for items that are not in the tree
+  static constexpr uint32_t kNone = 0xffffffffu;
+
+  /// Node sentinel for items kept in unboundedItems_
+  static constexpr uint32_t kUnbounded = 0xfffffffeu;
+
+  struct Node {
+    Eigen::Vector2d center;      ///< Center of the node's cell
+    double halfSize;             ///< Half edge length of the node's cell
+    int depth;                   ///< Depth of the node, zero at the root
+    uint32_t children[4];        ///< Child node indices, kNone if absent
+    std::vector<uint32_t> items; ///< Items stored in this node
+  };
+
+  struct Item {
+    Eigen::AlignedBox2d box;     ///< Current bounding box
+    uint32_t node = kNone;       ///< Node holding the item, kNone if absent
+    uint32_t slot = 0;           ///< Position of the item in its node's item list
+  };
+
+  /// Computes the depth an item belongs at from its half extent
+  int TargetDepth(const Eigen::AlignedBox2d& box) const;
+
+  /// Checks whether a node is the right home for a box
+  bool Fits(const Node& node, const Eigen::AlignedBox2d& box) const;
+
+  /// Finds or creates the node an item belongs in
+  uint32_t FindNode(const Eigen::AlignedBox2d& box);
+
+  /// Appends an item to a node's item list
+  void Link(uint32_t id, uint32_t node);
+
+  /// Removes an item from its node's item list
+  void Unlink(uint32_t id);
+
+  /// Checks whether a point lies in a node's loose bounds
+  static bool LooseContains(const Node& node, const Eigen::Vector2d& point);
+
+  /// Checks whether a box intersects a node's loose bounds
+  static bool LooseIntersects(const Node& node, const Eigen::AlignedBox2d& box);
+
+  Eigen::AlignedBox2d worldBounds_;       ///< Region covered by the root cell
+  int maxDepth_;                          ///< Maximum node depth
+  std::vector<Node> nodes_;               ///< Node storage; the root is nodes_[0]
+  std::vector<Item> items_;               ///< Item storage, indexed by id
+  std::vector<uint32_t> unboundedItems_;  ///< Items with an empty box
+  size_t itemCount_;                      ///< Number of items present
+};
+
+template <typename Visitor>
+bool LooseQuadtree::QueryPoint(const Eigen::Vector2d& point, Visitor&& visitor) const {
+  for (uint32_t id : unboundedItems_) {
+    if (visitor(id)) {
+      return true;
+    }
+  }
+
+  // The root is always visited since it also holds out-of-world items
+  uint32_t stack[4 * 32 + 1];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const Node& node = nodes_[stack[--top]];
+    for (uint32_t id : node.items) {
+      if (items_[id].box.contains(point) && visitor(id)) {
+        return true;
+      }
+    }
+    for (uint32_t child : node.children) {
+      if (child != kNone && LooseContains(nodes_[child], point)) {
+        stack[top++] = child;
+      }
+    }
+  }
+
+  return false;
+}
+
+template <typename Visitor>
+bool LooseQuadtree::QueryBox(const Eigen::AlignedBox2d& box, Visitor&& visitor) const {
+  for (uint32_t id : unboundedItems_) {
+    if (visitor(id)) {
+      return true;
+    }
+  }
+
+  std::vector<uint32_t> stack;
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const Node& node = nodes_[stack.back()];
+    stack.pop_back();
+    for (uint32_t id : node.items) {
+      if (items_[id].box.intersects(box) && visitor(id)) {
+        return true;
+      }
+    }
+    for (uint32_t child : node.children) {
+      if (child != kNone && LooseIntersects(nodes_[child], box)) {
+        stack.push_back(child);
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Read-only memory mapping of a file.
+ *
+ * MappedFile maps a whole file into memory with mmap so large maps and caches
+ * can be used in place. Pages are only read from disk when touched, so opening
+ * a file is constant time and untouched regions never become resident.
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Access pattern hint passed to the kernel.
+   */
+  enum class AccessHint { kNormal, kSequential, kRandom };
+
+  /**
+   * @brief Default constructor. Creates an unmapped file.
+   */
+  MappedFile();
+
+  /**
+   * @brief Destructor. Unmaps the file.
+   */
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief Move constructor.
+   *
+   * @param other The mapping to take over
+   */
+  MappedFile(MappedFile&& other) noexcept;
+
+  /**
+   * @brief Move assignment operator.
+   *
+   * @param other The mapping to take over
+   * @return Reference to this MappedFile
+   */
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  /**
+   * @brief Maps a file read-only.
+   *
+   * @param path The file to map
+   * @param hint Expected access pattern
+   * @return True if the file was mapped, false otherwise
+   */
+  bool Open(const std::string& path, AccessHint hint = AccessHint::kNormal);
+
+  /**
+   * @brief Unmaps the file.
+   */
+  void Close();
+
+  /**
+   * @brief Checks whether a file is mapped.
+   *
+   * @return True if a file is mapped, false otherwise
+   */
+  bool IsOpen() const { return data_ != nullptr; }
+
+  /**
+   * @brief Gets the mapped bytes.
+   *
+   * @return Pointer to the first byte, or nullptr if nothing is mapped
+   */
+  const uint8_t* GetData() const { return data_; }
+
+  /**
+   * @brief Gets the size of the mapping.
+   *
+   * @return The file size in bytes
+   */
+  size_t GetSize() const { return size_; }
+
+ private:
+  const uint8_t* data_;  ///< Start of the mapping
+  size_t size_;          ///< Length of the mapping in bytes
+};
+
+}  // namespace mobilerobotsim
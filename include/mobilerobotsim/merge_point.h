@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <string>
+
+#include "environment.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Circular zone where lanes merge.
+ *
+ * A MergePoint is a static, non-solid element: robots drive through it
+ * without colliding, and the SimulationEngine reports an OnMergePoint event
+ * when a robot enters it.
+ */
+class MergePoint : public EnvironmentElement {
+ public:
+  /**
+   * @brief Constructor with center and radius.
+   *
+   * @param x x-coordinate of the center
+   * @param y y-coordinate of the center
+   * @param radius Radius of the zone
+   */
+  MergePoint(double x, double y, double radius);
+
+  /**
+   * @brief Destructor.
+   */
+  ~MergePoint() override;
+
+  /**
+   * @brief Gets the type identifier of the element.
+   *
+   * @return "MergePoint"
+   */
+  std::string GetTypeId() const override { return "MergePoint"; }
+
+  /**
+   * @brief Checks if a point lies inside the zone.
+   *
+   * @param position The position to check
+   * @return True if the position is inside the zone, false otherwise
+   */
+  bool CheckCollision(const Eigen::Vector2d& position) const override;
+
+  /**
+   * @brief Gets the zone as a JSON object.
+   *
+   * @return JSON with the keys x, y and radius
+   */
+  std::string GetState() const override;
+
+  /**
+   * @brief Loads the zone from a JSON object.
+   *
+   * @param state JSON as produced by GetState(); missing keys keep their value
+   * @return True if the state was successfully loaded, false otherwise
+   */
+  bool LoadState(const std::string& state) override;
+
+  /**
+   * @brief Writes the zone as raw doubles.
+   *
+   * @param writer The writer to append the state to
+   * @return True
+   */
+  bool SaveBinary(BinaryWriter& writer) const override;
+
+  /**
+   * @brief Loads the zone from raw doubles written by SaveBinary().
+   *
+   * @param reader The reader positioned at the state
+   * @return True if the state was read, false if the input is truncated
+   */
+  bool LoadBinary(BinaryReader& reader) override;
+
+  /**
+   * @brief Merge points never block robots.
+   *
+   * @return False
+   */
+  bool IsSolid() const override { return false; }
+
+  /**
+   * @brief Gets the bounding box of the zone.
+   *
+   * @return The bounding box
+   */
+  Eigen::AlignedBox2d GetBounds() const override;
+
+  /**
+   * @brief Gets the center of the zone.
+   *
+   * @return The center position
+   */
+  const Eigen::Vector2d& GetPosition() const { return position_; }
+
+  /**
+   * @brief Gets the radius of the zone.
+   *
+   * @return The radius
+   */
+  double GetRadius() const { return radius_; }
+
+ private:
+  Eigen::Vector2d position_;  ///< The center of the zone
+  double radius_;             ///< The radius of the zone
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstddef>
+#include <vector>
+
+#include "mobile_robot_base.h"
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class MergePoint;
+
+/**
+ * @brief The robots approaching one merge point, as parallel arrays.
+ *
+ * The simulation engine fills one batch per controlled merge point at the
+ * start of every step, with the robots inside the merge point's approach
+ * radius in storage order. Element i of every array describes the same
+ * robot. The strategy writes its result to targetVelocities, which the
+ * engine prefills with the cruise velocities.
+ */
+struct MergeBatch {
+  const MergePoint* mergePoint = nullptr;         ///< The merge point
+  std::vector<RobotHandle> handles;               ///< Robot handles
+  std::vector<Eigen::Vector2d> positions;         ///< Positions at the start of the step
+  std::vector<Eigen::Vector2d> velocities;        ///< Velocities at the start of the step
+  std::vector<Eigen::Vector2d> cruiseVelocities;  ///< Target velocities on entering the approach
+  std::vector<double> distances;                  ///< Distance to the centre along the cruise
+                                                  ///< direction; negative once past it
+  std::vector<Eigen::Vector2d> targetVelocities;  ///< Output: velocity each robot steers towards
+
+  /**
+   * @brief Gets the number of robots in the batch.
+   *
+   * @return The number of robots
+   */
+  size_t size() const { return handles.size(); }
+
+  /**
+   * @brief Removes every robot, keeping the allocated capacity.
+   */
+  void Clear();
+};
+
+/**
+ * @brief Controls the robots approaching a merge point.
+ *
+ * Strategies see every approaching robot of a merge point at once, so they
+ * can share per-merge work such as sorting by arrival time and process the
+ * robots with straight loops over contiguous arrays, rather than deciding
+ * for each robot separately.
+ */
+class MergeStrategy {
+ public:
+  /**
+   * @brief Virtual destructor for proper cleanup of derived classes.
+   */
+  virtual ~MergeStrategy() = default;
+
+  /**
+   * @brief Computes the target velocities of the approaching robots.
+   *
+   * Strategies of different merge points may run concurrently; a strategy
+   * instance is only ever called for its own merge point.
+   *
+   * @param batch The approaching robots; the strategy writes targetVelocities
+   */
+  virtual void ComputeBatch(MergeBatch& batch) = 0;
+};
+
+/**
+ * @brief Lets robots through the merge point one at a time in arrival order.
+ *
+ * Every robot is given a time slot at the centre of the merge point, at
+ * least a fixed headway after the previous robot's, in order of the time
+ * it would arrive at cruise speed. Robots slow down just enough to arrive
+ * in their slot, so two lanes of similar load interleave like a zipper.
+ */
+class ZipperMergeStrategy : public MergeStrategy {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param headway Minimum time between two robots crossing the centre, in seconds
+   */
+  explicit ZipperMergeStrategy(double headway);
+
+  /**
+   * @brief Slows robots down to arrive in order, one headway apart.
+   *
+   * @param batch The approaching robots
+   */
+  void ComputeBatch(MergeBatch& batch) override;
+
+ private:
+  double headway_;             ///< Minimum time between crossings
+  std::vector<size_t> order_;  ///< Robots by arrival time; reused across steps
+};
+
+/**
+ * @brief Gives one direction of travel right of way through the merge point.
+ *
+ * Robots heading within 45 degrees of the priority direction are scheduled
+ * first, in arrival order and one headway apart. The other robots yield:
+ * each takes the earliest slot after its own arrival that keeps a headway
+ * to every slot already taken.
+ */
+class PriorityMergeStrategy : public MergeStrategy {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param priorityDirection Direction of travel of the lane with right of way
+   * @param headway Minimum time between two robots crossing the centre, in seconds
+   */
+  PriorityMergeStrategy(const Eigen::Vector2d& priorityDirection, double headway);
+
+  /**
+   * @brief Schedules the priority lane first and fits the other robots in between.
+   *
+   * @param batch The approaching robots
+   */
+  void ComputeBatch(MergeBatch& batch) override;
+
+ private:
+  Eigen::Vector2d priorityDirection_;  ///< Unit direction of the priority lane
+  double headway_;                     ///< Minimum time between crossings
+  std::vector<size_t> order_;          ///< Robots by arrival time; reused across steps
+  std::vector<double> slots_;          ///< Taken slots, sorted; reused across steps
+};
+
+}  // namespace mobilerobotsim
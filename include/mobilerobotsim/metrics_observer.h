@@ -0,0 +1,323 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include "simulation_observer.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Running mean, variance and range of a stream of values.
+ *
+ * Uses Welford's update, which stays accurate for long streams where the
+ * naive sum of squares cancels catastrophically.
+ */
+class RunningStats {
+ public:
+  /**
+   * @brief Default constructor. Starts empty.
+   */
+  RunningStats();
+
+  /**
+   * @brief Adds a value.
+   *
+   * @param value The value
+   */
+  void Add(double value);
+
+  /**
+   * @brief Removes all values.
+   */
+  void Reset();
+
+  /**
+   * @brief Gets the number of values added.
+   *
+   * @return The count
+   */
+  uint64_t GetCount() const { return count_; }
+
+  /**
+   * @brief Gets the mean, 0 if empty.
+   *
+   * @return The mean
+   */
+  double GetMean() const { return mean_; }
+
+  /**
+   * @brief Gets the sample variance, 0 with fewer than two values.
+   *
+   * @return The variance
+   */
+  double GetVariance() const;
+
+  /**
+   * @brief Gets the smallest value, 0 if empty.
+   *
+   * @return The minimum
+   */
+  double GetMin() const { return count_ > 0 ? min_ : 0.0; }
+
+  /**
+   * @brief Gets the largest value, 0 if empty.
+   *
+   * @return The maximum
+   */
+  double GetMax() const { return count_ > 0 ? max_ : 0.0; }
+
+ private:
+  uint64_t count_;  ///< Number of values
+  double mean_;     ///< Running mean
+  double m2_;       ///< Sum of squared deviations from the mean
+  double min_;      ///< Smallest value
+  double max_;      ///< Largest value
+};
+
+/**
+ * @brief Fixed-size histogram of non-negative values with bounded relative error.
+ *
+ * Buckets are log-linear in the manner of HDR histograms: every power of two
+ * between the lowest and highest tracked value is split into the same number
+ * of linear sub-buckets, so a quantile is accurate to about one part in the
+ * sub-bucket count anywhere in the range. Values below the lowest tracked
+ * value share one bucket, and values above the highest are clamped into the
+ * last one.
+ */
+class LogHistogram {
+ public:
+  /**
+   * @brief Constructor.
+   *
+   * @param lowest Smallest value resolved; positive
+   * @param highest Largest value resolved; greater than lowest
+   * @param subBuckets Linear buckets per power of two
+   */
+  LogHistogram(double lowest, double highest, int subBuckets = 32);
+
+  /**
+   * @brief Adds a value.
+   *
+   * @param value The value; negative values count as zero
+   */
+  void Add(double value);
+
+  /**
+   * @brief Removes all values.
+   */
+  void Reset();
+
+  /**
+   * @brief Gets the number of values added.
+   *
+   * @return The count
+   */
+  uint64_t GetCount() const { return count_; }
+
+  /**
+   * @brief Estimates a quantile.
+   *
+   * @param quantile The quantile in [0, 1], e.g. 0.99
+   * @return The middle of the bucket holding the quantile, or 0 if empty
+   */
+  double GetQuantile(double quantile) const;
+
+ private:
+  /**
+   * @brief Gets the bucket of a value.
+   *
+   * @param value The value
+   * @return The bucket index
+   */
+  size_t BucketOf(double value) const;
+
+  /**
+   * @brief Gets the middle of a bucket.
+   *
+   * @param bucket The bucket index
+   * @return A representative value of the bucket
+   */
+  double BucketMiddle(size_t bucket) const;
+
+  double lowest_;                  ///< Smallest value resolved
+  int subBuckets_;                 ///< Linear buckets per power of two
+  std::vector<uint64_t> buckets_;  ///< Counts; bucket 0 holds values below lowest_
+  uint64_t count_;                 ///< Number of values
+};
+
+/**
+ * @brief Summary of one distribution in a MetricsSnapshot.
+ */
+struct MetricsSummary {
+  uint64_t count = 0;         ///< Number of samples
+  double mean = 0.0;          ///< Mean
+  double deviation = 0.0;     ///< Sample standard deviation
+  double min = 0.0;           ///< Smallest sample
+  double max = 0.0;           ///< Largest sample
+  double median = 0.0;        ///< Estimated 50th percentile
+  double percentile90 = 0.0;  ///< Estimated 90th percentile
+  double percentile99 = 0.0;  ///< Estimated 99th percentile
+};
+
+/**
+ * @brief Counters of one zone in a MetricsSnapshot.
+ */
+struct MetricsZoneCounts {
+  std::string name;            ///< Name of the zone
+  double meanOccupancy = 0.0;  ///< Time-averaged number of robots in the zone
+  uint64_t collisions = 0;     ///< Collisions of robots in the zone
+  uint64_t mergeArrivals = 0;  ///< Merge points reached by robots in the zone
+};
+
+/**
+ * @brief Metrics collected by a MetricsObserver up to some time.
+ */
+struct MetricsSnapshot {
+  double time = 0.0;                     ///< Simulation time of the snapshot
+  double elapsed = 0.0;                  ///< Simulation time covered by the metrics
+  uint64_t steps = 0;                    ///< Steps observed
+  size_t robots = 0;                     ///< Robots in the last step
+  uint64_t mergeArrivals = 0;            ///< Merge points reached
+  double throughput = 0.0;               ///< Merge points reached per second
+  uint64_t collisions = 0;               ///< Collisions reported
+  double collisionRate = 0.0;            ///< Collisions per robot-second
+  MetricsSummary speed;                  ///< Robot speeds, one sample per robot and step
+  MetricsSummary mergeWait;              ///< Time spent stopped before reaching a merge point
+  std::vector<MetricsZoneCounts> zones;  ///< Per-zone counters, in the order added
+
+  /**
+   * @brief Writes the snapshot as a JSON object.
+   *
+   * @param stream The stream to write to
+   * @return True if the stream is still good, false otherwise
+   */
+  bool WriteJson(std::ostream& stream) const;
+};
+
+/**
+ * @brief Observer that keeps streaming statistics of a running simulation.
+ *
+ * Replaces computing metrics afterwards from state dumps: throughput,
+ * collision rates, speed and merge wait distributions and per-zone counters
+ * are updated as events arrive, in memory that does not grow with the
+ * simulated time. Distributions keep a RunningStats and a LogHistogram
+ * each; only the stopped time of live robots is tracked per robot, indexed
+ * by handle slot.
+ *
+ * A robot waits while its speed is below the stopped speed; the time it has
+ * waited since its last merge point is recorded when it reaches the next
+ * one. Snapshots can be taken at any time with GetSnapshot() or delivered
+ * periodically in simulation time with SetSnapshotInterval().
+ */
+class MetricsObserver : public SimulationObserver {
+ public:
+  /**
+   * @brief Called with each periodic snapshot.
+   */
+  using SnapshotCallback = std::function<void(const MetricsSnapshot& snapshot)>;
+
+  /**
+   * @brief Default constructor. Starts at simulation time 0.
+   */
+  MetricsObserver();
+
+  /**
+   * @brief Adds a zone whose robots are counted separately.
+   *
+   * @param name Name of the zone in snapshots
+   * @param region Region of the zone
+   * @return Index of the zone
+   */
+  size_t AddZone(const std::string& name, const Eigen::AlignedBox2d& region);
+
+  /**
+   * @brief Sets the speed below which a robot counts as waiting.
+   *
+   * @param speed Speed in m/s; 0.1 by default
+   */
+  void SetStoppedSpeed(double speed);
+
+  /**
+   * @brief Delivers a snapshot whenever the simulation time passes a multiple of an interval.
+   *
+   * @param interval Interval in simulation seconds; 0 disables periodic snapshots
+   * @param callback Called with each snapshot from the stepping thread
+   */
+  void SetSnapshotInterval(double interval, SnapshotCallback callback);
+
+  /**
+   * @brief Clears all metrics; zones and settings are kept.
+   *
+   * @param time Simulation time from which metrics are collected
+   */
+  void Reset(double time = 0.0);
+
+  /**
+   * @brief Takes a snapshot of the metrics so far.
+   *
+   * @return The snapshot
+   */
+  MetricsSnapshot GetSnapshot() const;
+
+  void OnStep(const SystemState& state) override;
+
+  void OnCollision(const MobileRobotBase* robot, const void* object) override;
+
+  void OnMergePoint(const MobileRobotBase* robot, const EnvironmentElement* mergePoint) override;
+
+ private:
+  /**
+   * @brief Stopped time of the robot in one handle slot.
+   */
+  struct RobotWait {
+    uint32_t generation = 0;  ///< Generation of the robot the entry belongs to
+    double stopped = 0.0;     ///< Time stopped since its last merge point
+  };
+
+  /**
+   * @brief A zone and its counters.
+   */
+  struct Zone {
+    std::string name;            ///< Name of the zone
+    Eigen::AlignedBox2d region;  ///< Region of the zone
+    double occupancy = 0.0;      ///< Integral of the robot count over time
+    uint64_t collisions = 0;     ///< Collisions in the zone
+    uint64_t mergeArrivals = 0;  ///< Merge points reached in the zone
+  };
+
+  /**
+   * @brief Gets the wait entry of a robot, resetting it if it belonged to an earlier robot.
+   *
+   * @param index Slot index of the robot's handle
+   * @param generation Generation of the robot's handle
+   * @return The entry
+   */
+  RobotWait& WaitOf(uint32_t index, uint32_t generation);
+
+  double startTime_;                   ///< Time metrics are collected from
+  double time_;                        ///< Time of the last step
+  uint64_t steps_;                     ///< Steps observed
+  size_t robots_;                      ///< Robots in the last step
+  double robotSeconds_;                ///< Integral of the robot count over time
+  uint64_t mergeArrivals_;             ///< Merge points reached
+  uint64_t collisions_;                ///< Collisions reported
+  double stoppedSpeed_;                ///< Speed below which robots wait
+  RunningStats speedStats_;            ///< Robot speeds
+  LogHistogram speedHistogram_;        ///< Robot speeds
+  RunningStats waitStats_;             ///< Merge wait times
+  LogHistogram waitHistogram_;         ///< Merge wait times
+  std::vector<RobotWait> waits_;       ///< Stopped time per handle slot
+  std::vector<Zone> zones_;            ///< Zones and their counters
+  double snapshotInterval_;            ///< Interval of periodic snapshots; 0 if disabled
+  double nextSnapshot_;                ///< Time of the next periodic snapshot
+  SnapshotCallback snapshotCallback_;  ///< Receives periodic snapshots
+};
+
+}  // namespace mobilerobotsim
@@ -1,13 +1,21 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <functional>
 #include <memory>
 
+#include "counter_rng.h"
+#include "slot_map.h"
+
 namespace mobilerobotsim {
 
 // Forward declarations
+class FleetView;
 class RobotState;
 
+/// Stable handle of a robot in a SimulationEngine
+using RobotHandle = SlotHandle;
+
 /**
  * @brief Abstract base class for mobile robots.
  *
@@ -31,7 +39,44 @@ class MobileRobotBase {
    *
    * @param dt Time step size in seconds
    */
-  virtual void updateState(double dt) = 0;
+  virtual void UpdateState(double dt) = 0;
+
+  /**
+   * @brief Updates the robot's state with access to the rest of the fleet.
+   *
+   * This is the method the simulation engine calls. Robots whose control
+   * depends on their neighbours override it and read the neighbours from
+   * the fleet view, which holds every robot as it was at the start of the
+   * step; they must not read other robots directly, since those are updated
+   * concurrently. The default ignores the fleet and calls UpdateState(dt).
+   *
+   * @param dt Time step size in seconds
+   * @param fleet The fleet at the start of the step
+   */
+  virtual void UpdateState(double dt, const FleetView& /*fleet*/) { UpdateState(dt); }
+
+  /**
+   * @brief Advances the robot by an arbitrary duration in closed form.
+   *
+   * Robots whose motion between commands is analytically solvable implement
+   * this so that SimulationEngine::AdvanceTo() can jump over long intervals
+   * in a single step. The default has no closed form and returns false, in
+   * which case the engine integrates with UpdateState() instead.
+   *
+   * @param duration Time to advance in seconds
+   * @return True if the robot was advanced, false if it has no closed form
+   */
+  virtual bool Advance(double /*duration*/) { return false; }
+
+  /**
+   * @brief Gets an upper bound on the robot's speed until its next command.
+   *
+   * SimulationEngine::AdvanceTo() divides clearances by this bound to find
+   * how far it can jump without missing a collision or zone entry.
+   *
+   * @return The speed bound in m/s, or infinity if the robot cannot bound it
+   */
+  virtual double GetSpeedBound() const;
 
   /**
    * @brief Returns the current state of the robot.
@@ -43,7 +88,7 @@ class MobileRobotBase {
    *
    * @return A unique pointer to a RobotState object representing the current state
    */
-  [[nodiscard]] virtual std::unique_ptr<RobotState> getState() const = 0;
+  [[nodiscard]] virtual std::unique_ptr<RobotState> GetState() const = 0;
 
   /**
    * @brief Loads a previously saved state.
@@ -55,7 +100,117 @@ class MobileRobotBase {
    * @param state The state to load
    * @return True if the state was successfully loaded, false otherwise
    */
-  virtual bool loadState(const RobotState& state) = 0;
+  virtual bool LoadState(const RobotState& state) = 0;
+
+  /**
+   * @brief Gets the current position of the robot.
+   *
+   * The simulation engine uses the position for collision and merge point
+   * detection.
+   *
+   * @return The position in world coordinates
+   */
+  virtual Eigen::Vector2d GetPosition() const = 0;
+
+  /**
+   * @brief Gets the current velocity of the robot.
+   *
+   * @return The velocity in world coordinates
+   */
+  virtual Eigen::Vector2d GetVelocity() const = 0;
+
+  /**
+   * @brief Gets the current orientation of the robot.
+   *
+   * The default suits robots without a heading.
+   *
+   * @return The orientation in radians
+   */
+  virtual double GetOrientation() const { return 0.0; }
+
+  /**
+   * @brief Gets the velocity the robot is steering towards.
+   *
+   * Merge strategies treat it as the robot's cruising velocity. The default
+   * is the current velocity.
+   *
+   * @return The target velocity in world coordinates
+   */
+  virtual Eigen::Vector2d GetTargetVelocity() const { return GetVelocity(); }
+
+  /**
+   * @brief Sets the velocity the robot should steer towards.
+   *
+   * The simulation engine uses this to apply the target velocities computed
+   * by merge strategies. The default does not accept velocity commands.
+   *
+   * @param velocity The target velocity in world coordinates
+   * @return True if the robot accepted the command, false otherwise
+   */
+  virtual bool SetTargetVelocity(const Eigen::Vector2d& /*velocity*/) { return false; }
+
+  /**
+   * @brief Assigns the random stream the robot draws its noise from.
+   *
+   * The simulation engine gives every robot its own stream derived from the
+   * simulation seed and the robot's id. Robots must not use any other source
+   * of randomness, so that results do not depend on how robots are spread
+   * across threads.
+   *
+   * @param rng The robot's random stream
+   */
+  virtual void SetRandomStream(const CounterRng& /*rng*/) {}
+
+  /**
+   * @brief Checks whether the robot is idle and will stay idle until commanded.
+   *
+   * The simulation engine puts robots at rest to sleep and stops updating
+   * them until they are woken. Robots that return true must not change
+   * their state in UpdateState() while at rest.
+   *
+   * @return True if the robot is at rest, false otherwise
+   */
+  virtual bool IsAtRest() const { return false; }
+
+  /**
+   * @brief Checks whether the simulation engine has put the robot to sleep.
+   *
+   * @return True if the robot is sleeping, false otherwise
+   */
+  bool IsSleeping() const { return sleeping_; }
+
+  /**
+   * @brief Marks the robot as sleeping or awake. Managed by the simulation engine.
+   *
+   * @param sleeping Whether the robot is sleeping
+   */
+  void SetSleeping(bool sleeping) { sleeping_ = sleeping; }
+
+  /**
+   * @brief Gets the handle the simulation engine issued for the robot.
+   *
+   * Observers use it to identify robots independently of their position in
+   * the engine's storage.
+   *
+   * @return The handle, or an invalid handle if the robot was never added
+   */
+  RobotHandle GetHandle() const { return handle_; }
+
+  /**
+   * @brief Sets the robot's handle. Managed by the simulation engine.
+   *
+   * @param handle The handle
+   */
+  void SetHandle(const RobotHandle& handle) { handle_ = handle; }
+
+  /**
+   * @brief Sets the function called when a sleeping robot receives a command.
+   *
+   * Managed by the simulation engine.
+   *
+   * @param callback The wake function
+   */
+  void SetWakeCallback(std::function<void()> callback);
 
  protected:
   /**
@@ -65,6 +220,19 @@ class MobileRobotBase {
    * Derived classes should call this constructor from their own constructors.
    */
   MobileRobotBase() = default;
+
+  /**
+   * @brief Asks the simulation engine to wake the robot if it is sleeping.
+   *
+   * Derived classes call this whenever a command or state change may end
+   * the robot's rest, e.g. a new target velocity.
+   */
+  void RequestWake();
+
+ private:
+  bool sleeping_ = false;               ///< Whether the engine put the robot to sleep
+  RobotHandle handle_;                  ///< Handle issued by the engine
+  std::function<void()> wakeCallback_;  ///< Called by RequestWake() while sleeping
 };
 
 }  // namespace mobilerobotsim
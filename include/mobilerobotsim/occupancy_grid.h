@@ -0,0 +1,298 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "environment.h"
+#include "mapped_file.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Static raster map stored as a bit-packed occupancy grid.
+ *
+ * OccupancyGrid stores one bit per cell, row-major with each row padded to a
+ * whole number of 64-bit words, so a point lookup is a shift and a mask. An
+ * optional pyramid of mip levels stores, per coarser cell, whether any of the
+ * 2x2 finer cells below it is occupied; region queries descend the pyramid and
+ * skip empty space.
+ *
+ * Cell (0, 0) is the lower-left cell and its lower-left corner sits at the
+ * grid origin. Maps can be loaded from binary PGM images or from the packed
+ * raw format written by SaveRaw(). Raw files are memory mapped and used in
+ * place, so even very large maps load in constant time and only the pages that
+ * queries touch become resident.
+ */
+class OccupancyGrid : public EnvironmentElement {
+ public:
+  /**
+   * @brief Default constructor. Creates an empty grid.
+   */
+  OccupancyGrid();
+
+  /**
+   * @brief Constructor for an all-free grid.
+   *
+   * @param width Number of columns
+   * @param height Number of rows
+   * @param resolution Cell edge length in meters
+   * @param origin World position of the lower-left corner of cell (0, 0)
+   */
+  OccupancyGrid(int width, int height, double resolution, const Eigen::Vector2d& origin);
+
+  /**
+   * @brief Destructor.
+   */
+  ~OccupancyGrid() override;
+
+  /**
+   * @brief Loads a binary (P5) PGM image.
+   *
+   * Dark pixels are occupied. The image is mapped and packed to one bit per
+   * cell in a single pass, after which the mapping is released. The first
+   * image row is the top of the map.
+   *
+   * @param path The PGM file
+   * @param resolution Cell edge length in meters
+   * @param origin World position of the lower-left corner of the map
+   * @param occupiedThreshold Darkness in [0, 1] at or above which a cell is occupied
+   * @return True if the image was loaded, false otherwise
+   */
+  bool LoadPgm(const std::string& path, double resolution, const Eigen::Vector2d& origin,
+               double occupiedThreshold = 0.65);
+
+  /**
+   * @brief Samples the static elements of an environment into the grid.
+   *
+   * A cell is occupied if its center collides with a static element. The grid
+   * replaces any previous contents and has no mip levels until
+   * BuildMipLevels() is called.
+   *
+   * @param environment The environment to sample
+   * @param region The world region to cover
+   * @param resolution Cell edge length in meters
+   * @return True if the grid was built, false if the region or resolution is invalid
+   */
+  bool Rasterize(const Environment& environment, const Eigen::AlignedBox2d& region,
+                 double resolution);
+
+  /**
+   * @brief Maps a packed raw grid written by SaveRaw().
+   *
+   * The bits, including any saved mip levels, are used directly from the
+   * mapping without copying.
+   *
+   * @param path The raw file
+   * @return True if the file was mapped, false otherwise
+   */
+  bool LoadRaw(const std::string& path);
+
+  /**
+   * @brief Writes the grid and its mip levels in the packed raw format.
+   *
+   * @param path The raw file
+   * @return True if the file was written, false otherwise
+   */
+  bool SaveRaw(const std::string& path) const;
+
+  /**
+   * @brief Builds the mip pyramid used by AnyOccupied().
+   */
+  void BuildMipLevels();
+
+  /**
+   * @brief Gets the number of levels, including the full-resolution level.
+   *
+   * @return The number of levels
+   */
+  size_t GetLevelCount() const { return levels_.size(); }
+
+  /**
+   * @brief Marks a cell as occupied or free.
+   *
+   * Modifying a mapped grid copies it into memory first. Mip levels are
+   * discarded and must be rebuilt.
+   *
+   * @param x Column index
+   * @param y Row index
+   * @param occupied Whether the cell is occupied
+   */
+  void SetOccupied(int x, int y, bool occupied);
+
+  /**
+   * @brief Checks whether a cell is occupied.
+   *
+   * @param x Column index
+   * @param y Row index
+   * @return True if the cell is occupied; cells outside the grid are free
+   */
+  bool IsOccupied(int x, int y) const;
+
+  /**
+   * @brief Checks whether the cell containing a world position is occupied.
+   *
+   * @param position The world position
+   * @return True if the cell is occupied; positions outside the grid are free
+   */
+  bool IsOccupiedAt(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Checks whether any cell overlapping a world region is occupied.
+   *
+   * @param region The world region
+   * @return True if any overlapping cell is occupied, false otherwise
+   */
+  bool AnyOccupied(const Eigen::AlignedBox2d& region) const;
+
+  /**
+   * @brief Converts a world position to cell indices.
+   *
+   * @param position The world position
+   * @param x Output parameter for the column index
+   * @param y Output parameter for the row index
+   */
+  void WorldToCell(const Eigen::Vector2d& position, int& x, int& y) const;
+
+  /**
+   * @brief Gets the number of columns.
+   *
+   * @return The grid width in cells
+   */
+  int GetWidth() const { return width_; }
+
+  /**
+   * @brief Gets the number of rows.
+   *
+   * @return The grid height in cells
+   */
+  int GetHeight() const { return height_; }
+
+  /**
+   * @brief Gets the cell edge length.
+   *
+   * @return The resolution in meters
+   */
+  double GetResolution() const { return resolution_; }
+
+  /**
+   * @brief Gets the world position of the lower-left corner of cell (0, 0).
+   *
+   * @return The grid origin
+   */
+  const Eigen::Vector2d& GetOrigin() const { return origin_; }
+
+  /**
+   * @brief Gets the file the grid was loaded from.
+   *
+   * @return The source path, or an empty string if the grid was not loaded from a file
+   */
+  const std::string& GetSource() const { return source_; }
+
+  /**
+   * @brief Checks whether the grid bits are used in place from a mapped file.
+   *
+   * @return True if the grid is memory mapped, false otherwise
+   */
+  bool IsMapped() const { return file_.IsOpen(); }
+
+  /**
+   * @brief Gets the type identifier of the element.
+   *
+   * @return "OccupancyGrid"
+   */
+  std::string GetTypeId() const override { return "OccupancyGrid"; }
+
+  /**
+   * @brief Checks if a point lies in an occupied cell.
+   *
+   * @param position The position to check for collision
+   * @return True if the position is in an occupied cell, false otherwise
+   */
+  bool CheckCollision(const Eigen::Vector2d& position) const override;
+
+  /**
+   * @brief Gets the grid metadata as a JSON object.
+   *
+   * The cell bits are not part of the state; they are identified by the
+   * source file the grid was loaded from.
+   *
+   * @return JSON with the grid dimensions, resolution, origin and source
+   */
+  std::string GetState() const override;
+
+  /**
+   * @brief Loads the grid from the source named in a state object.
+   *
+   * A file-backed map is only reloaded if the source or layout differs. The
+   * state of an in-memory grid carries no cells: it is accepted if it matches
+   * the current layout, keeping the cells, or by an empty grid, which becomes
+   * an all-free grid of the saved size.
+   *
+   * @param state JSON as produced by GetState()
+   * @return True if the state was successfully loaded, false if it is invalid or
+   *         describes an in-memory grid of a different layout
+   */
+  bool LoadState(const std::string& state) override;
+
+  /**
+   * @brief Hashes the state and the full-resolution cells.
+   *
+   * The cells are not part of GetState(), so a map edited in place or a grid
+   * built in memory would otherwise hash like the grid it replaced.
+   *
+   * @param hash The hash to continue
+   * @return The updated hash
+   */
+  uint64_t HashContent(uint64_t hash) const override;
+
+  /**
+   * @brief Gets the world-space extent of the grid.
+   *
+   * @return The bounding box, or an empty box for an empty grid
+   */
+  Eigen::AlignedBox2d GetBounds() const override;
+
+ private:
+  struct Level {
+    int width;           ///< Number of columns at this level
+    int height;          ///< Number of rows at this level
+    size_t wordsPerRow;  ///< Row stride in 64-bit words
+    size_t offset;       ///< Offset of the level's first word from words_
+  };
+
+  /// Resets the grid to the given dimensions with every cell free
+  void Allocate(int width, int height);
+
+  /// Appends the level layout for a grid of the given size, returning its word count
+  static size_t AppendLevel(std::vector<Level>& levels, int width, int height);
+
+  /// Copies mapped bits into owned storage so they can be modified
+  void MakeOwned();
+
+  /// Checks a cell at the given level
+  bool TestCell(const Level& level, int x, int y) const;
+
+  /// Inclusive range of cell indices
+  struct CellRange {
+    int x0, y0, x1, y1;
+  };
+
+  /// Recursive helper for AnyOccupied(); query is the range at full resolution
+  bool AnyOccupiedInLevel(size_t level, const CellRange& cells, const CellRange& query) const;
+
+  int width_;                      ///< Number of columns
+  int height_;                     ///< Number of rows
+  double resolution_;              ///< Cell edge length in meters
+  Eigen::Vector2d origin_;         ///< Lower-left corner of cell (0, 0)
+  std::vector<Level> levels_;      ///< Level 0 is full resolution, then coarser mips
+  const uint64_t* words_;          ///< Start of the level storage, owned or mapped
+  std::vector<uint64_t> owned_;    ///< Storage for all levels when not mapped
+  MappedFile file_;                ///< Mapping backing the levels when loaded raw
+  std::string source_;             ///< File the grid was loaded from, if any
+  std::string sourceFormat_;       ///< "pgm" or "raw"
+  double occupiedThreshold_;       ///< Threshold used when the source is a PGM
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <memory>
+#include <vector>
+
+#include "environment.h"
+#include "occupancy_grid.h"
+#include "thread_pool.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Configuration of a simulated planar range sensor.
+ */
+struct RangeSensorConfig {
+  int beamCount = 360;                        ///< Number of beams per scan
+  double minAngle = -3.14159265358979323846;  ///< First beam angle relative to the heading
+  double maxAngle = 3.14159265358979323846;   ///< End of the scanned interval, exclusive
+  double maxRange = 30.0;                     ///< Range reported for beams that hit nothing
+};
+
+/**
+ * @brief Simulated 2D range sensor (lidar) for a batch of robots.
+ *
+ * RangeSensor casts every beam of every robot in one call and writes the
+ * ranges into a contiguous, robot-major float buffer that is reused between
+ * scans. Beams evenly cover [minAngle, maxAngle) relative to each robot's
+ * heading.
+ *
+ * Static geometry is rasterized once into an occupancy grid and traversed per
+ * beam with a grid DDA; robots whose sensing window holds no occupied cell
+ * skip the traversal using the grid's mip levels. Dynamic elements are
+ * intersected analytically as circles, with the inner loop running over all
+ * beams of a robot on plain float arrays so that it vectorizes. DynamicObstacle
+ * elements are exact; other dynamic elements are approximated by the circle
+ * around their bounds. Robots are split across the sensor's threads.
+ */
+class RangeSensor {
+ public:
+  /**
+   * @brief Constructor with configuration.
+   *
+   * @param config The sensor configuration
+   * @param threadCount Number of threads used by Scan(), or zero for the
+   *                    number of hardware threads
+   */
+  explicit RangeSensor(const RangeSensorConfig& config, size_t threadCount = 1);
+
+  /**
+   * @brief Destructor.
+   */
+  ~RangeSensor();
+
+  /**
+   * @brief Rasterizes the static elements of an environment as the static map.
+   *
+   * @param environment The environment whose static elements are obstacles
+   * @param region The world region to cover
+   * @param resolution Cell edge length in meters
+   * @return True if the map was built, false otherwise
+   */
+  bool BuildStaticMap(const Environment& environment, const Eigen::AlignedBox2d& region,
+                      double resolution);
+
+  /**
+   * @brief Uses an existing grid as the static map.
+   *
+   * The grid is not copied and must outlive the sensor. Build its mip levels
+   * first so that robots in open space can skip the traversal.
+   *
+   * @param grid The grid, or nullptr to scan without static geometry
+   */
+  void SetStaticMap(const OccupancyGrid* grid);
+
+  /**
+   * @brief Preallocates the scan buffer.
+   *
+   * @param robotCount The number of robots to reserve scans for
+   */
+  void Reserve(size_t robotCount);
+
+  /**
+   * @brief Scans from a batch of poses.
+   *
+   * @param environment The environment providing the dynamic elements
+   * @param poses One column (x, y, heading) per robot
+   */
+  void Scan(const Environment& environment, const Eigen::Matrix3Xd& poses);
+
+  /**
+   * @brief Gets the ranges of one robot from the last scan.
+   *
+   * @param robot Index of the robot's pose column
+   * @return Pointer to beamCount ranges in meters
+   */
+  const float* GetScan(size_t robot) const {
+    return ranges_.data() + robot * static_cast<size_t>(config_.beamCount);
+  }
+
+  /**
+   * @brief Gets the ranges of all robots from the last scan, robot-major.
+   *
+   * @return The range buffer
+   */
+  const std::vector<float>& GetRanges() const { return ranges_; }
+
+  /**
+   * @brief Gets the number of robots in the last scan.
+   *
+   * @return The number of scans in the buffer
+   */
+  size_t GetScanCount() const { return scanCount_; }
+
+  /**
+   * @brief Gets the angle of a beam relative to the robot heading.
+   *
+   * @param beam The beam index
+   * @return The beam angle in radians
+   */
+  double GetBeamAngle(int beam) const;
+
+  /**
+   * @brief Gets the sensor configuration.
+   *
+   * @return The configuration
+   */
+  const RangeSensorConfig& GetConfig() const { return config_; }
+
+ private:
+  /// Per-thread working arrays, sized once and reused across scans
+  struct Scratch {
+    std::vector<float> directionX;  ///< World beam directions of the current robot
+    std::vector<float> directionY;
+    std::vector<float> circleX;     ///< Dynamic circles near the current robot
+    std::vector<float> circleY;
+    std::vector<float> circleRadius;
+  };
+
+  /// Scans one robot into its slot of the buffer
+  void ScanRobot(const Environment& environment, const Eigen::Vector3d& pose, Scratch& scratch,
+                 float* ranges) const;
+
+  /// Casts one beam through the static map, returning the hit distance or maxRange
+  float CastStatic(const Eigen::Vector2d& origin, double directionX, double directionY) const;
+
+  RangeSensorConfig config_;                 ///< Sensor configuration
+  std::vector<float> beamCos_;               ///< Beam directions relative to the heading
+  std::vector<float> beamSin_;
+  std::unique_ptr<OccupancyGrid> ownedMap_;  ///< Map built by BuildStaticMap()
+  const OccupancyGrid* map_;                 ///< Static map in use, owned or borrowed
+  std::vector<float> ranges_;                ///< Robot-major scan buffer
+  size_t scanCount_;                         ///< Number of robots in the last scan
+  ThreadPool pool_;                          ///< Threads scans are split across
+  std::vector<Scratch> scratch_;             ///< One working set per thread
+};
+
+}  // namespace mobilerobotsim
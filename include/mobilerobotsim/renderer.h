@@ -1,6 +1,18 @@
 #pragma once
 
+#include <Eigen/Geometry>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "simulation_observer.h"
+#include "slot_map.h"
 
 namespace mobilerobotsim {
 
@@ -8,91 +20,385 @@ namespace mobilerobotsim {
 class SystemState;
 class MobileRobotBase;
 class EnvironmentElement;
+class Environment;
 
 /**
- * @brief Interface for renderer components.
- * 
- * Renderer is an implementation of the SimulationObserver interface
- * that visualizes the simulation state. It provides methods for
- * initialization, rendering, and cleanup.
+ * @brief An 8-bit RGB image.
+ */
+struct RgbImage {
+  int width = 0;                ///< Width in pixels
+  int height = 0;               ///< Height in pixels
+  std::vector<uint8_t> pixels;  ///< Rows top to bottom, three bytes per pixel
+
+  /**
+   * @brief Resizes the image; the contents are unspecified afterwards.
+   *
+   * @param newWidth Width in pixels
+   * @param newHeight Height in pixels
+   */
+  void Resize(int newWidth, int newHeight);
+
+  /**
+   * @brief Gets a pixel.
+   *
+   * @param x Column, from the left
+   * @param y Row, from the top
+   * @return The RGB bytes of the pixel
+   */
+  const uint8_t* At(int x, int y) const { return &pixels[(size_t(y) * width + x) * 3]; }
+
+  /**
+   * @brief Writes the image as a binary PPM (P6) file.
+   *
+   * @param path The file to write
+   * @return True if the file was written, false otherwise
+   */
+  bool WritePpm(const std::string& path) const;
+
+  /**
+   * @brief Writes the image as an uncompressed PNG file.
+   *
+   * The image data is stored in deflate blocks without compression, which
+   * every PNG reader accepts and which costs no more than a copy to write.
+   *
+   * @param path The file to write
+   * @return True if the file was written, false otherwise
+   */
+  bool WritePng(const std::string& path) const;
+};
+
+/**
+ * @brief Headless software renderer.
+ *
+ * Renderer draws robots and environment elements into an RgbImage on the
+ * CPU and writes the frames to image files. As a SimulationObserver it
+ * keeps the simulation thread's share of the work small: OnStep() only
+ * copies robot poses and element shapes into a frame, and a background
+ * thread draws and writes it. Frames are handed over through three
+ * buffers, one being filled, one ready and one being drawn, so the
+ * simulation never waits for the renderer; if the renderer falls behind,
+ * the ready frame is replaced by the newer one and counted as dropped.
+ *
+ * Only every n-th step is captured (see SetFrameInterval()). Static
+ * elements are captured again only when the environment's revision
+ * changes, and drawn into a cached background that each frame starts from.
+ * Robots that collided since the previous frame are drawn in red.
+ *
+ * With a camera (see SetCamera()) or a viewport, a frame holds only what is
+ * visible: elements are looked up through the environment's spatial
+ * indices for the visible region, and robots outside it are skipped while
+ * capturing. Robots smaller than a pixel or so are not drawn one by one but
+ * counted into density tiles, and occupancy grids are sampled at most once
+ * per pixel, so the cost of drawing depends on the image rather than on the
+ * size of the fleet or the map.
  */
 class Renderer : public SimulationObserver {
  public:
+  /// File format of written frames
+  enum class ImageFormat { kPpm, kPng };
+
+  /**
+   * @brief What the image shows: a point of the world and a zoom.
+   */
+  struct Camera {
+    Eigen::Vector2d center = Eigen::Vector2d::Zero();  ///< World point at the image centre
+    double pixelsPerMetre = 0.0;                       ///< Zoom; zero to use the viewport
+  };
+
+  /**
+   * @brief Counts of the most recent capture.
+   */
+  struct CaptureStats {
+    size_t robotsDrawn = 0;       ///< Robots drawn individually
+    size_t robotsAggregated = 0;  ///< Robots counted into density tiles
+    size_t robotsCulled = 0;      ///< Robots outside the image
+    size_t shapes = 0;            ///< Element shapes captured, static and dynamic
+  };
+
   /**
-   * @brief Default constructor.
+   * @brief Default constructor. Draws robots only.
    */
   Renderer();
 
   /**
-   * @brief Destructor.
+   * @brief Constructor with the environment to draw.
+   *
+   * @param environment The environment, e.g. SimulationEngine::GetEnvironment();
+   *        only read from OnStep() and Render(), on the caller's thread
+   */
+  explicit Renderer(const Environment* environment);
+
+  /**
+   * @brief Destructor. Draws the pending frame, then stops the background thread.
    */
   ~Renderer() override;
-  
+
+  Renderer(const Renderer&) = delete;
+  Renderer& operator=(const Renderer&) = delete;
+
   /**
-   * @brief Called when a simulation step is completed.
-   * 
-   * This method is invoked by the SimulationEngine after each simulation step
-   * is completed, triggering a rendering update.
-   * 
+   * @brief Captures the step and hands it to the background thread.
+   *
+   * Only called for steps NeedsStepState() asked for. Starts the background
+   * thread on first use.
+   *
    * @param state Reference to the current state of the simulation
    */
-  void onStep(const SystemState& state) override;
+  void OnStep(const SystemState& state) override;
+
+  /**
+   * @brief Counts the step and asks for its state only if it is captured.
+   *
+   * @return True every n-th step, false otherwise
+   */
+  bool NeedsStepState() override;
 
   /**
-   * @brief Called when a collision is detected.
-   * 
-   * This method is invoked when a collision is detected, allowing
-   * the renderer to visualize the collision.
-   * 
+   * @brief Marks the robot for drawing in red in the next captured frame.
+   *
    * @param robot Pointer to the robot involved in the collision
    * @param object Pointer to the object involved in the collision
    */
-  void onCollision(const MobileRobotBase* robot, 
+  void OnCollision(const MobileRobotBase* robot,
                  const void* object) override;
 
   /**
-   * @brief Called when a robot reaches a merge point.
-   * 
-   * This method is invoked when a robot reaches a designated merge point,
-   * allowing the renderer to visualize the merge event.
-   * 
+   * @brief Called when a robot reaches a merge point. Not visualized.
+   *
    * @param robot Pointer to the robot that reached the merge point
    * @param mergePoint Pointer to the merge point that was reached
    */
-  void onMergePoint(const MobileRobotBase* robot, 
+  void OnMergePoint(const MobileRobotBase* robot,
                    const EnvironmentElement* mergePoint) override;
-  
-  /**
-   * @brief Initializes the renderer.
-   * 
-   * This method sets up the rendering environment, such as
-   * creating a window, initializing graphics libraries, etc.
-   * 
-   * @return True if initialization was successful, false otherwise
-   */
-  bool initialize();
-  
-  /**
-   * @brief Renders the current simulation state.
-   * 
-   * This method visualizes the current state of the simulation,
-   * including robots, environment elements, and other visual elements.
-   * 
+
+  /**
+   * @brief Starts the background thread.
+   *
+   * @return True if the renderer is running
+   */
+  bool Initialize();
+
+  /**
+   * @brief Draws a state immediately on the calling thread.
+   *
+   * Bypasses the background thread and writes no file.
+   *
    * @param state The state to render
+   * @return The image
    */
-  void render(const SystemState& state);
-  
+  RgbImage Render(const SystemState& state);
+
+  /**
+   * @brief Draws the pending frame and stops the background thread.
+   */
+  void Shutdown();
+
+  /**
+   * @brief Waits until the background thread has drawn every captured frame.
+   */
+  void Flush();
+
+  /**
+   * @brief Sets the image size. Defaults to 800 x 600.
+   *
+   * @param width Width in pixels
+   * @param height Height in pixels
+   */
+  void SetImageSize(int width, int height);
+
+  /**
+   * @brief Sets the region of the world shown, scaled uniformly and centred.
+   *
+   * Clears the camera. By default each frame is fitted to its robots and
+   * elements, which captures all of them.
+   *
+   * @param region The region, or an empty box to fit each frame
+   */
+  void SetViewport(const Eigen::AlignedBox2d& region);
+
   /**
-   * @brief Shuts down the renderer.
-   * 
-   * This method cleans up resources used by the renderer,
-   * such as closing windows, releasing graphics resources, etc.
+   * @brief Sets the camera. Takes precedence over the viewport.
+   *
+   * @param camera The camera; a zoom of zero falls back to the viewport
    */
-  void shutdown();
-  
+  void SetCamera(const Camera& camera);
+
+  /**
+   * @brief Gets the camera.
+   *
+   * @return The camera
+   */
+  Camera GetCamera() const;
+
+  /**
+   * @brief Sets the size below which robots are aggregated into density tiles.
+   *
+   * Robots drawn with a radius of fewer pixels than this are counted per
+   * tile, and each tile is shaded by its count. Robots that collided are
+   * always drawn individually.
+   *
+   * @param radiusPixels Drawn radius in pixels; zero draws every robot. Defaults to 1.
+   * @param tilePixels Tile edge length in pixels; at least one. Defaults to 4.
+   */
+  void SetDensityThreshold(double radiusPixels, int tilePixels);
+
+  /**
+   * @brief Captures only every n-th step.
+   *
+   * @param steps The frame interval in steps; at least one. Defaults to 1.
+   */
+  void SetFrameInterval(size_t steps);
+
+  /**
+   * @brief Sets the radius robots are drawn with. Defaults to 0.25 m.
+   *
+   * Robots are at least two pixels wide regardless.
+   *
+   * @param radius Radius in metres
+   */
+  void SetRobotRadius(double radius);
+
+  /**
+   * @brief Writes each frame drawn by the background thread to a file.
+   *
+   * Files are named by the prefix and the zero-padded step number, e.g.
+   * "frames/step_000120.png".
+   *
+   * @param prefix Path prefix, or an empty string to write no files
+   * @param format The file format
+   */
+  void SetOutput(const std::string& prefix, ImageFormat format);
+
+  /**
+   * @brief Gets the number of frames drawn by the background thread.
+   *
+   * @return The number of frames
+   */
+  uint64_t GetFramesRendered() const;
+
+  /**
+   * @brief Gets the number of captured frames replaced before they were drawn.
+   *
+   * @return The number of frames
+   */
+  uint64_t GetFramesDropped() const;
+
+  /**
+   * @brief Gets a copy of the image the background thread drew last.
+   *
+   * @return The image; empty before the first frame
+   */
+  RgbImage GetLastImage() const;
+
+  /**
+   * @brief Gets the counts of the most recent capture, by OnStep() or Render().
+   *
+   * @return The counts
+   */
+  CaptureStats GetCaptureStats() const;
+
  private:
-  /// Flag indicating whether the renderer has been initialized
-  bool initialized;
+  /**
+   * @brief Outline of an element.
+   */
+  struct Shape {
+    Eigen::AlignedBox2d bounds;    ///< Bounding box; discs are inscribed in it
+    bool disc;                     ///< Whether the shape is a disc rather than a box
+    bool filled;                   ///< Whether the shape is filled rather than outlined
+    std::array<uint8_t, 3> color;  ///< RGB colour
+  };
+
+  /// Shapes of the static elements at one environment revision and region
+  using ShapeList = std::vector<Shape>;
+
+  /**
+   * @brief Everything needed to draw one step.
+   */
+  struct Frame {
+    uint64_t step = 0;                              ///< Step number
+    Camera camera;                                  ///< Resolved camera, with a non-zero zoom
+    double robotRadius = 0.0;                       ///< Drawn robot radius in metres
+    int width = 0;                                  ///< Image width in pixels
+    int height = 0;                                 ///< Image height in pixels
+    std::vector<Eigen::Vector3d> robots;            ///< x, y and orientation of drawn robots
+    std::vector<uint8_t> collided;                  ///< Whether each drawn robot collided
+    int densityTile = 1;                            ///< Density tile edge length in pixels
+    int densityColumns = 0;                         ///< Density tiles per row
+    std::vector<uint32_t> density;                  ///< Aggregated robots per tile, row-major
+    std::vector<Shape> dynamicShapes;               ///< Shapes of the dynamic elements
+    std::shared_ptr<const ShapeList> staticShapes;  ///< Shapes of the static elements
+  };
+
+  /**
+   * @brief The static elements drawn for one camera and image size.
+   */
+  struct Background {
+    std::shared_ptr<const ShapeList> shapes;  ///< Shapes drawn, kept alive to compare by address
+    Camera camera;                            ///< Camera drawn with
+    RgbImage image;                           ///< The drawn background
+  };
+
+  /**
+   * @brief Copies the visible part of a state and the environment into a frame.
+   *
+   * @param state The state
+   * @param frame The frame to fill; its storage is reused
+   */
+  void Capture(const SystemState& state, Frame& frame);
+
+  /**
+   * @brief Captures the static elements again unless the cached shapes cover a region.
+   *
+   * @param region The visible region
+   * @param pixelsPerMetre Zoom the shapes are drawn at, or zero for full detail
+   */
+  void CaptureStatic(const Eigen::AlignedBox2d& region, double pixelsPerMetre);
+
+  /**
+   * @brief Draws a frame.
+   *
+   * @param frame The frame
+   * @param background Cached static elements; redrawn when out of date
+   * @param image The image to draw into
+   */
+  void Draw(const Frame& frame, Background& background, RgbImage& image) const;
+
+  /// Body of the background thread
+  void RenderLoop();
+
+  const Environment* environment_;                 ///< Environment to draw, or nullptr
+  uint64_t staticRevision_;                        ///< Environment revision of staticShapes_
+  Eigen::AlignedBox2d staticRegion_;               ///< Region covered by staticShapes_
+  double staticScale_;                             ///< Zoom staticShapes_ were sampled at
+  std::shared_ptr<const ShapeList> staticShapes_;  ///< Latest static element shapes
+  std::vector<SlotHandle> collisions_;             ///< Robots that collided since the last frame
+  uint64_t stepCount_;                             ///< Steps observed so far
+  size_t frameInterval_;                           ///< Capture every n-th step
+
+  mutable std::mutex mutex_;            ///< Guards the state below
+  std::condition_variable frameReady_;  ///< Signals the renderer thread
+  std::condition_variable frameDone_;   ///< Signals Flush()
+  std::array<Frame, 3> frames_;         ///< Triple buffer
+  size_t writeSlot_;                    ///< Frame being captured
+  size_t readySlot_;                    ///< Frame waiting to be drawn
+  size_t readSlot_;                     ///< Frame being drawn
+  bool hasReadyFrame_;                  ///< Whether readySlot_ holds a new frame
+  bool drawing_;                        ///< Whether the thread is drawing a frame
+  bool stopping_;                       ///< Set when the renderer shuts down
+  int width_;                           ///< Image width in pixels
+  int height_;                          ///< Image height in pixels
+  Eigen::AlignedBox2d viewport_;        ///< Region shown, or empty to fit each frame
+  Camera camera_;                       ///< Camera, or a zero zoom to use viewport_
+  double robotRadius_;                  ///< Drawn robot radius in metres
+  double densityThreshold_;             ///< Radius in pixels below which robots aggregate
+  int densityTile_;                     ///< Density tile edge length in pixels
+  CaptureStats captureStats_;           ///< Counts of the most recent capture
+  std::string outputPrefix_;            ///< Path prefix of written frames
+  ImageFormat outputFormat_;            ///< Format of written frames
+  uint64_t framesRendered_;             ///< Frames drawn by the thread
+  uint64_t framesDropped_;              ///< Frames replaced before being drawn
+  RgbImage lastImage_;                  ///< Image the thread drew last
+  std::thread thread_;                  ///< Renderer thread, once started
 };
 
 } // namespace mobilerobotsim
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class MobileRobotBase;
+
+/**
+ * @brief Recycles robot objects so that spawning does not allocate.
+ *
+ * Robot types are registered under the type identifier of their state
+ * (e.g. "PointRobotState") together with a factory. Acquire() hands out a
+ * previously released robot of that type if there is one and only calls the
+ * factory otherwise, so once the pool holds as many robots as are retired
+ * between spawns, spawning is allocation-free. Recycled robots keep their
+ * previous state and settings; callers load a state before using them.
+ */
+class RobotPool {
+ public:
+  /// Creates a new robot of a registered type
+  using Factory = std::function<std::unique_ptr<MobileRobotBase>()>;
+
+  /// Type index returned for unregistered types
+  static constexpr size_t kNoType = static_cast<size_t>(-1);
+
+  /**
+   * @brief Constructor.
+   */
+  RobotPool();
+
+  /**
+   * @brief Destructor.
+   */
+  ~RobotPool();
+
+  /**
+   * @brief Registers a robot type, replacing any factory registered before.
+   *
+   * @param stateTypeId Type identifier of the robot's state
+   * @param factory Creates a new robot of the type
+   * @return The type index
+   */
+  size_t RegisterType(const std::string& stateTypeId, Factory factory);
+
+  /**
+   * @brief Looks up a registered robot type.
+   *
+   * @param stateTypeId Type identifier of the robot's state
+   * @return The type index, or kNoType if the type is not registered
+   */
+  size_t FindType(const std::string& stateTypeId) const;
+
+  /**
+   * @brief Takes a robot of a type from the pool, creating one if it is empty.
+   *
+   * @param type The type index
+   * @return The robot, or nullptr if the index is invalid
+   */
+  std::unique_ptr<MobileRobotBase> Acquire(size_t type);
+
+  /**
+   * @brief Returns a robot to the pool.
+   *
+   * @param type The type index the robot was acquired with
+   * @param robot The robot
+   */
+  void Release(size_t type, std::unique_ptr<MobileRobotBase> robot);
+
+  /**
+   * @brief Fills the pool so that a number of robots can be acquired without allocating.
+   *
+   * @param type The type index
+   * @param count The number of robots to hold
+   */
+  void Reserve(size_t type, size_t count);
+
+  /**
+   * @brief Gets the number of robots of a type waiting in the pool.
+   *
+   * @param type The type index
+   * @return The number of free robots
+   */
+  size_t GetFreeCount(size_t type) const;
+
+  /**
+   * @brief Gets the number of robots the factories have created.
+   *
+   * @return The total number of robots created
+   */
+  size_t GetCreatedCount() const { return createdCount_; }
+
+ private:
+  /**
+   * @brief The factory and free robots of one type.
+   */
+  struct TypePool {
+    Factory factory;                                     ///< Creates new robots
+    std::vector<std::unique_ptr<MobileRobotBase>> free;  ///< Released robots
+  };
+
+  std::vector<TypePool> types_;                        ///< Pools, by type index
+  std::unordered_map<std::string, size_t> typeIndex_;  ///< Type index of each state type id
+  size_t createdCount_;                                ///< Robots created by the factories
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <string>
+
+#include "environment.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Lane exit that retires the robots entering it.
+ *
+ * A RobotSink is a static, non-solid element. At the end of the step in
+ * which a robot enters it, the SimulationEngine removes the robot and
+ * returns pooled robot objects to their pool for the next spawn.
+ */
+class RobotSink : public EnvironmentElement {
+ public:
+  /**
+   * @brief Constructor with center and radius.
+   *
+   * @param x x-coordinate of the center
+   * @param y y-coordinate of the center
+   * @param radius Radius of the zone
+   */
+  RobotSink(double x, double y, double radius);
+
+  /**
+   * @brief Destructor.
+   */
+  ~RobotSink() override;
+
+  /**
+   * @brief Gets the type identifier of the element.
+   *
+   * @return "RobotSink"
+   */
+  std::string GetTypeId() const override { return "RobotSink"; }
+
+  /**
+   * @brief Checks if a point lies inside the zone.
+   *
+   * @param position The position to check
+   * @return True if the position is inside the zone, false otherwise
+   */
+  bool CheckCollision(const Eigen::Vector2d& position) const override;
+
+  /**
+   * @brief Gets the zone as a JSON object.
+   *
+   * @return JSON with the keys x, y and radius
+   */
+  std::string GetState() const override;
+
+  /**
+   * @brief Loads the zone from a JSON object.
+   *
+   * @param state JSON as produced by GetState(); missing keys keep their value
+   * @return True if the state was successfully loaded, false otherwise
+   */
+  bool LoadState(const std::string& state) override;
+
+  /**
+   * @brief Writes the zone as raw doubles.
+   *
+   * @param writer The writer to append the state to
+   * @return True
+   */
+  bool SaveBinary(BinaryWriter& writer) const override;
+
+  /**
+   * @brief Loads the zone from raw doubles written by SaveBinary().
+   *
+   * @param reader The reader positioned at the state
+   * @return True if the state was read, false if the input is truncated
+   */
+  bool LoadBinary(BinaryReader& reader) override;
+
+  /**
+   * @brief Sinks never block robots.
+   *
+   * @return False
+   */
+  bool IsSolid() const override { return false; }
+
+  /**
+   * @brief Gets the bounding box of the zone.
+   *
+   * @return The bounding box
+   */
+  Eigen::AlignedBox2d GetBounds() const override;
+
+  /**
+   * @brief Gets the center of the zone.
+   *
+   * @return The center position
+   */
+  const Eigen::Vector2d& GetPosition() const { return position_; }
+
+  /**
+   * @brief Gets the radius of the zone.
+   *
+   * @return The radius
+   */
+  double GetRadius() const { return radius_; }
+
+ private:
+  Eigen::Vector2d position_;  ///< The center of the zone
+  double radius_;             ///< The radius of the zone
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "environment.h"
+#include "robot_state.h"
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class MobileRobotBase;
+
+/**
+ * @brief Lane entry that spawns robots at a fixed rate.
+ *
+ * A RobotSource is a static, non-solid element. The SimulationEngine spawns
+ * its k-th robot at the end of the first step that reaches
+ * startTime + k * interval, taking a pooled robot object of the spawn state's
+ * type, loading the spawn state into it and then running the optional spawn
+ * command, e.g. to set a target velocity. The spawn state places the robot
+ * and normally puts it at the source's position.
+ */
+class RobotSource : public EnvironmentElement {
+ public:
+  /// Command run on every spawned robot after its state is loaded
+  using SpawnCommand = std::function<void(MobileRobotBase&)>;
+
+  /**
+   * @brief Constructor with position, rate and spawn state.
+   *
+   * @param x x-coordinate of the source
+   * @param y y-coordinate of the source
+   * @param interval Time between spawns in seconds
+   * @param spawnState State loaded into every spawned robot
+   * @param command Optional command run on every spawned robot
+   * @param startTime Simulation time of the first spawn
+   */
+  RobotSource(double x, double y, double interval, std::unique_ptr<RobotState> spawnState,
+              SpawnCommand command = nullptr, double startTime = 0.0);
+
+  /**
+   * @brief Destructor.
+   */
+  ~RobotSource() override;
+
+  /**
+   * @brief Gets the type identifier of the element.
+   *
+   * @return "RobotSource"
+   */
+  std::string GetTypeId() const override { return "RobotSource"; }
+
+  /**
+   * @brief Sources never collide.
+   *
+   * @param position The position to check
+   * @return False
+   */
+  bool CheckCollision(const Eigen::Vector2d& position) const override;
+
+  /**
+   * @brief Gets the source as a JSON object.
+   *
+   * The spawn command is not part of the state.
+   *
+   * @return JSON with the keys x, y, interval, startTime, robotType and spawnState
+   */
+  std::string GetState() const override;
+
+  /**
+   * @brief Loads the source from a JSON object.
+   *
+   * A different robotType replaces the spawn state with a new state of that
+   * type, created through SystemState::CreateRobotState().
+   *
+   * @param state JSON as produced by GetState(); missing keys keep their value
+   * @return True if the state was successfully loaded, false otherwise
+   */
+  bool LoadState(const std::string& state) override;
+
+  /**
+   * @brief Sources never block robots.
+   *
+   * @return False
+   */
+  bool IsSolid() const override { return false; }
+
+  /**
+   * @brief Gets the bounding box of the source, a single point.
+   *
+   * @return The bounding box
+   */
+  Eigen::AlignedBox2d GetBounds() const override;
+
+  /**
+   * @brief Gets the position of the source.
+   *
+   * @return The position
+   */
+  const Eigen::Vector2d& GetPosition() const { return position_; }
+
+  /**
+   * @brief Gets the time between spawns.
+   *
+   * @return The interval in seconds
+   */
+  double GetInterval() const { return interval_; }
+
+  /**
+   * @brief Gets the simulation time of the first spawn.
+   *
+   * @return The start time in seconds
+   */
+  double GetStartTime() const { return startTime_; }
+
+  /**
+   * @brief Gets the type identifier of the spawn state.
+   *
+   * Selects the robot pool spawned robots are taken from.
+   *
+   * @return The robot state type identifier
+   */
+  const std::string& GetRobotType() const { return robotType_; }
+
+  /**
+   * @brief Gets the state loaded into every spawned robot.
+   *
+   * @return The spawn state
+   */
+  const RobotState& GetSpawnState() const { return *spawnState_; }
+
+  /**
+   * @brief Gets the command run on every spawned robot.
+   *
+   * @return The command, possibly empty
+   */
+  const SpawnCommand& GetSpawnCommand() const { return command_; }
+
+ private:
+  Eigen::Vector2d position_;                ///< The position of the source
+  double interval_;                         ///< Time between spawns in seconds
+  double startTime_;                        ///< Simulation time of the first spawn
+  std::unique_ptr<RobotState> spawnState_;  ///< State loaded into spawned robots
+  std::string robotType_;                   ///< Type identifier of spawnState_
+  SpawnCommand command_;                    ///< Command run on spawned robots
+};
+
+}  // namespace mobilerobotsim
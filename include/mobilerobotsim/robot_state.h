@@ -5,6 +5,10 @@
 
 namespace mobilerobotsim {
 
+// Forward declarations
+class BinaryReader;
+class BinaryWriter;
+
 /**
  * @brief Base class for robot state representations.
  *
@@ -27,21 +31,21 @@ class RobotState {
    *
    * @return String identifier for the robot state type
    */
-  virtual std::string getTypeId() const = 0;
+  virtual std::string GetTypeId() const = 0;
 
   /**
    * @brief Creates a clone of this robot state.
    *
    * @return A unique pointer to a new RobotState that is a copy of this one
    */
-  virtual std::unique_ptr<RobotState> clone() const = 0;
+  virtual std::unique_ptr<RobotState> Clone() const = 0;
 
   /**
    * @brief Serializes the robot state to a string representation.
    *
    * @return String representation of the robot state
    */
-  virtual std::string serialize() const = 0;
+  virtual std::string Serialize() const = 0;
 
   /**
    * @brief Deserializes a robot state from a string representation.
@@ -49,7 +53,50 @@ class RobotState {
    * @param serialized The serialized state string
    * @return True if deserialization was successful, false otherwise
    */
-  virtual bool deserialize(const std::string& serialized) = 0;
+  virtual bool Deserialize(const std::string& serialized) = 0;
+
+  /**
+   * @brief Writes the robot state in a compact binary form.
+   *
+   * Caches use the binary form to restore robots without parsing JSON.
+   * States without one keep the default, and Serialize() is cached instead.
+   *
+   * @param writer The writer to append the state to
+   * @return True if a binary state was written, false if the state has none
+   */
+  virtual bool SaveBinary(BinaryWriter& /*writer*/) const { return false; }
+
+  /**
+   * @brief Loads a state written by SaveBinary().
+   *
+   * @param reader The reader positioned at the state
+   * @return True if the state was successfully loaded, false otherwise
+   */
+  virtual bool LoadBinary(BinaryReader& /*reader*/) { return false; }
+
+  /**
+   * @brief Gets the planar pose recorded in the state.
+   *
+   * Renderers and other consumers that only need where a robot is use this
+   * instead of parsing the serialized state.
+   *
+   * @param x Output parameter for the x-coordinate
+   * @param y Output parameter for the y-coordinate
+   * @param orientation Output parameter for the orientation in radians
+   * @return True if the state has a pose, false otherwise
+   */
+  virtual bool GetPose(double& /*x*/, double& /*y*/, double& /*orientation*/) const {
+    return false;
+  }
+
+  /**
+   * @brief Gets the planar velocity recorded in the state.
+   *
+   * @param vx Output parameter for the x velocity
+   * @param vy Output parameter for the y velocity
+   * @return True if the state has a velocity, false otherwise
+   */
+  virtual bool GetVelocity(double& /*vx*/, double& /*vy*/) const { return false; }
 
  protected:
   /**
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class Environment;
+class EnvironmentElement;
+class RobotState;
+
+/**
+ * @brief Builds an environment and a robot set from a scenario file.
+ *
+ * A scenario is a JSON document of the form
+ *
+ *     {"worldBounds": [minX, minY, maxX, maxY],
+ *      "staticIndexCellSize": 2.0,
+ *      "elements": [{"type": "MergePoint", "state": {...}}, ...],
+ *      "robots": [{"type": "PointRobotState", "state": {...}}, ...]}
+ *
+ * where "worldBounds" and "staticIndexCellSize" are optional and each state
+ * is what the element's GetState() or the robot state's Serialize() returns.
+ * Elements and robots are parsed one at a time, and the static index is
+ * built once everything has been added. Robot sources are created without a
+ * spawn command, since a command is code rather than data.
+ *
+ * Parsing JSON dominates the start-up of large scenarios, so Load() can keep
+ * a compiled cache next to the scenario: a binary file keyed by a hash of the
+ * scenario's contents that holds every element and robot in its binary form
+ * (see EnvironmentElement::SaveBinary()) together with the built static
+ * index. While the scenario is unchanged, later loads map the cache instead
+ * of parsing JSON or rebuilding the index. Occupancy grids still reload
+ * their cells from their source files, which the key does not cover, so the
+ * index is rebuilt whenever a grid has a source. The cache is replaced by
+ * renaming a new file over it, so processes mapping the old one are safe.
+ */
+class ScenarioLoader {
+ public:
+  /// Creates an element of a registered type in a default state
+  using ElementFactory = std::function<std::unique_ptr<EnvironmentElement>()>;
+
+  /**
+   * @brief Constructor. Registers the built-in element types.
+   */
+  ScenarioLoader();
+
+  /**
+   * @brief Destructor.
+   */
+  ~ScenarioLoader();
+
+  /**
+   * @brief Registers an element type, replacing any factory registered before.
+   *
+   * Robot state types are registered with SystemState::RegisterRobotStateType().
+   *
+   * @param typeId The type identifier returned by the element's GetTypeId()
+   * @param factory Creates an element of the type; its state is loaded afterwards
+   */
+  void RegisterElementType(const std::string& typeId, ElementFactory factory);
+
+  /**
+   * @brief Loads a scenario, using and refreshing a compiled cache if a path is given.
+   *
+   * A missing, stale or unreadable cache is rebuilt from the scenario; failing
+   * to write it does not fail the load.
+   *
+   * @param scenarioPath The scenario file
+   * @param cachePath The cache file, or an empty string to always parse the scenario
+   * @return True if the scenario was loaded, false otherwise
+   */
+  bool Load(const std::string& scenarioPath, const std::string& cachePath = "");
+
+  /**
+   * @brief Checks whether the last Load() was served from the cache.
+   *
+   * @return True if the cache was used, false if the scenario was parsed
+   */
+  bool IsFromCache() const { return fromCache_; }
+
+  /**
+   * @brief Takes the environment built by the last Load().
+   *
+   * @return The environment, or nullptr if nothing was loaded
+   */
+  std::unique_ptr<Environment> TakeEnvironment();
+
+  /**
+   * @brief Takes the robot states read by the last Load(), in scenario order.
+   *
+   * The states can be passed to SimulationEngine::AddRobots().
+   *
+   * @return The robot states
+   */
+  std::vector<std::unique_ptr<RobotState>> TakeRobotStates();
+
+ private:
+  /**
+   * @brief Builds the scenario from JSON, compiling it into a cache image on the way.
+   *
+   * @param data The scenario document
+   * @param size Length of the document in bytes
+   * @param cache Receives the cache image after the header, or nullptr to skip it
+   * @return True if the scenario was valid, false otherwise
+   */
+  bool Parse(const char* data, size_t size, std::string* cache);
+
+  /**
+   * @brief Builds the scenario from a compiled cache.
+   *
+   * @param path The cache file
+   * @param key Content key of the scenario
+   * @return True if the cache matched the key and was read, false otherwise
+   */
+  bool LoadCache(const std::string& path, uint64_t key);
+
+  /**
+   * @brief Creates an element of a registered type.
+   *
+   * @param typeId The type identifier
+   * @return The element, or nullptr if the type is not registered
+   */
+  std::unique_ptr<EnvironmentElement> CreateElement(const std::string& typeId) const;
+
+  std::unordered_map<std::string, ElementFactory> elementFactories_;  ///< Factories, by type id
+  std::unique_ptr<Environment> environment_;                 ///< Environment of the last load
+  std::vector<std::unique_ptr<RobotState>> robotStates_;     ///< Robots of the last load
+  bool fromCache_;                                           ///< Whether the cache was used
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class Environment;
+class OccupancyGrid;
+
+/**
+ * @brief Precomputed signed distance to the static environment geometry.
+ *
+ * SignedDistanceField samples the distance to the nearest static obstacle at
+ * the centers of a regular grid. Distances are positive in free space and
+ * negative inside obstacles. The field is built once with the linear-time
+ * Felzenszwalb-Huttenlocher Euclidean distance transform, and queries
+ * interpolate bilinearly between samples, which also yields a gradient that is
+ * exact for the interpolant.
+ *
+ * A built field can be written to a cache file keyed by a content hash of the
+ * static environment. Loading a cache maps the samples in place, so startup
+ * does not repeat the transform.
+ */
+class SignedDistanceField {
+ public:
+  /**
+   * @brief Default constructor. Creates an empty field.
+   */
+  SignedDistanceField();
+
+  /**
+   * @brief Destructor.
+   */
+  ~SignedDistanceField();
+
+  /**
+   * @brief Builds the field over the static elements of an environment.
+   *
+   * Each cell is classified by a static collision query at its center.
+   *
+   * @param environment The environment whose static elements are obstacles
+   * @param region The world region to cover
+   * @param resolution Cell edge length in meters
+   * @return True if the field was built, false if the region is empty
+   */
+  bool Build(const Environment& environment, const Eigen::AlignedBox2d& region,
+             double resolution);
+
+  /**
+   * @brief Builds the field directly from an occupancy grid.
+   *
+   * @param grid The grid whose occupied cells are obstacles
+   * @return True if the field was built, false if the grid is empty
+   */
+  bool Build(const OccupancyGrid& grid);
+
+  /**
+   * @brief Checks whether the field holds samples.
+   *
+   * @return True if the field was built or loaded, false otherwise
+   */
+  bool IsValid() const { return values_ != nullptr; }
+
+  /**
+   * @brief Gets the interpolated signed distance at a position.
+   *
+   * Positions outside the field are clamped to its border.
+   *
+   * @param position The world position
+   * @return The signed distance in meters
+   */
+  double Distance(const Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Gets the interpolated signed distance and its gradient.
+   *
+   * @param position The world position
+   * @param gradient Output parameter for the gradient of the distance
+   * @return The signed distance in meters
+   */
+  double DistanceAndGradient(const Eigen::Vector2d& position, Eigen::Vector2d& gradient) const;
+
+  /**
+   * @brief Evaluates many positions in one call.
+   *
+   * Positions are the columns of a 2xN matrix, e.g. one column per robot.
+   *
+   * @param positions The world positions
+   * @param distances Output vector resized to N signed distances
+   * @param gradients Optional output matrix resized to the 2xN gradients
+   */
+  void DistanceBatch(const Eigen::Matrix2Xd& positions, Eigen::VectorXd& distances,
+                     Eigen::Matrix2Xd* gradients = nullptr) const;
+
+  /**
+   * @brief Writes the field to a cache file.
+   *
+   * @param path The cache file
+   * @param key Content key identifying the geometry the field was built from
+   * @return True if the file was written, false otherwise
+   */
+  bool SaveCache(const std::string& path, uint64_t key) const;
+
+  /**
+   * @brief Maps a cache file written by SaveCache().
+   *
+   * @param path The cache file
+   * @param key Content key the cache must have been written with
+   * @return True if the cache exists and matches the key, false otherwise
+   */
+  bool LoadCache(const std::string& path, uint64_t key);
+
+  /**
+   * @brief Gets the number of sample columns.
+   *
+   * @return The field width in cells
+   */
+  int GetWidth() const { return width_; }
+
+  /**
+   * @brief Gets the number of sample rows.
+   *
+   * @return The field height in cells
+   */
+  int GetHeight() const { return height_; }
+
+  /**
+   * @brief Gets the cell edge length.
+   *
+   * @return The resolution in meters
+   */
+  double GetResolution() const { return resolution_; }
+
+  /**
+   * @brief Gets the world position of the lower-left corner of the field.
+   *
+   * @return The field origin
+   */
+  const Eigen::Vector2d& GetOrigin() const { return origin_; }
+
+ private:
+  /// Computes signed distances from a row-major occupancy mask
+  void Transform(const std::vector<uint8_t>& occupied);
+
+  /// Finds the sample cell and interpolation weights for a position
+  void Locate(const Eigen::Vector2d& position, int& x, int& y, double& fx, double& fy) const;
+
+  /// Returns a sample, with indices clamped to the field
+  double Sample(int x, int y) const;
+
+  int width_;                    ///< Number of sample columns
+  int height_;                   ///< Number of sample rows
+  double resolution_;            ///< Cell edge length in meters
+  Eigen::Vector2d origin_;       ///< Lower-left corner of the field
+  std::vector<float> owned_;     ///< Samples when built in memory
+  MappedFile file_;              ///< Mapping backing the samples when loaded from a cache
+  const float* values_;          ///< Row-major samples in meters, owned or mapped
+};
+
+}  // namespace mobilerobotsim
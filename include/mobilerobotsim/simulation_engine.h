@@ -1,17 +1,44 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
+#include <Eigen/Geometry>
+
+#include "mobilerobotsim/fleet_state.h"
+#include "mobilerobotsim/merge_strategy.h"
+#include "mobilerobotsim/mobile_robot_base.h"
+#include "mobilerobotsim/robot_pool.h"
 #include "mobilerobotsim/simulation_observer.h"
+#include "mobilerobotsim/slot_map.h"
 
 namespace mobilerobotsim {
 
 // Forward declarations
-class MobileRobotBase;
+class CheckpointWriter;
 class Environment;
+class EnvironmentElement;
+class MergePoint;
+class RobotSource;
+class RobotState;
 class SystemState;
+class ThreadPool;
+
+/**
+ * @brief Counters describing the sleep/wake scheduler.
+ */
+struct SchedulerStats {
+  size_t activeRobots = 0;    ///< Robots updated every step
+  size_t sleepingRobots = 0;  ///< Robots skipped until woken
+  uint64_t sleepCount = 0;    ///< Total number of times a robot was put to sleep
+  uint64_t wakeCount = 0;     ///< Total number of times a robot was woken
+};
 
 /**
  * @brief Main simulation engine class.
@@ -20,6 +47,38 @@ class SystemState;
  * the simulation time, robots, environment, and observers. It provides methods
  * for stepping the simulation forward, adding and removing robots, and
  * managing the simulation state.
+ *
+ * Stepping is deterministic regardless of the thread count: robots are
+ * advanced in parallel but each one only touches its own state and draws
+ * noise from its own counter-based random stream, and collision and merge
+ * point events are collected per robot and dispatched afterwards in robot
+ * order. Results are therefore bit-identical between 1-thread and N-thread
+ * runs with the same seed.
+ *
+ * Robots that steer by their neighbours read them from a double-buffered
+ * FleetState: during a step every robot reads the fleet as it was at the
+ * start of the step and its new position and velocity go to the other
+ * buffer, and the buffers are swapped when the step ends. Neighbour-aware
+ * updates therefore need no locks and do not depend on update order.
+ *
+ * Robots at rest are put to sleep and skipped by Step() until they are
+ * woken by a command (e.g. PointRobot::SetTargetVelocity), by a moving robot
+ * or dynamic element coming within the wake radius, or by a change to the
+ * environment's element set. Sleeping never changes results, since robots
+ * at rest do not change state when updated.
+ *
+ * Robots are addressed by the generational handles AddRobot() returns.
+ * Robots are stored densely; removing one moves the last robot into its
+ * place, so removal is O(1) and every other handle stays valid, while a
+ * removed robot's handle never refers to a later robot. Observers and
+ * SystemState report the same handles (MobileRobotBase::GetHandle(),
+ * SystemState::GetRobotHandle()).
+ *
+ * RobotSource elements spawn robots and RobotSink elements retire them, both
+ * at the end of a step. Spawned robots, and robots added from a state, are
+ * taken from a RobotPool and returned to it on removal, so that in steady
+ * state spawning allocates nothing. PointRobot and PointRobotF are
+ * registered with the pool by default.
  */
 class SimulationEngine {
  public:
@@ -51,25 +110,151 @@ class SimulationEngine {
    * 
    * This method updates all robots and the environment based on the
    * specified time step, then notifies all observers of the updated state.
+   * Due scheduled commands run first, then the merge strategies. Collision
+   * and merge point events are reported when a robot enters an element, in
+   * robot order, before the environment is updated.
    * 
    * @param dt Time step size in seconds
    */
   void Step(double dt);
 
+  /**
+   * @brief Advances the simulation to a time in as few steps as possible.
+   * 
+   * Each step jumps straight to the earliest of the target time, the next
+   * scheduled command, and a conservative bound on when any awake robot
+   * could next touch an obstacle or enter a merge point. The bound divides
+   * each robot's clearance (from the static element bounds, the signed
+   * distance field if built, and the dynamic obstacles) by its speed bound,
+   * so collisions and zone entries are detected at most minStep late.
+   * Robots are advanced with MobileRobotBase::Advance() where available
+   * and with UpdateState() otherwise.
+   * 
+   * @param time The simulation time to advance to
+   * @param minStep Smallest step taken while approaching an event, in seconds
+   * @param maxStep Largest step taken, in seconds
+   */
+  void AdvanceTo(double time, double minStep = 1e-3,
+                 double maxStep = std::numeric_limits<double>::infinity());
+
+  /**
+   * @brief Schedules a command for a robot.
+   * 
+   * The command runs at the start of the first step that begins at or after
+   * the given time; AdvanceTo() ends a step exactly at that time. Commands
+   * for the same time run in the order they were scheduled.
+   * 
+   * Commands for a robot that is removed before their time are dropped.
+   * 
+   * @param time The simulation time at which to run the command
+   * @param handle The robot's handle
+   * @param command The command, e.g. a call to PointRobot::SetTargetVelocity()
+   * @return True if the command was scheduled, false if the handle is stale
+   */
+  bool ScheduleCommand(double time, RobotHandle handle,
+                       std::function<void(MobileRobotBase&)> command);
+
   /**
    * @brief Adds a robot to the simulation.
    * 
+   * The robot is given a random stream derived from the seed and a robot id
+   * that is never reused, so removing other robots does not change it.
+   * 
    * @param robot The robot to add
+   * @return The robot's handle
    */
-  void AddRobot(std::unique_ptr<MobileRobotBase> robot);
+  RobotHandle AddRobot(std::unique_ptr<MobileRobotBase> robot);
 
   /**
-   * @brief Removes a robot from the simulation.
+   * @brief Adds a robot created from a state, reusing a pooled robot object.
    * 
-   * @param index The index of the robot to remove
-   * @return True if the robot was successfully removed, false otherwise
+   * The robot type is selected by the state's type identifier and must have
+   * been registered with RegisterRobotType().
+   * 
+   * @param state The robot's initial state
+   * @return The robot's handle, or an invalid handle if the type is not
+   *         registered or the state could not be loaded
    */
-  bool RemoveRobot(size_t index);
+  RobotHandle AddRobot(const RobotState& state);
+
+  /**
+   * @brief Adds robots created from states, reserving storage for all of them first.
+   * 
+   * @param states The robots' initial states
+   * @return The robots' handles, in the order of the states
+   */
+  std::vector<RobotHandle> AddRobots(const std::vector<std::unique_ptr<RobotState>>& states);
+
+  /**
+   * @brief Reserves storage so that the engine can hold a number of robots without allocating.
+   * 
+   * @param count The total number of robots
+   */
+  void ReserveRobots(size_t count);
+
+  /**
+   * @brief Registers a robot type for AddRobot(const RobotState&) and robot sources.
+   * 
+   * @param stateTypeId Type identifier of the robot's state
+   * @param factory Creates a new robot of the type
+   */
+  void RegisterRobotType(const std::string& stateTypeId, RobotPool::Factory factory);
+
+  /**
+   * @brief Fills the robot pool so that robots of a type can be added without allocating.
+   * 
+   * @param stateTypeId Type identifier of the robot's state
+   * @param count The number of pooled robots to hold
+   * @return True if the pool was filled, false if the type is not registered
+   */
+  bool ReservePooledRobots(const std::string& stateTypeId, size_t count);
+
+  /**
+   * @brief Gets the pool that spawned robots are taken from.
+   * 
+   * @return The robot pool
+   */
+  const RobotPool& GetRobotPool() const;
+
+  /**
+   * @brief Gets the number of robots sources failed to spawn.
+   * 
+   * A spawn fails if the source's robot type is not registered or the
+   * robot rejects the spawn state. The spawn is not retried.
+   * 
+   * @return The number of failed spawns
+   */
+  uint64_t GetFailedSpawnCount() const;
+
+  /**
+   * @brief Removes a robot from the simulation in constant time.
+   * 
+   * The last robot in storage order takes the removed robot's place. Robots
+   * that came from the robot pool are returned to it.
+   * 
+   * @param handle The handle of the robot to remove
+   * @return True if the robot was removed, false if the handle is stale
+   */
+  bool RemoveRobot(RobotHandle handle);
+
+  /**
+   * @brief Looks up a robot.
+   * 
+   * @param handle The robot's handle
+   * @return The robot, or nullptr if the handle is stale
+   */
+  MobileRobotBase* GetRobot(RobotHandle handle) const;
+
+  /**
+   * @brief Gets the handle of the robot at a position in storage order.
+   * 
+   * Together with GetRobotCount() this enumerates the robots in the order
+   * they are updated and reported.
+   * 
+   * @param index Position in storage order, less than GetRobotCount()
+   * @return The robot's handle
+   */
+  RobotHandle GetRobotHandle(size_t index) const;
 
   /**
    * @brief Gets the number of robots in the simulation.
@@ -78,13 +263,159 @@ class SimulationEngine {
    */
   size_t GetRobotCount() const;
 
+  /**
+   * @brief Gets the poses and velocities of every robot as contiguous columns.
+   *
+   * Entries are in storage order (see GetRobotHandle()). They reflect the
+   * end of the last step, commands run since and robots added since, but not
+   * changes made directly through GetRobot(). The columns may move on the
+   * next call that changes the engine.
+   *
+   * @return The fleet state
+   */
+  const FleetState& GetFleetState();
+
+  /**
+   * @brief Sets the number of threads used to advance robots.
+   * 
+   * The thread count does not affect the results.
+   * 
+   * @param threadCount The number of threads, or zero for the number of hardware threads
+   */
+  void SetThreadCount(size_t threadCount);
+
+  /**
+   * @brief Gets the number of threads used to advance robots.
+   * 
+   * @return The thread count
+   */
+  size_t GetThreadCount() const;
+
+  /**
+   * @brief Sets the simulation seed and re-seeds every robot's random stream.
+   * 
+   * @param seed The seed
+   */
+  void SetSeed(uint64_t seed);
+
+  /**
+   * @brief Gets the simulation seed.
+   * 
+   * @return The seed
+   */
+  uint64_t GetSeed() const;
+
+  /**
+   * @brief Adds a group of robots that are updated at a higher rate.
+   * 
+   * Each step of the engine is split into equal substeps no longer than
+   * maxStep for the robots in the group; the other robots still take the
+   * step whole. GetTime() only advances once the whole step is done.
+   * 
+   * @param maxStep Longest substep in seconds
+   * @return The index of the new group; group 0 is the default group
+   */
+  size_t AddRateGroup(double maxStep);
+
+  /**
+   * @brief Moves a robot into a rate group.
+   * 
+   * @param handle The robot's handle
+   * @param group The index of the group
+   * @return True if the robot was moved, false if the handle or group is invalid
+   */
+  bool SetRobotRateGroup(RobotHandle handle, size_t group);
+
+  /**
+   * @brief Gets a robot's position at a time within the current or last step.
+   * 
+   * Robots that take the step whole are advanced before any substepped group,
+   * and report positions linearly interpolated between the start and end of
+   * the step, so substepped robots and their controllers see them at the
+   * substep time. Substepped robots report their latest position.
+   * 
+   * @param handle The robot's handle
+   * @param time Simulation time, clamped to the step
+   * @param position Output parameter for the position
+   * @return True if the robot exists, false otherwise
+   */
+  bool GetRobotPosition(RobotHandle handle, double time, Eigen::Vector2d& position) const;
+
+  /**
+   * @brief Controls the robots approaching a merge point with a strategy.
+   * 
+   * At the start of every step, the robots within the approach radius of the
+   * merge point are gathered into a MergeBatch and the strategy computes
+   * their target velocities in one MergeStrategy::ComputeBatch() call, before
+   * any robot is updated. Strategies of different merge points run in
+   * parallel. A robot's target velocity when it enters the approach is its
+   * cruise velocity, which is restored when it leaves; in between the
+   * strategy owns the target velocity. Robots that do not accept velocity
+   * commands are still reported but not steered.
+   * 
+   * Replaces any strategy already set for the merge point. The merge point
+   * must stay in the environment while it is controlled.
+   * 
+   * @param mergePoint The merge point
+   * @param strategy The strategy, or nullptr to release the merge point's robots
+   * @param approachRadius Distance from the centre within which robots are controlled
+   * @return False if the radius is not positive, or if nullptr is given for an
+   *         uncontrolled merge point; true otherwise
+   */
+  bool SetMergeStrategy(const MergePoint& mergePoint, std::unique_ptr<MergeStrategy> strategy,
+                        double approachRadius);
+
+  /**
+   * @brief Enables or disables putting robots at rest to sleep.
+   * 
+   * Disabling wakes every sleeping robot. Enabled by default.
+   * 
+   * @param enabled Whether robots may sleep
+   */
+  void SetSleepEnabled(bool enabled);
+
+  /**
+   * @brief Sets the distance within which moving robots and dynamic elements
+   *        wake sleeping robots.
+   * 
+   * @param radius The wake radius in meters
+   */
+  void SetWakeRadius(double radius);
+
+  /**
+   * @brief Gets the sleep/wake counters.
+   * 
+   * @return The scheduler statistics
+   */
+  SchedulerStats GetSchedulerStats() const;
+
+  /**
+   * @brief Computes a hash of the simulation state for regression baselines.
+   * 
+   * The hash covers the time, the exact bits of every robot's position and
+   * velocity, and the state of every environment element.
+   * 
+   * @return The 64-bit hash
+   */
+  uint64_t ComputeStateHash() const;
+
   /**
    * @brief Sets the environment for the simulation.
    * 
+   * Removes every merge strategy, handing their robots back their cruise
+   * velocities.
+   * 
    * @param environment The environment to use
    */
   void SetEnvironment(std::unique_ptr<Environment> environment);
 
+  /**
+   * @brief Gets the environment.
+   * 
+   * @return The environment; replaced by SetEnvironment()
+   */
+  const Environment& GetEnvironment() const;
+
   /**
    * @brief Gets the current simulation time.
    * 
@@ -124,6 +455,12 @@ class SimulationEngine {
    * state object. This allows for state loading, time travel debugging, and
    * scenario replays.
    * 
+   * Robots whose saved handle still refers to a live robot are loaded in
+   * place; the other saved robots are added from the robot pool with new
+   * handles, and robots that are not in the state are removed. Contacts are
+   * cleared, so robots that start inside an element report it again on the
+   * next step, and every robot is woken. Scheduled commands are kept.
+   * 
    * @param state The state to load
    * @return True if the state was successfully loaded, false otherwise
    */
@@ -132,6 +469,9 @@ class SimulationEngine {
   /**
    * @brief Saves the current simulation state to a file.
    * 
+   * The state is written as JSON while it is being serialized; see
+   * SystemState::Write().
+   * 
    * @param filename The name of the file to save to
    * @return True if the state was successfully saved, false otherwise
    */
@@ -145,12 +485,223 @@ class SimulationEngine {
    */
   bool LoadStateFromFile(const std::string& filename);
 
+  /**
+   * @brief Saves the current simulation state to a file in the background.
+   * 
+   * Only the snapshot is taken on the calling thread: the robot and element
+   * states are copied by GetState(), and serialization and file I/O run on a
+   * background thread, so the simulation can keep stepping right away. The
+   * file is renamed into place once it is complete. If the maximum number of
+   * checkpoints is already in flight, the checkpoint is skipped, or waits for
+   * the oldest one if SetCheckpointsWaitWhenFull() was set.
+   * 
+   * @param filename The name of the file to save to
+   * @return Future that becomes true once the file is written, or false if
+   *         writing failed or the checkpoint was skipped
+   */
+  std::future<bool> SaveStateToFileAsync(const std::string& filename);
+
+  /**
+   * @brief Sets the maximum number of background checkpoints in flight.
+   * 
+   * @param count The maximum; at least one. Defaults to 1.
+   */
+  void SetMaxPendingCheckpoints(size_t count);
+
+  /**
+   * @brief Sets whether a background checkpoint waits for a free slot rather than being skipped.
+   * 
+   * @param wait True to wait and throttle stepping to the disk, false to skip (default)
+   */
+  void SetCheckpointsWaitWhenFull(bool wait);
+
+  /**
+   * @brief Gets the number of background checkpoints not yet written.
+   * 
+   * @return The number of checkpoints in flight
+   */
+  size_t GetPendingCheckpointCount() const;
+
+  /**
+   * @brief Gets the number of background checkpoints skipped because too many were in flight.
+   * 
+   * @return The number of skipped checkpoints
+   */
+  uint64_t GetSkippedCheckpointCount() const;
+
+  /**
+   * @brief Waits until every background checkpoint has been written.
+   */
+  void WaitForCheckpoints();
+
  private:
+  /**
+   * @brief A robot and its per-step event slots.
+   */
+  struct RobotEntry {
+    std::unique_ptr<MobileRobotBase> robot;  ///< The robot
+    uint64_t id;                             ///< Robot id, selects the random stream
+    const EnvironmentElement* collision;     ///< Element the robot is in contact with
+    const EnvironmentElement* mergePoint;    ///< Merge point the robot is inside
+    const EnvironmentElement* collisionEvent;   ///< First element contacted this step
+    const EnvironmentElement* mergePointEvent;  ///< First merge point entered this step
+    uint64_t sleepCell;                      ///< Key of the sleeping grid cell while asleep
+    size_t rateGroup;                        ///< Index into rateGroups_
+    Eigen::Vector2d startPosition;           ///< Position at the start of the current step
+    size_t poolType;                         ///< Robot pool type, or RobotPool::kNoType
+    bool inSink;                             ///< Whether the robot ended the step in a sink
+    size_t mergeController;                  ///< Controlling merge, or kNoMergeController
+    Eigen::Vector2d cruiseVelocity;          ///< Target velocity on entering the merge approach
+  };
+
+  /**
+   * @brief Events of one robot in the current step, recorded before dispatch.
+   */
+  struct StepEvent {
+    RobotHandle robot;                     ///< The robot
+    const EnvironmentElement* collision;   ///< Element contacted, or nullptr
+    const EnvironmentElement* mergePoint;  ///< Merge point entered, or nullptr
+  };
+
+  /**
+   * @brief A merge point steered by a strategy.
+   */
+  struct MergeController {
+    const MergePoint* mergePoint;             ///< The merge point
+    std::unique_ptr<MergeStrategy> strategy;  ///< The strategy
+    double approachRadius;                    ///< Radius of the controlled approach
+    MergeBatch batch;                         ///< Approaching robots; reused across steps
+    std::vector<size_t> robots;               ///< Storage index of each batch entry
+  };
+
+  /// RobotEntry::mergeController of robots outside every merge approach
+  static constexpr size_t kNoMergeController = static_cast<size_t>(-1);
+
+  /**
+   * @brief A robot source and how many robots it has spawned.
+   */
+  struct SourceEntry {
+    const RobotSource* source;  ///< The source
+    size_t poolType;            ///< Robot pool type of the spawned robots
+    uint64_t spawned;           ///< Number of robots spawned so far
+  };
+
+  /**
+   * @brief Robots that share an update rate.
+   */
+  struct RateGroup {
+    double maxStep;  ///< Longest substep, or zero to take each step whole
+  };
+
+  /**
+   * @brief A command waiting for its time.
+   */
+  struct ScheduledCommand {
+    double time;                                  ///< Time at which the command runs
+    uint64_t sequence;                            ///< Tie-breaker keeping scheduling order
+    RobotHandle robot;                            ///< Handle of the commanded robot
+    std::function<void(MobileRobotBase&)> apply;  ///< The command
+  };
+
   /// The current simulation time in seconds
   double time_;
 
-  /// Collection of robots in the simulation
-  std::vector<std::unique_ptr<MobileRobotBase>> robots_;
+  /// Pending commands, a min-heap on (time, sequence)
+  std::vector<ScheduledCommand> commands_;
+
+  /// Sequence number of the next scheduled command
+  uint64_t commandSequence_;
+
+  /// Robots in the simulation, in storage order
+  SlotMap<RobotEntry> robots_;
+
+  /// Seed from which every robot's random stream is derived
+  uint64_t seed_;
+
+  /// Id given to the next robot that is added
+  uint64_t nextRobotId_;
+
+  /// Threads robots are advanced on
+  std::unique_ptr<ThreadPool> pool_;
+
+  /// Background thread for SaveStateToFileAsync(), started on first use
+  std::unique_ptr<CheckpointWriter> checkpointWriter_;
+
+  /// Cap on background checkpoints in flight
+  size_t maxPendingCheckpoints_;
+
+  /// Whether background checkpoints wait for a free slot rather than being skipped
+  bool checkpointsWaitWhenFull_;
+
+  /// Update rate groups; group 0 takes every step whole
+  std::vector<RateGroup> rateGroups_;
+
+  /// Simulation time at the start of the current or last step
+  double stepStart_;
+
+  /// Simulation time at the end of the current or last step
+  double stepEnd_;
+
+  /// Storage indices of the awake robots, in storage order
+  std::vector<size_t> active_;
+
+  /// Whether robots were removed since active_ was last rebuilt
+  bool activeStale_;
+
+  /// Merge points steered by strategies
+  std::vector<MergeController> mergeControllers_;
+
+  /// The fleet at the start of the step, read by the robots being updated
+  FleetState fleetFront_;
+
+  /// The fleet at the end of the step, written as robots finish their update
+  FleetState fleetBack_;
+
+  /// Whether robots were added, removed or loaded since the fleet was gathered
+  bool fleetStale_;
+
+  /// Sleeping robots that received a command since the last step
+  std::vector<RobotHandle> pendingWakes_;
+
+  /// Handles of the sleeping robots, hashed by wake-radius sized grid cell
+  std::unordered_map<uint64_t, std::vector<RobotHandle>> sleepingCells_;
+
+  /// Whether robots at rest are put to sleep
+  bool sleepEnabled_;
+
+  /// Distance within which moving things wake sleeping robots
+  double wakeRadius_;
+
+  /// Environment revision the schedule was last checked against
+  uint64_t environmentRevision_;
+
+  /// Sleep/wake counters
+  SchedulerStats stats_;
+
+  /// Recycled robot objects for spawning
+  RobotPool robotPool_;
+
+  /// Robot sources in the environment
+  std::vector<SourceEntry> sources_;
+
+  /// Whether the environment has any robot sink
+  bool hasSinks_;
+
+  /// Spawns that produced no robot
+  uint64_t failedSpawns_;
+
+  /// Environment revision sources_ and hasSinks_ were collected at
+  uint64_t spawnerRevision_;
+
+  /// Whether sources_ must be collected again regardless of the revision
+  bool spawnersStale_;
+
+  /// Robots that ended the current step in a sink, collected before events are dispatched
+  std::vector<RobotHandle> despawns_;
+
+  /// Events of the current step; observers may add or remove robots while
+  /// they are dispatched, so robots are referred to by handle
+  std::vector<StepEvent> stepEvents_;
 
   /// The environment for the simulation
   std::unique_ptr<Environment> environment_;
@@ -158,8 +709,188 @@ class SimulationEngine {
   /// Collection of observers for simulation events
   std::vector<SimulationObserver*> observers_;
 
+  /// Whether each observer asked for the state of the current step
+  std::vector<uint8_t> stepStateNeeded_;
+
+  /**
+   * @brief Advances one robot by one step, in substeps if its group requires.
+   * 
+   * Only touches the given entry, so robots can be updated concurrently.
+   * 
+   * @param entry The robot to advance
+   * @param dt Time step size in seconds
+   * @param closedForm Whether to try the robot's closed-form Advance() first
+   * @param fleet The fleet at the start of the step
+   */
+  void StepRobot(RobotEntry& entry, double dt, bool closedForm, const FleetView& fleet) const;
+
+  /**
+   * @brief Advances one robot and records any element it newly entered.
+   * 
+   * @param entry The robot to advance
+   * @param dt Time step size in seconds
+   * @param closedForm Whether to try the robot's closed-form Advance() first
+   * @param fleet The fleet at the start of the step
+   */
+  void UpdateRobot(RobotEntry& entry, double dt, bool closedForm, const FleetView& fleet) const;
+
+  /**
+   * @brief Records every robot in both fleet buffers if robots were added or removed.
+   */
+  void RefreshFleet();
+
+  /**
+   * @brief Runs due commands and merge strategies and wakes commanded robots.
+   * 
+   * Called before every StepInternal().
+   */
+  void PrepareStep();
+
+  /**
+   * @brief Runs the merge strategies and applies their target velocities.
+   */
+  void RunMergeStrategies();
+
   /**
-   * @brief Notifies all observers of a simulation step.
+   * @brief Advances robots, events, environment and time by one step.
+   * 
+   * @param dt Time step size in seconds
+   * @param closedForm Whether robots may use their closed-form Advance()
+   */
+  void StepInternal(double dt, bool closedForm);
+
+  /**
+   * @brief Runs the scheduled commands that are due.
+   */
+  void ApplyDueCommands();
+
+  /**
+   * @brief Stores a robot and gives it its handle, id and random stream.
+   * 
+   * @param robot The robot
+   * @param poolType Robot pool type to return the robot to, or RobotPool::kNoType
+   * @return The robot's handle
+   */
+  RobotHandle AddEntry(std::unique_ptr<MobileRobotBase> robot, size_t poolType);
+
+  /**
+   * @brief Takes a pooled robot, loads a state into it and adds it.
+   * 
+   * @param poolType Robot pool type
+   * @param state The robot's initial state
+   * @return The robot's handle, or an invalid handle on failure
+   */
+  RobotHandle SpawnRobot(size_t poolType, const RobotState& state);
+
+  /**
+   * @brief Collects the robot sources and sinks if the environment changed.
+   */
+  void RefreshSpawners();
+
+  /**
+   * @brief Retires the robots in despawns_ and spawns the robots that are due.
+   * 
+   * @param endTime Simulation time at the end of the current step
+   */
+  void ProcessSpawning(double endTime);
+
+  /**
+   * @brief Gets the time a source spawns a robot.
+   * 
+   * @param entry The source
+   * @param index Number of the spawn, counting from zero
+   * @return The spawn time, or infinity if the source spawns no more robots
+   */
+  static double GetSpawnTime(const SourceEntry& entry, uint64_t index);
+
+  /**
+   * @brief Computes how far every awake robot can advance without an event.
+   * 
+   * @param maxHorizon The largest horizon of interest
+   * @return The smallest horizon over all awake robots, at most maxHorizon
+   */
+  double ComputeEventHorizon(double maxHorizon) const;
+
+  /**
+   * @brief Computes how far one robot can advance without an event.
+   * 
+   * @param entry The robot
+   * @param maxHorizon The largest horizon of interest
+   * @param obstacleSpeed Upper bound on the speed of every dynamic element
+   * @return The robot's horizon, at most maxHorizon
+   */
+  double ComputeRobotHorizon(const RobotEntry& entry, double maxHorizon,
+                             double obstacleSpeed) const;
+
+  /**
+   * @brief Wakes robots that received commands while sleeping.
+   * 
+   * Also brings active_ up to date after removals.
+   */
+  void ProcessWakeRequests();
+
+  /**
+   * @brief Rebuilds active_ from the robots' sleep flags if robots were removed.
+   */
+  void RefreshActive();
+
+  /**
+   * @brief Puts robots at rest to sleep and wakes sleepers near moving things.
+   */
+  void UpdateSchedule();
+
+  /**
+   * @brief Puts an awake robot to sleep; the caller removes it from active_.
+   * 
+   * @param index Index of the robot
+   */
+  void Sleep(size_t index);
+
+  /**
+   * @brief Wakes a sleeping robot and appends it to active_.
+   * 
+   * @param index Index of the robot
+   */
+  void Wake(size_t index);
+
+  /**
+   * @brief Wakes every sleeping robot.
+   */
+  void WakeAll();
+
+  /**
+   * @brief Wakes the sleeping robots inside a region.
+   * 
+   * @param region The region
+   * @param maxDistance If non-negative, only robots within this distance of
+   *                    the region's center are woken
+   */
+  void WakeInRegion(const Eigen::AlignedBox2d& region, double maxDistance);
+
+  /**
+   * @brief Rebuilds the active list and sleeping grid, e.g. after the wake radius changed.
+   */
+  void RebuildSchedule();
+
+  /**
+   * @brief Gets the sleeping grid cell of a position.
+   * 
+   * @param x Column of the cell
+   * @param y Row of the cell
+   * @return The cell key
+   */
+  static uint64_t CellKey(int64_t x, int64_t y);
+
+  /**
+   * @brief Gets the sleeping grid column or row of a coordinate.
+   * 
+   * @param coordinate World coordinate
+   * @return The cell index
+   */
+  int64_t CellOf(double coordinate) const;
+
+  /**
+   * @brief Notifies the observers that asked for the state of the current step.
    * 
    * @param state The current state of the simulation
    */
@@ -168,19 +899,22 @@ class SimulationEngine {
   /**
    * @brief Notifies all observers of a collision.
    * 
-   * @param robot The robot involved in the collision
+   * Stops early if an observer removes the robot.
+   * 
+   * @param robot Handle of the robot involved in the collision
    * @param object The object involved in the collision
    */
-  void NotifyCollision(const MobileRobotBase* robot, const void* object) const;
+  void NotifyCollision(RobotHandle robot, const void* object) const;
 
   /**
    * @brief Notifies all observers of a robot reaching a merge point.
    * 
-   * @param robot The robot that reached the merge point
+   * Stops early if an observer removes the robot.
+   * 
+   * @param robot Handle of the robot that reached the merge point
    * @param mergePoint The merge point that was reached
    */
-  void NotifyMergePoint(const MobileRobotBase* robot, 
-                        const EnvironmentElement* mergePoint) const;
+  void NotifyMergePoint(RobotHandle robot, const EnvironmentElement* mergePoint) const;
 };
 
 } // namespace mobilerobotsim
@@ -31,7 +31,7 @@ class SimulationObserver {
    * 
    * @param state Reference to the current state of the simulation
    */
-  virtual void onStep(const SystemState& state) = 0;
+  virtual void OnStep(const SystemState& state) = 0;
 
   /**
    * @brief Called when a collision is detected.
@@ -42,7 +42,7 @@ class SimulationObserver {
    * @param robot Pointer to the robot involved in the collision
    * @param object Pointer to the object involved in the collision
    */
-  virtual void onCollision(const MobileRobotBase* robot, 
+  virtual void OnCollision(const MobileRobotBase* robot, 
                           const void* object) = 0;
 
   /**
@@ -54,8 +54,20 @@ class SimulationObserver {
    * @param robot Pointer to the robot that reached the merge point
    * @param mergePoint Pointer to the merge point that was reached
    */
-  virtual void onMergePoint(const MobileRobotBase* robot, 
+  virtual void OnMergePoint(const MobileRobotBase* robot, 
                            const EnvironmentElement* mergePoint) = 0;
+
+  /**
+   * @brief Checks whether the observer reads the state passed to OnStep().
+   *
+   * Engines call this once per step for every observer, before the step's
+   * OnStep() calls, and only build a SystemState if some observer needs it.
+   * Observers that only handle events, or that skip some steps, return
+   * false for those steps, in which case OnStep() is not called.
+   *
+   * @return True if OnStep() should be called for this step, false otherwise
+   */
+  virtual bool NeedsStepState() { return true; }
 };
 
 } // namespace mobilerobotsim
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Generational handle to a value in a SlotMap.
+ *
+ * A handle stays valid until its value is erased, no matter how many other
+ * values are inserted or erased. Reusing a slot bumps its generation, so a
+ * stale handle never refers to a newer value. The default handle is invalid.
+ */
+struct SlotHandle {
+  static constexpr uint32_t kInvalidIndex = 0xffffffffu;
+
+  uint32_t index = kInvalidIndex;  ///< Slot index
+  uint32_t generation = 0;         ///< Generation of the slot when the handle was issued
+
+  /**
+   * @brief Checks whether the handle was issued by a SlotMap.
+   *
+   * @return False for the default handle; an issued handle may still be stale
+   */
+  bool IsValid() const { return index != kInvalidIndex; }
+
+  bool operator==(const SlotHandle& other) const {
+    return index == other.index && generation == other.generation;
+  }
+
+  bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Densely stored values addressed by stable generational handles.
+ *
+ * Values live contiguously in insertion order until one is erased; Erase()
+ * moves the last value into the hole, so insertion, erasure and handle
+ * lookup are all O(1) and iteration touches only live values. Dense indices
+ * are therefore not stable across erasure, but handles are.
+ *
+ * @tparam T Movable value type
+ */
+template <typename T>
+class SlotMap {
+ public:
+  /**
+   * @brief Inserts a value at the end of the dense storage.
+   *
+   * @param value The value
+   * @return The value's handle
+   */
+  SlotHandle Insert(T value) {
+    uint32_t slot;
+    if (freeHead_ != SlotHandle::kInvalidIndex) {
+      slot = freeHead_;
+      freeHead_ = slots_[slot].dense;
+    } else {
+      slot = static_cast<uint32_t>(slots_.size());
+      slots_.push_back({1, 0});
+    }
+
+    slots_[slot].dense = static_cast<uint32_t>(values_.size());
+    values_.push_back(std::move(value));
+    denseToSlot_.push_back(slot);
+    return {slot, slots_[slot].generation};
+  }
+
+  /**
+   * @brief Erases a value, moving the last value into its place.
+   *
+   * @param handle The value's handle
+   * @return True if the value was erased, false if the handle is stale
+   */
+  bool Erase(const SlotHandle& handle) {
+    if (!Contains(handle)) {
+      return false;
+    }
+
+    Slot& slot = slots_[handle.index];
+    const uint32_t dense = slot.dense;
+    const uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+    if (dense != last) {
+      values_[dense] = std::move(values_[last]);
+      denseToSlot_[dense] = denseToSlot_[last];
+      slots_[denseToSlot_[dense]].dense = dense;
+    }
+    values_.pop_back();
+    denseToSlot_.pop_back();
+
+    ++slot.generation;
+    slot.dense = freeHead_;
+    freeHead_ = handle.index;
+    return true;
+  }
+
+  /**
+   * @brief Reserves storage so that inserting up to a number of values does not allocate.
+   *
+   * @param count The number of values
+   */
+  void Reserve(size_t count) {
+    values_.reserve(count);
+    denseToSlot_.reserve(count);
+    slots_.reserve(count);
+  }
+
+  /**
+   * @brief Removes every value and invalidates every handle.
+   */
+  void Clear() {
+    while (!values_.empty()) {
+      Erase(GetHandle(values_.size() - 1));
+    }
+  }
+
+  /**
+   * @brief Checks whether a handle refers to a live value.
+   *
+   * @param handle The handle
+   * @return True if the value has not been erased, false otherwise
+   */
+  bool Contains(const SlotHandle& handle) const {
+    return handle.index < slots_.size() && slots_[handle.index].generation == handle.generation;
+  }
+
+  /**
+   * @brief Looks up a value.
+   *
+   * @param handle The value's handle
+   * @return The value, or nullptr if the handle is stale
+   */
+  T* Find(const SlotHandle& handle) {
+    return Contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+  }
+
+  /**
+   * @brief Looks up a value.
+   *
+   * @param handle The value's handle
+   * @return The value, or nullptr if the handle is stale
+   */
+  const T* Find(const SlotHandle& handle) const {
+    return Contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+  }
+
+  /**
+   * @brief Gets the dense index of a value.
+   *
+   * @param handle The value's handle; must not be stale
+   * @return The dense index
+   */
+  size_t IndexOf(const SlotHandle& handle) const { return slots_[handle.index].dense; }
+
+  /**
+   * @brief Gets the handle of the value at a dense index.
+   *
+   * @param index The dense index
+   * @return The value's handle
+   */
+  SlotHandle GetHandle(size_t index) const {
+    const uint32_t slot = denseToSlot_[index];
+    return {slot, slots_[slot].generation};
+  }
+
+  /**
+   * @brief Gets the number of values.
+   *
+   * @return The number of values
+   */
+  size_t size() const { return values_.size(); }
+
+  /**
+   * @brief Checks whether there are no values.
+   *
+   * @return True if the map is empty, false otherwise
+   */
+  bool empty() const { return values_.empty(); }
+
+  T& operator[](size_t index) { return values_[index]; }
+  const T& operator[](size_t index) const { return values_[index]; }
+
+  typename std::vector<T>::iterator begin() { return values_.begin(); }
+  typename std::vector<T>::iterator end() { return values_.end(); }
+  typename std::vector<T>::const_iterator begin() const { return values_.begin(); }
+  typename std::vector<T>::const_iterator end() const { return values_.end(); }
+
+ private:
+  struct Slot {
+    uint32_t generation;  ///< Incremented whenever the slot's value is erased
+    uint32_t dense;       ///< Dense index while live, next free slot while free
+  };
+
+  std::vector<T> values_;              ///< Live values, densely packed
+  std::vector<uint32_t> denseToSlot_;  ///< Slot of each dense value
+  std::vector<Slot> slots_;            ///< Slots, indexed by handle index
+  uint32_t freeHead_ = SlotHandle::kInvalidIndex;  ///< First free slot
+};
+
+}  // namespace mobilerobotsim
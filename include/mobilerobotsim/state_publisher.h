@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "simulation_observer.h"
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class SystemState;
+class MobileRobotBase;
+class EnvironmentElement;
+
+/**
+ * @brief Pose of one robot as stored in shared memory.
+ */
+struct PublishedPose {
+  uint32_t index;       ///< Slot index of the robot's handle
+  uint32_t generation;  ///< Generation of the robot's handle
+  double x;             ///< X position in meters
+  double y;             ///< Y position in meters
+  double orientation;   ///< Orientation in radians
+};
+
+/**
+ * @brief Publishes robot poses into a POSIX shared-memory ring buffer.
+ *
+ * Each step's poses are written into the next slot of a ring of fixed-size
+ * slots, so readers in other processes (see StateReader) can access the
+ * latest steps directly in the mapping. Every slot is guarded by a seqlock:
+ * its sequence counter is odd while the slot is being written, and readers
+ * validate a read by checking that the counter is even and unchanged
+ * afterwards. The publisher never waits for readers, and readers never
+ * block each other or the publisher.
+ *
+ * Slots hold a fixed number of robots; robots beyond the capacity are left
+ * out, and the total count is published so readers can tell.
+ */
+class StatePublisher : public SimulationObserver {
+ public:
+  /**
+   * @brief Default constructor. Publishes nothing until Open() succeeds.
+   */
+  StatePublisher();
+
+  /**
+   * @brief Destructor. Unmaps and removes the segment.
+   */
+  ~StatePublisher() override;
+
+  StatePublisher(const StatePublisher&) = delete;
+  StatePublisher& operator=(const StatePublisher&) = delete;
+
+  /**
+   * @brief Creates the shared-memory segment, replacing one of the same name.
+   *
+   * @param name Segment name, e.g. "/mobilerobotsim"; a leading slash is added if missing
+   * @param slotCount Number of steps kept; at least one
+   * @param capacity Maximum number of robots per step
+   * @return True if the segment was created, false otherwise
+   */
+  bool Open(const std::string& name, size_t slotCount, size_t capacity);
+
+  /**
+   * @brief Unmaps and removes the segment. Mapped readers keep their view.
+   */
+  void Close();
+
+  /**
+   * @brief Checks whether a segment is open.
+   *
+   * @return True if a segment is open, false otherwise
+   */
+  bool IsOpen() const { return data_ != nullptr; }
+
+  /**
+   * @brief Publishes the poses of the robots in a state.
+   *
+   * @param state Reference to the current state of the simulation
+   */
+  void OnStep(const SystemState& state) override;
+
+  /**
+   * @brief Called when a collision is detected. Not published.
+   *
+   * @param robot Pointer to the robot involved in the collision
+   * @param object Pointer to the object involved in the collision
+   */
+  void OnCollision(const MobileRobotBase* robot, const void* object) override;
+
+  /**
+   * @brief Called when a robot reaches a merge point. Not published.
+   *
+   * @param robot Pointer to the robot that reached the merge point
+   * @param mergePoint Pointer to the merge point that was reached
+   */
+  void OnMergePoint(const MobileRobotBase* robot,
+                    const EnvironmentElement* mergePoint) override;
+
+  /**
+   * @brief Gets the number of steps published since Open().
+   *
+   * @return The number of steps
+   */
+  uint64_t GetPublishedCount() const { return published_; }
+
+ private:
+  std::string name_;   ///< Segment name
+  uint8_t* data_;      ///< Start of the mapping
+  size_t size_;        ///< Length of the mapping in bytes
+  size_t slotCount_;   ///< Number of slots in the ring
+  size_t capacity_;    ///< Robots per slot
+  size_t slotBytes_;   ///< Stride between slots
+  uint64_t published_; ///< Steps published so far
+};
+
+/**
+ * @brief Reads robot poses published by a StatePublisher, typically in another process.
+ *
+ * Steps are identified by their sequence number, counted from zero since the
+ * publisher opened the segment. A step stays readable until the publisher
+ * wraps around the ring and overwrites it.
+ */
+class StateReader {
+ public:
+  /**
+   * @brief One published step, copied out of shared memory.
+   */
+  struct Snapshot {
+    uint64_t sequence = 0;               ///< Sequence number of the step
+    double time = 0.0;                   ///< Simulation time of the step
+    uint64_t robotCount = 0;             ///< Robots in the step, including any left out
+    std::vector<PublishedPose> poses;    ///< Poses of at most the slot capacity of robots
+  };
+
+  /// Visitor over the poses of a step in place; takes the poses and their count
+  using PoseVisitor = std::function<void(const PublishedPose*, size_t)>;
+
+  /**
+   * @brief Default constructor. Creates an unmapped reader.
+   */
+  StateReader();
+
+  /**
+   * @brief Destructor. Unmaps the segment.
+   */
+  ~StateReader();
+
+  StateReader(const StateReader&) = delete;
+  StateReader& operator=(const StateReader&) = delete;
+
+  /**
+   * @brief Maps a segment created by a StatePublisher read-only.
+   *
+   * @param name Segment name as given to StatePublisher::Open()
+   * @return True if the segment was mapped and has the expected layout, false otherwise
+   */
+  bool Open(const std::string& name);
+
+  /**
+   * @brief Unmaps the segment.
+   */
+  void Close();
+
+  /**
+   * @brief Checks whether a segment is mapped.
+   *
+   * @return True if a segment is mapped, false otherwise
+   */
+  bool IsOpen() const { return data_ != nullptr; }
+
+  /**
+   * @brief Gets the number of steps published so far.
+   *
+   * @return The number of steps; the latest has sequence number one less
+   */
+  uint64_t GetPublishedCount() const;
+
+  /**
+   * @brief Gets the number of steps the ring keeps.
+   *
+   * @return The number of slots
+   */
+  size_t GetSlotCount() const { return slotCount_; }
+
+  /**
+   * @brief Gets the maximum number of robots per step.
+   *
+   * @return The slot capacity
+   */
+  size_t GetCapacity() const { return capacity_; }
+
+  /**
+   * @brief Copies a step out of shared memory.
+   *
+   * @param sequence Sequence number of the step
+   * @param snapshot Output parameter; its storage is reused
+   * @return True if the step was read, false if it is not published yet or was overwritten
+   */
+  bool Read(uint64_t sequence, Snapshot& snapshot) const;
+
+  /**
+   * @brief Copies the latest step out of shared memory.
+   *
+   * @param snapshot Output parameter; its storage is reused
+   * @return True if a step was read, false if nothing is published yet
+   */
+  bool ReadLatest(Snapshot& snapshot) const;
+
+  /**
+   * @brief Visits the poses of a step in shared memory without copying them.
+   *
+   * The visitor runs while the publisher may be overwriting the slot; its
+   * results are only valid if this returns true.
+   *
+   * @param sequence Sequence number of the step
+   * @param visitor Called with the poses of the step
+   * @return True if the slot held the step throughout the visit, false otherwise
+   */
+  bool Visit(uint64_t sequence, const PoseVisitor& visitor) const;
+
+ private:
+  const uint8_t* data_;  ///< Start of the mapping
+  size_t size_;          ///< Length of the mapping in bytes
+  size_t slotCount_;     ///< Number of slots in the ring
+  size_t capacity_;      ///< Robots per slot
+  size_t slotBytes_;     ///< Stride between slots
+};
+
+}  // namespace mobilerobotsim
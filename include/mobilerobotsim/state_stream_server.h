@@ -0,0 +1,237 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "simulation_observer.h"
+#include "state_publisher.h"
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class SystemState;
+class MobileRobotBase;
+class EnvironmentElement;
+
+/**
+ * @brief Message a client sends to subscribe to a StateStreamServer.
+ *
+ * Messages are sent in host byte order and may be sent again at any time
+ * to change the subscription.
+ */
+struct StreamSubscription {
+  static constexpr uint32_t kMagic = 0x5342534du;  ///< "MSBS"
+
+  uint32_t magic = kMagic;  ///< Must be kMagic
+  uint32_t decimation = 1;  ///< Send every n-th step; zero is taken as one
+  double minX = 1.0;        ///< Region of interest; an empty region selects every robot
+  double minY = 1.0;        ///< See minX
+  double maxX = 0.0;        ///< See minX
+  double maxY = 0.0;        ///< See minX
+};
+
+/**
+ * @brief Header of a frame sent by a StateStreamServer, followed by its poses.
+ */
+struct StreamFrameHeader {
+  static constexpr uint32_t kMagic = 0x4652534du;  ///< "MSRF"
+
+  uint32_t magic;       ///< Always kMagic
+  uint32_t robotCount;  ///< Number of PublishedPose records that follow
+  uint64_t sequence;    ///< Step number, counted from zero since the server opened
+  double time;          ///< Simulation time of the step
+};
+
+/**
+ * @brief Streams robot poses to clients on a Unix domain socket.
+ *
+ * As a SimulationObserver the server only copies the poses of each step
+ * into a buffer and wakes its I/O thread; the simulation never waits for
+ * the network. The I/O thread multiplexes the listening socket and all
+ * clients with epoll and encodes one frame per client into that client's
+ * own send buffer, which is reused from frame to frame. Steps that no
+ * subscribed client's decimation makes due are not captured at all.
+ *
+ * A client receives nothing until it sends a StreamSubscription, which sets
+ * its decimation and region of interest. Each frame is a StreamFrameHeader
+ * followed by the PublishedPose records of the robots in the region. A
+ * client that has not taken the previous frame off its send buffer yet
+ * skips frames, which are counted as dropped, so a slow client only ever
+ * falls behind itself. If steps come faster than the I/O thread runs, it
+ * takes the latest one and the sequence numbers clients see jump.
+ */
+class StateStreamServer : public SimulationObserver {
+ public:
+  /**
+   * @brief Default constructor. Streams nothing until Open() succeeds.
+   */
+  StateStreamServer();
+
+  /**
+   * @brief Destructor. Disconnects every client and removes the socket.
+   */
+  ~StateStreamServer() override;
+
+  StateStreamServer(const StateStreamServer&) = delete;
+  StateStreamServer& operator=(const StateStreamServer&) = delete;
+
+  /**
+   * @brief Listens on a socket path and starts the I/O thread.
+   *
+   * A socket left at the path, e.g. by a server that crashed, is replaced;
+   * any other file is left alone and the call fails.
+   *
+   * @param path The socket path
+   * @return True if the server is listening, false otherwise
+   */
+  bool Open(const std::string& path);
+
+  /**
+   * @brief Stops the I/O thread, disconnects every client and removes the socket.
+   */
+  void Close();
+
+  /**
+   * @brief Checks whether the server is listening.
+   *
+   * @return True if the server is listening, false otherwise
+   */
+  bool IsOpen() const { return thread_.joinable(); }
+
+  /**
+   * @brief Hands the poses of the robots in a state to the I/O thread.
+   *
+   * @param state Reference to the current state of the simulation
+   */
+  void OnStep(const SystemState& state) override;
+
+  /**
+   * @brief Counts the step and asks for its state only if a subscribed client wants it.
+   *
+   * @return True if some client's decimation makes the step due, false otherwise
+   */
+  bool NeedsStepState() override;
+
+  /**
+   * @brief Called when a collision is detected. Not streamed.
+   *
+   * @param robot Pointer to the robot involved in the collision
+   * @param object Pointer to the object involved in the collision
+   */
+  void OnCollision(const MobileRobotBase* robot, const void* object) override;
+
+  /**
+   * @brief Called when a robot reaches a merge point. Not streamed.
+   *
+   * @param robot Pointer to the robot that reached the merge point
+   * @param mergePoint Pointer to the merge point that was reached
+   */
+  void OnMergePoint(const MobileRobotBase* robot,
+                    const EnvironmentElement* mergePoint) override;
+
+  /**
+   * @brief Gets the number of connected clients that have subscribed.
+   *
+   * @return The number of subscribed clients
+   */
+  size_t GetSubscriberCount() const { return subscribers_.load(); }
+
+  /**
+   * @brief Gets the number of frames sent, summed over clients.
+   *
+   * @return The number of frames
+   */
+  uint64_t GetFramesSent() const { return framesSent_.load(); }
+
+  /**
+   * @brief Gets the number of frames skipped because a client was still busy, summed over clients.
+   *
+   * @return The number of frames
+   */
+  uint64_t GetFramesDropped() const { return framesDropped_.load(); }
+
+ private:
+  /**
+   * @brief A connected client.
+   */
+  struct Client {
+    int fd = -1;                  ///< Connected socket
+    bool subscribed = false;      ///< Whether a subscription was received
+    bool writable = true;         ///< False while waiting for EPOLLOUT
+    uint32_t decimation = 1;      ///< Send every n-th step
+    Eigen::AlignedBox2d region;   ///< Region of interest; empty for every robot
+    uint64_t nextSequence = 0;    ///< First step the next frame may carry
+    std::vector<uint8_t> input;   ///< Partial subscription message
+    std::vector<uint8_t> output;  ///< Send buffer, reused across frames
+    size_t outputSize = 0;        ///< Bytes of the current frame
+    size_t outputSent = 0;        ///< Bytes of the current frame already sent
+  };
+
+  /// Body of the I/O thread
+  void IoLoop();
+
+  /// Accepts every pending connection
+  void AcceptClients();
+
+  /**
+   * @brief Reads subscription messages from a client.
+   *
+   * @param client The client
+   * @return False if the client disconnected or misbehaved
+   */
+  bool ReadClient(Client& client);
+
+  /**
+   * @brief Sends as much of a client's current frame as the socket takes.
+   *
+   * @param client The client
+   * @return False if the client disconnected
+   */
+  bool FlushClient(Client& client);
+
+  /**
+   * @brief Encodes the current step into each due client's buffer and starts sending it.
+   */
+  void Broadcast();
+
+  /**
+   * @brief Disconnects a client.
+   *
+   * @param fd The client's socket
+   */
+  void DropClient(int fd);
+
+  std::string path_;     ///< Socket path
+  int listenFd_;         ///< Listening socket
+  int epollFd_;          ///< epoll instance of the I/O thread
+  int wakeFd_;           ///< eventfd that wakes the I/O thread
+
+  std::vector<PublishedPose> capture_;  ///< Poses being captured by OnStep()
+  uint64_t stepCount_;                  ///< Steps observed since Open()
+
+  std::mutex mutex_;                    ///< Guards the hand-over state below
+  std::vector<PublishedPose> pending_;  ///< Latest captured step
+  uint64_t pendingSequence_;            ///< Step number of pending_
+  double pendingTime_;                  ///< Simulation time of pending_
+  bool hasPending_;                     ///< Whether pending_ holds a new step
+  bool stopping_;                       ///< Set when the server shuts down
+
+  std::vector<PublishedPose> current_;  ///< Step being sent; I/O thread only
+  uint64_t currentSequence_;            ///< Step number of current_
+  double currentTime_;                  ///< Simulation time of current_
+  std::vector<Client> clients_;         ///< Connected clients; I/O thread only
+
+  std::atomic<size_t> subscribers_;     ///< Subscribed clients
+  std::atomic<uint64_t> nextDue_;       ///< First step any subscribed client wants
+  std::atomic<uint64_t> framesSent_;    ///< Frames sent to any client
+  std::atomic<uint64_t> framesDropped_; ///< Frames skipped for busy clients
+  std::thread thread_;                  ///< I/O thread, while open
+};
+
+}  // namespace mobilerobotsim
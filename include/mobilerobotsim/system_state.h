@@ -1,9 +1,14 @@
 #pragma once
 
+#include <functional>
+#include <istream>
+#include <ostream>
 #include <vector>
 #include <memory>
 #include <string>
 
+#include "mobilerobotsim/slot_map.h"
+
 namespace mobilerobotsim {
 
 // Forward declarations
@@ -19,6 +24,9 @@ class EnvironmentState;
  */
 class SystemState {
  public:
+  /// Creates an empty robot state of a registered type
+  using RobotStateFactory = std::function<std::unique_ptr<RobotState>()>;
+
   /**
    * @brief Default constructor.
    */
@@ -84,8 +92,9 @@ class SystemState {
    * @brief Adds a robot state to the system state.
    * 
    * @param robotState The robot state to add
+   * @param handle The robot's handle in the engine, if any
    */
-  void AddRobotState(std::unique_ptr<RobotState> robotState);
+  void AddRobotState(std::unique_ptr<RobotState> robotState, const SlotHandle& handle = {});
 
   /**
    * @brief Gets the robot state at the specified index.
@@ -95,6 +104,14 @@ class SystemState {
    */
   const RobotState* GetRobotState(size_t index) const;
 
+  /**
+   * @brief Gets the engine handle of the robot at the specified index.
+   * 
+   * @param index The index of the robot state
+   * @return The robot's handle, or an invalid handle if there is none
+   */
+  SlotHandle GetRobotHandle(size_t index) const;
+
   /**
    * @brief Gets the number of robot states.
    * 
@@ -116,6 +133,50 @@ class SystemState {
    */
   const EnvironmentState* GetEnvironmentState() const;
 
+  /**
+   * @brief Writes the system state as JSON.
+   * 
+   * The document has the form {"time": ..., "robots": [{"type": ...,
+   * "handle": [index, generation], "state": ...}, ...], "environment": ...}
+   * and is written to the stream as it is produced, without building it in
+   * memory first. "handle" is omitted for robots without one.
+   * 
+   * @param stream The stream to write to
+   * @return True if the whole document was written, false otherwise
+   */
+  bool Write(std::ostream& stream) const;
+
+  /**
+   * @brief Reads a system state written by Write(), replacing the current one.
+   * 
+   * The document is parsed incrementally and each robot is deserialized as
+   * soon as it has been read, so memory use is bounded by the resulting state
+   * plus one robot. Robot states are created through the factories
+   * registered with RegisterRobotStateType().
+   * 
+   * @param stream The stream to read from
+   * @return True if the stream held a valid state of known robot types, false otherwise
+   */
+  bool Read(std::istream& stream);
+
+  /**
+   * @brief Registers a robot state type so that it can be read.
+   * 
+   * PointRobotState and PointRobotStateF are registered by default.
+   * 
+   * @param typeId The type identifier returned by the state's GetTypeId()
+   * @param factory Creates an empty state of the type
+   */
+  static void RegisterRobotStateType(const std::string& typeId, RobotStateFactory factory);
+
+  /**
+   * @brief Creates an empty robot state of a registered type.
+   * 
+   * @param typeId The type identifier
+   * @return The state, or nullptr if the type is not registered
+   */
+  static std::unique_ptr<RobotState> CreateRobotState(const std::string& typeId);
+
   /**
    * @brief Serializes the system state to a string representation.
    * 
@@ -132,12 +193,20 @@ class SystemState {
   bool Deserialize(const std::string& serialized);
 
  private:
+  /**
+   * @brief Removes every robot state and the environment state.
+   */
+  void Clear();
+
   /// The current simulation time in seconds
   double time_;
 
   /// Collection of robot states
   std::vector<std::unique_ptr<RobotState>> robotStates_;
 
+  /// Engine handle of each robot, parallel to robotStates_
+  std::vector<SlotHandle> robotHandles_;
+
   /// Environment state
   std::unique_ptr<EnvironmentState> environmentState_;
 };
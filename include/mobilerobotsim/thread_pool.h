@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Fixed set of worker threads for data-parallel loops.
+ *
+ * ThreadPool splits a loop into one contiguous chunk per thread. The chunk
+ * boundaries only depend on the loop size and the thread count, and the
+ * calling thread runs the first chunk itself, so a pool of one thread runs
+ * the loop inline without any synchronization.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Function run for one chunk: begin index, end index, and chunk number.
+   */
+  using ChunkFunction = std::function<void(size_t begin, size_t end, size_t chunk)>;
+
+  /**
+   * @brief Constructor with thread count.
+   *
+   * @param threadCount Total number of threads including the caller, or zero
+   *                    for the number of hardware threads
+   */
+  explicit ThreadPool(size_t threadCount = 0);
+
+  /**
+   * @brief Destructor. Joins the worker threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Gets the total number of threads, including the caller.
+   *
+   * @return The thread count
+   */
+  size_t GetThreadCount() const { return workers_.size() + 1; }
+
+  /**
+   * @brief Runs a function over [0, count) split into one chunk per thread.
+   *
+   * Returns once every chunk has completed. Must not be called concurrently
+   * or from inside a chunk.
+   *
+   * @param count The number of loop iterations
+   * @param function The function to run for each chunk
+   */
+  void ParallelFor(size_t count, const ChunkFunction& function);
+
+ private:
+  /// Body of each worker thread
+  void WorkerLoop(size_t chunk);
+
+  /// Runs one chunk of the current job
+  void RunChunk(size_t chunk);
+
+  std::vector<std::thread> workers_;  ///< Worker threads; chunk 0 runs on the caller
+  std::mutex mutex_;                  ///< Guards the job state below
+  std::condition_variable wake_;      ///< Signals workers that a job is ready
+  std::condition_variable done_;      ///< Signals the caller that all chunks finished
+  const ChunkFunction* job_;          ///< Current job, valid during ParallelFor()
+  size_t count_;                      ///< Iteration count of the current job
+  size_t generation_;                 ///< Incremented for every job
+  size_t pending_;                    ///< Worker chunks not yet finished
+  bool stopping_;                     ///< Set when the pool shuts down
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace mobilerobotsim {
+
+// Forward declarations
+class BinaryReader;
+class BinaryWriter;
+
+/**
+ * @brief Immutable uniform bucket grid over axis-aligned boxes.
+ *
+ * UniformGridIndex is built once from a set of boxes and then answers point
+ * and box queries by visiting only the buckets that overlap the query. The
+ * buckets are stored in compressed-row form (one offset array plus one item
+ * array), so a built index costs two allocations regardless of its size.
+ *
+ * Items are identified by their position in the vector passed to Build().
+ * Empty boxes mean "extent unknown"; such items are reported by every query.
+ */
+class UniformGridIndex {
+ public:
+  /**
+   * @brief Default constructor. Creates an empty index.
+   */
+  UniformGridIndex() = default;
+
+  /**
+   * @brief Builds the index over the given boxes.
+   *
+   * @param boxes The item boxes; item ids are indices into this vector
+   * @param cellSize Bucket edge length in meters, or a non-positive value to
+   *                 derive it from the mean item extent
+   */
+  void Build(const std::vector<Eigen::AlignedBox2d>& boxes, double cellSize = 0.0);
+
+  /**
+   * @brief Removes all items from the index.
+   */
+  void Clear();
+
+  /**
+   * @brief Writes the built index so that it can be restored without rebuilding.
+   *
+   * @param writer The writer to append the index to
+   */
+  void SaveBinary(BinaryWriter& writer) const;
+
+  /**
+   * @brief Restores an index written by SaveBinary().
+   *
+   * The buckets are checked for consistency, so a corrupt input clears the
+   * index instead of producing out-of-range item ids.
+   *
+   * @param reader The reader positioned at the index
+   * @return True if the index was restored, false otherwise
+   */
+  bool LoadBinary(BinaryReader& reader);
+
+  /**
+   * @brief Gets the number of items the index was built over.
+   *
+   * @return The number of items
+   */
+  size_t GetItemCount() const { return boxes_.size(); }
+
+  /**
+   * @brief Gets the bucket edge length chosen by the last Build().
+   *
+   * @return The cell size in meters
+   */
+  double GetCellSize() const { return cellSize_; }
+
+  /**
+   * @brief Visits every item whose box contains the given point.
+   *
+   * @param point The query point
+   * @param visitor Callable taking the item id; returning true stops the query
+   * @return True if the visitor stopped the query, false otherwise
+   */
+  template <typename Visitor>
+  bool QueryPoint(const Eigen::Vector2d& point, Visitor&& visitor) const;
+
+  /**
+   * @brief Visits every item whose box intersects the given box, once each.
+   *
+   * @param box The query box
+   * @param visitor Callable taking the item id; returning true stops the query
+   * @return True if the visitor stopped the query, false otherwise
+   */
+  template <typename Visitor>
+  bool QueryBox(const Eigen::AlignedBox2d& box, Visitor&& visitor) const;
+
+ private:
+  /// Clamps a world coordinate to a column index
+  int ColumnOf(double x) const;
+
+  /// Clamps a world coordinate to a row index
+  int RowOf(double y) const;
+
+  Eigen::AlignedBox2d bounds_;              ///< Union of all bounded item boxes
+  double cellSize_ = 0.0;                   ///< Bucket edge length
+  int columns_ = 0;                         ///< Number of bucket columns
+  int rows_ = 0;                            ///< Number of bucket rows
+  std::vector<Eigen::AlignedBox2d> boxes_;  ///< Item boxes, indexed by item id
+  std::vector<uint32_t> cellStart_;         ///< Offsets into cellItems_, one per bucket plus one
+  std::vector<uint32_t> cellItems_;         ///< Item ids grouped by bucket
+  std::vector<uint32_t> unboundedItems_;    ///< Items with an empty box
+};
+
+template <typename Visitor>
+bool UniformGridIndex::QueryPoint(const Eigen::Vector2d& point, Visitor&& visitor) const {
+  for (uint32_t id : unboundedItems_) {
+    if (visitor(id)) {
+      return true;
+    }
+  }
+
+  if (columns_ == 0 || !bounds_.contains(point)) {
+    return false;
+  }
+
+  const size_t cell = static_cast<size_t>(RowOf(point.y())) * columns_ + ColumnOf(point.x());
+  for (uint32_t i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i) {
+    const uint32_t id = cellItems_[i];
+    if (boxes_[id].contains(point) && visitor(id)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename Visitor>
+bool UniformGridIndex::QueryBox(const Eigen::AlignedBox2d& box, Visitor&& visitor) const {
+  for (uint32_t id : unboundedItems_) {
+    if (visitor(id)) {
+      return true;
+    }
+  }
+
+  if (columns_ == 0 || !bounds_.intersects(box)) {
+    return false;
+  }
+
+  const int c0 = ColumnOf(box.min().x());
+  const int c1 = ColumnOf(box.max().x());
+  const int r0 = RowOf(box.min().y());
+  const int r1 = RowOf(box.max().y());
+
+  for (int r = r0; r <= r1; ++r) {
+    for (int c = c0; c <= c1; ++c) {
+      const size_t cell = static_cast<size_t>(r) * columns_ + c;
+      for (uint32_t i = cellStart_[cell]; i < cellStart_[cell + 1]; ++i) {
+        const uint32_t id = cellItems_[i];
+        const Eigen::AlignedBox2d& itemBox = boxes_[id];
+        if (!itemBox.intersects(box)) {
+          continue;
+        }
+
+        // Report each item only from the first bucket shared by both boxes
+        const int firstColumn = std::max(c0, ColumnOf(itemBox.min().x()));
+        const int firstRow = std::max(r0, RowOf(itemBox.min().y()));
+        if (firstColumn == c && firstRow == r && visitor(id)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace mobilerobotsim
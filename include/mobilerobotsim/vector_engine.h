@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "counter_rng.h"
+#include "simulation_engine.h"
+#include "thread_pool.h"
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Events one environment produced during a step.
+ */
+struct VectorStepEvents {
+  size_t collisions = 0;   ///< Collisions reported during the step
+  size_t mergePoints = 0;  ///< Merge points reached during the step
+};
+
+/**
+ * @brief Steps many independent engines in lockstep for reinforcement learning.
+ *
+ * Owns a fixed number of environments, each a SimulationEngine built by a
+ * user factory, and advances them in parallel on a thread pool, one chunk of
+ * environments per thread. Each environment has a fixed number of agents,
+ * the first robots of the engine in storage order right after the factory
+ * built it. Actions, observations, rewards and done flags are exchanged
+ * through contiguous arrays whose storage is reused across steps:
+ *
+ * - actions: environmentCount x agentCount x kActionSize target velocities
+ * - observations: environmentCount x agentCount x kObservationSize values
+ *   (x, y, vx, vy); agents that left the engine observe zeros
+ * - rewards: one value per environment
+ * - dones: one flag per environment
+ *
+ * An environment whose episode ended is reset right away by calling the
+ * factory again, so the observation returned for it already belongs to the
+ * next episode; the last observation of the finished episode is kept in the
+ * final observations. Episode seeds come from a counter-based stream per
+ * environment, so results do not depend on the thread count.
+ *
+ * Engines keep their default single thread; the parallelism is across
+ * environments, which avoids oversubscribing the cores.
+ */
+class VectorEngine {
+ public:
+  /**
+   * @brief Builds the engine of a new episode.
+   *
+   * Called concurrently for different environments, so it must be thread-safe.
+   *
+   * @param environment Index of the environment
+   * @param seed Seed of the episode
+   * @return The engine, with its agents added first
+   */
+  using Factory =
+      std::function<std::unique_ptr<SimulationEngine>(size_t environment, uint64_t seed)>;
+
+  /**
+   * @brief Computes the reward of one environment after a step.
+   *
+   * Called concurrently for different environments, so it must be thread-safe.
+   *
+   * @param engine The environment's engine
+   * @param events Events of the step
+   * @param terminal Set to true to end the episode
+   * @return The reward of the step
+   */
+  using RewardFunction = std::function<double(const SimulationEngine& engine,
+                                              const VectorStepEvents& events, bool& terminal)>;
+
+  /// Values per agent in an action: the target velocity (vx, vy)
+  static constexpr size_t kActionSize = 2;
+
+  /// Values per agent in an observation: position (x, y) and velocity (vx, vy)
+  static constexpr size_t kObservationSize = 4;
+
+  /**
+   * @brief Constructor. Environments are built by the first Reset().
+   *
+   * @param environmentCount Number of environments
+   * @param agentCount Number of agents per environment
+   * @param factory Builds the engine of each episode
+   * @param threadCount Number of threads; 0 uses all hardware threads
+   */
+  VectorEngine(size_t environmentCount, size_t agentCount, Factory factory,
+               size_t threadCount = 0);
+
+  /**
+   * @brief Destructor.
+   */
+  ~VectorEngine();
+
+  VectorEngine(const VectorEngine&) = delete;
+  VectorEngine& operator=(const VectorEngine&) = delete;
+
+  /**
+   * @brief Sets the reward function. Without one, rewards are zero and
+   * episodes only end at the step limit.
+   *
+   * @param function The reward function
+   */
+  void SetRewardFunction(RewardFunction function);
+
+  /**
+   * @brief Sets the number of steps after which an episode ends.
+   *
+   * @param steps Maximum episode length in steps; 0 means unlimited (default)
+   */
+  void SetMaxEpisodeSteps(size_t steps);
+
+  /**
+   * @brief Starts a new episode in every environment.
+   *
+   * @param seed Seed from which the episode seeds of all environments derive
+   * @return True if every factory call returned an engine, false otherwise
+   */
+  bool Reset(uint64_t seed);
+
+  /**
+   * @brief Applies actions and steps every environment.
+   *
+   * Environments whose episode ends are reset before the observations are
+   * written.
+   *
+   * @param actions Target velocities, environmentCount x agentCount x kActionSize
+   * @param actionCount Number of values in actions
+   * @param dt Time step in seconds
+   * @return True if the step was taken, false if the action count is wrong,
+   *         Reset() has not succeeded or a factory call failed
+   */
+  bool Step(const double* actions, size_t actionCount, double dt);
+
+  /**
+   * @brief Gets the observations, environmentCount x agentCount x kObservationSize.
+   *
+   * @return The observations after the last Reset() or Step()
+   */
+  const std::vector<double>& GetObservations() const { return observations_; }
+
+  /**
+   * @brief Gets the last observations of the episodes that ended in the last step.
+   *
+   * Laid out like GetObservations(); rows of environments that are not done
+   * hold stale values.
+   *
+   * @return The final observations
+   */
+  const std::vector<double>& GetFinalObservations() const { return finalObservations_; }
+
+  /**
+   * @brief Gets the reward of each environment in the last step.
+   *
+   * @return The rewards
+   */
+  const std::vector<double>& GetRewards() const { return rewards_; }
+
+  /**
+   * @brief Gets whether each environment's episode ended in the last step.
+   *
+   * @return One flag per environment, 1 if done
+   */
+  const std::vector<uint8_t>& GetDones() const { return dones_; }
+
+  /**
+   * @brief Gets the number of environments.
+   *
+   * @return The environment count
+   */
+  size_t GetEnvironmentCount() const { return instances_.size(); }
+
+  /**
+   * @brief Gets the number of agents per environment.
+   *
+   * @return The agent count
+   */
+  size_t GetAgentCount() const { return agentCount_; }
+
+  /**
+   * @brief Gets the number of episodes started since the last Reset(), in all environments.
+   *
+   * @return The episode count
+   */
+  uint64_t GetEpisodeCount() const;
+
+  /**
+   * @brief Gets the engine of an environment, e.g. to inspect it between steps.
+   *
+   * @param environment Index of the environment
+   * @return The engine, or nullptr before the first Reset()
+   */
+  SimulationEngine* GetEngine(size_t environment) const;
+
+ private:
+  class EventCounter;
+
+  /**
+   * @brief One environment and its episode bookkeeping.
+   */
+  struct Instance {
+    std::unique_ptr<SimulationEngine> engine;  ///< Engine of the current episode
+    std::unique_ptr<EventCounter> counter;     ///< Counts the engine's events
+    std::vector<RobotHandle> agents;           ///< Handles of the agents
+    CounterRng seeds;                          ///< Stream of episode seeds
+    size_t steps = 0;                          ///< Steps taken in the current episode
+    uint64_t episodes = 0;                     ///< Episodes started
+  };
+
+  /**
+   * @brief Builds a new episode of one environment.
+   *
+   * @param environment Index of the environment
+   * @return True if the factory returned an engine, false otherwise
+   */
+  bool ResetInstance(size_t environment);
+
+  /**
+   * @brief Writes one environment's observations.
+   *
+   * @param environment Index of the environment
+   * @param observations Start of the environment's row
+   */
+  void Observe(size_t environment, double* observations) const;
+
+  size_t agentCount_;                      ///< Agents per environment
+  Factory factory_;                        ///< Builds the engine of each episode
+  RewardFunction rewardFunction_;          ///< Computes rewards; may be empty
+  size_t maxEpisodeSteps_;                 ///< Episode length limit; 0 is unlimited
+  bool ready_;                             ///< Set once Reset() succeeded
+  std::vector<Instance> instances_;        ///< The environments
+  std::vector<double> observations_;       ///< Current observations
+  std::vector<double> finalObservations_;  ///< Last observations of ended episodes
+  std::vector<double> rewards_;            ///< Rewards of the last step
+  std::vector<uint8_t> dones_;             ///< Done flags of the last step
+  std::unique_ptr<ThreadPool> pool_;       ///< Steps the environments
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,207 @@
+#include "mobilerobotsim/c_api.h"
+#include "mobilerobotsim/fleet_state.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/simulation_engine.h"
+
+#include <memory>
+
+using mobilerobotsim::FleetState;
+using mobilerobotsim::MobileRobotBase;
+using mobilerobotsim::PointRobot;
+using mobilerobotsim::RobotHandle;
+using mobilerobotsim::SimulationEngine;
+
+struct mrs_engine {
+  SimulationEngine engine;
+};
+
+namespace {
+
+static_assert(sizeof(Eigen::Vector2d) == 2 * sizeof(double),
+              "Exported vectors must be packed pairs of doubles");
+static_assert(sizeof(RobotHandle) == 2 * sizeof(uint32_t),
+              "Exported handles must be packed pairs of uint32_t");
+
+RobotHandle ToHandle(mrs_robot_handle handle) {
+  RobotHandle result;
+  result.index = handle.index;
+  result.generation = handle.generation;
+  return result;
+}
+
+// Runs a call, turning exceptions into failure; none may unwind through extern "C" frames
+template <typename Call>
+bool Guard(Call&& call) {
+  try {
+    return call();
+  } catch (...) {
+    return false;
+  }
+}
+
+void ExportPairs(const void* data, mrs_dtype dtype, size_t count, size_t elementSize,
+                 size_t rowSize, mrs_buffer* buffer) {
+  buffer->data = count > 0 ? data : nullptr;
+  buffer->dtype = dtype;
+  buffer->ndim = 2;
+  buffer->shape[0] = static_cast<int64_t>(count);
+  buffer->shape[1] = 2;
+  buffer->strides[0] = static_cast<int64_t>(rowSize);
+  buffer->strides[1] = static_cast<int64_t>(elementSize);
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t mrs_api_version(void) {
+  return MRS_API_VERSION;
+}
+
+mrs_engine* mrs_engine_create(void) {
+  try {
+    return new mrs_engine();
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void mrs_engine_destroy(mrs_engine* engine) {
+  delete engine;
+}
+
+bool mrs_engine_set_thread_count(mrs_engine* engine, size_t thread_count) {
+  return engine != nullptr && Guard([&] {
+           engine->engine.SetThreadCount(thread_count);
+           return true;
+         });
+}
+
+bool mrs_engine_set_seed(mrs_engine* engine, uint64_t seed) {
+  return engine != nullptr && Guard([&] {
+           engine->engine.SetSeed(seed);
+           return true;
+         });
+}
+
+bool mrs_engine_step(mrs_engine* engine, double dt) {
+  return engine != nullptr && Guard([&] {
+           engine->engine.Step(dt);
+           return true;
+         });
+}
+
+bool mrs_engine_advance_to(mrs_engine* engine, double time, double min_step, double max_step) {
+  return engine != nullptr && Guard([&] {
+           engine->engine.AdvanceTo(time, min_step, max_step);
+           return true;
+         });
+}
+
+double mrs_engine_get_time(const mrs_engine* engine) {
+  return engine != nullptr ? engine->engine.GetTime() : 0.0;
+}
+
+size_t mrs_engine_get_robot_count(const mrs_engine* engine) {
+  return engine != nullptr ? engine->engine.GetRobotCount() : 0;
+}
+
+bool mrs_engine_add_point_robot(mrs_engine* engine, double x, double y, double orientation,
+                                double vx, double vy, mrs_robot_handle* handle) {
+  return engine != nullptr && Guard([&] {
+           const RobotHandle added =
+               engine->engine.AddRobot(std::make_unique<PointRobot>(x, y, orientation, vx, vy));
+           if (handle != nullptr) {
+             *handle = {added.index, added.generation};
+           }
+           return true;
+         });
+}
+
+bool mrs_engine_remove_robot(mrs_engine* engine, mrs_robot_handle handle) {
+  return engine != nullptr && Guard([&] { return engine->engine.RemoveRobot(ToHandle(handle)); });
+}
+
+bool mrs_engine_set_target_velocity(mrs_engine* engine, mrs_robot_handle handle, double vx,
+                                    double vy) {
+  return engine != nullptr && Guard([&] {
+           MobileRobotBase* robot = engine->engine.GetRobot(ToHandle(handle));
+           return robot != nullptr && robot->SetTargetVelocity(Eigen::Vector2d(vx, vy));
+         });
+}
+
+bool mrs_engine_schedule_target_velocity(mrs_engine* engine, double time,
+                                         mrs_robot_handle handle, double vx, double vy) {
+  return engine != nullptr && Guard([&] {
+           const Eigen::Vector2d velocity(vx, vy);
+           return engine->engine.ScheduleCommand(
+               time, ToHandle(handle),
+               [velocity](MobileRobotBase& robot) { robot.SetTargetVelocity(velocity); });
+         });
+}
+
+bool mrs_engine_save_state(const mrs_engine* engine, const char* filename) {
+  return engine != nullptr && filename != nullptr &&
+         Guard([&] { return engine->engine.SaveStateToFile(filename); });
+}
+
+bool mrs_engine_load_state(mrs_engine* engine, const char* filename) {
+  return engine != nullptr && filename != nullptr &&
+         Guard([&] { return engine->engine.LoadStateFromFile(filename); });
+}
+
+bool mrs_engine_get_positions(mrs_engine* engine, mrs_buffer* buffer) {
+  if (engine == nullptr || buffer == nullptr) {
+    return false;
+  }
+  return Guard([&] {
+    const FleetState& fleet = engine->engine.GetFleetState();
+    ExportPairs(fleet.positions.data(), MRS_FLOAT64, fleet.positions.size(), sizeof(double),
+                sizeof(Eigen::Vector2d), buffer);
+    return true;
+  });
+}
+
+bool mrs_engine_get_velocities(mrs_engine* engine, mrs_buffer* buffer) {
+  if (engine == nullptr || buffer == nullptr) {
+    return false;
+  }
+  return Guard([&] {
+    const FleetState& fleet = engine->engine.GetFleetState();
+    ExportPairs(fleet.velocities.data(), MRS_FLOAT64, fleet.velocities.size(), sizeof(double),
+                sizeof(Eigen::Vector2d), buffer);
+    return true;
+  });
+}
+
+bool mrs_engine_get_orientations(mrs_engine* engine, mrs_buffer* buffer) {
+  if (engine == nullptr || buffer == nullptr) {
+    return false;
+  }
+  return Guard([&] {
+    const FleetState& fleet = engine->engine.GetFleetState();
+    const size_t count = fleet.orientations.size();
+    buffer->data = count > 0 ? fleet.orientations.data() : nullptr;
+    buffer->dtype = MRS_FLOAT64;
+    buffer->ndim = 1;
+    buffer->shape[0] = static_cast<int64_t>(count);
+    buffer->shape[1] = 1;
+    buffer->strides[0] = sizeof(double);
+    buffer->strides[1] = 0;
+    return true;
+  });
+}
+
+bool mrs_engine_get_handles(mrs_engine* engine, mrs_buffer* buffer) {
+  if (engine == nullptr || buffer == nullptr) {
+    return false;
+  }
+  return Guard([&] {
+    const FleetState& fleet = engine->engine.GetFleetState();
+    ExportPairs(fleet.handles.data(), MRS_UINT32, fleet.handles.size(), sizeof(uint32_t),
+                sizeof(RobotHandle), buffer);
+    return true;
+  });
+}
+
+}  // extern "C"
@@ -0,0 +1,129 @@
+#include "mobilerobotsim/checkpoint_writer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "mobilerobotsim/system_state.h"
+
+namespace mobilerobotsim {
+
+namespace {
+
+// Writes a snapshot next to its destination, then renames it into place
+bool WriteCheckpoint(const SystemState& state, const std::string& filename) {
+  const std::string temporary = filename + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary);
+    if (!file.is_open()) {
+      return false;
+    }
+    if (!state.Write(file)) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+    file.close();
+    if (file.fail()) {
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+
+  if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+CheckpointWriter::CheckpointWriter(size_t maxPending, bool waitWhenFull)
+    : pending_(0),
+      maxPending_(std::max<size_t>(maxPending, 1)),
+      waitWhenFull_(waitWhenFull),
+      skipped_(0),
+      stopping_(false),
+      thread_(&CheckpointWriter::WriterLoop, this) {}
+
+CheckpointWriter::~CheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  jobReady_.notify_one();
+  thread_.join();
+}
+
+std::future<bool> CheckpointWriter::Submit(std::unique_ptr<SystemState> state,
+                                           const std::string& filename) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pending_ >= maxPending_ && !waitWhenFull_) {
+    ++skipped_;
+    std::promise<bool> skipped;
+    skipped.set_value(false);
+    return skipped.get_future();
+  }
+  jobDone_.wait(lock, [this] { return pending_ < maxPending_; });
+
+  jobs_.push_back({std::move(state), filename, std::promise<bool>()});
+  std::future<bool> done = jobs_.back().done.get_future();
+  ++pending_;
+  lock.unlock();
+
+  jobReady_.notify_one();
+  return done;
+}
+
+void CheckpointWriter::SetMaxPending(size_t maxPending) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxPending_ = std::max<size_t>(maxPending, 1);
+  }
+  jobDone_.notify_all();
+}
+
+void CheckpointWriter::SetWaitWhenFull(bool wait) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  waitWhenFull_ = wait;
+}
+
+size_t CheckpointWriter::GetPendingCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_;
+}
+
+uint64_t CheckpointWriter::GetSkippedCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return skipped_;
+}
+
+void CheckpointWriter::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  jobDone_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void CheckpointWriter::WriterLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    jobReady_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      // Only reached when stopping with nothing left to write
+      return;
+    }
+
+    Job job = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+
+    const bool written = WriteCheckpoint(*job.state, job.filename);
+    job.state.reset();
+
+    lock.lock();
+    --pending_;
+    jobDone_.notify_all();
+    job.done.set_value(written);
+  }
+}
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,75 @@
+#include "mobilerobotsim/dynamic_obstacle.h"
+
+#include <nlohmann/json.hpp>
+
+#include "json_stream_reader.h"
+#include "mobilerobotsim/binary_io.h"
+
+namespace mobilerobotsim {
+
+DynamicObstacle::DynamicObstacle(double x, double y, double radius, double vx, double vy)
+    : position_(x, y), velocity_(vx, vy), radius_(radius) {}
+
+DynamicObstacle::~DynamicObstacle() = default;
+
+bool DynamicObstacle::CheckCollision(const Eigen::Vector2d& position) const {
+  return (position - position_).squaredNorm() <= radius_ * radius_;
+}
+
+std::string DynamicObstacle::GetState() const {
+  nlohmann::json state = {{"x", position_.x()},   {"y", position_.y()},
+                          {"vx", velocity_.x()},  {"vy", velocity_.y()},
+                          {"radius", radius_}};
+  return state.dump();
+}
+
+bool DynamicObstacle::LoadState(const std::string& state) {
+  const nlohmann::json parsed = nlohmann::json::parse(state, nullptr, false);
+  if (parsed.is_discarded() || !parsed.is_object() ||
+      !HasNumberMembers(parsed, {"x", "y", "vx", "vy", "radius"})) {
+    return false;
+  }
+
+  position_ = Eigen::Vector2d(parsed.value("x", position_.x()), parsed.value("y", position_.y()));
+  velocity_ = Eigen::Vector2d(parsed.value("vx", velocity_.x()), parsed.value("vy", velocity_.y()));
+  radius_ = parsed.value("radius", radius_);
+  return true;
+}
+
+void DynamicObstacle::Update(double dt) {
+  position_ += velocity_ * dt;
+}
+
+bool DynamicObstacle::SaveBinary(BinaryWriter& writer) const {
+  writer.Write(position_.x());
+  writer.Write(position_.y());
+  writer.Write(velocity_.x());
+  writer.Write(velocity_.y());
+  writer.Write(radius_);
+  return true;
+}
+
+bool DynamicObstacle::LoadBinary(BinaryReader& reader) {
+  double values[5];
+  for (double& value : values) {
+    if (!reader.Read(value)) {
+      return false;
+    }
+  }
+
+  position_ = Eigen::Vector2d(values[0], values[1]);
+  velocity_ = Eigen::Vector2d(values[2], values[3]);
+  radius_ = values[4];
+  return true;
+}
+
+Eigen::AlignedBox2d DynamicObstacle::GetBounds() const {
+  const Eigen::Vector2d extent(radius_, radius_);
+  return Eigen::AlignedBox2d(position_ - extent, position_ + extent);
+}
+
+void DynamicObstacle::SetVelocity(double vx, double vy) {
+  velocity_ = Eigen::Vector2d(vx, vy);
+}
+
+}  // namespace mobilerobotsim
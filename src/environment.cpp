@@ -1,5 +1,15 @@
 #include "mobilerobotsim/environment.h"
 
+#include <nlohmann/json.hpp>
+#include <sstream>
+
+#include "json_stream_reader.h"
+#include "mobilerobotsim/hash.h"
+#include "mobilerobotsim/json_writer.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/robot_sink.h"
+#include "mobilerobotsim/signed_distance_field.h"
+
 namespace mobilerobotsim {
 
 // Implementation of EnvironmentState methods
@@ -22,44 +32,267 @@ size_t EnvironmentState::GetElementStateCount() const {
   return elementTypeIds_.size();
 }
 
+void EnvironmentState::Write(JsonWriter& writer) const {
+  writer.BeginObject();
+  writer.Key("elements");
+  writer.BeginArray();
+  for (size_t i = 0; i < elementTypeIds_.size(); ++i) {
+    writer.BeginObject();
+    writer.Key("type");
+    writer.Value(elementTypeIds_[i]);
+    writer.Key("state");
+    writer.RawValue(elementStates_[i]);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+}
+
+bool EnvironmentState::Read(std::istream& stream) {
+  Clear();
+
+  JsonStreamReader reader;
+  reader.StreamArray("/elements", [this](nlohmann::json& element) {
+    if (!element.is_object() || !element["type"].is_string()) {
+      return false;
+    }
+    AddElementState(element["type"].get<std::string>(), ToSerializedState(element["state"]));
+    return true;
+  });
+
+  nlohmann::json root;
+  return reader.Read(stream, root) && root.is_object();
+}
+
 std::string EnvironmentState::Serialize() const {
-  // Placeholder for serialization
-  return "{}";  // Empty JSON object
+  std::ostringstream stream;
+  JsonWriter writer(stream);
+  Write(writer);
+  return stream.str();
 }
 
 bool EnvironmentState::Deserialize(const std::string& serialized) {
-  // Placeholder for deserialization
-  return true;
+  std::istringstream stream(serialized);
+  return Read(stream);
+}
+
+void EnvironmentState::Clear() {
+  elementTypeIds_.clear();
+  elementStates_.clear();
 }
 
 // Implementation of Environment methods
-Environment::Environment() = default;
+namespace {
+
+// Default region covered by the dynamic element index
+const Eigen::AlignedBox2d kDefaultWorldBounds(Eigen::Vector2d(-1024.0, -1024.0),
+                                              Eigen::Vector2d(1024.0, 1024.0));
+
+}  // namespace
+
+Environment::Environment()
+    : staticIndexValid_(false), dynamicIndex_(kDefaultWorldBounds), revision_(0) {}
 
 Environment::~Environment() = default;
 
+void Environment::SetWorldBounds(const Eigen::AlignedBox2d& bounds) {
+  dynamicIndex_ = LooseQuadtree(bounds);
+  for (size_t i = 0; i < dynamicElements_.size(); ++i) {
+    dynamicIndex_.Insert(static_cast<uint32_t>(i), dynamicElements_[i]->GetBounds());
+  }
+}
+
+const Eigen::AlignedBox2d& Environment::GetWorldBounds() const {
+  return dynamicIndex_.GetWorldBounds();
+}
+
 void Environment::AddElement(std::unique_ptr<EnvironmentElement> element) {
-  elements_.push_back(std::move(element));
+  ++revision_;
+  if (element->IsDynamic()) {
+    dynamicIndex_.Insert(static_cast<uint32_t>(dynamicElements_.size()), element->GetBounds());
+    dynamicElements_.push_back(std::move(element));
+  } else {
+    staticElements_.push_back(std::move(element));
+    staticIndexValid_ = false;
+  }
+}
+
+void Environment::BuildStaticIndex(double cellSize) {
+  std::vector<Eigen::AlignedBox2d> boxes;
+  boxes.reserve(staticElements_.size());
+  for (const auto& element : staticElements_) {
+    boxes.push_back(element->GetBounds());
+  }
+
+  staticIndex_.Build(boxes, cellSize);
+  staticIndexValid_ = true;
+}
+
+bool Environment::HasStaticIndex() const {
+  return staticIndexValid_;
+}
+
+const UniformGridIndex* Environment::GetStaticIndex() const {
+  return staticIndexValid_ ? &staticIndex_ : nullptr;
+}
+
+bool Environment::SetStaticIndex(UniformGridIndex index) {
+  if (index.GetItemCount() != staticElements_.size()) {
+    return false;
+  }
+
+  staticIndex_ = std::move(index);
+  staticIndexValid_ = true;
+  return true;
 }
 
 void Environment::Update(double dt) {
-  // Placeholder for environment update logic
+  for (auto& element : dynamicElements_) {
+    element->Update(dt);
+  }
+
+  RefreshDynamicIndex();
 }
 
 const EnvironmentElement* Environment::CheckCollision(const Eigen::Vector2d& position) const {
-  // Placeholder for collision detection
-  for (const auto& element : elements_) {
-    if (element->CheckCollision(position)) {
-      return element.get();
+  if (const EnvironmentElement* element = CheckStaticCollision(position)) {
+    return element;
+  }
+
+  return CheckDynamicCollision(position);
+}
+
+const EnvironmentElement* Environment::CheckStaticCollision(
+    const Eigen::Vector2d& position) const {
+  if (!staticIndexValid_) {
+    for (const auto& element : staticElements_) {
+      if (element->IsSolid() && element->CheckCollision(position)) {
+        return element.get();
+      }
     }
+    return nullptr;
+  }
+
+  const EnvironmentElement* hit = nullptr;
+  staticIndex_.QueryPoint(position, [&](uint32_t id) {
+    if (staticElements_[id]->IsSolid() && staticElements_[id]->CheckCollision(position)) {
+      hit = staticElements_[id].get();
+      return true;
+    }
+    return false;
+  });
+
+  return hit;
+}
+
+const EnvironmentElement* Environment::CheckDynamicCollision(
+    const Eigen::Vector2d& position) const {
+  const EnvironmentElement* hit = nullptr;
+  dynamicIndex_.QueryPoint(position, [&](uint32_t id) {
+    if (dynamicElements_[id]->IsSolid() && dynamicElements_[id]->CheckCollision(position)) {
+      hit = dynamicElements_[id].get();
+      return true;
+    }
+    return false;
+  });
+
+  return hit;
+}
+
+const EnvironmentElement* Environment::FindMergePoint(const Eigen::Vector2d& position) const {
+  const EnvironmentElement* found = nullptr;
+  ForEachStaticElement(Eigen::AlignedBox2d(position, position),
+                       [&](const EnvironmentElement& element) {
+                         if (dynamic_cast<const MergePoint*>(&element) != nullptr &&
+                             element.CheckCollision(position)) {
+                           found = &element;
+                           return true;
+                         }
+                         return false;
+                       });
+
+  return found;
+}
+
+const EnvironmentElement* Environment::FindRobotSink(const Eigen::Vector2d& position) const {
+  const EnvironmentElement* found = nullptr;
+  ForEachStaticElement(Eigen::AlignedBox2d(position, position),
+                       [&](const EnvironmentElement& element) {
+                         if (dynamic_cast<const RobotSink*>(&element) != nullptr &&
+                             element.CheckCollision(position)) {
+                           found = &element;
+                           return true;
+                         }
+                         return false;
+                       });
+
+  return found;
+}
+
+bool Environment::BuildDistanceField(const Eigen::AlignedBox2d& region, double resolution,
+                                     const std::string& cachePath) {
+  uint64_t key = ComputeStaticHash();
+  key = HashBytes(region.min().data(), 2 * sizeof(double), key);
+  key = HashBytes(region.max().data(), 2 * sizeof(double), key);
+  key = HashBytes(&resolution, sizeof(resolution), key);
+
+  auto field = std::make_unique<SignedDistanceField>();
+  if (cachePath.empty() || !field->LoadCache(cachePath, key)) {
+    if (!field->Build(*this, region, resolution)) {
+      return false;
+    }
+    if (!cachePath.empty()) {
+      field->SaveCache(cachePath, key);
+    }
+  }
+
+  distanceField_ = std::move(field);
+  return true;
+}
+
+const SignedDistanceField* Environment::GetDistanceField() const {
+  return distanceField_.get();
+}
+
+uint64_t EnvironmentElement::HashContent(uint64_t hash) const {
+  return HashString(GetState(), hash);
+}
+
+uint64_t Environment::ComputeStaticHash() const {
+  uint64_t hash = kFnv1aOffsetBasis;
+  for (const auto& element : staticElements_) {
+    hash = HashString(element->GetTypeId(), hash);
+    hash = element->HashContent(hash);
+  }
+  return hash;
+}
+
+uint64_t Environment::GetRevision() const {
+  return revision_;
+}
+
+size_t Environment::GetStaticElementCount() const {
+  return staticElements_.size();
+}
+
+size_t Environment::GetDynamicElementCount() const {
+  return dynamicElements_.size();
+}
+
+void Environment::RefreshDynamicIndex() {
+  for (size_t i = 0; i < dynamicElements_.size(); ++i) {
+    dynamicIndex_.Update(static_cast<uint32_t>(i), dynamicElements_[i]->GetBounds());
   }
-  
-  return nullptr;
 }
 
 std::unique_ptr<EnvironmentState> Environment::GetState() const {
   auto state = std::make_unique<EnvironmentState>();
   
-  for (const auto& element : elements_) {
+  for (const auto& element : staticElements_) {
+    state->AddElementState(element->GetTypeId(), element->GetState());
+  }
+
+  for (const auto& element : dynamicElements_) {
     state->AddElementState(element->GetTypeId(), element->GetState());
   }
   
@@ -67,8 +300,44 @@ std::unique_ptr<EnvironmentState> Environment::GetState() const {
 }
 
 bool Environment::LoadState(const EnvironmentState& state) {
-  // Placeholder for state loading
-  return true;
+  const size_t count = staticElements_.size() + dynamicElements_.size();
+  if (state.GetElementStateCount() != count) {
+    return false;
+  }
+
+  // Elements are matched by position, so check every type before changing anything
+  std::string typeId;
+  std::string elementState;
+  for (size_t i = 0; i < count; ++i) {
+    state.GetElementState(i, typeId, elementState);
+    const EnvironmentElement& element = i < staticElements_.size()
+                                            ? *staticElements_[i]
+                                            : *dynamicElements_[i - staticElements_.size()];
+    if (element.GetTypeId() != typeId) {
+      return false;
+    }
+  }
+
+  const uint64_t staticHash = ComputeStaticHash();
+  bool loaded = true;
+  for (size_t i = 0; i < count; ++i) {
+    state.GetElementState(i, typeId, elementState);
+    EnvironmentElement& element = i < staticElements_.size()
+                                      ? *staticElements_[i]
+                                      : *dynamicElements_[i - staticElements_.size()];
+    if (element.GetState() != elementState) {
+      loaded = element.LoadState(elementState) && loaded;
+    }
+  }
+
+  // Derived static data is only stale if a static element actually changed
+  if (ComputeStaticHash() != staticHash) {
+    staticIndexValid_ = false;
+    distanceField_.reset();
+  }
+  RefreshDynamicIndex();
+  ++revision_;
+  return loaded;
 }
 
 } // namespace mobilerobotsim
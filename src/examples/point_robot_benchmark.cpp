@@ -0,0 +1,99 @@
+#include "mobilerobotsim/basic_simulation_engine.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/simulation_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace mobilerobotsim;
+
+namespace {
+
+// Steps a fleet of robots and reports the update cost per robot and step
+template <typename Scalar>
+void BenchmarkFleet(const char* name, size_t robotCount, int steps) {
+    std::vector<BasicPointRobot<Scalar>> fleet;
+    fleet.reserve(robotCount);
+    for (size_t i = 0; i < robotCount; ++i) {
+        fleet.emplace_back(Scalar(i % 1000), Scalar(i / 1000));
+        fleet.back().SetTargetVelocity(Scalar(1), Scalar(0.5));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; ++step) {
+        for (auto& robot : fleet) {
+            robot.UpdateState(0.05);
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << ": " << sizeof(BasicPointRobot<Scalar>) << " bytes/robot, "
+              << 1e9 * seconds / (double(robotCount) * steps) << " ns/robot-step" << std::endl;
+}
+
+// Drives a float and a double robot through the same commands for one hour
+// at 50 ms and reports the largest position difference
+void MeasureFloatError() {
+    PointRobot reference(100.0, -50.0);
+    PointRobotF single(100.0f, -50.0f);
+    double maxError = 0.0;
+    for (int step = 0; step < 72000; ++step) {
+        // New command every minute
+        if (step % 1200 == 0) {
+            const double vx = 2.0 * std::sin(0.001 * step);
+            const double vy = 1.5 * std::cos(0.0013 * step);
+            reference.SetTargetVelocity(vx, vy);
+            single.SetTargetVelocity(float(vx), float(vy));
+        }
+        reference.UpdateState(0.05);
+        single.UpdateState(0.05);
+        maxError = std::max(maxError, (reference.GetPosition() - single.GetPosition()).norm());
+    }
+
+    std::cout << "float vs double over 1 h at 50 ms: max position error " << maxError << " m"
+              << std::endl;
+}
+
+// Steps the same fleet in the polymorphic and the compile-time typed engine
+void BenchmarkEngines(size_t robotCount, int steps) {
+    SimulationEngine dynamicEngine;
+    BasicSimulationEngine<PointRobot> staticEngine;
+    for (size_t i = 0; i < robotCount; ++i) {
+        PointRobot robot(double(i % 1000), double(i / 1000));
+        robot.SetTargetVelocity(1.0, 0.5);
+        dynamicEngine.AddRobot(std::make_unique<PointRobot>(robot));
+        staticEngine.AddRobot(robot);
+    }
+
+    const auto time = [&](auto& engine) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; ++step) {
+            engine.Step(0.05);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        return 1e9 * std::chrono::duration<double>(end - start).count() /
+               (double(robotCount) * steps);
+    };
+
+    std::cout << "SimulationEngine: " << time(dynamicEngine) << " ns/robot-step" << std::endl;
+    std::cout << "BasicSimulationEngine<PointRobot>: " << time(staticEngine)
+              << " ns/robot-step" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    const size_t robotCount = 1000000;
+    const int steps = 20;
+
+    BenchmarkFleet<double>("double", robotCount, steps);
+    BenchmarkFleet<float>("float ", robotCount, steps);
+    MeasureFloatError();
+    BenchmarkEngines(robotCount / 10, steps);
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "json_stream_reader.h"
+
+namespace mobilerobotsim {
+
+void JsonStreamReader::StreamArray(const std::string& path, ElementCallback callback) {
+  streams_.emplace_back(path, std::move(callback));
+}
+
+bool JsonStreamReader::Read(std::istream& stream, nlohmann::json& root) {
+  root = nullptr;
+  root_ = &root;
+  stack_.clear();
+  element_ = nullptr;
+  return nlohmann::json::sax_parse(stream, this);
+}
+
+bool JsonStreamReader::Read(const char* data, size_t size, nlohmann::json& root) {
+  root = nullptr;
+  root_ = &root;
+  stack_.clear();
+  element_ = nullptr;
+  return nlohmann::json::sax_parse(data, data + size, this);
+}
+
+bool JsonStreamReader::null() {
+  Place(nullptr);
+  return Emit();
+}
+
+bool JsonStreamReader::boolean(bool value) {
+  Place(value);
+  return Emit();
+}
+
+bool JsonStreamReader::number_integer(number_integer_t value) {
+  Place(value);
+  return Emit();
+}
+
+bool JsonStreamReader::number_unsigned(number_unsigned_t value) {
+  Place(value);
+  return Emit();
+}
+
+bool JsonStreamReader::number_float(number_float_t value, const string_t& /*text*/) {
+  Place(value);
+  return Emit();
+}
+
+bool JsonStreamReader::string(string_t& value) {
+  Place(std::move(value));
+  return Emit();
+}
+
+bool JsonStreamReader::binary(binary_t& value) {
+  Place(nlohmann::json::binary(std::move(value)));
+  return Emit();
+}
+
+bool JsonStreamReader::start_object(std::size_t /*elements*/) {
+  std::string path;
+  if (!stack_.empty()) {
+    const Frame& parent = stack_.back();
+    path = parent.path + (parent.value->is_object() ? "/" + key_ : std::string("/-"));
+  }
+
+  nlohmann::json* value = Place(nlohmann::json::object());
+  stack_.push_back({value, std::move(path), nullptr});
+  return true;
+}
+
+bool JsonStreamReader::key(string_t& value) {
+  key_ = std::move(value);
+  return true;
+}
+
+bool JsonStreamReader::end_object() {
+  stack_.pop_back();
+  return Emit();
+}
+
+bool JsonStreamReader::start_array(std::size_t /*elements*/) {
+  std::string path;
+  if (!stack_.empty()) {
+    const Frame& parent = stack_.back();
+    path = parent.path + (parent.value->is_object() ? "/" + key_ : std::string("/-"));
+  }
+
+  const ElementCallback* stream = nullptr;
+  for (const auto& entry : streams_) {
+    if (entry.first == path) {
+      stream = &entry.second;
+      break;
+    }
+  }
+
+  nlohmann::json* value = Place(nlohmann::json::array());
+  stack_.push_back({value, std::move(path), stream});
+  return true;
+}
+
+bool JsonStreamReader::end_array() {
+  stack_.pop_back();
+  return Emit();
+}
+
+bool JsonStreamReader::parse_error(std::size_t /*position*/, const std::string& /*lastToken*/,
+                                   const nlohmann::json::exception& /*error*/) {
+  return false;
+}
+
+nlohmann::json* JsonStreamReader::Place(nlohmann::json value) {
+  if (stack_.empty()) {
+    *root_ = std::move(value);
+    return root_;
+  }
+
+  const Frame& parent = stack_.back();
+  if (parent.stream != nullptr) {
+    element_ = std::move(value);
+    return &element_;
+  }
+
+  if (parent.value->is_object()) {
+    nlohmann::json& member = (*parent.value)[key_];
+    member = std::move(value);
+    return &member;
+  }
+
+  parent.value->push_back(std::move(value));
+  return &parent.value->back();
+}
+
+bool JsonStreamReader::Emit() {
+  if (stack_.empty() || stack_.back().stream == nullptr) {
+    return true;
+  }
+
+  const bool accepted = (*stack_.back().stream)(element_);
+  element_ = nullptr;
+  return accepted;
+}
+
+}  // namespace mobilerobotsim
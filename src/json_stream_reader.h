@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <istream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Converts a "state" member back to the string GetState() or Serialize() returned.
+ *
+ * States are embedded as JSON when they are objects or arrays and as strings otherwise.
+ *
+ * @param state The member
+ * @return The serialized state
+ */
+inline std::string ToSerializedState(const nlohmann::json& state) {
+  return state.is_string() ? state.get<std::string>() : state.dump();
+}
+
+/**
+ * @brief Checks that the listed members of an object are numbers where present.
+ *
+ * nlohmann::json::value() throws if a member has another type, so states
+ * are checked with this before their members are read.
+ *
+ * @param object The object
+ * @param keys Names of the members
+ * @return True if no listed member has another type, false otherwise
+ */
+inline bool HasNumberMembers(const nlohmann::json& object,
+                             std::initializer_list<const char*> keys) {
+  return std::all_of(keys.begin(), keys.end(), [&](const char* key) {
+    const auto member = object.find(key);
+    return member == object.end() || member->is_number();
+  });
+}
+
+/**
+ * @brief Checks that the listed members of an object are strings where present.
+ *
+ * @param object The object
+ * @param keys Names of the members
+ * @return True if no listed member has another type, false otherwise
+ */
+inline bool HasStringMembers(const nlohmann::json& object,
+                             std::initializer_list<const char*> keys) {
+  return std::all_of(keys.begin(), keys.end(), [&](const char* key) {
+    const auto member = object.find(key);
+    return member == object.end() || member->is_string();
+  });
+}
+
+/**
+ * @brief SAX-style JSON reader that streams the elements of large arrays.
+ *
+ * Library-internal; nlohmann_json is a private dependency. The reader parses
+ * a document incrementally from a stream. Arrays registered with
+ * StreamArray() are never materialized: each of their elements is built on
+ * its own, handed to the callback and discarded, so reading a document with
+ * millions of robots needs memory for one robot at a time. Everything else
+ * is collected into the root value returned by Read(). Streamed arrays must
+ * not be nested inside one another.
+ */
+class JsonStreamReader : public nlohmann::json::json_sax_t {
+ public:
+  /// Receives one element of a streamed array; returning false aborts the read
+  using ElementCallback = std::function<bool(nlohmann::json& element)>;
+
+  /**
+   * @brief Streams the elements of an array to a callback instead of collecting them.
+   *
+   * @param path Location of the array as a JSON pointer, e.g. "/environment/elements"
+   * @param callback Receives each element
+   */
+  void StreamArray(const std::string& path, ElementCallback callback);
+
+  /**
+   * @brief Reads a document.
+   *
+   * @param stream The stream to read from
+   * @param root Receives the document without the streamed array elements
+   * @return True if the document was well-formed and no callback failed, false otherwise
+   */
+  bool Read(std::istream& stream, nlohmann::json& root);
+
+  /**
+   * @brief Reads a document from memory, e.g. a mapped file.
+   *
+   * @param data Start of the document
+   * @param size Length of the document in bytes
+   * @param root Receives the document without the streamed array elements
+   * @return True if the document was well-formed and no callback failed, false otherwise
+   */
+  bool Read(const char* data, size_t size, nlohmann::json& root);
+
+  bool null() override;
+  bool boolean(bool value) override;
+  bool number_integer(number_integer_t value) override;
+  bool number_unsigned(number_unsigned_t value) override;
+  bool number_float(number_float_t value, const string_t& text) override;
+  bool string(string_t& value) override;
+  bool binary(binary_t& value) override;
+  bool start_object(std::size_t elements) override;
+  bool key(string_t& value) override;
+  bool end_object() override;
+  bool start_array(std::size_t elements) override;
+  bool end_array() override;
+  bool parse_error(std::size_t position, const std::string& lastToken,
+                   const nlohmann::json::exception& error) override;
+
+ private:
+  /**
+   * @brief An array or object that is still being read.
+   */
+  struct Frame {
+    nlohmann::json* value;           ///< The container
+    std::string path;                ///< Location of the container
+    const ElementCallback* stream;   ///< Callback if this is a streamed array, else nullptr
+  };
+
+  /// Stores a value in the innermost container and returns where it was stored
+  nlohmann::json* Place(nlohmann::json value);
+
+  /// Hands a completed element to the innermost container's callback, if it is streamed
+  bool Emit();
+
+  std::vector<std::pair<std::string, ElementCallback>> streams_;  ///< Streamed arrays
+  std::vector<Frame> stack_;  ///< Open containers, outermost first
+  nlohmann::json* root_ = nullptr;  ///< Document being read
+  nlohmann::json element_;  ///< Element of a streamed array being read
+  std::string key_;         ///< Key of the next object member
+};
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,137 @@
+#include "mobilerobotsim/json_writer.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace mobilerobotsim {
+
+JsonWriter::JsonWriter(std::ostream& stream) : stream_(stream), afterKey_(false) {}
+
+void JsonWriter::BeginObject() {
+  Separate();
+  stream_.put('{');
+  empty_.push_back(true);
+}
+
+void JsonWriter::EndObject() {
+  stream_.put('}');
+  empty_.pop_back();
+}
+
+void JsonWriter::BeginArray() {
+  Separate();
+  stream_.put('[');
+  empty_.push_back(true);
+}
+
+void JsonWriter::EndArray() {
+  stream_.put(']');
+  empty_.pop_back();
+}
+
+void JsonWriter::Key(const std::string& key) {
+  Value(key);
+  stream_.put(':');
+  afterKey_ = true;
+}
+
+void JsonWriter::Value(double value) {
+  if (!std::isfinite(value)) {
+    Null();
+    return;
+  }
+
+  Separate();
+  char buffer[32];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  stream_.write(buffer, result.ptr - buffer);
+}
+
+void JsonWriter::Value(int64_t value) {
+  Separate();
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  stream_.write(buffer, result.ptr - buffer);
+}
+
+void JsonWriter::Value(uint64_t value) {
+  Separate();
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  stream_.write(buffer, result.ptr - buffer);
+}
+
+void JsonWriter::Value(bool value) {
+  Separate();
+  stream_ << (value ? "true" : "false");
+}
+
+void JsonWriter::Value(const std::string& value) {
+  Separate();
+  stream_.put('"');
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        stream_ << "\\\"";
+        break;
+      case '\\':
+        stream_ << "\\\\";
+        break;
+      case '\n':
+        stream_ << "\\n";
+        break;
+      case '\r':
+        stream_ << "\\r";
+        break;
+      case '\t':
+        stream_ << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          static const char kHex[] = "0123456789abcdef";
+          const char escaped[] = {'\\', 'u', '0', '0', kHex[(c >> 4) & 0xf], kHex[c & 0xf]};
+          stream_.write(escaped, sizeof(escaped));
+        } else {
+          stream_.put(c);
+        }
+    }
+  }
+  stream_.put('"');
+}
+
+void JsonWriter::Null() {
+  Separate();
+  stream_ << "null";
+}
+
+void JsonWriter::RawValue(const std::string& json) {
+  // Only containers are embedded: scalars would not read back as the same text
+  const size_t first = json.find_first_not_of(" \t\n\r");
+  const size_t last = json.find_last_not_of(" \t\n\r");
+  const bool container = first != std::string::npos &&
+                         ((json[first] == '{' && json[last] == '}') ||
+                          (json[first] == '[' && json[last] == ']'));
+  if (!container) {
+    Value(json);
+    return;
+  }
+
+  Separate();
+  stream_ << json;
+}
+
+void JsonWriter::Separate() {
+  if (afterKey_) {
+    // The key already separated itself from the previous member
+    afterKey_ = false;
+    return;
+  }
+  if (!empty_.empty()) {
+    if (!empty_.back()) {
+      stream_.put(',');
+    }
+    empty_.back() = false;
+  }
+}
+
+}  // namespace mobilerobotsim
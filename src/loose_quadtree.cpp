@@ -0,0 +1,166 @@
+#include "mobilerobotsim/loose_quadtree.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mobilerobotsim {
+
+LooseQuadtree::LooseQuadtree(const Eigen::AlignedBox2d& worldBounds, int maxDepth)
+    : worldBounds_(worldBounds), maxDepth_(std::clamp(maxDepth, 0, 30)), itemCount_(0) {
+  Clear();
+}
+
+void LooseQuadtree::Insert(uint32_t id, const Eigen::AlignedBox2d& box) {
+  if (id >= items_.size()) {
+    items_.resize(static_cast<size_t>(id) + 1);
+  }
+  if (items_[id].node != kNone) {
+    Update(id, box);
+    return;
+  }
+
+  items_[id].box = box;
+  if (box.isEmpty()) {
+    items_[id].node = kUnbounded;
+    items_[id].slot = static_cast<uint32_t>(unboundedItems_.size());
+    unboundedItems_.push_back(id);
+  } else {
+    Link(id, FindNode(box));
+  }
+  ++itemCount_;
+}
+
+void LooseQuadtree::Update(uint32_t id, const Eigen::AlignedBox2d& box) {
+  if (id >= items_.size() || items_[id].node == kNone) {
+    Insert(id, box);
+    return;
+  }
+
+  Item& item = items_[id];
+  const bool wasUnbounded = item.node == kUnbounded;
+  if (!wasUnbounded && !box.isEmpty() && Fits(nodes_[item.node], box)) {
+    // Common case: the item moved within its cell
+    item.box = box;
+    return;
+  }
+
+  Remove(id);
+  Insert(id, box);
+}
+
+bool LooseQuadtree::Remove(uint32_t id) {
+  if (id >= items_.size() || items_[id].node == kNone) {
+    return false;
+  }
+
+  Item& item = items_[id];
+  if (item.node == kUnbounded) {
+    const uint32_t moved = unboundedItems_.back();
+    unboundedItems_[item.slot] = moved;
+    items_[moved].slot = item.slot;
+    unboundedItems_.pop_back();
+  } else {
+    Unlink(id);
+  }
+
+  item.node = kNone;
+  --itemCount_;
+  return true;
+}
+
+void LooseQuadtree::Clear() {
+  nodes_.clear();
+  items_.clear();
+  unboundedItems_.clear();
+  itemCount_ = 0;
+
+  Node root;
+  root.center = worldBounds_.center();
+  root.halfSize = 0.5 * worldBounds_.sizes().maxCoeff();
+  root.depth = 0;
+  std::fill(std::begin(root.children), std::end(root.children), kNone);
+  nodes_.push_back(std::move(root));
+}
+
+int LooseQuadtree::TargetDepth(const Eigen::AlignedBox2d& box) const {
+  const double halfExtent = 0.5 * box.sizes().maxCoeff();
+  const double rootHalf = nodes_[0].halfSize;
+  if (halfExtent <= 0.0) {
+    return maxDepth_;
+  }
+
+  // Deepest depth d with rootHalf / 2^d >= halfExtent
+  const int depth = static_cast<int>(std::floor(std::log2(rootHalf / halfExtent)));
+  return std::clamp(depth, 0, maxDepth_);
+}
+
+bool LooseQuadtree::Fits(const Node& node, const Eigen::AlignedBox2d& box) const {
+  if (node.depth == 0) {
+    // The root also holds items whose center lies outside the world
+    return TargetDepth(box) == 0 || !worldBounds_.contains(box.center());
+  }
+
+  const Eigen::Vector2d offset = (box.center() - node.center).cwiseAbs();
+  return node.depth == TargetDepth(box) && offset.maxCoeff() <= node.halfSize;
+}
+
+uint32_t LooseQuadtree::FindNode(const Eigen::AlignedBox2d& box) {
+  const Eigen::Vector2d center = box.center();
+  if (!worldBounds_.contains(center)) {
+    return 0;
+  }
+
+  const int depth = TargetDepth(box);
+  uint32_t index = 0;
+  while (nodes_[index].depth < depth) {
+    const Node& node = nodes_[index];
+    const int quadrant = (center.x() >= node.center.x() ? 1 : 0) |
+                         (center.y() >= node.center.y() ? 2 : 0);
+    uint32_t child = node.children[quadrant];
+    if (child == kNone) {
+      Node created;
+      const double half = 0.5 * node.halfSize;
+      created.center = node.center + Eigen::Vector2d((quadrant & 1) ? half : -half,
+                                                     (quadrant & 2) ? half : -half);
+      created.halfSize = half;
+      created.depth = node.depth + 1;
+      std::fill(std::begin(created.children), std::end(created.children), kNone);
+
+      child = static_cast<uint32_t>(nodes_.size());
+      nodes_[index].children[quadrant] = child;
+      nodes_.push_back(std::move(created));
+    }
+    index = child;
+  }
+
+  return index;
+}
+
+void LooseQuadtree::Link(uint32_t id, uint32_t node) {
+  std::vector<uint32_t>& list = nodes_[node].items;
+  items_[id].node = node;
+  items_[id].slot = static_cast<uint32_t>(list.size());
+  list.push_back(id);
+}
+
+void LooseQuadtree::Unlink(uint32_t id) {
+  const Item& item = items_[id];
+  std::vector<uint32_t>& list = nodes_[item.node].items;
+  const uint32_t moved = list.back();
+  list[item.slot] = moved;
+  items_[moved].slot = item.slot;
+  list.pop_back();
+}
+
+bool LooseQuadtree::LooseContains(const Node& node, const Eigen::Vector2d& point) {
+  const Eigen::Vector2d offset = (point - node.center).cwiseAbs();
+  return offset.maxCoeff() <= 2.0 * node.halfSize;
+}
+
+bool LooseQuadtree::LooseIntersects(const Node& node, const Eigen::AlignedBox2d& box) {
+  const double loose = 2.0 * node.halfSize;
+  return box.min().x() <= node.center.x() + loose && box.max().x() >= node.center.x() - loose &&
+         box.min().y() <= node.center.y() + loose && box.max().y() >= node.center.y() - loose;
+}
+
+}  // namespace mobilerobotsim
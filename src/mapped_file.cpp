@@ -0,0 +1,71 @@
+#include "mobilerobotsim/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace mobilerobotsim {
+
+MappedFile::MappedFile() : data_(nullptr), size_(0) {}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+
+  return *this;
+}
+
+bool MappedFile::Open(const std::string& path, AccessHint hint) {
+  Close();
+
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  if (hint == AccessHint::kSequential) {
+    ::madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+  } else if (hint == AccessHint::kRandom) {
+    ::madvise(mapping, static_cast<size_t>(info.st_size), MADV_RANDOM);
+  }
+
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(info.st_size);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,60 @@
+#include "mobilerobotsim/merge_point.h"
+
+#include <nlohmann/json.hpp>
+
+#include "json_stream_reader.h"
+#include "mobilerobotsim/binary_io.h"
+
+namespace mobilerobotsim {
+
+MergePoint::MergePoint(double x, double y, double radius) : position_(x, y), radius_(radius) {}
+
+MergePoint::~MergePoint() = default;
+
+bool MergePoint::CheckCollision(const Eigen::Vector2d& position) const {
+  return (position - position_).squaredNorm() <= radius_ * radius_;
+}
+
+std::string MergePoint::GetState() const {
+  nlohmann::json state = {{"x", position_.x()}, {"y", position_.y()}, {"radius", radius_}};
+  return state.dump();
+}
+
+bool MergePoint::LoadState(const std::string& state) {
+  const nlohmann::json parsed = nlohmann::json::parse(state, nullptr, false);
+  if (parsed.is_discarded() || !parsed.is_object() ||
+      !HasNumberMembers(parsed, {"x", "y", "radius"})) {
+    return false;
+  }
+
+  position_ = Eigen::Vector2d(parsed.value("x", position_.x()), parsed.value("y", position_.y()));
+  radius_ = parsed.value("radius", radius_);
+  return true;
+}
+
+bool MergePoint::SaveBinary(BinaryWriter& writer) const {
+  writer.Write(position_.x());
+  writer.Write(position_.y());
+  writer.Write(radius_);
+  return true;
+}
+
+bool MergePoint::LoadBinary(BinaryReader& reader) {
+  double x = 0.0;
+  double y = 0.0;
+  double radius = 0.0;
+  if (!reader.Read(x) || !reader.Read(y) || !reader.Read(radius)) {
+    return false;
+  }
+
+  position_ = Eigen::Vector2d(x, y);
+  radius_ = radius;
+  return true;
+}
+
+Eigen::AlignedBox2d MergePoint::GetBounds() const {
+  const Eigen::Vector2d extent(radius_, radius_);
+  return Eigen::AlignedBox2d(position_ - extent, position_ + extent);
+}
+
+}  // namespace mobilerobotsim
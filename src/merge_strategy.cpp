@@ -0,0 +1,121 @@
+#include "mobilerobotsim/merge_strategy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mobilerobotsim {
+
+namespace {
+
+// cos(45 degrees): robots heading closer than this to the priority direction have right of way
+constexpr double kPriorityCosine = 0.70710678118654752;
+
+// Time at which a robot reaches the centre at cruise speed; negative once past it
+double ArrivalTime(const MergeBatch& batch, size_t i) {
+  const double speed = batch.cruiseVelocities[i].norm();
+  return speed > 0.0 ? batch.distances[i] / speed : std::numeric_limits<double>::infinity();
+}
+
+// Lists the moving robots by arrival time, ties broken by batch position
+void SortByArrival(const MergeBatch& batch, std::vector<size_t>& order) {
+  order.clear();
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (batch.cruiseVelocities[i].squaredNorm() > 0.0) {
+      order.push_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    const double arrivalA = ArrivalTime(batch, a);
+    const double arrivalB = ArrivalTime(batch, b);
+    return arrivalA != arrivalB ? arrivalA < arrivalB : a < b;
+  });
+}
+
+// Slows an approaching robot down so that it reaches the centre at the slot time
+void ArriveAt(MergeBatch& batch, size_t i, double arrival, double slot) {
+  if (batch.distances[i] > 0.0 && slot > arrival) {
+    batch.targetVelocities[i] = batch.cruiseVelocities[i] * (arrival / slot);
+  }
+}
+
+}  // namespace
+
+void MergeBatch::Clear() {
+  handles.clear();
+  positions.clear();
+  velocities.clear();
+  cruiseVelocities.clear();
+  distances.clear();
+  targetVelocities.clear();
+}
+
+ZipperMergeStrategy::ZipperMergeStrategy(double headway) : headway_(std::max(headway, 0.0)) {}
+
+void ZipperMergeStrategy::ComputeBatch(MergeBatch& batch) {
+  SortByArrival(batch, order_);
+
+  // Robots past the centre keep the time they crossed it
+  double previous = -std::numeric_limits<double>::infinity();
+  for (size_t i : order_) {
+    const double arrival = ArrivalTime(batch, i);
+    const double slot =
+        batch.distances[i] > 0.0 ? std::max(arrival, previous + headway_) : arrival;
+    ArriveAt(batch, i, arrival, slot);
+    previous = slot;
+  }
+}
+
+PriorityMergeStrategy::PriorityMergeStrategy(const Eigen::Vector2d& priorityDirection,
+                                             double headway)
+    : priorityDirection_(priorityDirection.normalized()), headway_(std::max(headway, 0.0)) {}
+
+void PriorityMergeStrategy::ComputeBatch(MergeBatch& batch) {
+  SortByArrival(batch, order_);
+
+  const auto hasPriority = [&](size_t i) {
+    const Eigen::Vector2d& cruise = batch.cruiseVelocities[i];
+    return cruise.dot(priorityDirection_) >= kPriorityCosine * cruise.norm();
+  };
+
+  // Robots past the centre hold their slots; the priority lane queues behind
+  // them and only behind itself
+  slots_.clear();
+  double previous = -std::numeric_limits<double>::infinity();
+  for (size_t i : order_) {
+    if (batch.distances[i] <= 0.0) {
+      previous = ArrivalTime(batch, i);
+      slots_.push_back(previous);
+    }
+  }
+  for (size_t i : order_) {
+    if (batch.distances[i] > 0.0 && hasPriority(i)) {
+      const double arrival = ArrivalTime(batch, i);
+      previous = std::max(arrival, previous + headway_);
+      ArriveAt(batch, i, arrival, previous);
+      slots_.push_back(previous);
+    }
+  }
+  std::sort(slots_.begin(), slots_.end());
+
+  // Yielding robots take the first gap after their arrival
+  for (size_t i : order_) {
+    if (batch.distances[i] <= 0.0 || hasPriority(i)) {
+      continue;
+    }
+    const double arrival = ArrivalTime(batch, i);
+    double slot = arrival;
+    for (double taken : slots_) {
+      if (taken >= slot + headway_) {
+        break;
+      }
+      if (taken > slot - headway_) {
+        slot = taken + headway_;
+      }
+    }
+    ArriveAt(batch, i, arrival, slot);
+    slots_.insert(std::upper_bound(slots_.begin(), slots_.end(), slot), slot);
+  }
+}
+
+}  // namespace mobilerobotsim
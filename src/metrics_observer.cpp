@@ -0,0 +1,369 @@
+#include "mobilerobotsim/metrics_observer.h"
+#include "mobilerobotsim/json_writer.h"
+#include "mobilerobotsim/mobile_robot_base.h"
+#include "mobilerobotsim/robot_state.h"
+#include "mobilerobotsim/system_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mobilerobotsim {
+
+namespace {
+
+// Speeds from 1 mm/s to 1 km/s and waits from 1 ms to about 12 days keep
+// every realistic value resolved, in under a thousand buckets each
+constexpr double kLowestSpeed = 1e-3;
+constexpr double kHighestSpeed = 1e3;
+constexpr double kLowestWait = 1e-3;
+constexpr double kHighestWait = 1e6;
+
+MetricsSummary Summarize(const RunningStats& stats, const LogHistogram& histogram) {
+  MetricsSummary summary;
+  summary.count = stats.GetCount();
+  summary.mean = stats.GetMean();
+  summary.deviation = std::sqrt(stats.GetVariance());
+  summary.min = stats.GetMin();
+  summary.max = stats.GetMax();
+
+  // Bucket middles may lie slightly outside the exact range
+  const auto quantile = [&](double q) {
+    return std::clamp(histogram.GetQuantile(q), summary.min, summary.max);
+  };
+  summary.median = quantile(0.5);
+  summary.percentile90 = quantile(0.9);
+  summary.percentile99 = quantile(0.99);
+  return summary;
+}
+
+void WriteSummary(JsonWriter& writer, const MetricsSummary& summary) {
+  writer.BeginObject();
+  writer.Key("count");
+  writer.Value(summary.count);
+  writer.Key("mean");
+  writer.Value(summary.mean);
+  writer.Key("deviation");
+  writer.Value(summary.deviation);
+  writer.Key("min");
+  writer.Value(summary.min);
+  writer.Key("max");
+  writer.Value(summary.max);
+  writer.Key("median");
+  writer.Value(summary.median);
+  writer.Key("percentile90");
+  writer.Value(summary.percentile90);
+  writer.Key("percentile99");
+  writer.Value(summary.percentile99);
+  writer.EndObject();
+}
+
+}  // namespace
+
+RunningStats::RunningStats() : count_(0), mean_(0.0), m2_(0.0), min_(0.0), max_(0.0) {}
+
+void RunningStats::Add(double value) {
+  ++count_;
+  const double delta = value - mean_;
+  mean_ += delta / static_cast<double>(count_);
+  m2_ += delta * (value - mean_);
+  if (count_ == 1) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+}
+
+void RunningStats::Reset() {
+  *this = RunningStats();
+}
+
+double RunningStats::GetVariance() const {
+  return count_ > 1 ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+}
+
+LogHistogram::LogHistogram(double lowest, double highest, int subBuckets)
+    : lowest_(lowest), subBuckets_(std::max(subBuckets, 1)), count_(0) {
+  const int octaves = std::max(1, static_cast<int>(std::ceil(std::log2(highest / lowest))));
+  buckets_.assign(1 + static_cast<size_t>(octaves) * subBuckets_, 0);
+}
+
+void LogHistogram::Add(double value) {
+  ++buckets_[BucketOf(value)];
+  ++count_;
+}
+
+void LogHistogram::Reset() {
+  std::fill(buckets_.begin(), buckets_.end(), 0);
+  count_ = 0;
+}
+
+double LogHistogram::GetQuantile(double quantile) const {
+  if (count_ == 0) {
+    return 0.0;
+  }
+
+  // Rank of the quantile among the sorted values, counting from one
+  const double scaled = std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count_);
+  const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(scaled)));
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < buckets_.size(); ++bucket) {
+    seen += buckets_[bucket];
+    if (seen >= rank) {
+      return BucketMiddle(bucket);
+    }
+  }
+  return BucketMiddle(buckets_.size() - 1);
+}
+
+size_t LogHistogram::BucketOf(double value) const {
+  if (!(value >= lowest_)) {
+    return 0;
+  }
+
+  // value / lowest_ = mantissa * 2^exponent with mantissa in [0.5, 1)
+  int exponent = 0;
+  const double mantissa = std::frexp(value / lowest_, &exponent);
+  const size_t sub = std::min(static_cast<size_t>((2.0 * mantissa - 1.0) * subBuckets_),
+                              static_cast<size_t>(subBuckets_ - 1));
+  const size_t bucket = 1 + static_cast<size_t>(exponent - 1) * subBuckets_ + sub;
+  return std::min(bucket, buckets_.size() - 1);
+}
+
+double LogHistogram::BucketMiddle(size_t bucket) const {
+  if (bucket == 0) {
+    return 0.5 * lowest_;
+  }
+
+  const size_t octave = (bucket - 1) / subBuckets_;
+  const size_t sub = (bucket - 1) % subBuckets_;
+  return std::ldexp(lowest_, static_cast<int>(octave)) *
+         (1.0 + (static_cast<double>(sub) + 0.5) / subBuckets_);
+}
+
+bool MetricsSnapshot::WriteJson(std::ostream& stream) const {
+  JsonWriter writer(stream);
+  writer.BeginObject();
+  writer.Key("time");
+  writer.Value(time);
+  writer.Key("elapsed");
+  writer.Value(elapsed);
+  writer.Key("steps");
+  writer.Value(steps);
+  writer.Key("robots");
+  writer.Value(static_cast<uint64_t>(robots));
+  writer.Key("mergeArrivals");
+  writer.Value(mergeArrivals);
+  writer.Key("throughput");
+  writer.Value(throughput);
+  writer.Key("collisions");
+  writer.Value(collisions);
+  writer.Key("collisionRate");
+  writer.Value(collisionRate);
+  writer.Key("speed");
+  WriteSummary(writer, speed);
+  writer.Key("mergeWait");
+  WriteSummary(writer, mergeWait);
+
+  writer.Key("zones");
+  writer.BeginArray();
+  for (const MetricsZoneCounts& zone : zones) {
+    writer.BeginObject();
+    writer.Key("name");
+    writer.Value(zone.name);
+    writer.Key("meanOccupancy");
+    writer.Value(zone.meanOccupancy);
+    writer.Key("collisions");
+    writer.Value(zone.collisions);
+    writer.Key("mergeArrivals");
+    writer.Value(zone.mergeArrivals);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return writer.IsGood();
+}
+
+MetricsObserver::MetricsObserver()
+    : startTime_(0.0),
+      time_(0.0),
+      steps_(0),
+      robots_(0),
+      robotSeconds_(0.0),
+      mergeArrivals_(0),
+      collisions_(0),
+      stoppedSpeed_(0.1),
+      speedHistogram_(kLowestSpeed, kHighestSpeed),
+      waitHistogram_(kLowestWait, kHighestWait),
+      snapshotInterval_(0.0),
+      nextSnapshot_(std::numeric_limits<double>::infinity()) {}
+
+size_t MetricsObserver::AddZone(const std::string& name, const Eigen::AlignedBox2d& region) {
+  Zone zone;
+  zone.name = name;
+  zone.region = region;
+  zones_.push_back(zone);
+  return zones_.size() - 1;
+}
+
+void MetricsObserver::SetStoppedSpeed(double speed) {
+  stoppedSpeed_ = speed;
+}
+
+void MetricsObserver::SetSnapshotInterval(double interval, SnapshotCallback callback) {
+  snapshotInterval_ = interval > 0.0 ? interval : 0.0;
+  snapshotCallback_ = std::move(callback);
+  nextSnapshot_ = snapshotInterval_ > 0.0
+                      ? (std::floor(time_ / snapshotInterval_) + 1.0) * snapshotInterval_
+                      : std::numeric_limits<double>::infinity();
+}
+
+void MetricsObserver::Reset(double time) {
+  startTime_ = time;
+  time_ = time;
+  steps_ = 0;
+  robots_ = 0;
+  robotSeconds_ = 0.0;
+  mergeArrivals_ = 0;
+  collisions_ = 0;
+  speedStats_.Reset();
+  speedHistogram_.Reset();
+  waitStats_.Reset();
+  waitHistogram_.Reset();
+  waits_.clear();
+  for (Zone& zone : zones_) {
+    zone.occupancy = 0.0;
+    zone.collisions = 0;
+    zone.mergeArrivals = 0;
+  }
+  nextSnapshot_ = snapshotInterval_ > 0.0
+                      ? (std::floor(time_ / snapshotInterval_) + 1.0) * snapshotInterval_
+                      : std::numeric_limits<double>::infinity();
+}
+
+MetricsSnapshot MetricsObserver::GetSnapshot() const {
+  MetricsSnapshot snapshot;
+  snapshot.time = time_;
+  snapshot.elapsed = time_ - startTime_;
+  snapshot.steps = steps_;
+  snapshot.robots = robots_;
+  snapshot.mergeArrivals = mergeArrivals_;
+  snapshot.collisions = collisions_;
+  if (snapshot.elapsed > 0.0) {
+    snapshot.throughput = static_cast<double>(mergeArrivals_) / snapshot.elapsed;
+  }
+  if (robotSeconds_ > 0.0) {
+    snapshot.collisionRate = static_cast<double>(collisions_) / robotSeconds_;
+  }
+  snapshot.speed = Summarize(speedStats_, speedHistogram_);
+  snapshot.mergeWait = Summarize(waitStats_, waitHistogram_);
+
+  snapshot.zones.reserve(zones_.size());
+  for (const Zone& zone : zones_) {
+    MetricsZoneCounts counts;
+    counts.name = zone.name;
+    counts.meanOccupancy = snapshot.elapsed > 0.0 ? zone.occupancy / snapshot.elapsed : 0.0;
+    counts.collisions = zone.collisions;
+    counts.mergeArrivals = zone.mergeArrivals;
+    snapshot.zones.push_back(counts);
+  }
+  return snapshot;
+}
+
+void MetricsObserver::OnStep(const SystemState& state) {
+  const double dt = std::max(state.GetTime() - time_, 0.0);
+  time_ = state.GetTime();
+  ++steps_;
+  robots_ = state.GetRobotStateCount();
+  robotSeconds_ += static_cast<double>(robots_) * dt;
+
+  for (size_t i = 0; i < robots_; ++i) {
+    const RobotState* robot = state.GetRobotState(i);
+    const SlotHandle handle = state.GetRobotHandle(i);
+    double vx = 0.0;
+    double vy = 0.0;
+    if (robot->GetVelocity(vx, vy)) {
+      const double speed = std::hypot(vx, vy);
+      speedStats_.Add(speed);
+      speedHistogram_.Add(speed);
+      if (speed < stoppedSpeed_ && handle.IsValid()) {
+        WaitOf(handle.index, handle.generation).stopped += dt;
+      }
+    }
+
+    double x = 0.0;
+    double y = 0.0;
+    double orientation = 0.0;
+    if (!zones_.empty() && robot->GetPose(x, y, orientation)) {
+      const Eigen::Vector2d position(x, y);
+      for (Zone& zone : zones_) {
+        if (zone.region.contains(position)) {
+          zone.occupancy += dt;
+        }
+      }
+    }
+  }
+
+  if (time_ >= nextSnapshot_) {
+    while (nextSnapshot_ <= time_) {
+      nextSnapshot_ += snapshotInterval_;
+    }
+    if (snapshotCallback_) {
+      snapshotCallback_(GetSnapshot());
+    }
+  }
+}
+
+void MetricsObserver::OnCollision(const MobileRobotBase* robot, const void* /*object*/) {
+  ++collisions_;
+  if (robot == nullptr) {
+    return;
+  }
+  const Eigen::Vector2d position = robot->GetPosition();
+  for (Zone& zone : zones_) {
+    if (zone.region.contains(position)) {
+      ++zone.collisions;
+    }
+  }
+}
+
+void MetricsObserver::OnMergePoint(const MobileRobotBase* robot,
+                                   const EnvironmentElement* /*mergePoint*/) {
+  ++mergeArrivals_;
+  if (robot == nullptr) {
+    return;
+  }
+
+  const RobotHandle handle = robot->GetHandle();
+  double waited = 0.0;
+  if (handle.IsValid()) {
+    RobotWait& wait = WaitOf(handle.index, handle.generation);
+    waited = wait.stopped;
+    wait.stopped = 0.0;
+  }
+  waitStats_.Add(waited);
+  waitHistogram_.Add(waited);
+
+  const Eigen::Vector2d position = robot->GetPosition();
+  for (Zone& zone : zones_) {
+    if (zone.region.contains(position)) {
+      ++zone.mergeArrivals;
+    }
+  }
+}
+
+MetricsObserver::RobotWait& MetricsObserver::WaitOf(uint32_t index, uint32_t generation) {
+  if (index >= waits_.size()) {
+    waits_.resize(static_cast<size_t>(index) + 1);
+  }
+  RobotWait& wait = waits_[index];
+  if (wait.generation != generation) {
+    wait.generation = generation;
+    wait.stopped = 0.0;
+  }
+  return wait;
+}
+
+}  // namespace mobilerobotsim
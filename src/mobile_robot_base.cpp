@@ -1,10 +1,21 @@
 #include "mobilerobotsim/mobile_robot_base.h"
 
+#include <limits>
+
 namespace mobilerobotsim {
 
-// Implementation for MobileRobotBase
-// Since this is an abstract base class, we don't need much implementation here
+double MobileRobotBase::GetSpeedBound() const {
+  return std::numeric_limits<double>::infinity();
+}
+
+void MobileRobotBase::SetWakeCallback(std::function<void()> callback) {
+  wakeCallback_ = std::move(callback);
+}
 
-// Any non-pure virtual methods would be implemented here
+void MobileRobotBase::RequestWake() {
+  if (sleeping_ && wakeCallback_) {
+    wakeCallback_();
+  }
+}
 
 } // namespace mobilerobotsim
@@ -0,0 +1,523 @@
+#include "mobilerobotsim/occupancy_grid.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+
+#include "json_stream_reader.h"
+#include "mobilerobotsim/hash.h"
+
+namespace mobilerobotsim {
+
+namespace {
+
+constexpr char kRawMagic[8] = {'M', 'R', 'S', 'O', 'C', 'C', '0', '1'};
+
+// Fixed-size header of the packed raw format; the level words follow it
+struct RawHeader {
+  char magic[8];
+  uint32_t width;
+  uint32_t height;
+  double resolution;
+  double originX;
+  double originY;
+  uint32_t levelCount;
+  uint32_t reserved;
+  uint8_t padding[16];
+};
+static_assert(sizeof(RawHeader) == 64, "raw header must keep the words 64-byte aligned");
+
+// ORs adjacent bit pairs of a word and packs the 32 results into the low half
+uint64_t CompressPairs(uint64_t word) {
+  uint64_t t = (word | (word >> 1)) & 0x5555555555555555ull;
+  t = (t | (t >> 1)) & 0x3333333333333333ull;
+  t = (t | (t >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+  t = (t | (t >> 4)) & 0x00FF00FF00FF00FFull;
+  t = (t | (t >> 8)) & 0x0000FFFF0000FFFFull;
+  t = (t | (t >> 16)) & 0x00000000FFFFFFFFull;
+  return t;
+}
+
+// Reads the next whitespace-separated PGM header token, skipping comments
+bool NextPgmToken(const uint8_t* data, size_t size, size_t& offset, std::string& token) {
+  token.clear();
+  while (offset < size) {
+    if (data[offset] == '#') {
+      while (offset < size && data[offset] != '\n') {
+        ++offset;
+      }
+    } else if (std::isspace(data[offset])) {
+      ++offset;
+    } else {
+      break;
+    }
+  }
+  while (offset < size && !std::isspace(data[offset]) && data[offset] != '#') {
+    token.push_back(static_cast<char>(data[offset++]));
+  }
+  return !token.empty();
+}
+
+}  // namespace
+
+OccupancyGrid::OccupancyGrid()
+    : width_(0),
+      height_(0),
+      resolution_(1.0),
+      origin_(Eigen::Vector2d::Zero()),
+      words_(nullptr),
+      occupiedThreshold_(0.65) {}
+
+OccupancyGrid::OccupancyGrid(int width, int height, double resolution,
+                             const Eigen::Vector2d& origin)
+    : OccupancyGrid() {
+  resolution_ = resolution;
+  origin_ = origin;
+  Allocate(width, height);
+}
+
+OccupancyGrid::~OccupancyGrid() = default;
+
+bool OccupancyGrid::LoadPgm(const std::string& path, double resolution,
+                            const Eigen::Vector2d& origin, double occupiedThreshold) {
+  MappedFile image;
+  if (!image.Open(path, MappedFile::AccessHint::kSequential)) {
+    return false;
+  }
+
+  const uint8_t* data = image.GetData();
+  const size_t size = image.GetSize();
+  size_t offset = 0;
+  std::string magic, widthToken, heightToken, maxToken;
+  if (!NextPgmToken(data, size, offset, magic) || magic != "P5" ||
+      !NextPgmToken(data, size, offset, widthToken) ||
+      !NextPgmToken(data, size, offset, heightToken) ||
+      !NextPgmToken(data, size, offset, maxToken)) {
+    return false;
+  }
+
+  const long width = std::strtol(widthToken.c_str(), nullptr, 10);
+  const long height = std::strtol(heightToken.c_str(), nullptr, 10);
+  const long maxValue = std::strtol(maxToken.c_str(), nullptr, 10);
+  if (width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535) {
+    return false;
+  }
+
+  // Exactly one whitespace byte separates the header from the pixels
+  ++offset;
+  const size_t bytesPerPixel = maxValue > 255 ? 2 : 1;
+  if (offset + static_cast<size_t>(width) * height * bytesPerPixel > size) {
+    return false;
+  }
+
+  resolution_ = resolution;
+  origin_ = origin;
+  Allocate(static_cast<int>(width), static_cast<int>(height));
+  source_ = path;
+  sourceFormat_ = "pgm";
+  occupiedThreshold_ = occupiedThreshold;
+
+  // Pixels at or below this value are dark enough to be occupied
+  const double freeLimit = (1.0 - occupiedThreshold) * static_cast<double>(maxValue);
+  const Level& level = levels_[0];
+  for (long row = 0; row < height; ++row) {
+    const uint8_t* pixels = data + offset + static_cast<size_t>(row) * width * bytesPerPixel;
+    uint64_t* words = owned_.data() + (height - 1 - row) * level.wordsPerRow;
+    for (long x = 0; x < width; ++x) {
+      const unsigned value = bytesPerPixel == 1
+                                 ? pixels[x]
+                                 : (static_cast<unsigned>(pixels[2 * x]) << 8) | pixels[2 * x + 1];
+      if (static_cast<double>(value) <= freeLimit) {
+        words[x >> 6] |= uint64_t{1} << (x & 63);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool OccupancyGrid::Rasterize(const Environment& environment, const Eigen::AlignedBox2d& region,
+                              double resolution) {
+  if (region.isEmpty() || resolution <= 0.0) {
+    return false;
+  }
+
+  resolution_ = resolution;
+  origin_ = region.min();
+  Allocate(std::max(1, static_cast<int>(std::ceil(region.sizes().x() / resolution))),
+           std::max(1, static_cast<int>(std::ceil(region.sizes().y() / resolution))));
+
+  const size_t wordsPerRow = levels_[0].wordsPerRow;
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      const Eigen::Vector2d center = origin_ + (Eigen::Vector2d(x, y).array() + 0.5).matrix() *
+                                                   resolution_;
+      if (environment.CheckStaticCollision(center) != nullptr) {
+        owned_[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] |= uint64_t{1} << (x & 63);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool OccupancyGrid::LoadRaw(const std::string& path) {
+  MappedFile file;
+  if (!file.Open(path, MappedFile::AccessHint::kRandom) || file.GetSize() < sizeof(RawHeader)) {
+    return false;
+  }
+
+  RawHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  const uint32_t kMaxSide = static_cast<uint32_t>(std::numeric_limits<int>::max());
+  if (std::memcmp(header.magic, kRawMagic, sizeof(kRawMagic)) != 0 || header.width == 0 ||
+      header.height == 0 || header.width > kMaxSide || header.height > kMaxSide ||
+      header.levelCount == 0 || !std::isfinite(header.resolution) || header.resolution <= 0.0 ||
+      !std::isfinite(header.originX) || !std::isfinite(header.originY)) {
+    return false;
+  }
+
+  // The header is untrusted: there is at most one level per halving down to
+  // a single cell, and every level must fit in the words the file holds
+  uint32_t maxLevels = 1;
+  for (uint32_t side = std::max(header.width, header.height); side > 1; side = (side + 1) / 2) {
+    ++maxLevels;
+  }
+  if (header.levelCount > maxLevels) {
+    return false;
+  }
+
+  const size_t availableWords = (file.GetSize() - sizeof(RawHeader)) / sizeof(uint64_t);
+  std::vector<Level> levels;
+  size_t totalWords = 0;
+  int width = static_cast<int>(header.width);
+  int height = static_cast<int>(header.height);
+  for (uint32_t i = 0; i < header.levelCount; ++i) {
+    const size_t wordsPerRow = (static_cast<size_t>(width) + 63) / 64;
+    if (wordsPerRow > (availableWords - totalWords) / static_cast<size_t>(height)) {
+      return false;
+    }
+    totalWords += AppendLevel(levels, width, height);
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+  }
+
+  width_ = static_cast<int>(header.width);
+  height_ = static_cast<int>(header.height);
+  resolution_ = header.resolution;
+  origin_ = Eigen::Vector2d(header.originX, header.originY);
+  levels_ = std::move(levels);
+  owned_.clear();
+  owned_.shrink_to_fit();
+  file_ = std::move(file);
+  words_ = reinterpret_cast<const uint64_t*>(file_.GetData() + sizeof(RawHeader));
+  source_ = path;
+  sourceFormat_ = "raw";
+  return true;
+}
+
+bool OccupancyGrid::SaveRaw(const std::string& path) const {
+  if (levels_.empty()) {
+    return false;
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  RawHeader header{};
+  std::memcpy(header.magic, kRawMagic, sizeof(kRawMagic));
+  header.width = static_cast<uint32_t>(width_);
+  header.height = static_cast<uint32_t>(height_);
+  header.resolution = resolution_;
+  header.originX = origin_.x();
+  header.originY = origin_.y();
+  header.levelCount = static_cast<uint32_t>(levels_.size());
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  const Level& last = levels_.back();
+  const size_t totalWords = last.offset + last.wordsPerRow * last.height;
+  file.write(reinterpret_cast<const char*>(words_),
+             static_cast<std::streamsize>(totalWords * sizeof(uint64_t)));
+
+  return static_cast<bool>(file);
+}
+
+void OccupancyGrid::BuildMipLevels() {
+  if (levels_.empty()) {
+    return;
+  }
+
+  MakeOwned();
+  levels_.resize(1);
+  size_t totalWords = levels_[0].wordsPerRow * levels_[0].height;
+  while (levels_.back().width > 1 || levels_.back().height > 1) {
+    const Level& previous = levels_.back();
+    totalWords += AppendLevel(levels_, (previous.width + 1) / 2, (previous.height + 1) / 2);
+  }
+  owned_.resize(totalWords, 0);
+  words_ = owned_.data();
+
+  for (size_t i = 1; i < levels_.size(); ++i) {
+    const Level& fine = levels_[i - 1];
+    const Level& coarse = levels_[i];
+    for (int y = 0; y < coarse.height; ++y) {
+      const uint64_t* row0 = owned_.data() + fine.offset + (2 * y) * fine.wordsPerRow;
+      const uint64_t* row1 = 2 * y + 1 < fine.height ? row0 + fine.wordsPerRow : row0;
+      uint64_t* out = owned_.data() + coarse.offset + y * coarse.wordsPerRow;
+      for (size_t word = 0; word < coarse.wordsPerRow; ++word) {
+        const size_t lo = 2 * word;
+        const size_t hi = lo + 1;
+        const uint64_t low = lo < fine.wordsPerRow ? CompressPairs(row0[lo] | row1[lo]) : 0;
+        const uint64_t high = hi < fine.wordsPerRow ? CompressPairs(row0[hi] | row1[hi]) : 0;
+        out[word] = low | (high << 32);
+      }
+    }
+  }
+}
+
+void OccupancyGrid::SetOccupied(int x, int y, bool occupied) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return;
+  }
+
+  MakeOwned();
+  if (levels_.size() > 1) {
+    levels_.resize(1);
+    owned_.resize(levels_[0].wordsPerRow * levels_[0].height);
+    words_ = owned_.data();
+  }
+
+  uint64_t& word = owned_[static_cast<size_t>(y) * levels_[0].wordsPerRow + (x >> 6)];
+  const uint64_t mask = uint64_t{1} << (x & 63);
+  word = occupied ? (word | mask) : (word & ~mask);
+}
+
+bool OccupancyGrid::IsOccupied(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return false;
+  }
+
+  return TestCell(levels_[0], x, y);
+}
+
+bool OccupancyGrid::IsOccupiedAt(const Eigen::Vector2d& position) const {
+  int x, y;
+  WorldToCell(position, x, y);
+  return IsOccupied(x, y);
+}
+
+bool OccupancyGrid::AnyOccupied(const Eigen::AlignedBox2d& region) const {
+  if (levels_.empty() || region.isEmpty()) {
+    return false;
+  }
+
+  int x0, y0, x1, y1;
+  WorldToCell(region.min(), x0, y0);
+  WorldToCell(region.max(), x1, y1);
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, width_ - 1);
+  y1 = std::min(y1, height_ - 1);
+  if (x0 > x1 || y0 > y1) {
+    return false;
+  }
+
+  const CellRange query{x0, y0, x1, y1};
+  const size_t top = levels_.size() - 1;
+  const int shift = static_cast<int>(top);
+  return AnyOccupiedInLevel(top, {x0 >> shift, y0 >> shift, x1 >> shift, y1 >> shift}, query);
+}
+
+void OccupancyGrid::WorldToCell(const Eigen::Vector2d& position, int& x, int& y) const {
+  const Eigen::Vector2d cell = (position - origin_) / resolution_;
+  // Clamp before converting so far-away positions cannot overflow
+  x = static_cast<int>(std::floor(std::clamp(cell.x(), -1.0, static_cast<double>(width_))));
+  y = static_cast<int>(std::floor(std::clamp(cell.y(), -1.0, static_cast<double>(height_))));
+}
+
+bool OccupancyGrid::CheckCollision(const Eigen::Vector2d& position) const {
+  return IsOccupiedAt(position);
+}
+
+std::string OccupancyGrid::GetState() const {
+  nlohmann::json state = {{"width", width_},
+                          {"height", height_},
+                          {"resolution", resolution_},
+                          {"originX", origin_.x()},
+                          {"originY", origin_.y()},
+                          {"source", source_},
+                          {"format", sourceFormat_},
+                          {"occupiedThreshold", occupiedThreshold_}};
+  return state.dump();
+}
+
+bool OccupancyGrid::LoadState(const std::string& state) {
+  const nlohmann::json parsed = nlohmann::json::parse(state, nullptr, false);
+  if (parsed.is_discarded() || !parsed.is_object() ||
+      !HasNumberMembers(parsed, {"resolution", "originX", "originY", "occupiedThreshold",
+                                 "width", "height"}) ||
+      !HasStringMembers(parsed, {"source", "format"})) {
+    return false;
+  }
+
+  const std::string source = parsed.value("source", std::string());
+  const std::string format = parsed.value("format", std::string());
+  const double resolution = parsed.value("resolution", resolution_);
+  const Eigen::Vector2d origin(parsed.value("originX", origin_.x()),
+                               parsed.value("originY", origin_.y()));
+  const double occupiedThreshold = parsed.value("occupiedThreshold", occupiedThreshold_);
+  const int width = parsed.value("width", 0);
+  const int height = parsed.value("height", 0);
+  const bool sameLayout = width == width_ && height == height_ && resolution == resolution_ &&
+                          origin == origin_;
+
+  if (!source.empty()) {
+    // Static maps do not change while the simulation runs, so only reload a different map
+    if (source == source_ && format == sourceFormat_ && sameLayout &&
+        (format != "pgm" || occupiedThreshold == occupiedThreshold_)) {
+      return true;
+    }
+    if (format == "raw") {
+      return LoadRaw(source);
+    }
+    if (format == "pgm") {
+      return LoadPgm(source, resolution, origin, occupiedThreshold);
+    }
+    return false;
+  }
+
+  // The state of an in-memory grid carries no cells, so it can only keep the current cells
+  // or describe a new all-free grid
+  if (source_.empty() && sameLayout) {
+    return true;
+  }
+  if (width_ > 0 && height_ > 0) {
+    return false;
+  }
+  resolution_ = resolution;
+  origin_ = origin;
+  Allocate(width, height);
+  return true;
+}
+
+uint64_t OccupancyGrid::HashContent(uint64_t hash) const {
+  hash = HashString(GetState(), hash);
+  if (levels_.empty()) {
+    return hash;
+  }
+
+  // Whole rows including padding; padding bits are written clear
+  const Level& level = levels_[0];
+  return HashBytes(words_ + level.offset, level.wordsPerRow * level.height * sizeof(uint64_t), hash);
+}
+
+Eigen::AlignedBox2d OccupancyGrid::GetBounds() const {
+  if (width_ == 0 || height_ == 0) {
+    return Eigen::AlignedBox2d();
+  }
+
+  return Eigen::AlignedBox2d(origin_,
+                             origin_ + Eigen::Vector2d(width_, height_) * resolution_);
+}
+
+void OccupancyGrid::Allocate(int width, int height) {
+  file_.Close();
+  levels_.clear();
+  owned_.clear();
+  source_.clear();
+  sourceFormat_.clear();
+  width_ = std::max(width, 0);
+  height_ = std::max(height, 0);
+
+  if (width_ > 0 && height_ > 0) {
+    owned_.assign(AppendLevel(levels_, width_, height_), 0);
+  }
+  words_ = owned_.data();
+}
+
+size_t OccupancyGrid::AppendLevel(std::vector<Level>& levels, int width, int height) {
+  Level level;
+  level.width = width;
+  level.height = height;
+  level.wordsPerRow = (static_cast<size_t>(width) + 63) / 64;
+  level.offset = levels.empty() ? 0
+                                : levels.back().offset +
+                                      levels.back().wordsPerRow * levels.back().height;
+  levels.push_back(level);
+  return level.wordsPerRow * height;
+}
+
+void OccupancyGrid::MakeOwned() {
+  if (!file_.IsOpen()) {
+    return;
+  }
+
+  const Level& last = levels_.back();
+  owned_.assign(words_, words_ + last.offset + last.wordsPerRow * last.height);
+  words_ = owned_.data();
+  file_.Close();
+}
+
+bool OccupancyGrid::TestCell(const Level& level, int x, int y) const {
+  const uint64_t word = words_[level.offset + static_cast<size_t>(y) * level.wordsPerRow + (x >> 6)];
+  return (word >> (x & 63)) & 1u;
+}
+
+bool OccupancyGrid::AnyOccupiedInLevel(size_t level, const CellRange& cells,
+                                       const CellRange& query) const {
+  const Level& info = levels_[level];
+
+  if (level == 0) {
+    // Scan whole words, masking off the columns outside the range
+    const size_t firstWord = static_cast<size_t>(cells.x0) >> 6;
+    const size_t lastWord = static_cast<size_t>(cells.x1) >> 6;
+    const uint64_t firstMask = ~uint64_t{0} << (cells.x0 & 63);
+    const uint64_t lastMask = ~uint64_t{0} >> (63 - (cells.x1 & 63));
+    for (int y = cells.y0; y <= cells.y1; ++y) {
+      const uint64_t* row = words_ + info.offset + static_cast<size_t>(y) * info.wordsPerRow;
+      for (size_t word = firstWord; word <= lastWord; ++word) {
+        uint64_t mask = ~uint64_t{0};
+        if (word == firstWord) {
+          mask &= firstMask;
+        }
+        if (word == lastWord) {
+          mask &= lastMask;
+        }
+        if (row[word] & mask) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Descend only into occupied coarse cells, clipping each cell's children
+  // to the query range at the finer level
+  const size_t finer = level - 1;
+  const int shift = static_cast<int>(finer);
+  const CellRange clip{query.x0 >> shift, query.y0 >> shift, query.x1 >> shift,
+                       query.y1 >> shift};
+  for (int y = cells.y0; y <= cells.y1; ++y) {
+    for (int x = cells.x0; x <= cells.x1; ++x) {
+      if (!TestCell(info, x, y)) {
+        continue;
+      }
+      const CellRange children{std::max(2 * x, clip.x0), std::max(2 * y, clip.y0),
+                               std::min(2 * x + 1, clip.x1), std::min(2 * y + 1, clip.y1)};
+      if (children.x0 <= children.x1 && children.y0 <= children.y1 &&
+          AnyOccupiedInLevel(finer, children, query)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace mobilerobotsim
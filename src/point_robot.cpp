@@ -1,144 +1,261 @@
 #include "mobilerobotsim/point_robot.h"
 
 #include <Eigen/Dense>  // Include Eigen header for Vector2d
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <type_traits>
 
+#include "json_stream_reader.h"
+#include "mobilerobotsim/binary_io.h"
 #include "mobilerobotsim/robot_state.h"
 
 namespace mobilerobotsim {
 
-// Forward declaration of PointRobotState
-class PointRobotState : public RobotState {
- public:
-  PointRobotState(double x, double y, double orientation, double vx, double vy);
-  ~PointRobotState() override = default;
-
-  std::string getTypeId() const override { return "PointRobotState"; }
-  std::unique_ptr<RobotState> clone() const override;
-  std::string serialize() const override;
-  bool deserialize(const std::string& serialized) override;
-
-  Eigen::Vector2d position;
-  double x;
-  double y;
-  double orientation;
-  double vx;
-  double vy;
-};
-
-// Implementation of PointRobotState
-PointRobotState::PointRobotState(double x, double y, double orientation, double vx, double vy)
+// Implementation of BasicPointRobotState
+template <typename Scalar>
+BasicPointRobotState<Scalar>::BasicPointRobotState(Scalar x, Scalar y, Scalar orientation,
+                                                   Scalar vx, Scalar vy)
     : x(x), y(y), orientation(orientation), vx(vx), vy(vy) {}
 
-std::unique_ptr<RobotState> PointRobotState::clone() const {
-  return std::make_unique<PointRobotState>(x, y, orientation, vx, vy);
+template <typename Scalar>
+std::string BasicPointRobotState<Scalar>::GetTypeId() const {
+  return std::is_same_v<Scalar, float> ? "PointRobotStateF" : "PointRobotState";
 }
 
-std::string PointRobotState::serialize() const {
-  // Placeholder for serialization
-  return "{}";  // Empty JSON object
+template <typename Scalar>
+std::unique_ptr<RobotState> BasicPointRobotState<Scalar>::Clone() const {
+  return std::make_unique<BasicPointRobotState>(x, y, orientation, vx, vy);
 }
 
-bool PointRobotState::deserialize(const std::string& serialized) {
-  // Placeholder for deserialization
+template <typename Scalar>
+bool BasicPointRobotState<Scalar>::GetPose(double& poseX, double& poseY,
+                                           double& poseOrientation) const {
+  poseX = x;
+  poseY = y;
+  poseOrientation = orientation;
   return true;
 }
 
-// Implementation of PointRobot
-PointRobot::PointRobot()
-    : x_(0.0),
-      y_(0.0),
-      orientation_(0.0),
-      vx_(0.0),
-      vy_(0.0),
-      targetVx_(0.0),
-      targetVy_(0.0),
-      maxAcceleration_(1.0) {}
-
-PointRobot::PointRobot(double x, double y)
-    : x_(x),
-      y_(y),
-      orientation_(0.0),
-      vx_(0.0),
-      vy_(0.0),
-      targetVx_(0.0),
-      targetVy_(0.0),
-      maxAcceleration_(1.0) {}
-
-PointRobot::PointRobot(double x, double y, double orientation, double vx, double vy)
+template <typename Scalar>
+bool BasicPointRobotState<Scalar>::GetVelocity(double& velocityX, double& velocityY) const {
+  velocityX = vx;
+  velocityY = vy;
+  return true;
+}
+
+template <typename Scalar>
+std::string BasicPointRobotState<Scalar>::Serialize() const {
+  nlohmann::json state = {{"x", x}, {"y", y}, {"orientation", orientation}, {"vx", vx}, {"vy", vy}};
+  return state.dump();
+}
+
+template <typename Scalar>
+bool BasicPointRobotState<Scalar>::Deserialize(const std::string& serialized) {
+  const nlohmann::json parsed = nlohmann::json::parse(serialized, nullptr, false);
+  if (parsed.is_discarded() || !parsed.is_object() ||
+      !HasNumberMembers(parsed, {"x", "y", "orientation", "vx", "vy"})) {
+    return false;
+  }
+
+  // Missing members keep their current value
+  x = static_cast<Scalar>(parsed.value("x", static_cast<double>(x)));
+  y = static_cast<Scalar>(parsed.value("y", static_cast<double>(y)));
+  orientation = static_cast<Scalar>(parsed.value("orientation", static_cast<double>(orientation)));
+  vx = static_cast<Scalar>(parsed.value("vx", static_cast<double>(vx)));
+  vy = static_cast<Scalar>(parsed.value("vy", static_cast<double>(vy)));
+  return true;
+}
+
+template <typename Scalar>
+bool BasicPointRobotState<Scalar>::SaveBinary(BinaryWriter& writer) const {
+  writer.Write(x);
+  writer.Write(y);
+  writer.Write(orientation);
+  writer.Write(vx);
+  writer.Write(vy);
+  return true;
+}
+
+template <typename Scalar>
+bool BasicPointRobotState<Scalar>::LoadBinary(BinaryReader& reader) {
+  Scalar values[5];
+  for (Scalar& value : values) {
+    if (!reader.Read(value)) {
+      return false;
+    }
+  }
+
+  x = values[0];
+  y = values[1];
+  orientation = values[2];
+  vx = values[3];
+  vy = values[4];
+  return true;
+}
+
+// Implementation of BasicPointRobot
+template <typename Scalar>
+BasicPointRobot<Scalar>::BasicPointRobot() : BasicPointRobot(0, 0, 0, 0, 0) {}
+
+template <typename Scalar>
+BasicPointRobot<Scalar>::BasicPointRobot(Scalar x, Scalar y) : BasicPointRobot(x, y, 0, 0, 0) {}
+
+template <typename Scalar>
+BasicPointRobot<Scalar>::BasicPointRobot(Scalar x, Scalar y, Scalar orientation, Scalar vx,
+                                         Scalar vy)
     : position_(x, y),
       orientation_(orientation),
       velocity_(vx, vy),
       targetVelocity_(vx, vy),
-      maxAcceleration_(1.0) {}
+      maxAcceleration_(1),
+      maxVelocity_(10),
+      minVelocity_(0),
+      acceleration_(0),
+      velocityNoise_(0) {}
 
-PointRobot::~PointRobot() = default;
+template <typename Scalar>
+BasicPointRobot<Scalar>::~BasicPointRobot() = default;
 
-void PointRobot::UpdateState(double dt) {
-  // Simple acceleration model to reach target velocity
-  Eigen::Vector2d deltaV = targetVelocity_ - velocity_;
+template <typename Scalar>
+void BasicPointRobot<Scalar>::UpdateState(double dt) {
+  const Scalar step = static_cast<Scalar>(dt);
 
-  double dvx = targetVelocity_.x() - velocity_.x();
-  double dvy = targetVelocity_.y() - velocity_.y();
+  // Simple acceleration model to reach target velocity
+  Vector2 deltaV = targetVelocity_ - velocity_;
 
   // Limit acceleration
-  double accel = std::sqrt(dvx * dvx + dvy * dvy) / dt;
+  Scalar accel = deltaV.norm() / step;
   if (accel > maxAcceleration_) {
-    double scale = maxAcceleration_ / accel;
-    dvx *= scale;
-    dvy *= scale;
+    deltaV *= maxAcceleration_ / accel;
+    accel = maxAcceleration_;
   }
+  acceleration_ = accel;
 
   // Apply acceleration
-  velocity_ += dvx;
-  vy_ += dvy;
+  velocity_ += deltaV;
+  if (velocityNoise_ > 0) {
+    velocity_.x() += velocityNoise_ * static_cast<Scalar>(rng_.NextGaussian());
+    velocity_.y() += velocityNoise_ * static_cast<Scalar>(rng_.NextGaussian());
+  }
 
   // Update position
-  x_ += vx_ * dt;
-  y_ += vy_ * dt;
+  position_ += velocity_ * step;
 
   // Update orientation based on velocity
-  if (std::abs(vx_) > 1e-6 || std::abs(vy_) > 1e-6) {
-    orientation_ = std::atan2(vy_, vx_);
+  if (std::abs(velocity_.x()) > Scalar(1e-6) || std::abs(velocity_.y()) > Scalar(1e-6)) {
+    orientation_ = std::atan2(velocity_.y(), velocity_.x());
+  }
+}
+
+template <typename Scalar>
+bool BasicPointRobot<Scalar>::Advance(double duration) {
+  if (velocityNoise_ > 0) {
+    return false;
+  }
+
+  // Solve in double and round once, so long jumps do not lose float precision
+  Eigen::Vector2d position = position_.template cast<double>();
+  Eigen::Vector2d velocity = velocity_.template cast<double>();
+  const Eigen::Vector2d target = targetVelocity_.template cast<double>();
+  const double maxAcceleration = maxAcceleration_;
+
+  double remaining = duration;
+  const Eigen::Vector2d deltaV = target - velocity;
+  const double gap = deltaV.norm();
+  acceleration_ = 0;
+  if (gap > 0.0 && maxAcceleration > 0.0) {
+    // Constant acceleration along deltaV until the target velocity is reached
+    const double rampTime = gap / maxAcceleration;
+    const double t = std::min(duration, rampTime);
+    const Eigen::Vector2d acceleration = deltaV * (maxAcceleration / gap);
+    position += velocity * t + 0.5 * acceleration * t * t;
+    if (t < rampTime) {
+      velocity += acceleration * t;
+      acceleration_ = maxAcceleration_;
+    } else {
+      velocity = target;
+    }
+    remaining -= t;
+  }
+
+  position += velocity * remaining;
+  position_ = position.template cast<Scalar>();
+  velocity_ = velocity.template cast<Scalar>();
+
+  if (std::abs(velocity_.x()) > Scalar(1e-6) || std::abs(velocity_.y()) > Scalar(1e-6)) {
+    orientation_ = std::atan2(velocity_.y(), velocity_.x());
+  }
+  return true;
+}
+
+template <typename Scalar>
+double BasicPointRobot<Scalar>::GetSpeedBound() const {
+  if (velocityNoise_ > 0) {
+    return std::numeric_limits<double>::infinity();
   }
+  return std::max<double>(velocity_.norm(), targetVelocity_.norm());
 }
 
-std::unique_ptr<RobotState> PointRobot::GetState() const {
-  return std::make_unique<PointRobotState>(x_, y_, orientation_, vx_, vy_);
+template <typename Scalar>
+std::unique_ptr<RobotState> BasicPointRobot<Scalar>::GetState() const {
+  return std::make_unique<State>(position_.x(), position_.y(), orientation_, velocity_.x(),
+                                 velocity_.y());
 }
 
-bool PointRobot::LoadState(const RobotState& state) {
-  const auto* pointState = dynamic_cast<const PointRobotState*>(&state);
+template <typename Scalar>
+bool BasicPointRobot<Scalar>::LoadState(const RobotState& state) {
+  const auto* pointState = dynamic_cast<const State*>(&state);
   if (!pointState) {
     return false;
   }
 
-  x_ = pointState->x;
-  y_ = pointState->y;
+  position_ = Vector2(pointState->x, pointState->y);
   orientation_ = pointState->orientation;
-  vx_ = pointState->vx;
-  vy_ = pointState->vy;
+  velocity_ = Vector2(pointState->vx, pointState->vy);
+  RequestWake();
 
   return true;
 }
 
-void PointRobot::SetTargetVelocity(double vx, double vy) {
-  targetVx_ = vx;
-  targetVy_ = vy;
+template <typename Scalar>
+bool BasicPointRobot<Scalar>::IsAtRest() const {
+  return velocity_.isZero(0) && targetVelocity_.isZero(0) && velocityNoise_ <= 0;
 }
 
-void PointRobot::GetPosition(double& x, double& y) const {
-  x = x_;
-  y = y_;
+template <typename Scalar>
+void BasicPointRobot<Scalar>::SetTargetVelocity(Scalar vx, Scalar vy) {
+  targetVelocity_ = Vector2(vx, vy);
+  RequestWake();
 }
 
-double PointRobot::GetOrientation() const {
+template <typename Scalar>
+bool BasicPointRobot<Scalar>::SetTargetVelocity(const Eigen::Vector2d& velocity) {
+  SetTargetVelocity(static_cast<Scalar>(velocity.x()), static_cast<Scalar>(velocity.y()));
+  return true;
+}
+
+template <typename Scalar>
+void BasicPointRobot<Scalar>::GetPosition(Scalar& x, Scalar& y) const {
+  x = position_.x();
+  y = position_.y();
+}
+
+template <typename Scalar>
+double BasicPointRobot<Scalar>::GetOrientation() const {
   return orientation_;
 }
 
-void PointRobot::GetVelocity(double& vx, double& vy) const {
-  vx = vx_;
-  vy = vy_;
+template <typename Scalar>
+void BasicPointRobot<Scalar>::GetVelocity(Scalar& vx, Scalar& vy) const {
+  vx = velocity_.x();
+  vy = velocity_.y();
 }
 
+template class BasicPointRobotState<double>;
+template class BasicPointRobotState<float>;
+template class BasicPointRobot<double>;
+template class BasicPointRobot<float>;
+
 }  // namespace mobilerobotsim
@@ -0,0 +1,212 @@
+#include "mobilerobotsim/range_sensor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "mobilerobotsim/dynamic_obstacle.h"
+
+namespace mobilerobotsim {
+
+RangeSensor::RangeSensor(const RangeSensorConfig& config, size_t threadCount)
+    : config_(config), map_(nullptr), scanCount_(0), pool_(threadCount) {
+  config_.beamCount = std::max(config_.beamCount, 1);
+  beamCos_.resize(config_.beamCount);
+  beamSin_.resize(config_.beamCount);
+  for (int beam = 0; beam < config_.beamCount; ++beam) {
+    const double angle = GetBeamAngle(beam);
+    beamCos_[beam] = static_cast<float>(std::cos(angle));
+    beamSin_[beam] = static_cast<float>(std::sin(angle));
+  }
+
+  scratch_.resize(pool_.GetThreadCount());
+  for (Scratch& scratch : scratch_) {
+    scratch.directionX.resize(config_.beamCount);
+    scratch.directionY.resize(config_.beamCount);
+  }
+}
+
+RangeSensor::~RangeSensor() = default;
+
+bool RangeSensor::BuildStaticMap(const Environment& environment,
+                                 const Eigen::AlignedBox2d& region, double resolution) {
+  auto grid = std::make_unique<OccupancyGrid>();
+  if (!grid->Rasterize(environment, region, resolution)) {
+    return false;
+  }
+
+  grid->BuildMipLevels();
+  ownedMap_ = std::move(grid);
+  map_ = ownedMap_.get();
+  return true;
+}
+
+void RangeSensor::SetStaticMap(const OccupancyGrid* grid) {
+  ownedMap_.reset();
+  map_ = grid;
+}
+
+void RangeSensor::Reserve(size_t robotCount) {
+  ranges_.reserve(robotCount * static_cast<size_t>(config_.beamCount));
+}
+
+void RangeSensor::Scan(const Environment& environment, const Eigen::Matrix3Xd& poses) {
+  scanCount_ = static_cast<size_t>(poses.cols());
+  ranges_.resize(scanCount_ * static_cast<size_t>(config_.beamCount));
+
+  pool_.ParallelFor(scanCount_, [&](size_t begin, size_t end, size_t chunk) {
+    Scratch& scratch = scratch_[chunk];
+    for (size_t robot = begin; robot < end; ++robot) {
+      ScanRobot(environment, poses.col(static_cast<Eigen::Index>(robot)), scratch,
+                ranges_.data() + robot * static_cast<size_t>(config_.beamCount));
+    }
+  });
+}
+
+double RangeSensor::GetBeamAngle(int beam) const {
+  return config_.minAngle + (config_.maxAngle - config_.minAngle) * beam / config_.beamCount;
+}
+
+void RangeSensor::ScanRobot(const Environment& environment, const Eigen::Vector3d& pose,
+                            Scratch& scratch, float* ranges) const {
+  const int beams = config_.beamCount;
+  const float maxRange = static_cast<float>(config_.maxRange);
+  const Eigen::Vector2d origin = pose.head<2>();
+  const Eigen::AlignedBox2d window(origin.array() - config_.maxRange,
+                                   origin.array() + config_.maxRange);
+
+  // Rotate the beam fan into the world frame
+  const float c = static_cast<float>(std::cos(pose.z()));
+  const float s = static_cast<float>(std::sin(pose.z()));
+  float* dx = scratch.directionX.data();
+  float* dy = scratch.directionY.data();
+  for (int i = 0; i < beams; ++i) {
+    dx[i] = c * beamCos_[i] - s * beamSin_[i];
+    dy[i] = s * beamCos_[i] + c * beamSin_[i];
+  }
+
+  if (map_ != nullptr && map_->AnyOccupied(window)) {
+    for (int i = 0; i < beams; ++i) {
+      ranges[i] = CastStatic(origin, dx[i], dy[i]);
+    }
+  } else {
+    std::fill(ranges, ranges + beams, maxRange);
+  }
+
+  // Gather nearby dynamic geometry as circles relative to the robot
+  scratch.circleX.clear();
+  scratch.circleY.clear();
+  scratch.circleRadius.clear();
+  environment.ForEachDynamicElement(window, [&](const EnvironmentElement& element) {
+    if (!element.IsSolid()) {
+      return false;
+    }
+
+    Eigen::Vector2d center;
+    double radius;
+    if (const auto* obstacle = dynamic_cast<const DynamicObstacle*>(&element)) {
+      center = obstacle->GetPosition();
+      radius = obstacle->GetRadius();
+    } else {
+      const Eigen::AlignedBox2d bounds = element.GetBounds();
+      if (bounds.isEmpty()) {
+        return false;
+      }
+      center = bounds.center();
+      radius = 0.5 * bounds.sizes().norm();
+    }
+    scratch.circleX.push_back(static_cast<float>(center.x() - origin.x()));
+    scratch.circleY.push_back(static_cast<float>(center.y() - origin.y()));
+    scratch.circleRadius.push_back(static_cast<float>(radius));
+    return false;
+  });
+
+  for (size_t k = 0; k < scratch.circleX.size(); ++k) {
+    const float cx = scratch.circleX[k];
+    const float cy = scratch.circleY[k];
+    const float offset = cx * cx + cy * cy - scratch.circleRadius[k] * scratch.circleRadius[k];
+    if (offset <= 0.0f) {
+      // The sensor is inside the circle, so every beam is blocked immediately
+      std::fill(ranges, ranges + beams, 0.0f);
+      continue;
+    }
+
+    // Branch-free ray-circle test over all beams; written to vectorize
+    for (int i = 0; i < beams; ++i) {
+      const float b = cx * dx[i] + cy * dy[i];
+      const float discriminant = b * b - offset;
+      const float t = b - std::sqrt(std::max(discriminant, 0.0f));
+      const bool hit = discriminant >= 0.0f && b >= 0.0f && t < ranges[i];
+      ranges[i] = hit ? t : ranges[i];
+    }
+  }
+}
+
+float RangeSensor::CastStatic(const Eigen::Vector2d& origin, double directionX,
+                              double directionY) const {
+  const double resolution = map_->GetResolution();
+  const int width = map_->GetWidth();
+  const int height = map_->GetHeight();
+  const double px = (origin.x() - map_->GetOrigin().x()) / resolution;
+  const double py = (origin.y() - map_->GetOrigin().y()) / resolution;
+  const float miss = static_cast<float>(config_.maxRange);
+
+  // Clip the beam to the grid so that traversal starts at the first cell inside it
+  double tEnter = 0.0;
+  double tExit = config_.maxRange / resolution;
+  const double p[2] = {px, py};
+  const double d[2] = {directionX, directionY};
+  const double size[2] = {static_cast<double>(width), static_cast<double>(height)};
+  for (int axis = 0; axis < 2; ++axis) {
+    if (d[axis] == 0.0) {
+      if (p[axis] < 0.0 || p[axis] >= size[axis]) {
+        return miss;
+      }
+      continue;
+    }
+    double t0 = -p[axis] / d[axis];
+    double t1 = (size[axis] - p[axis]) / d[axis];
+    if (t0 > t1) {
+      std::swap(t0, t1);
+    }
+    tEnter = std::max(tEnter, t0);
+    tExit = std::min(tExit, t1);
+  }
+  if (tEnter > tExit) {
+    return miss;
+  }
+
+  // Amanatides-Woo traversal in cell units
+  const double inf = std::numeric_limits<double>::infinity();
+  int x = std::clamp(static_cast<int>(std::floor(px + directionX * tEnter)), 0, width - 1);
+  int y = std::clamp(static_cast<int>(std::floor(py + directionY * tEnter)), 0, height - 1);
+  const int stepX = directionX > 0.0 ? 1 : -1;
+  const int stepY = directionY > 0.0 ? 1 : -1;
+  const double deltaX = directionX != 0.0 ? std::abs(1.0 / directionX) : inf;
+  const double deltaY = directionY != 0.0 ? std::abs(1.0 / directionY) : inf;
+  double nextX = directionX != 0.0 ? (x + (stepX > 0 ? 1 : 0) - px) / directionX : inf;
+  double nextY = directionY != 0.0 ? (y + (stepY > 0 ? 1 : 0) - py) / directionY : inf;
+
+  double t = tEnter;
+  while (t <= tExit) {
+    if (map_->IsOccupied(x, y)) {
+      return static_cast<float>(t * resolution);
+    }
+    if (nextX < nextY) {
+      t = nextX;
+      nextX += deltaX;
+      x += stepX;
+    } else {
+      t = nextY;
+      nextY += deltaY;
+      y += stepY;
+    }
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+      break;
+    }
+  }
+
+  return miss;
+}
+
+}  // namespace mobilerobotsim
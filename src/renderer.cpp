@@ -2,73 +2,746 @@
 #include "mobilerobotsim/system_state.h"
 #include "mobilerobotsim/robot_state.h"
 #include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/mobile_robot_base.h"
+#include "mobilerobotsim/occupancy_grid.h"
+#include "mobilerobotsim/robot_sink.h"
+#include "mobilerobotsim/robot_source.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 
 namespace mobilerobotsim {
 
-// Forward declaration of Renderer implementation
-class Renderer : public SimulationObserver {
- public:
-  Renderer();
-  ~Renderer() override;
-  
-  // SimulationObserver interface implementation
-  void OnStep(const SystemState& state) override;
-  void OnCollision(const MobileRobotBase* robot, const void* object) override;
-  void OnMergePoint(const MobileRobotBase* robot, const EnvironmentElement* mergePoint) override;
-  
-  // Renderer-specific methods
-  void Initialize();
-  void Render(const SystemState& state);
-  void Shutdown();
-  
- private:
-  // Placeholder for rendering state
-  bool initialized_;
+namespace {
+
+using Color = std::array<uint8_t, 3>;
+
+constexpr Color kBackgroundColor = {245, 245, 245};
+constexpr Color kRobotColor = {30, 90, 200};
+constexpr Color kCollidedRobotColor = {220, 30, 30};
+constexpr Color kHeadingColor = {255, 255, 255};
+constexpr Color kMergePointColor = {70, 130, 180};
+constexpr Color kSinkColor = {40, 160, 70};
+constexpr Color kSourceColor = {230, 140, 30};
+constexpr Color kObstacleColor = {90, 90, 90};
+constexpr Color kOccupiedColor = {40, 40, 40};
+constexpr Color kElementColor = {150, 150, 150};
+
+// Default image size in pixels
+constexpr int kDefaultWidth = 800;
+constexpr int kDefaultHeight = 600;
+
+// Share of the fitted content added around it on each side
+constexpr double kFitMargin = 0.05;
+
+// Default drawn robot radius in pixels below which robots are aggregated
+constexpr double kDefaultDensityThreshold = 1.0;
+constexpr int kDefaultDensityTile = 4;
+
+// Share of a density tile's colour taken from the robot colour at the lowest count
+constexpr double kMinDensityShade = 0.35;
+
+// Maps world coordinates to pixels; rows grow downwards, y grows upwards
+struct Transform {
+  double scale;
+  double offsetX;
+  double offsetY;
+  int height;
+
+  double ToX(double x) const { return x * scale + offsetX; }
+  double ToY(double y) const { return height - (y * scale + offsetY); }
 };
 
-Renderer::Renderer() : initialized_(false) {
+Transform MakeTransform(const Renderer::Camera& camera, int width, int height) {
+  const double scale = camera.pixelsPerMetre;
+  return {scale, width * 0.5 - camera.center.x() * scale,
+          height * 0.5 - camera.center.y() * scale, height};
 }
 
-Renderer::~Renderer() {
-  if (initialized_) {
-    Shutdown();
+// Centres a region in the image at a uniform scale
+Renderer::Camera FitCamera(const Eigen::AlignedBox2d& region, int width, int height) {
+  const Eigen::Vector2d size = region.sizes().cwiseMax(1e-9);
+  return {region.center(), std::min(width / size.x(), height / size.y())};
+}
+
+// The world region a camera shows
+Eigen::AlignedBox2d VisibleRegion(const Renderer::Camera& camera, int width, int height) {
+  const Eigen::Vector2d half = Eigen::Vector2d(width, height) * (0.5 / camera.pixelsPerMetre);
+  return Eigen::AlignedBox2d(camera.center - half, camera.center + half);
+}
+
+void FillSpan(RgbImage& image, int y, double x0, double x1, const Color& color) {
+  if (y < 0 || y >= image.height) {
+    return;
+  }
+  const int begin = std::max(0, static_cast<int>(std::ceil(x0 - 0.5)));
+  const int end = std::min(image.width, static_cast<int>(std::ceil(x1 - 0.5)));
+  uint8_t* pixel = image.pixels.data() + (size_t(y) * image.width + begin) * 3;
+  for (int x = begin; x < end; ++x, pixel += 3) {
+    pixel[0] = color[0];
+    pixel[1] = color[1];
+    pixel[2] = color[2];
+  }
+}
+
+// Fills the pixels whose centres lie in a box given in pixel coordinates
+void FillBox(RgbImage& image, double x0, double y0, double x1, double y1, const Color& color) {
+  const int begin = std::max(0, static_cast<int>(std::ceil(y0 - 0.5)));
+  const int end = std::min(image.height, static_cast<int>(std::ceil(y1 - 0.5)));
+  for (int y = begin; y < end; ++y) {
+    FillSpan(image, y, x0, x1, color);
+  }
+}
+
+// Fills the pixels whose centres lie within a radius, minus those within an inner radius
+void FillRing(RgbImage& image, double cx, double cy, double radius, double inner,
+              const Color& color) {
+  const int begin = std::max(0, static_cast<int>(std::ceil(cy - radius - 0.5)));
+  const int end = std::min(image.height, static_cast<int>(std::ceil(cy + radius - 0.5)));
+  for (int y = begin; y < end; ++y) {
+    const double dy = y + 0.5 - cy;
+    const double outer = std::sqrt(std::max(radius * radius - dy * dy, 0.0));
+    if (inner > 0.0 && std::abs(dy) < inner) {
+      const double hole = std::sqrt(inner * inner - dy * dy);
+      FillSpan(image, y, cx - outer, cx - hole, color);
+      FillSpan(image, y, cx + hole, cx + outer, color);
+    } else {
+      FillSpan(image, y, cx - outer, cx + outer, color);
+    }
+  }
+}
+
+void DrawLine(RgbImage& image, double x0, double y0, double x1, double y1, const Color& color) {
+  const int steps = static_cast<int>(std::ceil(std::max(std::abs(x1 - x0), std::abs(y1 - y0))));
+  for (int i = 0; i <= steps; ++i) {
+    const double t = steps > 0 ? static_cast<double>(i) / steps : 0.0;
+    const int x = static_cast<int>(std::floor(x0 + t * (x1 - x0)));
+    const int y = static_cast<int>(std::floor(y0 + t * (y1 - y0)));
+    if (x >= 0 && x < image.width && y >= 0 && y < image.height) {
+      uint8_t* pixel = image.pixels.data() + (size_t(y) * image.width + x) * 3;
+      pixel[0] = color[0];
+      pixel[1] = color[1];
+      pixel[2] = color[2];
+    }
+  }
+}
+
+// Appends the shapes of one element. Occupancy grids become runs of
+// occupied cells within a region, sampled in blocks of about one pixel when
+// their cells are smaller than that
+template <typename Shape>
+void AppendShapes(const EnvironmentElement& element, const Eigen::AlignedBox2d& region,
+                  double pixelsPerMetre, std::vector<Shape>& shapes) {
+  if (const auto* grid = dynamic_cast<const OccupancyGrid*>(&element)) {
+    const double resolution = grid->GetResolution();
+    const Eigen::Vector2d& origin = grid->GetOrigin();
+    const int width = grid->GetWidth();
+    const int height = grid->GetHeight();
+    const double cellsPerPixel =
+        pixelsPerMetre > 0.0 ? 1.0 / (resolution * pixelsPerMetre) : 1.0;
+    const int stride = static_cast<int>(
+        std::clamp(std::floor(cellsPerPixel), 1.0, static_cast<double>(std::max(width, height))));
+
+    // Clamp in floating point so far-away regions cannot overflow
+    const Eigen::Vector2d size(width, height);
+    const Eigen::Vector2d lo = ((region.min() - origin) / resolution).cwiseMax(0.0).cwiseMin(size);
+    const Eigen::Vector2d hi = ((region.max() - origin) / resolution).cwiseMax(0.0).cwiseMin(size);
+    const int x0 = static_cast<int>(lo.x()) / stride * stride;
+    const int y0 = static_cast<int>(lo.y()) / stride * stride;
+    const int x1 = static_cast<int>(std::ceil(hi.x()));
+    const int y1 = static_cast<int>(std::ceil(hi.y()));
+
+    // A block of cells is occupied if any of its cells is; the query box is
+    // inset so it does not touch the neighbouring cells
+    const auto occupied = [&](int x, int y) {
+      if (stride == 1) {
+        return grid->IsOccupied(x, y);
+      }
+      const Eigen::Vector2d min = origin + (Eigen::Vector2d(x, y).array() + 0.25).matrix() * resolution;
+      const Eigen::Vector2d max =
+          origin + (Eigen::Vector2d(x + stride, y + stride).array() - 0.25).matrix() * resolution;
+      return grid->AnyOccupied(Eigen::AlignedBox2d(min, max));
+    };
+
+    for (int y = y0; y < y1; y += stride) {
+      int x = x0;
+      while (x < x1) {
+        if (!occupied(x, y)) {
+          x += stride;
+          continue;
+        }
+        const int start = x;
+        while (x < x1 && occupied(x, y)) {
+          x += stride;
+        }
+        const Eigen::Vector2d min = origin + Eigen::Vector2d(start, y) * resolution;
+        const Eigen::Vector2d max =
+            origin + Eigen::Vector2d(std::min(x, width), std::min(y + stride, height)) * resolution;
+        shapes.push_back({Eigen::AlignedBox2d(min, max), false, true, kOccupiedColor});
+      }
+    }
+    return;
+  }
+
+  const Eigen::AlignedBox2d bounds = element.GetBounds();
+  if (bounds.isEmpty()) {
+    return;
+  }
+  if (dynamic_cast<const MergePoint*>(&element) != nullptr) {
+    shapes.push_back({bounds, true, false, kMergePointColor});
+  } else if (dynamic_cast<const RobotSink*>(&element) != nullptr) {
+    shapes.push_back({bounds, true, false, kSinkColor});
+  } else if (dynamic_cast<const RobotSource*>(&element) != nullptr) {
+    shapes.push_back({bounds, true, false, kSourceColor});
+  } else if (dynamic_cast<const DynamicObstacle*>(&element) != nullptr) {
+    shapes.push_back({bounds, true, true, kObstacleColor});
+  } else {
+    shapes.push_back({bounds, false, element.IsSolid(), kElementColor});
   }
 }
 
+template <typename Shape>
+void DrawShape(RgbImage& image, const Transform& transform, const Shape& shape) {
+  const double x0 = transform.ToX(shape.bounds.min().x());
+  const double x1 = transform.ToX(shape.bounds.max().x());
+  const double y0 = transform.ToY(shape.bounds.max().y());
+  const double y1 = transform.ToY(shape.bounds.min().y());
+  if (shape.disc) {
+    const double radius = std::max(0.5 * (x1 - x0), 1.0);
+    FillRing(image, 0.5 * (x0 + x1), 0.5 * (y0 + y1), radius,
+             shape.filled ? 0.0 : radius - 1.5, shape.color);
+  } else if (shape.filled) {
+    FillBox(image, x0, y0, std::max(x1, x0 + 1.0), std::max(y1, y0 + 1.0), shape.color);
+  } else {
+    FillBox(image, x0, y0, x1, y0 + 1.0, shape.color);
+    FillBox(image, x0, y1 - 1.0, x1, y1, shape.color);
+    FillBox(image, x0, y0, x0 + 1.0, y1, shape.color);
+    FillBox(image, x1 - 1.0, y0, x1, y1, shape.color);
+  }
+}
+
+// Orders handles for looking up collided robots
+bool HandleLess(const SlotHandle& a, const SlotHandle& b) {
+  return a.index != b.index ? a.index < b.index : a.generation < b.generation;
+}
+
+// CRC-32 as used by PNG chunks
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+  static const auto table = [] {
+    std::array<uint32_t, 256> values{};
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      values[n] = c;
+    }
+    return values;
+  }();
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+void AppendBigEndian(std::string& out, uint32_t value) {
+  out.push_back(static_cast<char>(value >> 24));
+  out.push_back(static_cast<char>(value >> 16));
+  out.push_back(static_cast<char>(value >> 8));
+  out.push_back(static_cast<char>(value));
+}
+
+void WriteChunk(std::ofstream& file, const char* type, const std::string& data) {
+  std::string chunk;
+  AppendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+  chunk.append(type, 4);
+  chunk.append(data);
+  const auto* bytes = reinterpret_cast<const uint8_t*>(chunk.data());
+  AppendBigEndian(chunk, Crc32(bytes + 4, chunk.size() - 4));
+  file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+}
+
+}  // namespace
+
+void RgbImage::Resize(int newWidth, int newHeight) {
+  width = std::max(newWidth, 0);
+  height = std::max(newHeight, 0);
+  pixels.resize(size_t(width) * height * 3);
+}
+
+bool RgbImage::WritePpm(const std::string& path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  file << "P6\n" << width << " " << height << "\n255\n";
+  file.write(reinterpret_cast<const char*>(pixels.data()),
+             static_cast<std::streamsize>(pixels.size()));
+  return file.good();
+}
+
+bool RgbImage::WritePng(const std::string& path) const {
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  static const char kSignature[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+  file.write(kSignature, sizeof(kSignature));
+
+  std::string header;
+  AppendBigEndian(header, static_cast<uint32_t>(width));
+  AppendBigEndian(header, static_cast<uint32_t>(height));
+  header += std::string("\x08\x02\x00\x00\x00", 5);  // 8-bit RGB, no interlace
+  WriteChunk(file, "IHDR", header);
+
+  // Each row is preceded by filter type 0; the rows form a zlib stream of
+  // stored deflate blocks
+  const size_t rowSize = size_t(width) * 3;
+  std::string raw;
+  raw.reserve((rowSize + 1) * height);
+  for (int y = 0; y < height; ++y) {
+    raw.push_back('\0');
+    raw.append(reinterpret_cast<const char*>(pixels.data()) + y * rowSize, rowSize);
+  }
+
+  std::string data("\x78\x01", 2);
+  data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+  size_t offset = 0;
+  do {
+    const size_t length = std::min<size_t>(raw.size() - offset, 65535);
+    const bool last = offset + length == raw.size();
+    data.push_back(last ? '\x01' : '\x00');
+    data.push_back(static_cast<char>(length & 0xff));
+    data.push_back(static_cast<char>(length >> 8));
+    data.push_back(static_cast<char>(~length & 0xff));
+    data.push_back(static_cast<char>((~length >> 8) & 0xff));
+    data.append(raw, offset, length);
+    offset += length;
+  } while (offset < raw.size());
+
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (char c : raw) {
+    a = (a + static_cast<uint8_t>(c)) % 65521;
+    b = (b + a) % 65521;
+  }
+  AppendBigEndian(data, (b << 16) | a);
+  WriteChunk(file, "IDAT", data);
+  WriteChunk(file, "IEND", std::string());
+  return file.good();
+}
+
+Renderer::Renderer() : Renderer(nullptr) {
+}
+
+Renderer::Renderer(const Environment* environment)
+    : environment_(environment),
+      staticRevision_(0),
+      staticScale_(0.0),
+      stepCount_(0),
+      frameInterval_(1),
+      writeSlot_(0),
+      readySlot_(1),
+      readSlot_(2),
+      hasReadyFrame_(false),
+      drawing_(false),
+      stopping_(false),
+      width_(kDefaultWidth),
+      height_(kDefaultHeight),
+      robotRadius_(0.25),
+      densityThreshold_(kDefaultDensityThreshold),
+      densityTile_(kDefaultDensityTile),
+      outputFormat_(ImageFormat::kPng),
+      framesRendered_(0),
+      framesDropped_(0) {
+}
+
+Renderer::~Renderer() {
+  Shutdown();
+}
+
 void Renderer::OnStep(const SystemState& state) {
-  if (!initialized_) {
-    Initialize();
+  Initialize();
+
+  // Only the frame being captured is touched outside the lock
+  Frame& frame = frames_[writeSlot_];
+  frame.step = stepCount_ - 1;
+  Capture(state, frame);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(writeSlot_, readySlot_);
+    if (hasReadyFrame_) {
+      ++framesDropped_;
+    }
+    hasReadyFrame_ = true;
   }
-  
-  Render(state);
+  frameReady_.notify_one();
 }
 
-void Renderer::OnCollision(const MobileRobotBase* robot, const void* object) {
-  // Placeholder for collision visualization
+bool Renderer::NeedsStepState() {
+  return stepCount_++ % frameInterval_ == 0;
 }
 
-void Renderer::OnMergePoint(const MobileRobotBase* robot, const EnvironmentElement* mergePoint) {
-  // Placeholder for merge point visualization
+void Renderer::OnCollision(const MobileRobotBase* robot, const void* /*object*/) {
+  collisions_.push_back(robot->GetHandle());
 }
 
-void Renderer::Initialize() {
-  // Placeholder for renderer initialization
-  // In a real implementation, this would set up graphics context, load shaders, etc.
-  initialized_ = true;
+void Renderer::OnMergePoint(const MobileRobotBase* /*robot*/,
+                            const EnvironmentElement* /*mergePoint*/) {
 }
 
-void Renderer::Render(const SystemState& state) {
-  // Placeholder for rendering logic
-  // In a real implementation, this would clear the screen, render all objects, and swap buffers
-  
-  // Example: Print simulation time to console
-  // std::cout << "Rendering state at time: " << state.GetTime() << " seconds" << std::endl;
+bool Renderer::Initialize() {
+  if (!thread_.joinable()) {
+    stopping_ = false;
+    thread_ = std::thread(&Renderer::RenderLoop, this);
+  }
+  return true;
+}
+
+RgbImage Renderer::Render(const SystemState& state) {
+  Frame frame;
+  Capture(state, frame);
+
+  Background background;
+  RgbImage image;
+  Draw(frame, background, image);
+  return image;
 }
 
 void Renderer::Shutdown() {
-  // Placeholder for renderer cleanup
-  // In a real implementation, this would clean up graphics resources
-  initialized_ = false;
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  frameReady_.notify_one();
+  thread_.join();
+}
+
+void Renderer::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  frameDone_.wait(lock, [this] { return !thread_.joinable() || (!hasReadyFrame_ && !drawing_); });
+}
+
+void Renderer::SetImageSize(int width, int height) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  width_ = std::max(width, 1);
+  height_ = std::max(height, 1);
+}
+
+void Renderer::SetViewport(const Eigen::AlignedBox2d& region) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  viewport_ = region;
+  camera_ = Camera();
+}
+
+void Renderer::SetCamera(const Camera& camera) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  camera_ = camera;
+  camera_.pixelsPerMetre = std::max(camera.pixelsPerMetre, 0.0);
+}
+
+Renderer::Camera Renderer::GetCamera() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return camera_;
+}
+
+void Renderer::SetDensityThreshold(double radiusPixels, int tilePixels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  densityThreshold_ = std::max(radiusPixels, 0.0);
+  densityTile_ = std::max(tilePixels, 1);
+}
+
+void Renderer::SetFrameInterval(size_t steps) {
+  frameInterval_ = std::max<size_t>(steps, 1);
+}
+
+void Renderer::SetRobotRadius(double radius) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  robotRadius_ = std::max(radius, 0.0);
+}
+
+void Renderer::SetOutput(const std::string& prefix, ImageFormat format) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  outputPrefix_ = prefix;
+  outputFormat_ = format;
+}
+
+uint64_t Renderer::GetFramesRendered() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return framesRendered_;
+}
+
+uint64_t Renderer::GetFramesDropped() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return framesDropped_;
+}
+
+RgbImage Renderer::GetLastImage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return lastImage_;
+}
+
+Renderer::CaptureStats Renderer::GetCaptureStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return captureStats_;
+}
+
+void Renderer::Capture(const SystemState& state, Frame& frame) {
+  Eigen::AlignedBox2d viewport;
+  double densityThreshold = 0.0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    viewport = viewport_;
+    frame.camera = camera_;
+    frame.width = width_;
+    frame.height = height_;
+    frame.robotRadius = robotRadius_;
+    frame.densityTile = densityTile_;
+    densityThreshold = densityThreshold_;
+  }
+  CaptureStats stats;
+  frame.dynamicShapes.clear();
+
+  const Eigen::AlignedBox2d everywhere(Eigen::Vector2d::Constant(-1e300),
+                                       Eigen::Vector2d::Constant(1e300));
+  if (frame.camera.pixelsPerMetre > 0.0 || !viewport.isEmpty()) {
+    if (frame.camera.pixelsPerMetre <= 0.0) {
+      frame.camera = FitCamera(viewport, frame.width, frame.height);
+    }
+    const Eigen::AlignedBox2d visible = VisibleRegion(frame.camera, frame.width, frame.height);
+    if (environment_ != nullptr) {
+      CaptureStatic(visible, frame.camera.pixelsPerMetre);
+      environment_->ForEachDynamicElement(visible, [&](const EnvironmentElement& element) {
+        AppendShapes(element, visible, frame.camera.pixelsPerMetre, frame.dynamicShapes);
+        return false;
+      });
+    }
+  } else {
+    // Fitting needs every robot and element, so nothing is culled
+    Eigen::AlignedBox2d region;
+    if (environment_ != nullptr) {
+      CaptureStatic(everywhere, 0.0);
+      environment_->ForEachDynamicElement(everywhere, [&](const EnvironmentElement& element) {
+        AppendShapes(element, everywhere, 0.0, frame.dynamicShapes);
+        return false;
+      });
+      for (const Shape& shape : *staticShapes_) {
+        region.extend(shape.bounds);
+      }
+    }
+    for (const Shape& shape : frame.dynamicShapes) {
+      region.extend(shape.bounds);
+    }
+    for (size_t i = 0; i < state.GetRobotStateCount(); ++i) {
+      double x = 0.0;
+      double y = 0.0;
+      double orientation = 0.0;
+      if (state.GetRobotState(i)->GetPose(x, y, orientation)) {
+        region.extend(Eigen::Vector2d(x, y));
+      }
+    }
+    if (region.isEmpty()) {
+      region = Eigen::AlignedBox2d(Eigen::Vector2d(-1.0, -1.0), Eigen::Vector2d(1.0, 1.0));
+    }
+    const Eigen::Vector2d margin =
+        (region.sizes() * kFitMargin).cwiseMax(frame.robotRadius * 2.0);
+    frame.camera = FitCamera(Eigen::AlignedBox2d(region.min() - margin, region.max() + margin),
+                             frame.width, frame.height);
+  }
+  frame.staticShapes = environment_ != nullptr ? staticShapes_ : nullptr;
+
+  // Robots are culled and aggregated in pixel space
+  const Transform transform = MakeTransform(frame.camera, frame.width, frame.height);
+  const double radius = frame.robotRadius * transform.scale;
+  const bool aggregate = radius < densityThreshold;
+  const double reach = std::max(radius, 1.0);
+  const int tile = frame.densityTile;
+  frame.densityColumns = (frame.width + tile - 1) / tile;
+  frame.density.assign(aggregate ? size_t(frame.densityColumns) * ((frame.height + tile - 1) / tile)
+                                 : 0,
+                       0);
+
+  std::sort(collisions_.begin(), collisions_.end(), HandleLess);
+  frame.robots.clear();
+  frame.collided.clear();
+  for (size_t i = 0; i < state.GetRobotStateCount(); ++i) {
+    double x = 0.0;
+    double y = 0.0;
+    double orientation = 0.0;
+    if (!state.GetRobotState(i)->GetPose(x, y, orientation)) {
+      continue;
+    }
+    const double px = transform.ToX(x);
+    const double py = transform.ToY(y);
+    if (!(px > -reach && px < frame.width + reach && py > -reach && py < frame.height + reach)) {
+      ++stats.robotsCulled;
+      continue;
+    }
+    const bool collided = std::binary_search(collisions_.begin(), collisions_.end(),
+                                             state.GetRobotHandle(i), HandleLess);
+    if (aggregate && !collided) {
+      // Sub-pixel robots only count where their centre falls
+      if (px >= 0.0 && px < frame.width && py >= 0.0 && py < frame.height) {
+        ++frame.density[size_t(py / tile) * frame.densityColumns + size_t(px / tile)];
+        ++stats.robotsAggregated;
+      } else {
+        ++stats.robotsCulled;
+      }
+      continue;
+    }
+    frame.robots.emplace_back(x, y, orientation);
+    frame.collided.push_back(collided);
+    ++stats.robotsDrawn;
+  }
+  collisions_.clear();
+
+  stats.shapes = frame.dynamicShapes.size() +
+                 (frame.staticShapes != nullptr ? frame.staticShapes->size() : 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  captureStats_ = stats;
+}
+
+void Renderer::CaptureStatic(const Eigen::AlignedBox2d& region, double pixelsPerMetre) {
+  if (staticShapes_ != nullptr && staticRevision_ == environment_->GetRevision() &&
+      staticScale_ == pixelsPerMetre && staticRegion_.contains(region)) {
+    return;
+  }
+
+  // Cover half a view more on each side so that panning rarely captures again
+  const Eigen::AlignedBox2d covered =
+      pixelsPerMetre > 0.0
+          ? Eigen::AlignedBox2d(region.min() - region.sizes() * 0.5,
+                                region.max() + region.sizes() * 0.5)
+          : region;
+  auto shapes = std::make_shared<ShapeList>();
+  environment_->ForEachStaticElement(covered, [&](const EnvironmentElement& element) {
+    AppendShapes(element, covered, pixelsPerMetre, *shapes);
+    return false;
+  });
+  staticShapes_ = std::move(shapes);
+  staticRevision_ = environment_->GetRevision();
+  staticRegion_ = covered;
+  staticScale_ = pixelsPerMetre;
+}
+
+void Renderer::Draw(const Frame& frame, Background& background, RgbImage& image) const {
+  const int width = frame.width;
+  const int height = frame.height;
+  const Transform transform = MakeTransform(frame.camera, width, height);
+
+  // The static elements only change with the environment revision and the camera
+  if (background.shapes != frame.staticShapes ||
+      background.camera.center != frame.camera.center ||
+      background.camera.pixelsPerMetre != frame.camera.pixelsPerMetre ||
+      background.image.width != width || background.image.height != height) {
+    background.shapes = frame.staticShapes;
+    background.camera = frame.camera;
+    background.image.Resize(width, height);
+    for (size_t i = 0; i < background.image.pixels.size(); i += 3) {
+      std::copy(kBackgroundColor.begin(), kBackgroundColor.end(), &background.image.pixels[i]);
+    }
+    if (frame.staticShapes != nullptr) {
+      for (const Shape& shape : *frame.staticShapes) {
+        DrawShape(background.image, transform, shape);
+      }
+    }
+  }
+
+  image.Resize(width, height);
+  std::copy(background.image.pixels.begin(), background.image.pixels.end(),
+            image.pixels.begin());
+  for (const Shape& shape : frame.dynamicShapes) {
+    DrawShape(image, transform, shape);
+  }
+
+  // Density tiles blend towards the robot colour with the logarithm of their count
+  if (!frame.density.empty()) {
+    const uint32_t most = *std::max_element(frame.density.begin(), frame.density.end());
+    const double normalizer = most > 0 ? 1.0 / std::log1p(static_cast<double>(most)) : 0.0;
+    const int tile = frame.densityTile;
+    for (size_t i = 0; i < frame.density.size(); ++i) {
+      if (frame.density[i] == 0) {
+        continue;
+      }
+      const double shade = kMinDensityShade + (1.0 - kMinDensityShade) *
+                                                  std::log1p(static_cast<double>(frame.density[i])) *
+                                                  normalizer;
+      const int x0 = static_cast<int>(i % frame.densityColumns) * tile;
+      const int y0 = static_cast<int>(i / frame.densityColumns) * tile;
+      const int x1 = std::min(x0 + tile, width);
+      const int y1 = std::min(y0 + tile, height);
+      for (int y = y0; y < y1; ++y) {
+        uint8_t* pixel = image.pixels.data() + (size_t(y) * width + x0) * 3;
+        for (int x = x0; x < x1; ++x, pixel += 3) {
+          for (int c = 0; c < 3; ++c) {
+            pixel[c] = static_cast<uint8_t>(std::lround(pixel[c] + (kRobotColor[c] - pixel[c]) * shade));
+          }
+        }
+      }
+    }
+  }
+
+  const double radius = std::max(frame.robotRadius * transform.scale, 1.0);
+  for (size_t i = 0; i < frame.robots.size(); ++i) {
+    const Eigen::Vector3d& robot = frame.robots[i];
+    const double x = transform.ToX(robot.x());
+    const double y = transform.ToY(robot.y());
+    FillRing(image, x, y, radius, 0.0, frame.collided[i] ? kCollidedRobotColor : kRobotColor);
+    if (radius >= 3.0) {
+      DrawLine(image, x, y, x + radius * std::cos(robot.z()), y - radius * std::sin(robot.z()),
+               kHeadingColor);
+    }
+  }
+}
+
+void Renderer::RenderLoop() {
+  Background background;
+  RgbImage image;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    frameReady_.wait(lock, [this] { return stopping_ || hasReadyFrame_; });
+    if (!hasReadyFrame_) {
+      // Only reached when stopping with nothing left to draw
+      return;
+    }
+
+    std::swap(readSlot_, readySlot_);
+    hasReadyFrame_ = false;
+    drawing_ = true;
+    const std::string prefix = outputPrefix_;
+    const ImageFormat format = outputFormat_;
+    const Frame& frame = frames_[readSlot_];
+    lock.unlock();
+
+    Draw(frame, background, image);
+    if (!prefix.empty()) {
+      char number[32];
+      std::snprintf(number, sizeof(number), "%06llu",
+                    static_cast<unsigned long long>(frame.step));
+      if (format == ImageFormat::kPpm) {
+        image.WritePpm(prefix + number + ".ppm");
+      } else {
+        image.WritePng(prefix + number + ".png");
+      }
+    }
+
+    lock.lock();
+    std::swap(image, lastImage_);
+    ++framesRendered_;
+    drawing_ = false;
+    frameDone_.notify_all();
+  }
 }
 
 } // namespace mobilerobotsim
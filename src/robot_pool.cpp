@@ -0,0 +1,68 @@
+#include "mobilerobotsim/robot_pool.h"
+
+#include "mobilerobotsim/mobile_robot_base.h"
+
+namespace mobilerobotsim {
+
+RobotPool::RobotPool() : createdCount_(0) {}
+
+RobotPool::~RobotPool() = default;
+
+size_t RobotPool::RegisterType(const std::string& stateTypeId, Factory factory) {
+  const auto it = typeIndex_.find(stateTypeId);
+  if (it != typeIndex_.end()) {
+    types_[it->second].factory = std::move(factory);
+    types_[it->second].free.clear();
+    return it->second;
+  }
+
+  types_.push_back({std::move(factory), {}});
+  typeIndex_[stateTypeId] = types_.size() - 1;
+  return types_.size() - 1;
+}
+
+size_t RobotPool::FindType(const std::string& stateTypeId) const {
+  const auto it = typeIndex_.find(stateTypeId);
+  return it != typeIndex_.end() ? it->second : kNoType;
+}
+
+std::unique_ptr<MobileRobotBase> RobotPool::Acquire(size_t type) {
+  if (type >= types_.size()) {
+    return nullptr;
+  }
+
+  TypePool& pool = types_[type];
+  if (pool.free.empty()) {
+    ++createdCount_;
+    return pool.factory();
+  }
+
+  std::unique_ptr<MobileRobotBase> robot = std::move(pool.free.back());
+  pool.free.pop_back();
+  return robot;
+}
+
+void RobotPool::Release(size_t type, std::unique_ptr<MobileRobotBase> robot) {
+  if (type < types_.size() && robot != nullptr) {
+    types_[type].free.push_back(std::move(robot));
+  }
+}
+
+void RobotPool::Reserve(size_t type, size_t count) {
+  if (type >= types_.size()) {
+    return;
+  }
+
+  TypePool& pool = types_[type];
+  pool.free.reserve(count);
+  while (pool.free.size() < count) {
+    pool.free.push_back(pool.factory());
+    ++createdCount_;
+  }
+}
+
+size_t RobotPool::GetFreeCount(size_t type) const {
+  return type < types_.size() ? types_[type].free.size() : 0;
+}
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,74 @@
+#include "mobilerobotsim/robot_source.h"
+
+#include <nlohmann/json.hpp>
+
+#include "json_stream_reader.h"
+#include "mobilerobotsim/system_state.h"
+
+namespace mobilerobotsim {
+
+RobotSource::RobotSource(double x, double y, double interval,
+                         std::unique_ptr<RobotState> spawnState, SpawnCommand command,
+                         double startTime)
+    : position_(x, y),
+      interval_(interval),
+      startTime_(startTime),
+      spawnState_(std::move(spawnState)),
+      robotType_(spawnState_->GetTypeId()),
+      command_(std::move(command)) {}
+
+RobotSource::~RobotSource() = default;
+
+bool RobotSource::CheckCollision(const Eigen::Vector2d& /*position*/) const {
+  return false;
+}
+
+std::string RobotSource::GetState() const {
+  nlohmann::json state = {{"x", position_.x()},
+                          {"y", position_.y()},
+                          {"interval", interval_},
+                          {"startTime", startTime_},
+                          {"robotType", robotType_},
+                          {"spawnState", spawnState_->Serialize()}};
+  return state.dump();
+}
+
+bool RobotSource::LoadState(const std::string& state) {
+  const nlohmann::json parsed = nlohmann::json::parse(state, nullptr, false);
+  if (parsed.is_discarded() || !parsed.is_object() ||
+      !HasNumberMembers(parsed, {"x", "y", "interval", "startTime"}) ||
+      !HasStringMembers(parsed, {"robotType"})) {
+    return false;
+  }
+
+  std::unique_ptr<RobotState> spawnState;
+  const std::string robotType = parsed.value("robotType", robotType_);
+  if (robotType != robotType_) {
+    spawnState = SystemState::CreateRobotState(robotType);
+    if (spawnState == nullptr) {
+      return false;
+    }
+  }
+  RobotState& target = spawnState != nullptr ? *spawnState : *spawnState_;
+  if (parsed.contains("spawnState") &&
+      (!parsed["spawnState"].is_string() ||
+       !target.Deserialize(parsed["spawnState"].get<std::string>()))) {
+    return false;
+  }
+
+  if (spawnState != nullptr) {
+    spawnState_ = std::move(spawnState);
+    robotType_ = robotType;
+  }
+
+  position_ = Eigen::Vector2d(parsed.value("x", position_.x()), parsed.value("y", position_.y()));
+  interval_ = parsed.value("interval", interval_);
+  startTime_ = parsed.value("startTime", startTime_);
+  return true;
+}
+
+Eigen::AlignedBox2d RobotSource::GetBounds() const {
+  return Eigen::AlignedBox2d(position_, position_);
+}
+
+}  // namespace mobilerobotsim
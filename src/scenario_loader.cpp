@@ -0,0 +1,369 @@
+#include "mobilerobotsim/scenario_loader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+#include "json_stream_reader.h"
+#include "mobilerobotsim/binary_io.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/hash.h"
+#include "mobilerobotsim/mapped_file.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/occupancy_grid.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/robot_sink.h"
+#include "mobilerobotsim/robot_source.h"
+#include "mobilerobotsim/system_state.h"
+
+namespace mobilerobotsim {
+
+namespace {
+
+constexpr char kCacheMagic[8] = {'M', 'R', 'S', 'S', 'C', 'N', '0', '1'};
+
+// Fixed-size header of the cache format; the compiled scenario follows it
+struct CacheHeader {
+  char magic[8];
+  uint64_t key;
+};
+
+// How the state of a cached element or robot is stored
+constexpr uint8_t kTextRecord = 0;    // GetState() or Serialize() text
+constexpr uint8_t kBinaryRecord = 1;  // SaveBinary() bytes
+
+// Appends the state of an element or robot, in binary form if it has one
+template <typename T>
+void WriteRecord(BinaryWriter& writer, uint32_t type, const T& object, const std::string& text) {
+  std::string payload;
+  BinaryWriter payloadWriter(payload);
+  const bool binary = object.SaveBinary(payloadWriter);
+
+  writer.Write(type);
+  writer.Write(binary ? kBinaryRecord : kTextRecord);
+  writer.WriteString(binary ? payload : text);
+}
+
+// Loads a state written by WriteRecord() after its type
+template <typename T, typename LoadText>
+bool ReadRecord(BinaryReader& reader, T& object, LoadText loadText) {
+  uint8_t kind = 0;
+  if (!reader.Read(kind)) {
+    return false;
+  }
+
+  if (kind == kBinaryRecord) {
+    BinaryReader block(nullptr, 0);
+    return reader.ReadBlock(block) && object.LoadBinary(block) && block.GetRemaining() == 0;
+  }
+
+  std::string text;
+  return kind == kTextRecord && reader.ReadString(text) && loadText(object, text);
+}
+
+// Writes the cache next to its destination, then renames it into place so
+// that a process mapping the old cache never sees it truncated
+void WriteCache(const std::string& path, const CacheHeader& header, const std::string& image) {
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary);
+    if (!file.is_open()) {
+      return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(image.data(), static_cast<std::streamsize>(image.size()));
+    file.close();
+    if (file.fail()) {
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+
+  // A cache that cannot be written only costs the next load a parse
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+  }
+}
+
+}  // namespace
+
+ScenarioLoader::ScenarioLoader() : fromCache_(false) {
+  RegisterElementType("MergePoint", [] { return std::make_unique<MergePoint>(0.0, 0.0, 0.0); });
+  RegisterElementType("RobotSink", [] { return std::make_unique<RobotSink>(0.0, 0.0, 0.0); });
+  RegisterElementType("DynamicObstacle",
+                      [] { return std::make_unique<DynamicObstacle>(0.0, 0.0, 0.0); });
+  RegisterElementType("OccupancyGrid", [] { return std::make_unique<OccupancyGrid>(); });
+  RegisterElementType("RobotSource", [] {
+    return std::make_unique<RobotSource>(0.0, 0.0, 0.0,
+                                         std::make_unique<PointRobotState>(0, 0, 0, 0, 0));
+  });
+}
+
+ScenarioLoader::~ScenarioLoader() = default;
+
+void ScenarioLoader::RegisterElementType(const std::string& typeId, ElementFactory factory) {
+  elementFactories_[typeId] = std::move(factory);
+}
+
+bool ScenarioLoader::Load(const std::string& scenarioPath, const std::string& cachePath) {
+  fromCache_ = false;
+  environment_.reset();
+  robotStates_.clear();
+
+  MappedFile scenario;
+  if (!scenario.Open(scenarioPath, MappedFile::AccessHint::kSequential)) {
+    return false;
+  }
+
+  const uint64_t key =
+      HashBytes(scenario.GetData(), scenario.GetSize(),
+                HashBytes(kCacheMagic, sizeof(kCacheMagic)));
+  if (!cachePath.empty() && LoadCache(cachePath, key)) {
+    fromCache_ = true;
+    return true;
+  }
+
+  // Element and robot types registered by users may throw on bad members
+  std::string image;
+  bool parsed = false;
+  try {
+    parsed = Parse(reinterpret_cast<const char*>(scenario.GetData()), scenario.GetSize(),
+                   cachePath.empty() ? nullptr : &image);
+  } catch (const nlohmann::json::exception&) {
+    parsed = false;
+  }
+  if (!parsed) {
+    environment_.reset();
+    robotStates_.clear();
+    return false;
+  }
+
+  if (!cachePath.empty()) {
+    CacheHeader header{};
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.key = key;
+    WriteCache(cachePath, header, image);
+  }
+  return true;
+}
+
+std::unique_ptr<Environment> ScenarioLoader::TakeEnvironment() {
+  return std::move(environment_);
+}
+
+std::vector<std::unique_ptr<RobotState>> ScenarioLoader::TakeRobotStates() {
+  return std::move(robotStates_);
+}
+
+bool ScenarioLoader::Parse(const char* data, size_t size, std::string* cache) {
+  environment_ = std::make_unique<Environment>();
+  robotStates_.clear();
+
+  // Records refer to their type by position in a table written ahead of them
+  std::vector<std::string> types;
+  std::unordered_map<std::string, uint32_t> typeIndex;
+  const auto typeOf = [&](const std::string& typeId) {
+    const auto inserted = typeIndex.emplace(typeId, static_cast<uint32_t>(types.size()));
+    if (inserted.second) {
+      types.push_back(typeId);
+    }
+    return inserted.first->second;
+  };
+
+  std::string elementRecords;
+  std::string robotRecords;
+  BinaryWriter elementWriter(elementRecords);
+  BinaryWriter robotWriter(robotRecords);
+  uint64_t elementCount = 0;
+
+  JsonStreamReader reader;
+  reader.StreamArray("/elements", [&](nlohmann::json& entry) {
+    if (!entry.is_object() || !entry["type"].is_string()) {
+      return false;
+    }
+    const std::string typeId = entry["type"].get<std::string>();
+    const std::string state = ToSerializedState(entry["state"]);
+    std::unique_ptr<EnvironmentElement> element = CreateElement(typeId);
+    if (element == nullptr || !element->LoadState(state)) {
+      return false;
+    }
+
+    if (cache != nullptr) {
+      WriteRecord(elementWriter, typeOf(typeId), *element, state);
+    }
+    environment_->AddElement(std::move(element));
+    ++elementCount;
+    return true;
+  });
+
+  reader.StreamArray("/robots", [&](nlohmann::json& entry) {
+    if (!entry.is_object() || !entry["type"].is_string()) {
+      return false;
+    }
+    const std::string typeId = entry["type"].get<std::string>();
+    const std::string state = ToSerializedState(entry["state"]);
+    std::unique_ptr<RobotState> robotState = SystemState::CreateRobotState(typeId);
+    if (robotState == nullptr || !robotState->Deserialize(state)) {
+      return false;
+    }
+
+    if (cache != nullptr) {
+      WriteRecord(robotWriter, typeOf(typeId), *robotState, state);
+    }
+    robotStates_.push_back(std::move(robotState));
+    return true;
+  });
+
+  nlohmann::json root;
+  if (!reader.Read(data, size, root) || !root.is_object()) {
+    return false;
+  }
+
+  if (root.contains("worldBounds")) {
+    const nlohmann::json& bounds = root["worldBounds"];
+    if (!bounds.is_array() || bounds.size() != 4 ||
+        !std::all_of(bounds.begin(), bounds.end(),
+                     [](const nlohmann::json& value) { return value.is_number(); })) {
+      return false;
+    }
+    environment_->SetWorldBounds(
+        Eigen::AlignedBox2d(Eigen::Vector2d(bounds[0].get<double>(), bounds[1].get<double>()),
+                            Eigen::Vector2d(bounds[2].get<double>(), bounds[3].get<double>())));
+  }
+
+  double cellSize = 0.0;
+  if (root.contains("staticIndexCellSize")) {
+    if (!root["staticIndexCellSize"].is_number()) {
+      return false;
+    }
+    cellSize = root["staticIndexCellSize"].get<double>();
+  }
+  environment_->BuildStaticIndex(cellSize);
+
+  if (cache == nullptr) {
+    return true;
+  }
+
+  BinaryWriter writer(*cache);
+  const Eigen::AlignedBox2d& worldBounds = environment_->GetWorldBounds();
+  writer.Write(worldBounds.min().x());
+  writer.Write(worldBounds.min().y());
+  writer.Write(worldBounds.max().x());
+  writer.Write(worldBounds.max().y());
+  writer.Write(static_cast<uint64_t>(types.size()));
+  for (const std::string& typeId : types) {
+    writer.WriteString(typeId);
+  }
+  writer.Write(elementCount);
+  cache->append(elementRecords);
+  writer.Write(static_cast<uint64_t>(robotStates_.size()));
+  cache->append(robotRecords);
+  environment_->GetStaticIndex()->SaveBinary(writer);
+  return true;
+}
+
+bool ScenarioLoader::LoadCache(const std::string& path, uint64_t key) {
+  MappedFile file;
+  if (!file.Open(path, MappedFile::AccessHint::kSequential) ||
+      file.GetSize() < sizeof(CacheHeader)) {
+    return false;
+  }
+
+  CacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.key != key) {
+    return false;
+  }
+
+  BinaryReader reader(file.GetData() + sizeof(CacheHeader), file.GetSize() - sizeof(CacheHeader));
+  double bounds[4];
+  for (double& value : bounds) {
+    if (!reader.Read(value)) {
+      return false;
+    }
+  }
+
+  uint64_t typeCount = 0;
+  if (!reader.Read(typeCount) || typeCount > reader.GetRemaining()) {
+    return false;
+  }
+  std::vector<std::string> types(typeCount);
+  for (std::string& typeId : types) {
+    if (!reader.ReadString(typeId)) {
+      return false;
+    }
+  }
+
+  auto environment = std::make_unique<Environment>();
+  environment->SetWorldBounds(Eigen::AlignedBox2d(Eigen::Vector2d(bounds[0], bounds[1]),
+                                                  Eigen::Vector2d(bounds[2], bounds[3])));
+
+  uint64_t elementCount = 0;
+  if (!reader.Read(elementCount)) {
+    return false;
+  }
+  bool externalSources = false;
+  for (uint64_t i = 0; i < elementCount; ++i) {
+    uint32_t type = 0;
+    if (!reader.Read(type) || type >= types.size()) {
+      return false;
+    }
+    std::unique_ptr<EnvironmentElement> element = CreateElement(types[type]);
+    if (element == nullptr ||
+        !ReadRecord(reader, *element, [](EnvironmentElement& target, const std::string& text) {
+          return target.LoadState(text);
+        })) {
+      return false;
+    }
+    const auto* grid = dynamic_cast<const OccupancyGrid*>(element.get());
+    externalSources = externalSources || (grid != nullptr && !grid->GetSource().empty());
+    environment->AddElement(std::move(element));
+  }
+
+  uint64_t robotCount = 0;
+  if (!reader.Read(robotCount) || robotCount > reader.GetRemaining()) {
+    return false;
+  }
+  std::vector<std::unique_ptr<RobotState>> robotStates;
+  robotStates.reserve(robotCount);
+  for (uint64_t i = 0; i < robotCount; ++i) {
+    uint32_t type = 0;
+    if (!reader.Read(type) || type >= types.size()) {
+      return false;
+    }
+    std::unique_ptr<RobotState> robotState = SystemState::CreateRobotState(types[type]);
+    if (robotState == nullptr ||
+        !ReadRecord(reader, *robotState, [](RobotState& target, const std::string& text) {
+          return target.Deserialize(text);
+        })) {
+      return false;
+    }
+    robotStates.push_back(std::move(robotState));
+  }
+
+  // Grids reload their cells from files the key does not cover, so the
+  // extent they had when the cache was written may be stale
+  UniformGridIndex index;
+  if (!index.LoadBinary(reader)) {
+    return false;
+  }
+  if (externalSources) {
+    environment->BuildStaticIndex(index.GetCellSize());
+  } else if (!environment->SetStaticIndex(std::move(index))) {
+    return false;
+  }
+
+  environment_ = std::move(environment);
+  robotStates_ = std::move(robotStates);
+  return true;
+}
+
+std::unique_ptr<EnvironmentElement> ScenarioLoader::CreateElement(const std::string& typeId) const {
+  const auto factory = elementFactories_.find(typeId);
+  return factory != elementFactories_.end() ? factory->second() : nullptr;
+}
+
+}  // namespace mobilerobotsim
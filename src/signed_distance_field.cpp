@@ -0,0 +1,257 @@
+#include "mobilerobotsim/signed_distance_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "mobilerobotsim/occupancy_grid.h"
+
+namespace mobilerobotsim {
+
+namespace {
+
+constexpr char kCacheMagic[8] = {'M', 'R', 'S', 'S', 'D', 'F', '0', '1'};
+
+// Squared distance used for "no feature"; finite so the envelope math stays exact
+constexpr double kFar = 1e20;
+
+// Fixed-size header of the cache format; the samples follow it
+struct CacheHeader {
+  char magic[8];
+  uint64_t key;
+  int32_t width;
+  int32_t height;
+  double resolution;
+  double originX;
+  double originY;
+  uint8_t padding[16];
+};
+static_assert(sizeof(CacheHeader) == 64, "cache header must keep the samples aligned");
+
+// Felzenszwalb-Huttenlocher lower envelope of parabolas: d[q] = min_p (q - p)^2 + f[p]
+void DistanceTransform1d(const double* f, int n, double* d, int* v, double* z) {
+  int k = 0;
+  v[0] = 0;
+  z[0] = -kFar;
+  z[1] = kFar;
+  for (int q = 1; q < n; ++q) {
+    double s = ((f[q] + double(q) * q) - (f[v[k]] + double(v[k]) * v[k])) / (2.0 * (q - v[k]));
+    while (s <= z[k]) {
+      --k;
+      s = ((f[q] + double(q) * q) - (f[v[k]] + double(v[k]) * v[k])) / (2.0 * (q - v[k]));
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = kFar;
+  }
+
+  k = 0;
+  for (int q = 0; q < n; ++q) {
+    while (z[k + 1] < q) {
+      ++k;
+    }
+    const double offset = q - v[k];
+    d[q] = offset * offset + f[v[k]];
+  }
+}
+
+// Squared Euclidean distance (in cells) from every cell to the nearest cell with mask == target
+std::vector<double> SquaredDistanceTo(const std::vector<uint8_t>& mask, uint8_t target, int width,
+                                      int height) {
+  std::vector<double> grid(mask.size());
+  for (size_t i = 0; i < mask.size(); ++i) {
+    grid[i] = mask[i] == target ? 0.0 : kFar;
+  }
+
+  const int longest = std::max(width, height);
+  std::vector<double> f(longest), d(longest), z(longest + 1);
+  std::vector<int> v(longest);
+
+  // Columns, then rows
+  for (int x = 0; x < width; ++x) {
+    for (int y = 0; y < height; ++y) {
+      f[y] = grid[static_cast<size_t>(y) * width + x];
+    }
+    DistanceTransform1d(f.data(), height, d.data(), v.data(), z.data());
+    for (int y = 0; y < height; ++y) {
+      grid[static_cast<size_t>(y) * width + x] = d[y];
+    }
+  }
+  for (int y = 0; y < height; ++y) {
+    double* row = grid.data() + static_cast<size_t>(y) * width;
+    std::copy(row, row + width, f.begin());
+    DistanceTransform1d(f.data(), width, row, v.data(), z.data());
+  }
+
+  return grid;
+}
+
+}  // namespace
+
+SignedDistanceField::SignedDistanceField()
+    : width_(0), height_(0), resolution_(1.0), origin_(Eigen::Vector2d::Zero()), values_(nullptr) {}
+
+SignedDistanceField::~SignedDistanceField() = default;
+
+bool SignedDistanceField::Build(const Environment& environment, const Eigen::AlignedBox2d& region,
+                                double resolution) {
+  OccupancyGrid grid;
+  return grid.Rasterize(environment, region, resolution) && Build(grid);
+}
+
+bool SignedDistanceField::Build(const OccupancyGrid& grid) {
+  if (grid.GetWidth() == 0 || grid.GetHeight() == 0) {
+    return false;
+  }
+
+  width_ = grid.GetWidth();
+  height_ = grid.GetHeight();
+  resolution_ = grid.GetResolution();
+  origin_ = grid.GetOrigin();
+
+  std::vector<uint8_t> occupied(static_cast<size_t>(width_) * height_);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      occupied[static_cast<size_t>(y) * width_ + x] = grid.IsOccupied(x, y) ? 1 : 0;
+    }
+  }
+
+  Transform(occupied);
+  return true;
+}
+
+double SignedDistanceField::Distance(const Eigen::Vector2d& position) const {
+  int x, y;
+  double fx, fy;
+  Locate(position, x, y, fx, fy);
+
+  const double s00 = Sample(x, y);
+  const double s10 = Sample(x + 1, y);
+  const double s01 = Sample(x, y + 1);
+  const double s11 = Sample(x + 1, y + 1);
+  return (1.0 - fy) * ((1.0 - fx) * s00 + fx * s10) + fy * ((1.0 - fx) * s01 + fx * s11);
+}
+
+double SignedDistanceField::DistanceAndGradient(const Eigen::Vector2d& position,
+                                                Eigen::Vector2d& gradient) const {
+  int x, y;
+  double fx, fy;
+  Locate(position, x, y, fx, fy);
+
+  const double s00 = Sample(x, y);
+  const double s10 = Sample(x + 1, y);
+  const double s01 = Sample(x, y + 1);
+  const double s11 = Sample(x + 1, y + 1);
+  gradient.x() = ((1.0 - fy) * (s10 - s00) + fy * (s11 - s01)) / resolution_;
+  gradient.y() = ((1.0 - fx) * (s01 - s00) + fx * (s11 - s10)) / resolution_;
+  return (1.0 - fy) * ((1.0 - fx) * s00 + fx * s10) + fy * ((1.0 - fx) * s01 + fx * s11);
+}
+
+void SignedDistanceField::DistanceBatch(const Eigen::Matrix2Xd& positions,
+                                        Eigen::VectorXd& distances,
+                                        Eigen::Matrix2Xd* gradients) const {
+  const Eigen::Index count = positions.cols();
+  distances.resize(count);
+  if (gradients == nullptr) {
+    for (Eigen::Index i = 0; i < count; ++i) {
+      distances[i] = Distance(positions.col(i));
+    }
+    return;
+  }
+
+  gradients->resize(2, count);
+  Eigen::Vector2d gradient;
+  for (Eigen::Index i = 0; i < count; ++i) {
+    distances[i] = DistanceAndGradient(positions.col(i), gradient);
+    gradients->col(i) = gradient;
+  }
+}
+
+bool SignedDistanceField::SaveCache(const std::string& path, uint64_t key) const {
+  if (!IsValid()) {
+    return false;
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  CacheHeader header{};
+  std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.key = key;
+  header.width = width_;
+  header.height = height_;
+  header.resolution = resolution_;
+  header.originX = origin_.x();
+  header.originY = origin_.y();
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(values_),
+             static_cast<std::streamsize>(sizeof(float) * width_ * height_));
+
+  return static_cast<bool>(file);
+}
+
+bool SignedDistanceField::LoadCache(const std::string& path, uint64_t key) {
+  MappedFile file;
+  if (!file.Open(path, MappedFile::AccessHint::kRandom) || file.GetSize() < sizeof(CacheHeader)) {
+    return false;
+  }
+
+  CacheHeader header;
+  std::memcpy(&header, file.GetData(), sizeof(header));
+  if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.key != key ||
+      header.width <= 0 || header.height <= 0 ||
+      file.GetSize() < sizeof(CacheHeader) + sizeof(float) * header.width * header.height) {
+    return false;
+  }
+
+  width_ = header.width;
+  height_ = header.height;
+  resolution_ = header.resolution;
+  origin_ = Eigen::Vector2d(header.originX, header.originY);
+  owned_.clear();
+  owned_.shrink_to_fit();
+  file_ = std::move(file);
+  values_ = reinterpret_cast<const float*>(file_.GetData() + sizeof(CacheHeader));
+  return true;
+}
+
+void SignedDistanceField::Transform(const std::vector<uint8_t>& occupied) {
+  const std::vector<double> toObstacle = SquaredDistanceTo(occupied, 1, width_, height_);
+  const std::vector<double> toFree = SquaredDistanceTo(occupied, 0, width_, height_);
+
+  // Distances are between cell centers; shifting by half a cell puts the zero
+  // level set on the boundary between free and occupied cells
+  file_.Close();
+  owned_.resize(occupied.size());
+  for (size_t i = 0; i < occupied.size(); ++i) {
+    const double cells = occupied[i] ? -(std::sqrt(toFree[i]) - 0.5)
+                                     : std::sqrt(toObstacle[i]) - 0.5;
+    owned_[i] = static_cast<float>(cells * resolution_);
+  }
+  values_ = owned_.data();
+}
+
+void SignedDistanceField::Locate(const Eigen::Vector2d& position, int& x, int& y, double& fx,
+                                 double& fy) const {
+  // Samples sit at cell centers, half a cell in from the origin
+  const double u = std::clamp((position.x() - origin_.x()) / resolution_ - 0.5, 0.0,
+                              static_cast<double>(width_ - 1));
+  const double v = std::clamp((position.y() - origin_.y()) / resolution_ - 0.5, 0.0,
+                              static_cast<double>(height_ - 1));
+  x = std::min(static_cast<int>(u), std::max(width_ - 2, 0));
+  y = std::min(static_cast<int>(v), std::max(height_ - 2, 0));
+  fx = u - x;
+  fy = v - y;
+}
+
+double SignedDistanceField::Sample(int x, int y) const {
+  x = std::min(x, width_ - 1);
+  y = std::min(y, height_ - 1);
+  return values_[static_cast<size_t>(y) * width_ + x];
+}
+
+}  // namespace mobilerobotsim
@@ -1,62 +1,472 @@
 #include "mobilerobotsim/simulation_engine.h"
+#include "mobilerobotsim/checkpoint_writer.h"
 #include "mobilerobotsim/mobile_robot_base.h"
+#include "mobilerobotsim/robot_state.h"
 #include "mobilerobotsim/environment.h"
 #include "mobilerobotsim/system_state.h"
+#include "mobilerobotsim/hash.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/merge_strategy.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/robot_sink.h"
+#include "mobilerobotsim/robot_source.h"
+#include "mobilerobotsim/signed_distance_field.h"
+#include "mobilerobotsim/thread_pool.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <nlohmann/json.hpp>
 
 namespace mobilerobotsim {
 
-SimulationEngine::SimulationEngine() : time_(0.0) {
-  environment_ = std::make_unique<Environment>();
+namespace {
+
+// Default distance within which moving things wake sleeping robots
+constexpr double kDefaultWakeRadius = 1.0;
+
+// Slack on spawn times so that accumulated step rounding does not defer a spawn
+constexpr double kSpawnTimeTolerance = 1e-9;
+
+}  // namespace
+
+SimulationEngine::SimulationEngine()
+    : SimulationEngine(std::make_unique<Environment>()) {
 }
 
 SimulationEngine::SimulationEngine(std::unique_ptr<Environment> environment)
-    : time_(0.0), environment_(std::move(environment)) {
+    : time_(0.0),
+      commandSequence_(0),
+      seed_(0),
+      nextRobotId_(0),
+      pool_(std::make_unique<ThreadPool>(1)),
+      maxPendingCheckpoints_(1),
+      checkpointsWaitWhenFull_(false),
+      rateGroups_{RateGroup{0.0}},
+      stepStart_(0.0),
+      stepEnd_(0.0),
+      activeStale_(false),
+      fleetStale_(true),
+      sleepEnabled_(true),
+      wakeRadius_(kDefaultWakeRadius),
+      environmentRevision_(environment->GetRevision()),
+      hasSinks_(false),
+      failedSpawns_(0),
+      spawnerRevision_(0),
+      spawnersStale_(true),
+      environment_(std::move(environment)) {
+  RegisterRobotType("PointRobotState", [] { return std::make_unique<PointRobot>(); });
+  RegisterRobotType("PointRobotStateF", [] { return std::make_unique<PointRobotF>(); });
 }
 
 SimulationEngine::~SimulationEngine() = default;
 
 void SimulationEngine::Step(double dt) {
-  // Update all robots
-  for (auto& robot : robots_) {
-    robot->UpdateState(dt);
-    
-    // TODO: Implement collision detection and handling
-    // TODO: Implement merge point detection and handling
+  PrepareStep();
+  StepInternal(dt, false);
+}
+
+void SimulationEngine::AdvanceTo(double time, double minStep, double maxStep) {
+  const double smallest = minStep > 0.0 ? minStep : 1e-9;
+  while (time_ < time) {
+    // Strategies may raise speed bounds, so they run before the horizon is taken
+    PrepareStep();
+
+    double boundary = time;
+    if (!commands_.empty()) {
+      boundary = std::min(boundary, commands_.front().time);
+    }
+    for (const SourceEntry& entry : sources_) {
+      boundary = std::min(boundary, GetSpawnTime(entry, entry.spawned));
+    }
+
+    const double remaining = boundary - time_;
+    double step = std::min(remaining, maxStep);
+    step = std::min(step, ComputeEventHorizon(step));
+    step = std::max(step, std::min(smallest, remaining));
+
+    StepInternal(step, true);
+    if (step >= remaining) {
+      // Land exactly on the boundary instead of accumulating rounding error
+      time_ = boundary;
+      stepEnd_ = boundary;
+    }
+  }
+}
+
+bool SimulationEngine::ScheduleCommand(double time, RobotHandle handle,
+                                       std::function<void(MobileRobotBase&)> command) {
+  if (!robots_.Contains(handle) || !command) {
+    return false;
+  }
+
+  commands_.push_back({time, commandSequence_++, handle, std::move(command)});
+  std::push_heap(commands_.begin(), commands_.end(), [](const auto& a, const auto& b) {
+    return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+  });
+  return true;
+}
+
+void SimulationEngine::PrepareStep() {
+  ApplyDueCommands();
+  RefreshFleet();
+  RunMergeStrategies();
+  ProcessWakeRequests();
+  RefreshSpawners();
+}
+
+void SimulationEngine::StepInternal(double dt, bool closedForm) {
+  // Update the awake robots; each one only writes its own entry and its own
+  // slot of the back buffer, and reads other robots from the front buffer.
+  // Robots that take the step whole go first so that substepped robots can
+  // query their interpolated positions.
+  stepStart_ = time_;
+  stepEnd_ = time_ + dt;
+  const FleetView fleet(fleetFront_);
+  for (const bool substepped : {false, true}) {
+    pool_->ParallelFor(active_.size(), [&](size_t begin, size_t end, size_t /*chunk*/) {
+      for (size_t i = begin; i < end; ++i) {
+        RobotEntry& entry = robots_[active_[i]];
+        if ((rateGroups_[entry.rateGroup].maxStep > 0.0) == substepped) {
+          StepRobot(entry, dt, closedForm, fleet);
+          fleetBack_.Store(active_[i], *entry.robot);
+        }
+      }
+    });
+  }
+
+  // Dispatch events in robot order so that observers see the same sequence
+  // for any thread count. They are collected first because observers may add
+  // or remove robots, which reorders robots_ and active_. Robots that ended
+  // the step in a sink are noted for ProcessSpawning() for the same reason.
+  stepEvents_.clear();
+  despawns_.clear();
+  for (size_t index : active_) {
+    const RobotEntry& entry = robots_[index];
+    if (entry.collisionEvent != nullptr || entry.mergePointEvent != nullptr) {
+      stepEvents_.push_back(
+          {robots_.GetHandle(index), entry.collisionEvent, entry.mergePointEvent});
+    }
+    if (entry.inSink) {
+      despawns_.push_back(robots_.GetHandle(index));
+    }
+  }
+  for (const StepEvent& event : stepEvents_) {
+    if (event.collision != nullptr) {
+      NotifyCollision(event.robot, event.collision);
+    }
+    if (event.mergePoint != nullptr) {
+      NotifyMergePoint(event.robot, event.mergePoint);
+    }
   }
+  ProcessSpawning(time_ + dt);
   
   // Update environment
   environment_->Update(dt);
+  UpdateSchedule();
   
   // Update simulation time
   time_ += dt;
+
+  // The end of this step is the start of the next one
+  if (!fleetStale_) {
+    std::swap(fleetFront_, fleetBack_);
+  }
   
-  // Notify observers
-  auto state = GetState();
-  NotifyStep(*state);
+  // Notify observers; the state is only built if one of them reads it
+  stepStateNeeded_.resize(observers_.size());
+  bool needsState = false;
+  for (size_t i = 0; i < observers_.size(); ++i) {
+    stepStateNeeded_[i] = observers_[i]->NeedsStepState();
+    needsState = needsState || stepStateNeeded_[i] != 0;
+  }
+  if (needsState) {
+    auto state = GetState();
+    NotifyStep(*state);
+  }
+}
+
+RobotHandle SimulationEngine::AddRobot(std::unique_ptr<MobileRobotBase> robot) {
+  return AddEntry(std::move(robot), RobotPool::kNoType);
+}
+
+RobotHandle SimulationEngine::AddRobot(const RobotState& state) {
+  return SpawnRobot(robotPool_.FindType(state.GetTypeId()), state);
+}
+
+std::vector<RobotHandle> SimulationEngine::AddRobots(
+    const std::vector<std::unique_ptr<RobotState>>& states) {
+  ReserveRobots(robots_.size() + states.size());
+
+  std::vector<RobotHandle> handles;
+  handles.reserve(states.size());
+  for (const auto& state : states) {
+    handles.push_back(AddRobot(*state));
+  }
+  return handles;
+}
+
+void SimulationEngine::ReserveRobots(size_t count) {
+  robots_.Reserve(count);
+  active_.reserve(count);
 }
 
-void SimulationEngine::AddRobot(std::unique_ptr<MobileRobotBase> robot) {
-  robots_.push_back(std::move(robot));
+void SimulationEngine::RegisterRobotType(const std::string& stateTypeId,
+                                         RobotPool::Factory factory) {
+  robotPool_.RegisterType(stateTypeId, std::move(factory));
+  spawnersStale_ = true;
 }
 
-bool SimulationEngine::RemoveRobot(size_t index) {
-  if (index >= robots_.size()) {
+bool SimulationEngine::ReservePooledRobots(const std::string& stateTypeId, size_t count) {
+  const size_t type = robotPool_.FindType(stateTypeId);
+  if (type == RobotPool::kNoType) {
     return false;
   }
-  
-  robots_.erase(robots_.begin() + index);
+
+  robotPool_.Reserve(type, count);
+  return true;
+}
+
+const RobotPool& SimulationEngine::GetRobotPool() const {
+  return robotPool_;
+}
+
+uint64_t SimulationEngine::GetFailedSpawnCount() const {
+  return failedSpawns_;
+}
+
+RobotHandle SimulationEngine::AddEntry(std::unique_ptr<MobileRobotBase> robot, size_t poolType) {
+  MobileRobotBase* added = robot.get();
+  RobotEntry entry{std::move(robot), nextRobotId_++, nullptr, nullptr, nullptr, nullptr, 0, 0,
+                   Eigen::Vector2d::Zero(), poolType, false, kNoMergeController,
+                   Eigen::Vector2d::Zero()};
+  entry.startPosition = added->GetPosition();
+  added->SetRandomStream(CounterRng(seed_, entry.id));
+  added->SetSleeping(false);
+
+  const RobotHandle handle = robots_.Insert(std::move(entry));
+  added->SetHandle(handle);
+  added->SetWakeCallback([this, handle] { pendingWakes_.push_back(handle); });
+  active_.push_back(robots_.size() - 1);
+  fleetStale_ = true;
+  return handle;
+}
+
+bool SimulationEngine::RemoveRobot(RobotHandle handle) {
+  RobotEntry* entry = robots_.Find(handle);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  if (entry->robot->IsSleeping()) {
+    const auto cell = sleepingCells_.find(entry->sleepCell);
+    if (cell != sleepingCells_.end()) {
+      std::vector<RobotHandle>& handles = cell->second;
+      const auto it = std::find(handles.begin(), handles.end(), handle);
+      if (it != handles.end()) {
+        *it = handles.back();
+        handles.pop_back();
+      }
+      if (handles.empty()) {
+        sleepingCells_.erase(cell);
+      }
+    }
+  }
+
+  if (entry->poolType != RobotPool::kNoType) {
+    MobileRobotBase& robot = *entry->robot;
+    robot.SetSleeping(false);
+    robot.SetWakeCallback(nullptr);
+    robot.SetHandle(RobotHandle());
+    robotPool_.Release(entry->poolType, std::move(entry->robot));
+  }
+
+  // The last robot moves into the hole; active_ is fixed up once before the
+  // next step instead of on every removal
+  robots_.Erase(handle);
+  activeStale_ = true;
+  fleetStale_ = true;
   return true;
 }
 
+MobileRobotBase* SimulationEngine::GetRobot(RobotHandle handle) const {
+  const RobotEntry* entry = robots_.Find(handle);
+  return entry != nullptr ? entry->robot.get() : nullptr;
+}
+
+RobotHandle SimulationEngine::GetRobotHandle(size_t index) const {
+  return robots_.GetHandle(index);
+}
+
 size_t SimulationEngine::GetRobotCount() const {
   return robots_.size();
 }
 
+void SimulationEngine::SetThreadCount(size_t threadCount) {
+  pool_ = std::make_unique<ThreadPool>(threadCount);
+}
+
+size_t SimulationEngine::GetThreadCount() const {
+  return pool_->GetThreadCount();
+}
+
+void SimulationEngine::SetSeed(uint64_t seed) {
+  seed_ = seed;
+  for (auto& entry : robots_) {
+    entry.robot->SetRandomStream(CounterRng(seed_, entry.id));
+  }
+}
+
+uint64_t SimulationEngine::GetSeed() const {
+  return seed_;
+}
+
+size_t SimulationEngine::AddRateGroup(double maxStep) {
+  rateGroups_.push_back({std::max(maxStep, 0.0)});
+  return rateGroups_.size() - 1;
+}
+
+bool SimulationEngine::SetRobotRateGroup(RobotHandle handle, size_t group) {
+  RobotEntry* entry = robots_.Find(handle);
+  if (entry == nullptr || group >= rateGroups_.size()) {
+    return false;
+  }
+
+  entry->rateGroup = group;
+  return true;
+}
+
+bool SimulationEngine::GetRobotPosition(RobotHandle handle, double time,
+                                        Eigen::Vector2d& position) const {
+  const RobotEntry* found = robots_.Find(handle);
+  if (found == nullptr) {
+    return false;
+  }
+
+  const RobotEntry& entry = *found;
+  position = entry.robot->GetPosition();
+  if (entry.robot->IsSleeping() || rateGroups_[entry.rateGroup].maxStep > 0.0) {
+    return true;
+  }
+
+  // Robots that took the step whole have already moved from startPosition
+  // to their end-of-step position
+  if (stepEnd_ > stepStart_) {
+    const double t = std::clamp((time - stepStart_) / (stepEnd_ - stepStart_), 0.0, 1.0);
+    position = entry.startPosition + t * (position - entry.startPosition);
+  }
+  return true;
+}
+
+bool SimulationEngine::SetMergeStrategy(const MergePoint& mergePoint,
+                                        std::unique_ptr<MergeStrategy> strategy,
+                                        double approachRadius) {
+  const auto controller =
+      std::find_if(mergeControllers_.begin(), mergeControllers_.end(),
+                   [&](const MergeController& entry) { return entry.mergePoint == &mergePoint; });
+
+  if (strategy != nullptr) {
+    if (!(approachRadius > 0.0)) {
+      return false;
+    }
+    if (controller != mergeControllers_.end()) {
+      controller->strategy = std::move(strategy);
+      controller->approachRadius = approachRadius;
+    } else {
+      mergeControllers_.push_back(
+          {&mergePoint, std::move(strategy), approachRadius, MergeBatch(), {}});
+    }
+    return true;
+  }
+
+  if (controller == mergeControllers_.end()) {
+    return false;
+  }
+
+  // Release the merge point's robots and renumber the remaining controllers
+  const size_t removed = static_cast<size_t>(controller - mergeControllers_.begin());
+  for (auto& entry : robots_) {
+    if (entry.mergeController == removed) {
+      entry.robot->SetTargetVelocity(entry.cruiseVelocity);
+      entry.mergeController = kNoMergeController;
+    } else if (entry.mergeController != kNoMergeController && entry.mergeController > removed) {
+      --entry.mergeController;
+    }
+  }
+  mergeControllers_.erase(controller);
+  return true;
+}
+
+void SimulationEngine::SetSleepEnabled(bool enabled) {
+  sleepEnabled_ = enabled;
+  if (!enabled) {
+    WakeAll();
+  }
+}
+
+void SimulationEngine::SetWakeRadius(double radius) {
+  wakeRadius_ = radius > 0.0 ? radius : kDefaultWakeRadius;
+  RebuildSchedule();
+}
+
+SchedulerStats SimulationEngine::GetSchedulerStats() const {
+  SchedulerStats stats = stats_;
+  for (const auto& cell : sleepingCells_) {
+    stats.sleepingRobots += cell.second.size();
+  }
+  stats.activeRobots = robots_.size() - stats.sleepingRobots;
+  return stats;
+}
+
+uint64_t SimulationEngine::ComputeStateHash() const {
+  uint64_t hash = HashBytes(&time_, sizeof(time_));
+  for (const auto& entry : robots_) {
+    const Eigen::Vector2d position = entry.robot->GetPosition();
+    const Eigen::Vector2d velocity = entry.robot->GetVelocity();
+    hash = HashBytes(&entry.id, sizeof(entry.id), hash);
+    hash = HashBytes(position.data(), 2 * sizeof(double), hash);
+    hash = HashBytes(velocity.data(), 2 * sizeof(double), hash);
+  }
+
+  const auto environmentState = environment_->GetState();
+  std::string typeId, state;
+  for (size_t i = 0; i < environmentState->GetElementStateCount(); ++i) {
+    environmentState->GetElementState(i, typeId, state);
+    hash = HashString(typeId, hash);
+    hash = HashString(state, hash);
+  }
+
+  return hash;
+}
+
 void SimulationEngine::SetEnvironment(std::unique_ptr<Environment> environment) {
+  // Merge strategies refer to merge points of the old environment
+  for (auto& entry : robots_) {
+    if (entry.mergeController != kNoMergeController) {
+      entry.robot->SetTargetVelocity(entry.cruiseVelocity);
+      entry.mergeController = kNoMergeController;
+    }
+  }
+  mergeControllers_.clear();
+
   environment_ = std::move(environment);
+  environmentRevision_ = environment_->GetRevision();
+  spawnersStale_ = true;
+  for (auto& entry : robots_) {
+    entry.collision = nullptr;
+    entry.mergePoint = nullptr;
+  }
+  WakeAll();
+}
+
+const FleetState& SimulationEngine::GetFleetState() {
+  RefreshFleet();
+  return fleetFront_;
+}
+
+const Environment& SimulationEngine::GetEnvironment() const {
+  return *environment_;
 }
 
 double SimulationEngine::GetTime() const {
@@ -81,8 +491,8 @@ std::unique_ptr<SystemState> SimulationEngine::GetState() const {
   auto state = std::make_unique<SystemState>(time_);
   
   // Add robot states
-  for (const auto& robot : robots_) {
-    state->AddRobotState(robot->GetState());
+  for (const auto& entry : robots_) {
+    state->AddRobotState(entry.robot->GetState(), entry.robot->GetHandle());
   }
   
   // Add environment state
@@ -92,63 +502,667 @@ std::unique_ptr<SystemState> SimulationEngine::GetState() const {
 }
 
 bool SimulationEngine::LoadState(const SystemState& state) {
+  const EnvironmentState* environmentState = state.GetEnvironmentState();
+  if (environmentState != nullptr && !environment_->LoadState(*environmentState)) {
+    return false;
+  }
+
+  // Robots the state still refers to are loaded in place
+  bool loaded = true;
+  std::vector<bool> kept(robots_.size(), false);
+  std::vector<size_t> added;
+  for (size_t i = 0; i < state.GetRobotStateCount(); ++i) {
+    RobotEntry* entry = robots_.Find(state.GetRobotHandle(i));
+    if (entry != nullptr && entry->robot->LoadState(*state.GetRobotState(i))) {
+      kept[robots_.IndexOf(state.GetRobotHandle(i))] = true;
+    } else {
+      added.push_back(i);
+    }
+  }
+
+  std::vector<RobotHandle> removed;
+  for (size_t index = 0; index < robots_.size(); ++index) {
+    if (!kept[index]) {
+      removed.push_back(robots_.GetHandle(index));
+    }
+  }
+  for (const RobotHandle& handle : removed) {
+    RemoveRobot(handle);
+  }
+
+  for (size_t i : added) {
+    loaded = AddRobot(*state.GetRobotState(i)).IsValid() && loaded;
+  }
+
   time_ = state.GetTime();
-  
-  // TODO: Implement robot state loading
-  // TODO: Implement environment state loading
-  
-  return true;
+  stepStart_ = time_;
+  stepEnd_ = time_;
+  for (auto& entry : robots_) {
+    entry.collision = nullptr;
+    entry.mergePoint = nullptr;
+    entry.collisionEvent = nullptr;
+    entry.mergePointEvent = nullptr;
+    entry.inSink = false;
+    entry.mergeController = kNoMergeController;
+    entry.startPosition = entry.robot->GetPosition();
+  }
+  fleetStale_ = true;
+  WakeAll();
+
+  // Sources resume with the spawns that were due by the loaded time
+  RefreshSpawners();
+  for (SourceEntry& entry : sources_) {
+    entry.spawned = 0;
+    while (GetSpawnTime(entry, entry.spawned) <= time_ + kSpawnTimeTolerance) {
+      ++entry.spawned;
+    }
+  }
+
+  return loaded;
 }
 
 bool SimulationEngine::SaveStateToFile(const std::string& filename) const {
-  auto state = GetState();
-  std::string serialized = state->Serialize();
-  
-  std::ofstream file(filename);
+  std::ofstream file(filename, std::ios::binary);
   if (!file.is_open()) {
     return false;
   }
-  
-  file << serialized;
+
+  if (!GetState()->Write(file)) {
+    return false;
+  }
   file.close();
-  
-  return true;
+  return !file.fail();
 }
 
 bool SimulationEngine::LoadStateFromFile(const std::string& filename) {
-  std::ifstream file(filename);
+  std::ifstream file(filename, std::ios::binary);
   if (!file.is_open()) {
     return false;
   }
-  
-  std::string serialized;
-  file >> serialized;
-  file.close();
-  
-  auto state = std::make_unique<SystemState>();
-  if (!state->Deserialize(serialized)) {
+
+  SystemState state;
+  if (!state.Read(file)) {
     return false;
   }
-  
-  return LoadState(*state);
+
+  return LoadState(state);
+}
+
+std::future<bool> SimulationEngine::SaveStateToFileAsync(const std::string& filename) {
+  if (checkpointWriter_ == nullptr) {
+    checkpointWriter_ =
+        std::make_unique<CheckpointWriter>(maxPendingCheckpoints_, checkpointsWaitWhenFull_);
+  }
+  return checkpointWriter_->Submit(GetState(), filename);
+}
+
+void SimulationEngine::SetMaxPendingCheckpoints(size_t count) {
+  maxPendingCheckpoints_ = std::max<size_t>(count, 1);
+  if (checkpointWriter_ != nullptr) {
+    checkpointWriter_->SetMaxPending(maxPendingCheckpoints_);
+  }
+}
+
+void SimulationEngine::SetCheckpointsWaitWhenFull(bool wait) {
+  checkpointsWaitWhenFull_ = wait;
+  if (checkpointWriter_ != nullptr) {
+    checkpointWriter_->SetWaitWhenFull(wait);
+  }
+}
+
+size_t SimulationEngine::GetPendingCheckpointCount() const {
+  return checkpointWriter_ != nullptr ? checkpointWriter_->GetPendingCount() : 0;
+}
+
+uint64_t SimulationEngine::GetSkippedCheckpointCount() const {
+  return checkpointWriter_ != nullptr ? checkpointWriter_->GetSkippedCount() : 0;
+}
+
+void SimulationEngine::WaitForCheckpoints() {
+  if (checkpointWriter_ != nullptr) {
+    checkpointWriter_->Wait();
+  }
+}
+
+void SimulationEngine::StepRobot(RobotEntry& entry, double dt, bool closedForm,
+                                 const FleetView& fleet) const {
+  entry.startPosition = entry.robot->GetPosition();
+  entry.collisionEvent = nullptr;
+  entry.mergePointEvent = nullptr;
+
+  const double maxStep = rateGroups_[entry.rateGroup].maxStep;
+  const double substeps = maxStep > 0.0 ? std::max(1.0, std::ceil(dt / maxStep)) : 1.0;
+  const double substep = dt / substeps;
+  for (double k = 0.0; k < substeps; k += 1.0) {
+    UpdateRobot(entry, substep, closedForm, fleet);
+  }
+}
+
+void SimulationEngine::UpdateRobot(RobotEntry& entry, double dt, bool closedForm,
+                                   const FleetView& fleet) const {
+  if (!closedForm || !entry.robot->Advance(dt)) {
+    entry.robot->UpdateState(dt, fleet);
+  }
+
+  const Eigen::Vector2d position = entry.robot->GetPosition();
+  const EnvironmentElement* collision = environment_->CheckCollision(position);
+  if (collision != nullptr && collision != entry.collision && entry.collisionEvent == nullptr) {
+    entry.collisionEvent = collision;
+  }
+  entry.collision = collision;
+
+  const EnvironmentElement* mergePoint = environment_->FindMergePoint(position);
+  if (mergePoint != nullptr && mergePoint != entry.mergePoint &&
+      entry.mergePointEvent == nullptr) {
+    entry.mergePointEvent = mergePoint;
+  }
+  entry.mergePoint = mergePoint;
+
+  if (hasSinks_ && !entry.inSink) {
+    entry.inSink = environment_->FindRobotSink(position) != nullptr;
+  }
+}
+
+void SimulationEngine::RunMergeStrategies() {
+  if (mergeControllers_.empty()) {
+    return;
+  }
+
+  for (MergeController& controller : mergeControllers_) {
+    controller.batch.Clear();
+    controller.batch.mergePoint = controller.mergePoint;
+    controller.robots.clear();
+  }
+
+  // Gather the approaching robots from the fleet snapshot; a robot entering
+  // an approach records its cruise velocity and one leaving gets it back
+  for (size_t index = 0; index < robots_.size(); ++index) {
+    const Eigen::Vector2d& position = fleetFront_.positions[index];
+    size_t found = kNoMergeController;
+    for (size_t c = 0; c < mergeControllers_.size(); ++c) {
+      const MergeController& controller = mergeControllers_[c];
+      const double radius = controller.approachRadius;
+      if ((position - controller.mergePoint->GetPosition()).squaredNorm() <= radius * radius) {
+        found = c;
+        break;
+      }
+    }
+
+    RobotEntry& entry = robots_[index];
+    if (entry.mergeController != found) {
+      if (entry.mergeController != kNoMergeController) {
+        entry.robot->SetTargetVelocity(entry.cruiseVelocity);
+      }
+      if (found != kNoMergeController) {
+        entry.cruiseVelocity = entry.robot->GetTargetVelocity();
+      }
+      entry.mergeController = found;
+    }
+    if (found == kNoMergeController) {
+      continue;
+    }
+
+    MergeController& controller = mergeControllers_[found];
+    const Eigen::Vector2d offset = controller.mergePoint->GetPosition() - position;
+    const double cruiseSpeed = entry.cruiseVelocity.norm();
+    MergeBatch& batch = controller.batch;
+    batch.handles.push_back(fleetFront_.handles[index]);
+    batch.positions.push_back(position);
+    batch.velocities.push_back(fleetFront_.velocities[index]);
+    batch.cruiseVelocities.push_back(entry.cruiseVelocity);
+    batch.distances.push_back(cruiseSpeed > 0.0 ? offset.dot(entry.cruiseVelocity) / cruiseSpeed
+                                                : offset.norm());
+    batch.targetVelocities.push_back(entry.cruiseVelocity);
+    controller.robots.push_back(index);
+  }
+
+  pool_->ParallelFor(mergeControllers_.size(), [&](size_t begin, size_t end, size_t /*chunk*/) {
+    for (size_t c = begin; c < end; ++c) {
+      if (mergeControllers_[c].batch.size() > 0) {
+        mergeControllers_[c].strategy->ComputeBatch(mergeControllers_[c].batch);
+      }
+    }
+  });
+
+  // Commands wake sleeping robots, so only changed targets are applied
+  for (const MergeController& controller : mergeControllers_) {
+    for (size_t i = 0; i < controller.robots.size(); ++i) {
+      MobileRobotBase& robot = *robots_[controller.robots[i]].robot;
+      const Eigen::Vector2d& target = controller.batch.targetVelocities[i];
+      if (robot.GetTargetVelocity() != target) {
+        robot.SetTargetVelocity(target);
+      }
+    }
+  }
+}
+
+void SimulationEngine::RefreshFleet() {
+  if (!fleetStale_) {
+    return;
+  }
+
+  fleetFront_.Resize(robots_.size());
+  fleetBack_.Resize(robots_.size());
+  for (size_t index = 0; index < robots_.size(); ++index) {
+    fleetFront_.Store(index, *robots_[index].robot);
+    fleetBack_.Store(index, *robots_[index].robot);
+  }
+  fleetStale_ = false;
+}
+
+void SimulationEngine::ApplyDueCommands() {
+  const auto later = [](const ScheduledCommand& a, const ScheduledCommand& b) {
+    return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+  };
+
+  while (!commands_.empty() && commands_.front().time <= time_) {
+    std::pop_heap(commands_.begin(), commands_.end(), later);
+    ScheduledCommand command = std::move(commands_.back());
+    commands_.pop_back();
+
+    RobotEntry* entry = robots_.Find(command.robot);
+    if (entry != nullptr) {
+      command.apply(*entry->robot);
+      if (!fleetStale_) {
+        fleetFront_.Store(robots_.IndexOf(command.robot), *entry->robot);
+      }
+    }
+  }
+}
+
+double SimulationEngine::ComputeEventHorizon(double maxHorizon) const {
+  // Bound the speed of the dynamic elements once for all robots
+  double obstacleSpeed = 0.0;
+  const Eigen::AlignedBox2d everywhere(Eigen::Vector2d::Constant(-1e300),
+                                       Eigen::Vector2d::Constant(1e300));
+  environment_->ForEachDynamicElement(everywhere, [&](const EnvironmentElement& element) {
+    if (const auto* obstacle = dynamic_cast<const DynamicObstacle*>(&element)) {
+      obstacleSpeed = std::max(obstacleSpeed, obstacle->GetVelocity().norm());
+    } else if (element.IsSolid()) {
+      obstacleSpeed = std::numeric_limits<double>::infinity();
+    }
+    return false;
+  });
+
+  // Minimum over robots; the result does not depend on the chunking
+  std::vector<double> chunkHorizons(pool_->GetThreadCount(), maxHorizon);
+  pool_->ParallelFor(active_.size(), [&](size_t begin, size_t end, size_t chunk) {
+    double horizon = maxHorizon;
+    for (size_t i = begin; i < end && horizon > 0.0; ++i) {
+      horizon = std::min(horizon, ComputeRobotHorizon(robots_[active_[i]], horizon, obstacleSpeed));
+    }
+    chunkHorizons[chunk] = horizon;
+  });
+
+  return *std::min_element(chunkHorizons.begin(), chunkHorizons.end());
+}
+
+double SimulationEngine::ComputeRobotHorizon(const RobotEntry& entry, double maxHorizon,
+                                             double obstacleSpeed) const {
+  const double speed = entry.robot->GetSpeedBound();
+  if (!std::isfinite(speed) || !std::isfinite(obstacleSpeed)) {
+    return 0.0;
+  }
+
+  const Eigen::Vector2d position = entry.robot->GetPosition();
+  double horizon = maxHorizon;
+
+  // Static elements only matter if the robot itself moves
+  if (speed > 0.0) {
+    const Eigen::Vector2d reach = Eigen::Vector2d::Constant(speed * maxHorizon);
+    double solidGap = std::numeric_limits<double>::infinity();
+    double zoneGap = std::numeric_limits<double>::infinity();
+    environment_->ForEachStaticElement(
+        Eigen::AlignedBox2d(position - reach, position + reach),
+        [&](const EnvironmentElement& element) {
+          if (&element == entry.collision || &element == entry.mergePoint) {
+            return false;
+          }
+          if (const auto* zone = dynamic_cast<const MergePoint*>(&element)) {
+            zoneGap = std::min(zoneGap, (position - zone->GetPosition()).norm() - zone->GetRadius());
+          } else if (const auto* sink = dynamic_cast<const RobotSink*>(&element)) {
+            zoneGap = std::min(zoneGap, (position - sink->GetPosition()).norm() - sink->GetRadius());
+          } else if (element.IsSolid()) {
+            const Eigen::AlignedBox2d bounds = element.GetBounds();
+            solidGap = std::min(solidGap, bounds.isEmpty() ? 0.0 : bounds.exteriorDistance(position));
+          }
+          return false;
+        });
+
+    // The distance field is a lower bound up to one cell, and often much
+    // tighter than the element bounds
+    const SignedDistanceField* field = environment_->GetDistanceField();
+    if (field != nullptr && entry.collision == nullptr) {
+      const Eigen::Vector2d extent(field->GetWidth() * field->GetResolution(),
+                                   field->GetHeight() * field->GetResolution());
+      if (Eigen::AlignedBox2d(field->GetOrigin(), field->GetOrigin() + extent).contains(position)) {
+        solidGap = std::max(solidGap, field->Distance(position) - field->GetResolution());
+      }
+    }
+
+    horizon = std::min(horizon, std::max(std::min(solidGap, zoneGap), 0.0) / speed);
+  }
+
+  const Eigen::Vector2d reach =
+      Eigen::Vector2d::Constant((speed + obstacleSpeed) * maxHorizon);
+  environment_->ForEachDynamicElement(
+      Eigen::AlignedBox2d(position - reach, position + reach),
+      [&](const EnvironmentElement& element) {
+        if (!element.IsSolid() || &element == entry.collision) {
+          return false;
+        }
+        // Any other kind of solid dynamic element made obstacleSpeed infinite
+        const auto* obstacle = dynamic_cast<const DynamicObstacle*>(&element);
+        const double closing = speed + obstacle->GetVelocity().norm();
+        if (closing > 0.0) {
+          const double gap = (position - obstacle->GetPosition()).norm() - obstacle->GetRadius();
+          horizon = std::min(horizon, std::max(gap, 0.0) / closing);
+        }
+        return horizon <= 0.0;
+      });
+
+  return horizon;
+}
+
+RobotHandle SimulationEngine::SpawnRobot(size_t poolType, const RobotState& state) {
+  std::unique_ptr<MobileRobotBase> robot = robotPool_.Acquire(poolType);
+  if (robot == nullptr) {
+    return RobotHandle();
+  }
+  if (!robot->LoadState(state)) {
+    robotPool_.Release(poolType, std::move(robot));
+    return RobotHandle();
+  }
+
+  return AddEntry(std::move(robot), poolType);
+}
+
+void SimulationEngine::RefreshSpawners() {
+  if (!spawnersStale_ && environment_->GetRevision() == spawnerRevision_) {
+    return;
+  }
+
+  // Sources that are still present keep their spawn count
+  std::vector<SourceEntry> previous;
+  if (!spawnersStale_) {
+    previous.swap(sources_);
+  }
+  sources_.clear();
+  hasSinks_ = false;
+
+  const Eigen::AlignedBox2d everywhere(Eigen::Vector2d::Constant(-1e300),
+                                       Eigen::Vector2d::Constant(1e300));
+  environment_->ForEachStaticElement(everywhere, [&](const EnvironmentElement& element) {
+    if (const auto* source = dynamic_cast<const RobotSource*>(&element)) {
+      const auto it = std::find_if(previous.begin(), previous.end(),
+                                   [&](const SourceEntry& entry) { return entry.source == source; });
+      sources_.push_back({source, robotPool_.FindType(source->GetRobotType()),
+                          it != previous.end() ? it->spawned : 0});
+    } else if (dynamic_cast<const RobotSink*>(&element) != nullptr) {
+      hasSinks_ = true;
+    }
+    return false;
+  });
+
+  spawnerRevision_ = environment_->GetRevision();
+  spawnersStale_ = false;
+}
+
+void SimulationEngine::ProcessSpawning(double endTime) {
+  // Robots an observer already removed are skipped by RemoveRobot()
+  for (const RobotHandle& handle : despawns_) {
+    RemoveRobot(handle);
+  }
+
+  for (SourceEntry& entry : sources_) {
+    while (GetSpawnTime(entry, entry.spawned) <= endTime + kSpawnTimeTolerance) {
+      const RobotHandle handle = SpawnRobot(entry.poolType, entry.source->GetSpawnState());
+      ++entry.spawned;
+      if (!handle.IsValid()) {
+        ++failedSpawns_;
+        continue;
+      }
+      const auto& command = entry.source->GetSpawnCommand();
+      if (command) {
+        command(*robots_.Find(handle)->robot);
+      }
+    }
+  }
+}
+
+double SimulationEngine::GetSpawnTime(const SourceEntry& entry, uint64_t index) {
+  const double interval = entry.source->GetInterval();
+  if (interval <= 0.0) {
+    return index == 0 ? entry.source->GetStartTime() : std::numeric_limits<double>::infinity();
+  }
+
+  return entry.source->GetStartTime() + static_cast<double>(index) * interval;
+}
+
+void SimulationEngine::ProcessWakeRequests() {
+  RefreshActive();
+  if (pendingWakes_.empty()) {
+    return;
+  }
+
+  for (const RobotHandle& handle : pendingWakes_) {
+    const RobotEntry* entry = robots_.Find(handle);
+    if (entry != nullptr && entry->robot->IsSleeping()) {
+      Wake(robots_.IndexOf(handle));
+    }
+  }
+  pendingWakes_.clear();
+  std::sort(active_.begin(), active_.end());
+}
+
+void SimulationEngine::RefreshActive() {
+  if (!activeStale_) {
+    return;
+  }
+
+  active_.clear();
+  for (size_t index = 0; index < robots_.size(); ++index) {
+    if (!robots_[index].robot->IsSleeping()) {
+      active_.push_back(index);
+    }
+  }
+  activeStale_ = false;
+}
+
+void SimulationEngine::UpdateSchedule() {
+  // Observers may have removed robots while events were dispatched
+  RefreshActive();
+  if (!sleepEnabled_) {
+    return;
+  }
+
+  // Any change to the element set may affect every robot
+  if (environment_->GetRevision() != environmentRevision_) {
+    environmentRevision_ = environment_->GetRevision();
+    WakeAll();
+  }
+
+  size_t kept = 0;
+  for (size_t index : active_) {
+    if (robots_[index].robot->IsAtRest()) {
+      Sleep(index);
+    } else {
+      active_[kept++] = index;
+    }
+  }
+  active_.resize(kept);
+
+  if (sleepingCells_.empty()) {
+    return;
+  }
+
+  // Moving robots and dynamic elements wake the sleepers they come close to;
+  // robots woken here are appended behind the ones that are checked
+  const Eigen::Vector2d reach = Eigen::Vector2d::Constant(wakeRadius_);
+  for (size_t i = 0; i < kept; ++i) {
+    const Eigen::Vector2d position = robots_[active_[i]].robot->GetPosition();
+    WakeInRegion(Eigen::AlignedBox2d(position - reach, position + reach), wakeRadius_);
+  }
+
+  const Eigen::AlignedBox2d everywhere(Eigen::Vector2d::Constant(-1e300),
+                                       Eigen::Vector2d::Constant(1e300));
+  environment_->ForEachDynamicElement(everywhere, [&](const EnvironmentElement& element) {
+    const Eigen::AlignedBox2d bounds = element.GetBounds();
+    if (!bounds.isEmpty()) {
+      WakeInRegion(Eigen::AlignedBox2d(bounds.min() - reach, bounds.max() + reach), -1.0);
+    }
+    return false;
+  });
+
+  if (active_.size() != kept) {
+    std::sort(active_.begin(), active_.end());
+  }
+}
+
+void SimulationEngine::Sleep(size_t index) {
+  RobotEntry& entry = robots_[index];
+  const Eigen::Vector2d position = entry.robot->GetPosition();
+
+  // Sleeping robots are not written while they sleep, so both buffers keep them
+  if (!fleetStale_) {
+    fleetFront_.Store(index, *entry.robot);
+    fleetBack_.Store(index, *entry.robot);
+  }
+  entry.robot->SetSleeping(true);
+  entry.sleepCell = CellKey(CellOf(position.x()), CellOf(position.y()));
+  sleepingCells_[entry.sleepCell].push_back(robots_.GetHandle(index));
+  ++stats_.sleepCount;
+}
+
+void SimulationEngine::Wake(size_t index) {
+  RobotEntry& entry = robots_[index];
+  entry.robot->SetSleeping(false);
+
+  const auto cell = sleepingCells_.find(entry.sleepCell);
+  if (cell != sleepingCells_.end()) {
+    std::vector<RobotHandle>& handles = cell->second;
+    const auto it = std::find(handles.begin(), handles.end(), robots_.GetHandle(index));
+    if (it != handles.end()) {
+      *it = handles.back();
+      handles.pop_back();
+    }
+    if (handles.empty()) {
+      sleepingCells_.erase(cell);
+    }
+  }
+
+  active_.push_back(index);
+  ++stats_.wakeCount;
+}
+
+void SimulationEngine::WakeAll() {
+  RefreshActive();
+  if (sleepingCells_.empty()) {
+    return;
+  }
+
+  for (size_t index = 0; index < robots_.size(); ++index) {
+    if (robots_[index].robot->IsSleeping()) {
+      robots_[index].robot->SetSleeping(false);
+      active_.push_back(index);
+      ++stats_.wakeCount;
+    }
+  }
+  sleepingCells_.clear();
+  std::sort(active_.begin(), active_.end());
+}
+
+void SimulationEngine::WakeInRegion(const Eigen::AlignedBox2d& region, double maxDistance) {
+  const int64_t x0 = CellOf(region.min().x());
+  const int64_t x1 = CellOf(region.max().x());
+  const int64_t y0 = CellOf(region.min().y());
+  const int64_t y1 = CellOf(region.max().y());
+
+  std::vector<size_t> woken;
+  const auto collect = [&](const std::vector<RobotHandle>& handles) {
+    for (const RobotHandle& handle : handles) {
+      const size_t index = robots_.IndexOf(handle);
+      const Eigen::Vector2d position = robots_[index].robot->GetPosition();
+      if (region.contains(position) &&
+          (maxDistance < 0.0 || (position - region.center()).norm() <= maxDistance)) {
+        woken.push_back(index);
+      }
+    }
+  };
+
+  // Large regions scan the occupied cells instead of every covered cell
+  const double coveredCells = double(x1 - x0 + 1) * double(y1 - y0 + 1);
+  if (coveredCells > static_cast<double>(sleepingCells_.size())) {
+    for (const auto& cell : sleepingCells_) {
+      collect(cell.second);
+    }
+  } else {
+    for (int64_t y = y0; y <= y1; ++y) {
+      for (int64_t x = x0; x <= x1; ++x) {
+        const auto cell = sleepingCells_.find(CellKey(x, y));
+        if (cell != sleepingCells_.end()) {
+          collect(cell->second);
+        }
+      }
+    }
+  }
+
+  for (size_t index : woken) {
+    Wake(index);
+  }
+}
+
+void SimulationEngine::RebuildSchedule() {
+  active_.clear();
+  activeStale_ = false;
+  sleepingCells_.clear();
+  for (size_t index = 0; index < robots_.size(); ++index) {
+    RobotEntry& entry = robots_[index];
+    if (entry.robot->IsSleeping()) {
+      const Eigen::Vector2d position = entry.robot->GetPosition();
+      entry.sleepCell = CellKey(CellOf(position.x()), CellOf(position.y()));
+      sleepingCells_[entry.sleepCell].push_back(robots_.GetHandle(index));
+    } else {
+      active_.push_back(index);
+    }
+  }
+}
+
+uint64_t SimulationEngine::CellKey(int64_t x, int64_t y) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+int64_t SimulationEngine::CellOf(double coordinate) const {
+  const double cell = std::floor(coordinate / wakeRadius_);
+  return static_cast<int64_t>(std::clamp(cell, -2147483648.0, 2147483647.0));
 }
 
 void SimulationEngine::NotifyStep(const SystemState& state) const {
-  for (auto observer : observers_) {
-    observer->OnStep(state);
+  for (size_t i = 0; i < observers_.size() && i < stepStateNeeded_.size(); ++i) {
+    if (stepStateNeeded_[i] != 0) {
+      observers_[i]->OnStep(state);
+    }
   }
 }
 
-void SimulationEngine::NotifyCollision(const MobileRobotBase* robot, const void* object) const {
-  for (auto observer : observers_) {
-    observer->OnCollision(robot, object);
+void SimulationEngine::NotifyCollision(RobotHandle robot, const void* object) const {
+  for (size_t i = 0; i < observers_.size(); ++i) {
+    const RobotEntry* entry = robots_.Find(robot);
+    if (entry == nullptr) {
+      return;
+    }
+    observers_[i]->OnCollision(entry->robot.get(), object);
   }
 }
 
-void SimulationEngine::NotifyMergePoint(const MobileRobotBase* robot, 
-                                     const EnvironmentElement* mergePoint) const {
-  for (auto observer : observers_) {
-    observer->OnMergePoint(robot, mergePoint);
+void SimulationEngine::NotifyMergePoint(RobotHandle robot,
+                                        const EnvironmentElement* mergePoint) const {
+  for (size_t i = 0; i < observers_.size(); ++i) {
+    const RobotEntry* entry = robots_.Find(robot);
+    if (entry == nullptr) {
+      return;
+    }
+    observers_[i]->OnMergePoint(entry->robot.get(), mergePoint);
   }
 }
 
@@ -0,0 +1,294 @@
+#include "mobilerobotsim/state_publisher.h"
+#include "mobilerobotsim/system_state.h"
+#include "mobilerobotsim/robot_state.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+namespace mobilerobotsim {
+
+namespace {
+
+constexpr uint64_t kMagic = 0x31425550534d524dull;  // "MRSMPUB1"
+constexpr uint32_t kVersion = 1;
+
+// Header and slots start on cache lines so that slots do not share them
+constexpr size_t kAlignment = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Seqlock counters must be lock-free to be shared between processes");
+
+struct SegmentHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t poseSize;
+  uint64_t slotCount;
+  uint64_t capacity;
+  uint64_t slotBytes;
+  std::atomic<uint64_t> published;  // Steps published; the latest is one less
+};
+
+// Written between the two updates of the slot's seqlock counter
+struct SlotFields {
+  uint64_t sequence;
+  double time;
+  uint64_t robotCount;
+  uint64_t stored;
+};
+
+struct SlotHeader {
+  std::atomic<uint64_t> lock;  // Odd while the slot is being written
+  SlotFields fields;
+};
+
+static_assert(sizeof(SegmentHeader) <= kAlignment, "Segment header must fit its cache line");
+
+size_t RoundUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string SegmentName(const std::string& name) {
+  return !name.empty() && name.front() == '/' ? name : "/" + name;
+}
+
+size_t SlotBytes(size_t capacity) {
+  return RoundUp(sizeof(SlotHeader) + capacity * sizeof(PublishedPose), kAlignment);
+}
+
+const SlotHeader& SlotAt(const uint8_t* data, size_t slotBytes, size_t slot) {
+  return *reinterpret_cast<const SlotHeader*>(data + kAlignment + slot * slotBytes);
+}
+
+// Runs a reader on a slot under its seqlock. The reader takes the slot's
+// fields, its poses and their count; its results are only valid if this
+// returns true, meaning the slot held the step throughout
+template <typename Reader>
+bool ReadSlot(const SlotHeader& slot, uint64_t sequence, size_t capacity, Reader&& reader) {
+  const uint64_t lock = slot.lock.load(std::memory_order_acquire);
+  if ((lock & 1) != 0) {
+    return false;
+  }
+  SlotFields fields;
+  std::memcpy(&fields, &slot.fields, sizeof(fields));
+  if (fields.sequence != sequence) {
+    return false;
+  }
+
+  // A torn count must not send the reader past the slot
+  const auto* poses = reinterpret_cast<const PublishedPose*>(&slot + 1);
+  reader(fields, poses, static_cast<size_t>(std::min<uint64_t>(fields.stored, capacity)));
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.lock.load(std::memory_order_relaxed) == lock;
+}
+
+}  // namespace
+
+StatePublisher::StatePublisher()
+    : data_(nullptr), size_(0), slotCount_(0), capacity_(0), slotBytes_(0), published_(0) {}
+
+StatePublisher::~StatePublisher() {
+  Close();
+}
+
+bool StatePublisher::Open(const std::string& name, size_t slotCount, size_t capacity) {
+  Close();
+  if (slotCount == 0) {
+    return false;
+  }
+
+  // Readers that mapped a previous segment of the same name keep it
+  const std::string segment = SegmentName(name);
+  ::shm_unlink(segment.c_str());
+  const int fd = ::shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  const size_t slotBytes = SlotBytes(capacity);
+  const size_t size = kAlignment + slotCount * slotBytes;
+  void* mapping = MAP_FAILED;
+  if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    ::shm_unlink(segment.c_str());
+    return false;
+  }
+
+  // The segment starts out zeroed, so every slot is unlocked and empty
+  data_ = static_cast<uint8_t*>(mapping);
+  auto* header = new (data_) SegmentHeader();
+  header->magic = kMagic;
+  header->version = kVersion;
+  header->poseSize = sizeof(PublishedPose);
+  header->slotCount = slotCount;
+  header->capacity = capacity;
+  header->slotBytes = slotBytes;
+  header->published.store(0, std::memory_order_release);
+  for (size_t i = 0; i < slotCount; ++i) {
+    new (data_ + kAlignment + i * slotBytes) SlotHeader();
+  }
+
+  name_ = segment;
+  size_ = size;
+  slotCount_ = slotCount;
+  capacity_ = capacity;
+  slotBytes_ = slotBytes;
+  published_ = 0;
+  return true;
+}
+
+void StatePublisher::Close() {
+  if (data_ == nullptr) {
+    return;
+  }
+  ::munmap(data_, size_);
+  ::shm_unlink(name_.c_str());
+  data_ = nullptr;
+  size_ = 0;
+}
+
+void StatePublisher::OnStep(const SystemState& state) {
+  if (data_ == nullptr) {
+    return;
+  }
+
+  auto* slot = const_cast<SlotHeader*>(&SlotAt(data_, slotBytes_, published_ % slotCount_));
+  auto* poses = reinterpret_cast<PublishedPose*>(slot + 1);
+
+  const uint64_t lock = slot->lock.load(std::memory_order_relaxed);
+  slot->lock.store(lock + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint64_t robotCount = 0;
+  for (size_t i = 0; i < state.GetRobotStateCount(); ++i) {
+    double x = 0.0;
+    double y = 0.0;
+    double orientation = 0.0;
+    if (!state.GetRobotState(i)->GetPose(x, y, orientation)) {
+      continue;
+    }
+    if (robotCount < capacity_) {
+      const SlotHandle handle = state.GetRobotHandle(i);
+      poses[robotCount] = {handle.index, handle.generation, x, y, orientation};
+    }
+    ++robotCount;
+  }
+  slot->fields = {published_, state.GetTime(), robotCount,
+                  std::min<uint64_t>(robotCount, capacity_)};
+
+  slot->lock.store(lock + 2, std::memory_order_release);
+  reinterpret_cast<SegmentHeader*>(data_)->published.store(++published_, std::memory_order_release);
+}
+
+void StatePublisher::OnCollision(const MobileRobotBase* /*robot*/, const void* /*object*/) {
+}
+
+void StatePublisher::OnMergePoint(const MobileRobotBase* /*robot*/,
+                                  const EnvironmentElement* /*mergePoint*/) {
+}
+
+StateReader::StateReader() : data_(nullptr), size_(0), slotCount_(0), capacity_(0), slotBytes_(0) {}
+
+StateReader::~StateReader() {
+  Close();
+}
+
+bool StateReader::Open(const std::string& name) {
+  Close();
+
+  const int fd = ::shm_open(SegmentName(name).c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kAlignment) {
+    ::close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(info.st_size);
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  const auto* header = static_cast<const SegmentHeader*>(mapping);
+  const bool valid = header->magic == kMagic && header->version == kVersion &&
+                     header->poseSize == sizeof(PublishedPose) && header->slotCount > 0 &&
+                     header->slotBytes == SlotBytes(header->capacity) &&
+                     kAlignment + header->slotCount * header->slotBytes <= size;
+  if (!valid) {
+    ::munmap(mapping, size);
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = size;
+  slotCount_ = header->slotCount;
+  capacity_ = header->capacity;
+  slotBytes_ = header->slotBytes;
+  return true;
+}
+
+void StateReader::Close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+uint64_t StateReader::GetPublishedCount() const {
+  if (data_ == nullptr) {
+    return 0;
+  }
+  return reinterpret_cast<const SegmentHeader*>(data_)->published.load(std::memory_order_acquire);
+}
+
+bool StateReader::Read(uint64_t sequence, Snapshot& snapshot) const {
+  if (data_ == nullptr || sequence >= GetPublishedCount()) {
+    return false;
+  }
+  return ReadSlot(SlotAt(data_, slotBytes_, sequence % slotCount_), sequence, capacity_,
+                  [&](const SlotFields& fields, const PublishedPose* poses, size_t count) {
+                    snapshot.sequence = sequence;
+                    snapshot.time = fields.time;
+                    snapshot.robotCount = fields.robotCount;
+                    snapshot.poses.assign(poses, poses + count);
+                  });
+}
+
+bool StateReader::ReadLatest(Snapshot& snapshot) const {
+  // The latest step can only be lost to a publisher that laps the ring
+  while (true) {
+    const uint64_t published = GetPublishedCount();
+    if (published == 0) {
+      return false;
+    }
+    if (Read(published - 1, snapshot)) {
+      return true;
+    }
+  }
+}
+
+bool StateReader::Visit(uint64_t sequence, const PoseVisitor& visitor) const {
+  if (data_ == nullptr || sequence >= GetPublishedCount()) {
+    return false;
+  }
+  return ReadSlot(SlotAt(data_, slotBytes_, sequence % slotCount_), sequence, capacity_,
+                  [&](const SlotFields& /*fields*/, const PublishedPose* poses, size_t count) {
+                    visitor(poses, count);
+                  });
+}
+
+}  // namespace mobilerobotsim
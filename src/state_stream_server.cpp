@@ -0,0 +1,395 @@
+#include "mobilerobotsim/state_stream_server.h"
+#include "mobilerobotsim/system_state.h"
+#include "mobilerobotsim/robot_state.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+namespace mobilerobotsim {
+
+namespace {
+
+// Events handled per epoll_wait() call
+constexpr int kMaxEvents = 64;
+
+bool Watch(int epollFd, int operation, int fd, uint32_t events) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  return ::epoll_ctl(epollFd, operation, fd, &event) == 0;
+}
+
+void Wake(int wakeFd) {
+  const uint64_t one = 1;
+  const ssize_t written = ::write(wakeFd, &one, sizeof(one));
+  (void)written;  // A full counter already wakes the thread
+}
+
+}  // namespace
+
+StateStreamServer::StateStreamServer()
+    : listenFd_(-1),
+      epollFd_(-1),
+      wakeFd_(-1),
+      stepCount_(0),
+      pendingSequence_(0),
+      pendingTime_(0.0),
+      hasPending_(false),
+      stopping_(false),
+      currentSequence_(0),
+      currentTime_(0.0),
+      subscribers_(0),
+      nextDue_(0),
+      framesSent_(0),
+      framesDropped_(0) {}
+
+StateStreamServer::~StateStreamServer() {
+  Close();
+}
+
+bool StateStreamServer::Open(const std::string& path) {
+  Close();
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  // Only a stale socket is replaced; any other file makes bind() fail
+  struct stat existing;
+  if (::lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+    ::unlink(path.c_str());
+  }
+  listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd_ < 0 ||
+      ::bind(listenFd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    Close();
+    return false;
+  }
+  path_ = path;
+
+  epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (::listen(listenFd_, SOMAXCONN) != 0 || epollFd_ < 0 || wakeFd_ < 0 ||
+      !Watch(epollFd_, EPOLL_CTL_ADD, listenFd_, EPOLLIN) ||
+      !Watch(epollFd_, EPOLL_CTL_ADD, wakeFd_, EPOLLIN)) {
+    Close();
+    return false;
+  }
+
+  stepCount_ = 0;
+  nextDue_ = 0;
+  hasPending_ = false;
+  stopping_ = false;
+  framesSent_ = 0;
+  framesDropped_ = 0;
+  thread_ = std::thread(&StateStreamServer::IoLoop, this);
+  return true;
+}
+
+void StateStreamServer::Close() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    Wake(wakeFd_);
+    thread_.join();
+  }
+
+  for (const Client& client : clients_) {
+    ::close(client.fd);
+  }
+  clients_.clear();
+  subscribers_ = 0;
+
+  for (int* fd : {&listenFd_, &epollFd_, &wakeFd_}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+  if (!path_.empty()) {
+    ::unlink(path_.c_str());
+    path_.clear();
+  }
+}
+
+void StateStreamServer::OnStep(const SystemState& state) {
+  if (!thread_.joinable()) {
+    return;
+  }
+
+  capture_.clear();
+  for (size_t i = 0; i < state.GetRobotStateCount(); ++i) {
+    double x = 0.0;
+    double y = 0.0;
+    double orientation = 0.0;
+    if (state.GetRobotState(i)->GetPose(x, y, orientation)) {
+      const SlotHandle handle = state.GetRobotHandle(i);
+      capture_.push_back({handle.index, handle.generation, x, y, orientation});
+    }
+  }
+
+  // Swapping keeps the storage of both buffers, so steady state allocates nothing
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::swap(capture_, pending_);
+    pendingSequence_ = stepCount_++;
+    pendingTime_ = state.GetTime();
+    hasPending_ = true;
+  }
+  Wake(wakeFd_);
+}
+
+bool StateStreamServer::NeedsStepState() {
+  if (thread_.joinable() && subscribers_.load() > 0 && stepCount_ >= nextDue_.load()) {
+    return true;
+  }
+
+  // Skipped steps still count, so sequence numbers stay step numbers
+  ++stepCount_;
+  return false;
+}
+
+void StateStreamServer::OnCollision(const MobileRobotBase* /*robot*/, const void* /*object*/) {
+}
+
+void StateStreamServer::OnMergePoint(const MobileRobotBase* /*robot*/,
+                                     const EnvironmentElement* /*mergePoint*/) {
+}
+
+void StateStreamServer::IoLoop() {
+  epoll_event events[kMaxEvents];
+  while (true) {
+    const int count = ::epoll_wait(epollFd_, events, kMaxEvents, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == wakeFd_) {
+        uint64_t value = 0;
+        const ssize_t drained = ::read(wakeFd_, &value, sizeof(value));
+        (void)drained;  // Only clears the counter
+
+        bool hasStep = false;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (stopping_) {
+            return;
+          }
+          if (hasPending_) {
+            std::swap(pending_, current_);
+            currentSequence_ = pendingSequence_;
+            currentTime_ = pendingTime_;
+            hasPending_ = false;
+            hasStep = true;
+          }
+        }
+        if (hasStep) {
+          Broadcast();
+        }
+      } else if (fd == listenFd_) {
+        AcceptClients();
+      } else {
+        const auto client = std::find_if(clients_.begin(), clients_.end(),
+                                         [fd](const Client& c) { return c.fd == fd; });
+        if (client == clients_.end()) {
+          continue;
+        }
+        bool connected = (events[i].events & EPOLLERR) == 0;
+        if (connected && (events[i].events & (EPOLLIN | EPOLLHUP)) != 0) {
+          connected = ReadClient(*client);
+        }
+        if (connected && (events[i].events & EPOLLOUT) != 0) {
+          connected = FlushClient(*client);
+        }
+        if (!connected) {
+          DropClient(fd);
+        }
+      }
+    }
+  }
+}
+
+void StateStreamServer::AcceptClients() {
+  while (true) {
+    const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      return;
+    }
+    if (!Watch(epollFd_, EPOLL_CTL_ADD, fd, EPOLLIN)) {
+      ::close(fd);
+      continue;
+    }
+
+    // Room for a frame of the whole fleet, so sending rarely allocates
+    Client client;
+    client.fd = fd;
+    client.output.resize(sizeof(StreamFrameHeader) + current_.size() * sizeof(PublishedPose));
+    clients_.push_back(std::move(client));
+  }
+}
+
+bool StateStreamServer::ReadClient(Client& client) {
+  uint8_t buffer[256];
+  while (true) {
+    const ssize_t received = ::recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (received > 0) {
+      client.input.insert(client.input.end(), buffer, buffer + received);
+      continue;
+    }
+    if (received == 0) {
+      return false;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    return false;
+  }
+
+  size_t offset = 0;
+  while (client.input.size() - offset >= sizeof(StreamSubscription)) {
+    StreamSubscription subscription;
+    std::memcpy(&subscription, client.input.data() + offset, sizeof(subscription));
+    offset += sizeof(subscription);
+    if (subscription.magic != StreamSubscription::kMagic) {
+      return false;
+    }
+
+    // Set before the count goes up so the simulation never skips the client's first step
+    nextDue_ = 0;
+    if (!client.subscribed) {
+      client.subscribed = true;
+      ++subscribers_;
+    }
+    client.decimation = std::max<uint32_t>(subscription.decimation, 1);
+    client.region = Eigen::AlignedBox2d(Eigen::Vector2d(subscription.minX, subscription.minY),
+                                        Eigen::Vector2d(subscription.maxX, subscription.maxY));
+    client.nextSequence = 0;
+  }
+  client.input.erase(client.input.begin(), client.input.begin() + offset);
+  return true;
+}
+
+bool StateStreamServer::FlushClient(Client& client) {
+  while (client.outputSent < client.outputSize) {
+    const ssize_t sent = ::send(client.fd, client.output.data() + client.outputSent,
+                                client.outputSize - client.outputSent,
+                                MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent > 0) {
+      client.outputSent += static_cast<size_t>(sent);
+    } else if (sent < 0 && errno == EINTR) {
+      continue;
+    } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Resume once the client has drained its socket
+      if (client.writable) {
+        client.writable = false;
+        return Watch(epollFd_, EPOLL_CTL_MOD, client.fd, EPOLLIN | EPOLLOUT);
+      }
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  if (!client.writable) {
+    client.writable = true;
+    return Watch(epollFd_, EPOLL_CTL_MOD, client.fd, EPOLLIN);
+  }
+  return true;
+}
+
+void StateStreamServer::Broadcast() {
+  // Publish the next step anyone wants before sending, so the steps in between are never captured
+  uint64_t nextDue = std::numeric_limits<uint64_t>::max();
+  for (const Client& client : clients_) {
+    if (client.subscribed) {
+      nextDue = std::min(nextDue, currentSequence_ < client.nextSequence
+                                      ? client.nextSequence
+                                      : currentSequence_ + client.decimation);
+    }
+  }
+  nextDue_ = nextDue;
+
+  size_t i = 0;
+  while (i < clients_.size()) {
+    Client& client = clients_[i];
+    if (!client.subscribed || currentSequence_ < client.nextSequence) {
+      ++i;
+      continue;
+    }
+    client.nextSequence = currentSequence_ + client.decimation;
+
+    // A client still sending its previous frame skips this one
+    if (client.outputSent < client.outputSize) {
+      ++framesDropped_;
+      ++i;
+      continue;
+    }
+
+    const size_t most = sizeof(StreamFrameHeader) + current_.size() * sizeof(PublishedPose);
+    if (client.output.size() < most) {
+      client.output.resize(most);
+    }
+    uint8_t* poses = client.output.data() + sizeof(StreamFrameHeader);
+    uint32_t robotCount = 0;
+    for (const PublishedPose& pose : current_) {
+      if (client.region.isEmpty() || client.region.contains(Eigen::Vector2d(pose.x, pose.y))) {
+        std::memcpy(poses + size_t(robotCount) * sizeof(PublishedPose), &pose, sizeof(pose));
+        ++robotCount;
+      }
+    }
+    const StreamFrameHeader header{StreamFrameHeader::kMagic, robotCount, currentSequence_,
+                                   currentTime_};
+    std::memcpy(client.output.data(), &header, sizeof(header));
+    client.outputSize = sizeof(header) + size_t(robotCount) * sizeof(PublishedPose);
+    client.outputSent = 0;
+    ++framesSent_;
+
+    if (!FlushClient(client)) {
+      DropClient(client.fd);
+      continue;
+    }
+    ++i;
+  }
+}
+
+void StateStreamServer::DropClient(int fd) {
+  const auto client = std::find_if(clients_.begin(), clients_.end(),
+                                   [fd](const Client& c) { return c.fd == fd; });
+  if (client == clients_.end()) {
+    return;
+  }
+  if (client->subscribed) {
+    --subscribers_;
+  }
+  ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+  ::close(fd);
+  std::swap(*client, clients_.back());
+  clients_.pop_back();
+}
+
+}  // namespace mobilerobotsim
@@ -1,16 +1,39 @@
 #include "mobilerobotsim/system_state.h"
-#include "mobilerobotsim/robot_state.h"
+
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <unordered_map>
+
+#include "json_stream_reader.h"
 #include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/json_writer.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/robot_state.h"
 
 namespace mobilerobotsim {
 
+namespace {
+
+// Factories for the robot state types that Read() can create, by type id
+std::unordered_map<std::string, SystemState::RobotStateFactory>& GetRobotStateFactories() {
+  static std::unordered_map<std::string, SystemState::RobotStateFactory> factories = {
+      {"PointRobotState", [] { return std::make_unique<PointRobotState>(0, 0, 0, 0, 0); }},
+      {"PointRobotStateF", [] { return std::make_unique<PointRobotStateF>(0, 0, 0, 0, 0); }},
+  };
+  return factories;
+}
+
+}  // namespace
+
 SystemState::SystemState() : time_(0.0) {
 }
 
 SystemState::SystemState(double time) : time_(time) {
 }
 
-SystemState::SystemState(const SystemState& other) : time_(other.time_) {
+SystemState::SystemState(const SystemState& other)
+    : time_(other.time_), robotHandles_(other.robotHandles_) {
   // Clone robot states
   for (const auto& robotState : other.robotStates_) {
     robotStates_.push_back(robotState->Clone());
@@ -25,6 +48,7 @@ SystemState::SystemState(const SystemState& other) : time_(other.time_) {
 SystemState::SystemState(SystemState&& other) noexcept
     : time_(other.time_),
       robotStates_(std::move(other.robotStates_)),
+      robotHandles_(std::move(other.robotHandles_)),
       environmentState_(std::move(other.environmentState_)) {
 }
 
@@ -37,6 +61,7 @@ SystemState& SystemState::operator=(const SystemState& other) {
     for (const auto& robotState : other.robotStates_) {
       robotStates_.push_back(robotState->Clone());
     }
+    robotHandles_ = other.robotHandles_;
     
     // Clone environment state
     if (other.environmentState_) {
@@ -53,6 +78,7 @@ SystemState& SystemState::operator=(SystemState&& other) noexcept {
   if (this != &other) {
     time_ = other.time_;
     robotStates_ = std::move(other.robotStates_);
+    robotHandles_ = std::move(other.robotHandles_);
     environmentState_ = std::move(other.environmentState_);
   }
   
@@ -69,8 +95,10 @@ void SystemState::SetTime(double time) {
   time_ = time;
 }
 
-void SystemState::AddRobotState(std::unique_ptr<RobotState> robotState) {
+void SystemState::AddRobotState(std::unique_ptr<RobotState> robotState,
+                                const SlotHandle& handle) {
   robotStates_.push_back(std::move(robotState));
+  robotHandles_.push_back(handle);
 }
 
 const RobotState* SystemState::GetRobotState(size_t index) const {
@@ -81,6 +109,14 @@ const RobotState* SystemState::GetRobotState(size_t index) const {
   return robotStates_[index].get();
 }
 
+SlotHandle SystemState::GetRobotHandle(size_t index) const {
+  if (index >= robotHandles_.size()) {
+    return SlotHandle();
+  }
+  
+  return robotHandles_[index];
+}
+
 size_t SystemState::GetRobotStateCount() const {
   return robotStates_.size();
 }
@@ -93,14 +129,121 @@ const EnvironmentState* SystemState::GetEnvironmentState() const {
   return environmentState_.get();
 }
 
+bool SystemState::Write(std::ostream& stream) const {
+  JsonWriter writer(stream);
+  writer.BeginObject();
+  writer.Key("time");
+  writer.Value(time_);
+
+  writer.Key("robots");
+  writer.BeginArray();
+  for (size_t i = 0; i < robotStates_.size(); ++i) {
+    writer.BeginObject();
+    writer.Key("type");
+    writer.Value(robotStates_[i]->GetTypeId());
+    if (robotHandles_[i].IsValid()) {
+      writer.Key("handle");
+      writer.BeginArray();
+      writer.Value(static_cast<uint64_t>(robotHandles_[i].index));
+      writer.Value(static_cast<uint64_t>(robotHandles_[i].generation));
+      writer.EndArray();
+    }
+    writer.Key("state");
+    writer.RawValue(robotStates_[i]->Serialize());
+    writer.EndObject();
+  }
+  writer.EndArray();
+
+  if (environmentState_) {
+    writer.Key("environment");
+    environmentState_->Write(writer);
+  }
+  writer.EndObject();
+  return writer.IsGood();
+}
+
+bool SystemState::Read(std::istream& stream) {
+  Clear();
+
+  JsonStreamReader reader;
+  reader.StreamArray("/robots", [this](nlohmann::json& robot) {
+    if (!robot.is_object() || !robot["type"].is_string()) {
+      return false;
+    }
+
+    std::unique_ptr<RobotState> state = CreateRobotState(robot["type"].get<std::string>());
+    if (state == nullptr || !state->Deserialize(ToSerializedState(robot["state"]))) {
+      return false;
+    }
+
+    SlotHandle handle;
+    if (robot.contains("handle")) {
+      // Values beyond 32 bits would be truncated into a different handle
+      const nlohmann::json& saved = robot["handle"];
+      const auto isField = [](const nlohmann::json& value) {
+        return value.is_number_unsigned() &&
+               value.get<uint64_t>() <= std::numeric_limits<uint32_t>::max();
+      };
+      if (!saved.is_array() || saved.size() != 2 || !isField(saved[0]) || !isField(saved[1])) {
+        return false;
+      }
+      handle.index = static_cast<uint32_t>(saved[0].get<uint64_t>());
+      handle.generation = static_cast<uint32_t>(saved[1].get<uint64_t>());
+    }
+
+    AddRobotState(std::move(state), handle);
+    return true;
+  });
+
+  auto environment = std::make_unique<EnvironmentState>();
+  reader.StreamArray("/environment/elements", [&environment](nlohmann::json& element) {
+    if (!element.is_object() || !element["type"].is_string()) {
+      return false;
+    }
+    environment->AddElementState(element["type"].get<std::string>(),
+                                 ToSerializedState(element["state"]));
+    return true;
+  });
+
+  nlohmann::json root;
+  if (!reader.Read(stream, root) || !root.is_object() || !root["time"].is_number()) {
+    Clear();
+    return false;
+  }
+
+  time_ = root["time"].get<double>();
+  if (root.contains("environment")) {
+    environmentState_ = std::move(environment);
+  }
+  return true;
+}
+
+void SystemState::RegisterRobotStateType(const std::string& typeId, RobotStateFactory factory) {
+  GetRobotStateFactories()[typeId] = std::move(factory);
+}
+
+std::unique_ptr<RobotState> SystemState::CreateRobotState(const std::string& typeId) {
+  const auto& factories = GetRobotStateFactories();
+  const auto factory = factories.find(typeId);
+  return factory != factories.end() ? factory->second() : nullptr;
+}
+
 std::string SystemState::Serialize() const {
-  // Placeholder for serialization
-  return "{}";  // Empty JSON object
+  std::ostringstream stream;
+  Write(stream);
+  return stream.str();
 }
 
 bool SystemState::Deserialize(const std::string& serialized) {
-  // Placeholder for deserialization
-  return true;
+  std::istringstream stream(serialized);
+  return Read(stream);
+}
+
+void SystemState::Clear() {
+  time_ = 0.0;
+  robotStates_.clear();
+  robotHandles_.clear();
+  environmentState_.reset();
 }
 
 } // namespace mobilerobotsim
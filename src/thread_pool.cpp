@@ -0,0 +1,81 @@
+#include "mobilerobotsim/thread_pool.h"
+
+namespace mobilerobotsim {
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : job_(nullptr), count_(0), generation_(0), pending_(0), stopping_(false) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  workers_.reserve(threadCount - 1);
+  for (size_t chunk = 1; chunk < threadCount; ++chunk) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this, chunk);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, const ChunkFunction& function) {
+  if (workers_.empty() || count < 2) {
+    function(0, count, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &function;
+    count_ = count;
+    pending_ = workers_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  RunChunk(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+  job_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t chunk) {
+  size_t seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seenGeneration; });
+      if (stopping_) {
+        return;
+      }
+      seenGeneration = generation_;
+    }
+
+    RunChunk(chunk);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunChunk(size_t chunk) {
+  const size_t chunks = GetThreadCount();
+  const size_t begin = count_ * chunk / chunks;
+  const size_t end = count_ * (chunk + 1) / chunks;
+  if (begin < end) {
+    (*job_)(begin, end, chunk);
+  }
+}
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,169 @@
+#include "mobilerobotsim/uniform_grid_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mobilerobotsim/binary_io.h"
+
+namespace mobilerobotsim {
+
+namespace {
+
+// Upper bound on the number of buckets so degenerate inputs cannot exhaust memory
+constexpr double kMaxCells = 4.0 * 1024.0 * 1024.0;
+
+}  // namespace
+
+void UniformGridIndex::Build(const std::vector<Eigen::AlignedBox2d>& boxes, double cellSize) {
+  Clear();
+  boxes_ = boxes;
+
+  // Gather the bounded items and their union
+  double extentSum = 0.0;
+  size_t boundedCount = 0;
+  for (size_t id = 0; id < boxes_.size(); ++id) {
+    if (boxes_[id].isEmpty()) {
+      unboundedItems_.push_back(static_cast<uint32_t>(id));
+      continue;
+    }
+    bounds_.extend(boxes_[id]);
+    extentSum += boxes_[id].sizes().maxCoeff();
+    ++boundedCount;
+  }
+
+  if (boundedCount == 0) {
+    return;
+  }
+
+  // Pick the cell size, then grow it until the grid fits the bucket budget
+  const Eigen::Vector2d worldSize = bounds_.sizes().cwiseMax(1e-9);
+  if (cellSize <= 0.0) {
+    cellSize = std::max(extentSum / static_cast<double>(boundedCount), 1e-3);
+  }
+  while ((worldSize.x() / cellSize + 1.0) * (worldSize.y() / cellSize + 1.0) > kMaxCells) {
+    cellSize *= 2.0;
+  }
+
+  cellSize_ = cellSize;
+  columns_ = static_cast<int>(std::floor(worldSize.x() / cellSize_)) + 1;
+  rows_ = static_cast<int>(std::floor(worldSize.y() / cellSize_)) + 1;
+
+  // Counting pass, prefix sum, then fill pass
+  cellStart_.assign(static_cast<size_t>(columns_) * rows_ + 1, 0);
+  for (const auto& box : boxes_) {
+    if (box.isEmpty()) {
+      continue;
+    }
+    for (int r = RowOf(box.min().y()); r <= RowOf(box.max().y()); ++r) {
+      for (int c = ColumnOf(box.min().x()); c <= ColumnOf(box.max().x()); ++c) {
+        ++cellStart_[static_cast<size_t>(r) * columns_ + c + 1];
+      }
+    }
+  }
+
+  for (size_t cell = 1; cell < cellStart_.size(); ++cell) {
+    cellStart_[cell] += cellStart_[cell - 1];
+  }
+
+  cellItems_.resize(cellStart_.back());
+  std::vector<uint32_t> cursor(cellStart_.begin(), cellStart_.end() - 1);
+  for (size_t id = 0; id < boxes_.size(); ++id) {
+    const auto& box = boxes_[id];
+    if (box.isEmpty()) {
+      continue;
+    }
+    for (int r = RowOf(box.min().y()); r <= RowOf(box.max().y()); ++r) {
+      for (int c = ColumnOf(box.min().x()); c <= ColumnOf(box.max().x()); ++c) {
+        cellItems_[cursor[static_cast<size_t>(r) * columns_ + c]++] = static_cast<uint32_t>(id);
+      }
+    }
+  }
+}
+
+void UniformGridIndex::Clear() {
+  bounds_.setEmpty();
+  cellSize_ = 0.0;
+  columns_ = 0;
+  rows_ = 0;
+  boxes_.clear();
+  cellStart_.clear();
+  cellItems_.clear();
+  unboundedItems_.clear();
+}
+
+void UniformGridIndex::SaveBinary(BinaryWriter& writer) const {
+  // Empty boxes round-trip as their (inverted) corners
+  std::vector<double> corners;
+  corners.reserve(4 * boxes_.size() + 4);
+  for (const auto& box : boxes_) {
+    corners.insert(corners.end(), {box.min().x(), box.min().y(), box.max().x(), box.max().y()});
+  }
+  corners.insert(corners.end(),
+                 {bounds_.min().x(), bounds_.min().y(), bounds_.max().x(), bounds_.max().y()});
+
+  writer.WriteArray(corners);
+  writer.Write(cellSize_);
+  writer.Write(static_cast<int32_t>(columns_));
+  writer.Write(static_cast<int32_t>(rows_));
+  writer.WriteArray(cellStart_);
+  writer.WriteArray(cellItems_);
+  writer.WriteArray(unboundedItems_);
+}
+
+bool UniformGridIndex::LoadBinary(BinaryReader& reader) {
+  Clear();
+
+  std::vector<double> corners;
+  int32_t columns = 0;
+  int32_t rows = 0;
+  if (!reader.ReadArray(corners) || corners.size() % 4 != 0 || corners.empty() ||
+      !reader.Read(cellSize_) || !reader.Read(columns) || !reader.Read(rows) ||
+      !reader.ReadArray(cellStart_) || !reader.ReadArray(cellItems_) ||
+      !reader.ReadArray(unboundedItems_)) {
+    Clear();
+    return false;
+  }
+
+  const size_t itemCount = corners.size() / 4 - 1;
+  boxes_.resize(itemCount);
+  for (size_t id = 0; id <= itemCount; ++id) {
+    const Eigen::AlignedBox2d box(Eigen::Vector2d(corners[4 * id], corners[4 * id + 1]),
+                                  Eigen::Vector2d(corners[4 * id + 2], corners[4 * id + 3]));
+    (id < itemCount ? boxes_[id] : bounds_) = box;
+  }
+  columns_ = columns;
+  rows_ = rows;
+
+  // Every bucket range and item id must stay in bounds for the queries
+  const size_t cellCount = static_cast<size_t>(std::max(columns_, 0)) * std::max(rows_, 0);
+  bool consistent = columns_ >= 0 && rows_ >= 0 &&
+                    (cellCount == 0 ? cellStart_.empty() : cellStart_.size() == cellCount + 1) &&
+                    (cellCount == 0 || (cellSize_ > 0.0 && cellStart_.front() == 0 &&
+                                        cellStart_.back() == cellItems_.size()));
+  for (size_t cell = 1; consistent && cell < cellStart_.size(); ++cell) {
+    consistent = cellStart_[cell - 1] <= cellStart_[cell];
+  }
+  for (uint32_t id : cellItems_) {
+    consistent = consistent && id < itemCount;
+  }
+  for (uint32_t id : unboundedItems_) {
+    consistent = consistent && id < itemCount;
+  }
+
+  if (!consistent) {
+    Clear();
+  }
+  return consistent;
+}
+
+int UniformGridIndex::ColumnOf(double x) const {
+  const int column = static_cast<int>(std::floor((x - bounds_.min().x()) / cellSize_));
+  return std::clamp(column, 0, columns_ - 1);
+}
+
+int UniformGridIndex::RowOf(double y) const {
+  const int row = static_cast<int>(std::floor((y - bounds_.min().y()) / cellSize_));
+  return std::clamp(row, 0, rows_ - 1);
+}
+
+}  // namespace mobilerobotsim
@@ -0,0 +1,170 @@
+#include "mobilerobotsim/vector_engine.h"
+#include "mobilerobotsim/mobile_robot_base.h"
+#include "mobilerobotsim/simulation_observer.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace mobilerobotsim {
+
+/**
+ * @brief Counts an engine's events without asking for the step state.
+ */
+class VectorEngine::EventCounter : public SimulationObserver {
+ public:
+  void OnStep(const SystemState& /*state*/) override {}
+
+  void OnCollision(const MobileRobotBase* /*robot*/, const void* /*object*/) override {
+    ++events.collisions;
+  }
+
+  void OnMergePoint(const MobileRobotBase* /*robot*/,
+                    const EnvironmentElement* /*mergePoint*/) override {
+    ++events.mergePoints;
+  }
+
+  bool NeedsStepState() override { return false; }
+
+  VectorStepEvents events;  ///< Events since the last clear
+};
+
+VectorEngine::VectorEngine(size_t environmentCount, size_t agentCount, Factory factory,
+                           size_t threadCount)
+    : agentCount_(agentCount),
+      factory_(std::move(factory)),
+      maxEpisodeSteps_(0),
+      ready_(false),
+      instances_(environmentCount),
+      observations_(environmentCount * agentCount * kObservationSize, 0.0),
+      finalObservations_(environmentCount * agentCount * kObservationSize, 0.0),
+      rewards_(environmentCount, 0.0),
+      dones_(environmentCount, 0),
+      pool_(std::make_unique<ThreadPool>(threadCount)) {
+  for (Instance& instance : instances_) {
+    instance.counter = std::make_unique<EventCounter>();
+  }
+}
+
+VectorEngine::~VectorEngine() = default;
+
+void VectorEngine::SetRewardFunction(RewardFunction function) {
+  rewardFunction_ = std::move(function);
+}
+
+void VectorEngine::SetMaxEpisodeSteps(size_t steps) {
+  maxEpisodeSteps_ = steps;
+}
+
+bool VectorEngine::Reset(uint64_t seed) {
+  std::atomic<bool> failed(false);
+  pool_->ParallelFor(instances_.size(), [&](size_t begin, size_t end, size_t /*chunk*/) {
+    for (size_t i = begin; i < end; ++i) {
+      instances_[i].seeds = CounterRng(seed, i);
+      instances_[i].episodes = 0;
+      if (!ResetInstance(i)) {
+        failed = true;
+        continue;
+      }
+      Observe(i, observations_.data() + i * agentCount_ * kObservationSize);
+    }
+  });
+
+  std::fill(rewards_.begin(), rewards_.end(), 0.0);
+  std::fill(dones_.begin(), dones_.end(), 0);
+  ready_ = !failed;
+  return ready_;
+}
+
+bool VectorEngine::Step(const double* actions, size_t actionCount, double dt) {
+  if (!ready_ || actionCount != instances_.size() * agentCount_ * kActionSize) {
+    return false;
+  }
+
+  std::atomic<bool> failed(false);
+  pool_->ParallelFor(instances_.size(), [&](size_t begin, size_t end, size_t /*chunk*/) {
+    for (size_t i = begin; i < end; ++i) {
+      Instance& instance = instances_[i];
+      const double* action = actions + i * agentCount_ * kActionSize;
+      for (const RobotHandle& agent : instance.agents) {
+        MobileRobotBase* robot = instance.engine->GetRobot(agent);
+        if (robot != nullptr) {
+          robot->SetTargetVelocity(Eigen::Vector2d(action[0], action[1]));
+        }
+        action += kActionSize;
+      }
+
+      instance.counter->events = VectorStepEvents();
+      instance.engine->Step(dt);
+      ++instance.steps;
+
+      bool terminal = false;
+      rewards_[i] =
+          rewardFunction_ ? rewardFunction_(*instance.engine, instance.counter->events, terminal)
+                          : 0.0;
+      const bool done = terminal || (maxEpisodeSteps_ > 0 && instance.steps >= maxEpisodeSteps_);
+      dones_[i] = done ? 1 : 0;
+
+      double* observations = observations_.data() + i * agentCount_ * kObservationSize;
+      if (done) {
+        Observe(i, finalObservations_.data() + i * agentCount_ * kObservationSize);
+        if (!ResetInstance(i)) {
+          failed = true;
+          continue;
+        }
+      }
+      Observe(i, observations);
+    }
+  });
+
+  ready_ = !failed;
+  return ready_;
+}
+
+uint64_t VectorEngine::GetEpisodeCount() const {
+  uint64_t count = 0;
+  for (const Instance& instance : instances_) {
+    count += instance.episodes;
+  }
+  return count;
+}
+
+SimulationEngine* VectorEngine::GetEngine(size_t environment) const {
+  return environment < instances_.size() ? instances_[environment].engine.get() : nullptr;
+}
+
+bool VectorEngine::ResetInstance(size_t environment) {
+  Instance& instance = instances_[environment];
+  instance.engine = factory_(environment, instance.seeds.NextU64());
+  instance.agents.clear();
+  if (!instance.engine) {
+    return false;
+  }
+
+  instance.engine->RegisterObserver(instance.counter.get());
+  const size_t agents = std::min(agentCount_, instance.engine->GetRobotCount());
+  for (size_t i = 0; i < agents; ++i) {
+    instance.agents.push_back(instance.engine->GetRobotHandle(i));
+  }
+  instance.steps = 0;
+  ++instance.episodes;
+  return true;
+}
+
+void VectorEngine::Observe(size_t environment, double* observations) const {
+  const Instance& instance = instances_[environment];
+  std::fill(observations, observations + agentCount_ * kObservationSize, 0.0);
+  for (const RobotHandle& agent : instance.agents) {
+    const MobileRobotBase* robot = instance.engine->GetRobot(agent);
+    if (robot != nullptr) {
+      const Eigen::Vector2d position = robot->GetPosition();
+      const Eigen::Vector2d velocity = robot->GetVelocity();
+      observations[0] = position.x();
+      observations[1] = position.y();
+      observations[2] = velocity.x();
+      observations[3] = velocity.y();
+    }
+    observations += kObservationSize;
+  }
+}
+
+}  // namespace mobilerobotsim
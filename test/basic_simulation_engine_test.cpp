@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/basic_simulation_engine.h"
+#include "mobilerobotsim/simulation_engine.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/merge_point.h"
+
+#include <limits>
+#include <utility>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// Counts events and records which robots reported them
+class EventCounter : public SimulationObserver {
+ public:
+  void OnStep(const SystemState& state) override { robotStates = state.GetRobotStateCount(); }
+
+  void OnCollision(const MobileRobotBase* robot, const void* /*object*/) override {
+    robots.push_back(robot);
+  }
+
+  void OnMergePoint(const MobileRobotBase* robot,
+                    const EnvironmentElement* /*mergePoint*/) override {
+    robots.push_back(robot);
+  }
+
+  size_t robotStates = 0;
+  std::vector<const MobileRobotBase*> robots;
+};
+
+std::unique_ptr<Environment> MakeCrowdEnvironment() {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(5.0, 0.0, 1.5));
+  environment->AddElement(std::make_unique<DynamicObstacle>(12.0, 0.0, 1.0, -0.5, 0.0));
+  return environment;
+}
+
+// Steers towards the nearest other robot at the start of the step
+class Follower : public PointRobot {
+ public:
+  using PointRobot::PointRobot;
+  using PointRobot::UpdateState;
+
+  void UpdateState(double dt, const FleetView& fleet) override {
+    double nearest = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < fleet.size(); ++i) {
+      const Eigen::Vector2d offset = fleet.GetPosition(i) - GetPosition();
+      if (fleet.GetHandle(i) != GetHandle() && offset.norm() < nearest) {
+        nearest = offset.norm();
+        SetTargetVelocity(offset.x(), offset.y());
+      }
+    }
+    UpdateState(dt);
+  }
+};
+
+PointRobot MakeCrowdRobot(int i) {
+  PointRobot robot(0.0, 0.25 * (i % 32) - 4.0);
+  robot.SetTargetVelocity(1.0 + 0.01 * i, 0.02 * (i % 7) - 0.06);
+  robot.SetVelocityNoise(0.05);
+  return robot;
+}
+
+}  // namespace
+
+// A single-type fleet evolves exactly as in the polymorphic engine
+TEST(BasicSimulationEngineTest, MatchesSimulationEngine) {
+  SimulationEngine reference(MakeCrowdEnvironment());
+  reference.SetSeed(7);
+  for (int i = 0; i < 64; ++i) {
+    reference.AddRobot(std::make_unique<PointRobot>(MakeCrowdRobot(i)));
+  }
+
+  for (size_t threadCount : {1, 4}) {
+    BasicSimulationEngine<PointRobot> engine(MakeCrowdEnvironment());
+    engine.SetSeed(7);
+    engine.SetThreadCount(threadCount);
+    for (int i = 0; i < 64; ++i) {
+      EXPECT_EQ(engine.AddRobot(MakeCrowdRobot(i)), static_cast<size_t>(i));
+    }
+
+    for (int step = 0; step < 200; ++step) {
+      engine.Step(0.05);
+      if (threadCount == 1) {
+        reference.Step(0.05);
+      }
+    }
+    EXPECT_EQ(engine.ComputeStateHash(), reference.ComputeStateHash());
+  }
+}
+
+// Neighbour-aware robots see the whole fleet as the polymorphic engine shows it
+TEST(BasicSimulationEngineTest, PassesFleetView) {
+  SimulationEngine reference;
+  for (int i = 0; i < 16; ++i) {
+    reference.AddRobot(std::make_unique<Follower>(1.5 * i, (i * 5) % 7));
+  }
+
+  for (size_t threadCount : {1, 3}) {
+    BasicSimulationEngine<Follower, PointRobot> engine;
+    engine.SetThreadCount(threadCount);
+    for (int i = 0; i < 16; ++i) {
+      engine.AddRobot(Follower(1.5 * i, (i * 5) % 7));
+    }
+    for (int step = 0; step < 40; ++step) {
+      engine.Step(0.05);
+      if (threadCount == 1) {
+        reference.Step(0.05);
+      }
+    }
+    EXPECT_EQ(engine.ComputeStateHash(), reference.ComputeStateHash());
+    EXPECT_GT(engine.GetRobot<Follower>(15).GetVelocity().norm(), 0.0);
+  }
+}
+
+// Robots of several types are stepped and reported in type order
+TEST(BasicSimulationEngineTest, MixedRobotTypes) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(1.0, 0.0, 0.5));
+  BasicSimulationEngine<PointRobot, PointRobotF> engine(std::move(environment));
+
+  PointRobotF single(0.0f, 0.0f);
+  single.SetTargetVelocity(1.0f, 0.0f);
+  PointRobot reference(0.0, 0.0);
+  reference.SetTargetVelocity(1.0, 0.0);
+  engine.AddRobot(single);
+  engine.AddRobot(reference);
+  engine.AddRobot(PointRobot(5.0, 5.0));
+  EXPECT_EQ(engine.GetRobotCount(), 3u);
+  EXPECT_EQ(engine.GetRobotCount<PointRobot>(), 2u);
+  EXPECT_EQ(engine.GetRobotCount<PointRobotF>(), 1u);
+
+  EventCounter counter;
+  engine.RegisterObserver(&counter);
+  for (int step = 0; step < 20; ++step) {
+    engine.Step(0.1);
+  }
+
+  ASSERT_EQ(counter.robots.size(), 2u);
+  EXPECT_EQ(counter.robots[0], &engine.GetRobot<PointRobot>(0));
+  EXPECT_EQ(counter.robots[1], &engine.GetRobot<PointRobotF>(0));
+  EXPECT_EQ(counter.robotStates, 3u);
+  EXPECT_NEAR(engine.GetRobot<PointRobotF>(0).GetPosition().x(),
+              engine.GetRobot<PointRobot>(0).GetPosition().x(), 1e-5);
+
+  const auto state = engine.GetState();
+  ASSERT_EQ(state->GetRobotStateCount(), 3u);
+  EXPECT_EQ(state->GetRobotState(0)->GetTypeId(), "PointRobotState");
+  EXPECT_EQ(state->GetRobotState(2)->GetTypeId(), "PointRobotStateF");
+
+  size_t visited = 0;
+  engine.ForEachRobot([&](auto& robot) { visited += robot.IsAtRest() ? 0 : 1; });
+  EXPECT_EQ(visited, 2u);
+
+  EXPECT_TRUE(engine.RemoveRobot<PointRobot>(1));
+  EXPECT_FALSE(engine.RemoveRobot<PointRobotF>(1));
+  EXPECT_EQ(engine.GetRobotCount(), 2u);
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
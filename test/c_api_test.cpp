@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/c_api.h"
+
+#include <cstdio>
+#include <string>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+double At(const mrs_buffer& buffer, int64_t i, int64_t j) {
+  const char* element =
+      static_cast<const char*>(buffer.data) + i * buffer.strides[0] + j * buffer.strides[1];
+  return *reinterpret_cast<const double*>(element);
+}
+
+}  // namespace
+
+// Test that the fleet is exported in place with shape and strides a host can wrap
+TEST(CApiTest, ExportsFleetBuffers) {
+  EXPECT_EQ(mrs_api_version(), static_cast<uint32_t>(MRS_API_VERSION));
+  mrs_engine* engine = mrs_engine_create();
+  ASSERT_NE(engine, nullptr);
+
+  mrs_buffer positions{};
+  ASSERT_TRUE(mrs_engine_get_positions(engine, &positions));
+  EXPECT_EQ(positions.shape[0], 0);
+  EXPECT_EQ(positions.data, nullptr);
+
+  mrs_robot_handle handles[3];
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(mrs_engine_add_point_robot(engine, i, -i, 0.5 * i, 1.0, 0.0, &handles[i]));
+  }
+  EXPECT_EQ(mrs_engine_get_robot_count(engine), 3u);
+
+  // Robots added since the last step are exported too
+  ASSERT_TRUE(mrs_engine_get_positions(engine, &positions));
+  EXPECT_EQ(positions.dtype, MRS_FLOAT64);
+  EXPECT_EQ(positions.ndim, 2);
+  EXPECT_EQ(positions.shape[0], 3);
+  EXPECT_EQ(positions.shape[1], 2);
+  EXPECT_EQ(positions.strides[1], static_cast<int64_t>(sizeof(double)));
+  EXPECT_DOUBLE_EQ(At(positions, 2, 0), 2.0);
+  EXPECT_DOUBLE_EQ(At(positions, 2, 1), -2.0);
+  mrs_buffer orientations{};
+  ASSERT_TRUE(mrs_engine_get_orientations(engine, &orientations));
+  EXPECT_EQ(orientations.ndim, 1);
+  EXPECT_EQ(orientations.shape[0], 3);
+  EXPECT_DOUBLE_EQ(At(orientations, 2, 0), 1.0);
+
+  ASSERT_TRUE(mrs_engine_step(engine, 0.5));
+  EXPECT_DOUBLE_EQ(mrs_engine_get_time(engine), 0.5);
+  ASSERT_TRUE(mrs_engine_get_positions(engine, &positions));
+  mrs_buffer velocities{};
+  mrs_buffer exported{};
+  ASSERT_TRUE(mrs_engine_get_velocities(engine, &velocities));
+  ASSERT_TRUE(mrs_engine_get_orientations(engine, &orientations));
+  ASSERT_TRUE(mrs_engine_get_handles(engine, &exported));
+  for (int64_t i = 0; i < 3; ++i) {
+    EXPECT_DOUBLE_EQ(At(positions, i, 0), i + 0.5);
+    EXPECT_DOUBLE_EQ(At(velocities, i, 0), 1.0);
+    EXPECT_DOUBLE_EQ(At(orientations, i, 0), 0.0);  // Heading follows the velocity
+    const auto* handle = reinterpret_cast<const uint32_t*>(
+        static_cast<const char*>(exported.data) + i * exported.strides[0]);
+    EXPECT_EQ(handle[0], handles[i].index);
+    EXPECT_EQ(handle[1], handles[i].generation);
+  }
+  EXPECT_EQ(exported.dtype, MRS_UINT32);
+
+  // Removing a robot swaps the last one into its place
+  ASSERT_TRUE(mrs_engine_remove_robot(engine, handles[0]));
+  EXPECT_FALSE(mrs_engine_remove_robot(engine, handles[0]));
+  ASSERT_TRUE(mrs_engine_get_positions(engine, &positions));
+  EXPECT_EQ(positions.shape[0], 2);
+  EXPECT_DOUBLE_EQ(At(positions, 0, 0), 2.5);
+
+  mrs_engine_destroy(engine);
+  mrs_engine_destroy(nullptr);
+}
+
+// Test that commands and state files work through the C interface
+TEST(CApiTest, CommandsAndStateFiles) {
+  mrs_engine* engine = mrs_engine_create();
+  mrs_robot_handle robot{};
+  ASSERT_TRUE(mrs_engine_add_point_robot(engine, 0.0, 0.0, 0.0, 0.0, 0.0, &robot));
+  ASSERT_TRUE(mrs_engine_set_thread_count(engine, 2));
+  ASSERT_TRUE(mrs_engine_schedule_target_velocity(engine, 1.0, robot, 0.0, 2.0));
+  EXPECT_FALSE(mrs_engine_set_target_velocity(engine, {robot.index + 1, 0}, 1.0, 0.0));
+
+  ASSERT_TRUE(mrs_engine_advance_to(engine, 1.0, 1e-3, 0.25));
+  mrs_buffer velocities{};
+  ASSERT_TRUE(mrs_engine_get_velocities(engine, &velocities));
+  EXPECT_DOUBLE_EQ(At(velocities, 0, 1), 0.0);
+  for (int step = 0; step < 200; ++step) {
+    ASSERT_TRUE(mrs_engine_step(engine, 0.05));
+  }
+  ASSERT_TRUE(mrs_engine_get_velocities(engine, &velocities));
+  EXPECT_NEAR(At(velocities, 0, 1), 2.0, 1e-6);
+
+  const std::string path = ::testing::TempDir() + "c_api_state.json";
+  ASSERT_TRUE(mrs_engine_save_state(engine, path.c_str()));
+  ASSERT_TRUE(mrs_engine_set_target_velocity(engine, robot, 0.0, 0.0));
+  mrs_engine* restored = mrs_engine_create();
+  ASSERT_TRUE(mrs_engine_load_state(restored, path.c_str()));
+  EXPECT_DOUBLE_EQ(mrs_engine_get_time(restored), mrs_engine_get_time(engine));
+  mrs_buffer positions{};
+  mrs_buffer restoredPositions{};
+  ASSERT_TRUE(mrs_engine_get_positions(engine, &positions));
+  ASSERT_TRUE(mrs_engine_get_positions(restored, &restoredPositions));
+  EXPECT_DOUBLE_EQ(At(restoredPositions, 0, 1), At(positions, 0, 1));
+  EXPECT_FALSE(mrs_engine_load_state(restored, nullptr));
+
+  std::remove(path.c_str());
+  mrs_engine_destroy(restored);
+  mrs_engine_destroy(engine);
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
@@ -4,6 +4,32 @@
 namespace mobilerobotsim {
 namespace testing {
 
+// Axis-aligned box element for testing; counts how often it is updated
+class TestBoxElement : public EnvironmentElement {
+ public:
+  TestBoxElement(const Eigen::AlignedBox2d& box, bool dynamic) : box_(box), dynamic_(dynamic) {}
+
+  std::string GetTypeId() const override { return "TestBoxElement"; }
+  bool CheckCollision(const Eigen::Vector2d& position) const override {
+    return box_.contains(position);
+  }
+  std::string GetState() const override { return "{}"; }
+  bool LoadState(const std::string& /*state*/) override { return true; }
+  bool IsDynamic() const override { return dynamic_; }
+  void Update(double dt) override {
+    ++updateCount_;
+    box_.translate(Eigen::Vector2d(dt, 0.0));
+  }
+  Eigen::AlignedBox2d GetBounds() const override { return box_; }
+
+  int GetUpdateCount() const { return updateCount_; }
+
+ private:
+  Eigen::AlignedBox2d box_;
+  bool dynamic_;
+  int updateCount_ = 0;
+};
+
 // Basic test for environment creation
 TEST(EnvironmentTest, Creation) {
   auto env = std::make_unique<Environment>();
@@ -39,6 +65,70 @@ TEST(EnvironmentTest, StateManagement) {
   EXPECT_FALSE(state.GetElementState(2, typeId, elementState));
 }
 
+// Test that only dynamic elements are updated
+TEST(EnvironmentTest, StaticDynamicPartitioning) {
+  Environment env;
+
+  auto wall = std::make_unique<TestBoxElement>(
+      Eigen::AlignedBox2d(Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(1.0, 10.0)), false);
+  auto cart = std::make_unique<TestBoxElement>(
+      Eigen::AlignedBox2d(Eigen::Vector2d(5.0, 0.0), Eigen::Vector2d(6.0, 1.0)), true);
+  const TestBoxElement* wallPtr = wall.get();
+  const TestBoxElement* cartPtr = cart.get();
+  env.AddElement(std::move(wall));
+  env.AddElement(std::move(cart));
+
+  EXPECT_EQ(env.GetStaticElementCount(), 1);
+  EXPECT_EQ(env.GetDynamicElementCount(), 1);
+
+  env.Update(1.0);
+  env.Update(1.0);
+  EXPECT_EQ(wallPtr->GetUpdateCount(), 0);
+  EXPECT_EQ(cartPtr->GetUpdateCount(), 2);
+
+  // The dynamic element has moved two meters along x
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(5.5, 0.5)), nullptr);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(7.5, 0.5)), cartPtr);
+  EXPECT_EQ(env.CheckDynamicCollision(Eigen::Vector2d(0.5, 5.0)), nullptr);
+  EXPECT_EQ(env.CheckStaticCollision(Eigen::Vector2d(0.5, 5.0)), wallPtr);
+}
+
+// Test the one-time static index build
+TEST(EnvironmentTest, StaticIndex) {
+  Environment env;
+  for (int i = 0; i < 100; ++i) {
+    const Eigen::Vector2d corner(2.0 * i, 0.0);
+    env.AddElement(std::make_unique<TestBoxElement>(
+        Eigen::AlignedBox2d(corner, corner + Eigen::Vector2d(1.0, 1.0)), false));
+  }
+
+  EXPECT_FALSE(env.HasStaticIndex());
+  const EnvironmentElement* linearHit = env.CheckCollision(Eigen::Vector2d(100.5, 0.5));
+  EXPECT_NE(linearHit, nullptr);
+
+  env.BuildStaticIndex();
+  EXPECT_TRUE(env.HasStaticIndex());
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(100.5, 0.5)), linearHit);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(101.5, 0.5)), nullptr);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(-5.0, 0.5)), nullptr);
+
+  // Single-precision queries take the same path
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2f(100.5f, 0.5f)), linearHit);
+  Eigen::Matrix2Xf positions(2, 2);
+  positions << 100.5f, 101.5f, 0.5f, 0.5f;
+  std::vector<const EnvironmentElement*> hits;
+  env.CheckCollisionBatch(positions, hits);
+  ASSERT_EQ(hits.size(), 2u);
+  EXPECT_EQ(hits[0], linearHit);
+  EXPECT_EQ(hits[1], nullptr);
+
+  // Adding static geometry invalidates the index but keeps queries correct
+  env.AddElement(std::make_unique<TestBoxElement>(
+      Eigen::AlignedBox2d(Eigen::Vector2d(-6.0, 0.0), Eigen::Vector2d(-4.0, 1.0)), false));
+  EXPECT_FALSE(env.HasStaticIndex());
+  EXPECT_NE(env.CheckCollision(Eigen::Vector2d(-5.0, 0.5)), nullptr);
+}
+
 // Test serialization (basic functionality)
 TEST(EnvironmentTest, Serialization) {
   EnvironmentState state;
@@ -49,6 +139,14 @@ TEST(EnvironmentTest, Serialization) {
   
   EnvironmentState newState;
   EXPECT_TRUE(newState.Deserialize(serialized));
+  ASSERT_EQ(newState.GetElementStateCount(), 1u);
+  std::string typeId;
+  std::string elementState;
+  ASSERT_TRUE(newState.GetElementState(0, typeId, elementState));
+  EXPECT_EQ(typeId, "TestElement");
+  EXPECT_EQ(elementState, "TestState");
+
+  EXPECT_FALSE(newState.Deserialize("{\"elements\": [{\"state\": 1}]}"));
 }
 
 } // namespace testing
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/loose_quadtree.h"
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+Eigen::AlignedBox2d MakeBox(const Eigen::Vector2d& center, double halfExtent) {
+  const Eigen::Vector2d extent(halfExtent, halfExtent);
+  return Eigen::AlignedBox2d(center - extent, center + extent);
+}
+
+}  // namespace
+
+// Test that queries match a brute-force scan while items move
+TEST(LooseQuadtreeTest, MatchesBruteForceUnderMotion) {
+  const Eigen::AlignedBox2d world(Eigen::Vector2d(-100.0, -100.0), Eigen::Vector2d(100.0, 100.0));
+  LooseQuadtree tree(world);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> coordinate(-120.0, 120.0);
+  std::uniform_real_distribution<double> size(0.1, 5.0);
+  std::uniform_real_distribution<double> step(-3.0, 3.0);
+
+  std::vector<Eigen::AlignedBox2d> boxes;
+  for (uint32_t id = 0; id < 200; ++id) {
+    boxes.push_back(MakeBox(Eigen::Vector2d(coordinate(rng), coordinate(rng)), size(rng)));
+    tree.Insert(id, boxes.back());
+  }
+  EXPECT_EQ(tree.GetItemCount(), 200);
+
+  for (int iteration = 0; iteration < 20; ++iteration) {
+    for (uint32_t id = 0; id < boxes.size(); ++id) {
+      boxes[id].translate(Eigen::Vector2d(step(rng), step(rng)));
+      tree.Update(id, boxes[id]);
+    }
+
+    for (int query = 0; query < 50; ++query) {
+      const Eigen::Vector2d point(coordinate(rng), coordinate(rng));
+      std::vector<uint32_t> expected;
+      for (uint32_t id = 0; id < boxes.size(); ++id) {
+        if (boxes[id].contains(point)) {
+          expected.push_back(id);
+        }
+      }
+
+      std::vector<uint32_t> found;
+      tree.QueryPoint(point, [&](uint32_t id) {
+        found.push_back(id);
+        return false;
+      });
+      std::sort(found.begin(), found.end());
+      EXPECT_EQ(found, expected);
+
+      const Eigen::AlignedBox2d region = MakeBox(point, 10.0);
+      size_t expectedInBox = 0;
+      for (const auto& box : boxes) {
+        expectedInBox += box.intersects(region) ? 1 : 0;
+      }
+      size_t foundInBox = 0;
+      tree.QueryBox(region, [&](uint32_t) {
+        ++foundInBox;
+        return false;
+      });
+      EXPECT_EQ(foundInBox, expectedInBox);
+    }
+  }
+
+  // Removed items are no longer reported
+  EXPECT_TRUE(tree.Remove(0));
+  EXPECT_FALSE(tree.Remove(0));
+  bool reported = false;
+  tree.QueryBox(world, [&](uint32_t id) {
+    reported = reported || id == 0;
+    return false;
+  });
+  EXPECT_FALSE(reported);
+  EXPECT_EQ(tree.GetItemCount(), 199);
+}
+
+// Test moving obstacles through the environment
+TEST(LooseQuadtreeTest, EnvironmentDynamicObstacles) {
+  Environment env;
+  auto forklift = std::make_unique<DynamicObstacle>(0.0, 0.0, 0.5, 1.0, 0.0);
+  const DynamicObstacle* forkliftPtr = forklift.get();
+  env.AddElement(std::move(forklift));
+  env.AddElement(std::make_unique<DynamicObstacle>(10.0, 10.0, 0.3));
+
+  EXPECT_EQ(env.GetDynamicElementCount(), 2);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(0.0, 0.0)), forkliftPtr);
+
+  for (int i = 0; i < 50; ++i) {
+    env.Update(0.1);
+  }
+
+  EXPECT_NEAR(forkliftPtr->GetPosition().x(), 5.0, 1e-9);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(0.0, 0.0)), nullptr);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(5.2, 0.0)), forkliftPtr);
+  EXPECT_NE(env.CheckCollision(Eigen::Vector2d(10.0, 10.2)), nullptr);
+
+  // Moving the world bounds re-indexes the existing obstacles
+  env.SetWorldBounds(Eigen::AlignedBox2d(Eigen::Vector2d(-10.0, -10.0), Eigen::Vector2d(20.0, 20.0)));
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(5.2, 0.0)), forkliftPtr);
+
+  // State round trip
+  DynamicObstacle copy(0.0, 0.0, 1.0);
+  EXPECT_TRUE(copy.LoadState(forkliftPtr->GetState()));
+  EXPECT_NEAR(copy.GetPosition().x(), 5.0, 1e-9);
+  EXPECT_DOUBLE_EQ(copy.GetRadius(), 0.5);
+  EXPECT_FALSE(copy.LoadState("not json"));
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/merge_strategy.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/simulation_engine.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// Appends a robot heading for the origin at a speed, from a distance along a direction
+void AddApproach(MergeBatch& batch, const Eigen::Vector2d& direction, double distance,
+                 double speed) {
+  const Eigen::Vector2d cruise = direction.normalized() * speed;
+  batch.handles.push_back(RobotHandle());
+  batch.positions.push_back(-direction.normalized() * distance);
+  batch.velocities.push_back(cruise);
+  batch.cruiseVelocities.push_back(cruise);
+  batch.distances.push_back(distance);
+  batch.targetVelocities.push_back(cruise);
+}
+
+// Time at which a robot reaches the centre at its target velocity
+double Arrival(const MergeBatch& batch, size_t i) {
+  return batch.distances[i] / batch.targetVelocities[i].norm();
+}
+
+// Runs two crossing lanes of robots and returns the closest approach of any two robots
+double RunCrossing(std::unique_ptr<MergeStrategy> strategy, std::vector<Eigen::Vector2d>* targets) {
+  auto environment = std::make_unique<Environment>();
+  auto mergePoint = std::make_unique<MergePoint>(10.0, 0.0, 1.0);
+  const MergePoint& merge = *mergePoint;
+  environment->AddElement(std::move(mergePoint));
+  SimulationEngine engine(std::move(environment));
+  engine.SetThreadCount(2);
+  if (strategy != nullptr) {
+    EXPECT_TRUE(engine.SetMergeStrategy(merge, std::move(strategy), 8.0));
+  }
+
+  // Pairs of robots, one from each lane, would reach the centre together
+  std::vector<RobotHandle> handles;
+  for (int i = 0; i < 4; ++i) {
+    handles.push_back(engine.AddRobot(std::make_unique<PointRobot>(5.0 - 3.0 * i, 0.0, 0.0,
+                                                                   1.0, 0.0)));
+    handles.push_back(engine.AddRobot(std::make_unique<PointRobot>(10.0, -5.0 - 3.0 * i, 0.0,
+                                                                   0.0, 1.0)));
+  }
+
+  double closest = std::numeric_limits<double>::infinity();
+  for (int step = 0; step < 600; ++step) {
+    engine.Step(0.05);
+    for (size_t a = 0; a < handles.size(); ++a) {
+      for (size_t b = a + 1; b < handles.size(); ++b) {
+        const Eigen::Vector2d offset =
+            engine.GetRobot(handles[a])->GetPosition() - engine.GetRobot(handles[b])->GetPosition();
+        closest = std::min(closest, offset.norm());
+      }
+    }
+  }
+
+  for (const RobotHandle& handle : handles) {
+    targets->push_back(engine.GetRobot(handle)->GetTargetVelocity());
+  }
+  return closest;
+}
+
+}  // namespace
+
+// Test that the zipper strategy spaces arrivals by the headway in arrival order
+TEST(MergeStrategyTest, ZipperSpacesArrivals) {
+  MergeBatch batch;
+  AddApproach(batch, Eigen::Vector2d(1.0, 0.0), 4.0, 1.0);
+  AddApproach(batch, Eigen::Vector2d(0.0, 1.0), 4.0, 1.0);
+  AddApproach(batch, Eigen::Vector2d(1.0, 0.0), 10.0, 1.0);
+  AddApproach(batch, Eigen::Vector2d(0.0, 1.0), -1.0, 1.0);
+
+  ZipperMergeStrategy strategy(2.0);
+  strategy.ComputeBatch(batch);
+
+  // The robot past the centre holds slot -1, so the first one arrives at 4
+  // at cruise speed and the tie is broken by batch position
+  EXPECT_EQ(batch.targetVelocities[0], batch.cruiseVelocities[0]);
+  EXPECT_NEAR(Arrival(batch, 1), 6.0, 1e-12);
+  EXPECT_NEAR(Arrival(batch, 2), 10.0, 1e-12);
+  EXPECT_EQ(batch.targetVelocities[3], batch.cruiseVelocities[3]);
+
+  // Robots only ever slow down along their own direction
+  EXPECT_NEAR(batch.targetVelocities[1].x(), 0.0, 1e-12);
+  EXPECT_LT(batch.targetVelocities[1].norm(), 1.0);
+}
+
+// Test that the priority lane keeps cruising and the other lane yields into gaps
+TEST(MergeStrategyTest, PriorityLaneHasRightOfWay) {
+  MergeBatch batch;
+  AddApproach(batch, Eigen::Vector2d(0.0, 1.0), 3.0, 1.0);   // Yields
+  AddApproach(batch, Eigen::Vector2d(1.0, 0.0), 3.5, 1.0);   // Priority
+  AddApproach(batch, Eigen::Vector2d(1.0, 0.1), 7.0, 1.0);   // Priority
+  AddApproach(batch, Eigen::Vector2d(0.0, 1.0), 6.0, 1.0);   // Yields
+
+  PriorityMergeStrategy strategy(Eigen::Vector2d(2.0, 0.0), 1.0);
+  strategy.ComputeBatch(batch);
+
+  EXPECT_EQ(batch.targetVelocities[1], batch.cruiseVelocities[1]);
+  EXPECT_EQ(batch.targetVelocities[2], batch.cruiseVelocities[2]);
+
+  // The first yielding robot waits for the gap behind the priority robot at
+  // 3.5; the second one fits between 4.5 and the priority robot at 7
+  EXPECT_NEAR(Arrival(batch, 0), 4.5, 1e-12);
+  EXPECT_NEAR(Arrival(batch, 3), 6.0, 1e-12);
+}
+
+// Test that the engine runs strategies before the update and restores cruise velocities
+TEST(MergeStrategyTest, EngineSeparatesCrossingLanes) {
+  std::vector<Eigen::Vector2d> uncontrolledTargets;
+  const double uncontrolled = RunCrossing(nullptr, &uncontrolledTargets);
+  EXPECT_LT(uncontrolled, 0.1);
+
+  std::vector<Eigen::Vector2d> controlledTargets;
+  const double controlled =
+      RunCrossing(std::make_unique<ZipperMergeStrategy>(1.5), &controlledTargets);
+  EXPECT_GT(controlled, 0.5);
+
+  // Every robot is past the approach again and cruising as before
+  EXPECT_EQ(controlledTargets, uncontrolledTargets);
+}
+
+// Test that merge strategies can be replaced and removed
+TEST(MergeStrategyTest, EngineReplacesAndRemovesStrategies) {
+  auto environment = std::make_unique<Environment>();
+  auto mergePoint = std::make_unique<MergePoint>(0.0, 0.0, 1.0);
+  const MergePoint& merge = *mergePoint;
+  environment->AddElement(std::move(mergePoint));
+  SimulationEngine engine(std::move(environment));
+
+  EXPECT_FALSE(engine.SetMergeStrategy(merge, std::make_unique<ZipperMergeStrategy>(1.0), 0.0));
+  EXPECT_FALSE(engine.SetMergeStrategy(merge, nullptr, 5.0));
+  EXPECT_TRUE(engine.SetMergeStrategy(merge, std::make_unique<ZipperMergeStrategy>(1.0), 5.0));
+
+  // Two robots tied for the centre; one of them is slowed down
+  const RobotHandle first = engine.AddRobot(std::make_unique<PointRobot>(-2.0, 0.0, 0.0, 1.0, 0.0));
+  const RobotHandle second = engine.AddRobot(std::make_unique<PointRobot>(0.0, -2.0, 0.0, 0.0, 1.0));
+  engine.Step(0.05);
+  EXPECT_EQ(engine.GetRobot(first)->GetTargetVelocity(), Eigen::Vector2d(1.0, 0.0));
+  EXPECT_LT(engine.GetRobot(second)->GetTargetVelocity().y(), 1.0);
+
+  // Removing the strategy hands the cruise velocity back
+  EXPECT_TRUE(engine.SetMergeStrategy(merge, nullptr, 5.0));
+  EXPECT_EQ(engine.GetRobot(second)->GetTargetVelocity(), Eigen::Vector2d(0.0, 1.0));
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
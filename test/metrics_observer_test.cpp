@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/metrics_observer.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/simulation_engine.h"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mobilerobotsim {
+namespace testing {
+
+// Test the streaming statistics against exact values
+TEST(MetricsObserverTest, StreamingStatistics) {
+  RunningStats stats;
+  LogHistogram histogram(1e-3, 1e6);
+  EXPECT_DOUBLE_EQ(histogram.GetQuantile(0.5), 0.0);
+  for (int i = 1; i <= 1000; ++i) {
+    stats.Add(i);
+    histogram.Add(i);
+  }
+  EXPECT_EQ(stats.GetCount(), 1000u);
+  EXPECT_DOUBLE_EQ(stats.GetMean(), 500.5);
+  EXPECT_NEAR(stats.GetVariance(), 1000.0 * 1001.0 / 12.0, 1e-6);
+  EXPECT_DOUBLE_EQ(stats.GetMin(), 1.0);
+  EXPECT_DOUBLE_EQ(stats.GetMax(), 1000.0);
+
+  // Quantiles are accurate to about one part in 32
+  EXPECT_NEAR(histogram.GetQuantile(0.5), 500.0, 500.0 / 32);
+  EXPECT_NEAR(histogram.GetQuantile(0.99), 990.0, 990.0 / 32);
+  EXPECT_NEAR(histogram.GetQuantile(0.0), 1.0, 1.0 / 32);
+
+  // A large offset does not cancel the variance
+  RunningStats offset;
+  for (const double value : {4.0, 7.0, 13.0, 16.0}) {
+    offset.Add(1e9 + value);
+  }
+  EXPECT_NEAR(offset.GetVariance(), 30.0, 1e-6);
+
+  stats.Reset();
+  histogram.Reset();
+  EXPECT_EQ(stats.GetCount(), 0u);
+  EXPECT_EQ(histogram.GetCount(), 0u);
+}
+
+// Test merge waits, zones, collisions and periodic snapshots of a small run
+TEST(MetricsObserverTest, CollectsRunMetrics) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(5.0, 0.0, 1.0));
+  environment->AddElement(std::make_unique<DynamicObstacle>(3.0, -5.0, 1.0, 0.0, 0.0));
+  SimulationEngine engine(std::move(environment));
+
+  // One robot waits two seconds before driving off, one drives right away
+  // and one runs into the obstacle
+  const RobotHandle waiting =
+      engine.AddRobot(std::make_unique<PointRobot>(0.0, 0.0, 0.0, 0.0, 0.0));
+  engine.AddRobot(std::make_unique<PointRobot>(0.0, 0.5, 0.0, 1.0, 0.0));
+  engine.AddRobot(std::make_unique<PointRobot>(0.0, -5.0, 0.0, 1.0, 0.0));
+  engine.ScheduleCommand(2.0, waiting, [](MobileRobotBase& robot) {
+    robot.SetTargetVelocity(Eigen::Vector2d(1.0, 0.0));
+  });
+
+  MetricsObserver metrics;
+  metrics.AddZone("start", Eigen::AlignedBox2d(Eigen::Vector2d(-1.0, -1.0),
+                                               Eigen::Vector2d(1.0, 1.0)));
+  metrics.AddZone("obstacle", Eigen::AlignedBox2d(Eigen::Vector2d(0.0, -7.0),
+                                                  Eigen::Vector2d(6.0, -3.0)));
+  std::vector<MetricsSnapshot> snapshots;
+  metrics.SetSnapshotInterval(
+      1.0, [&](const MetricsSnapshot& snapshot) { snapshots.push_back(snapshot); });
+  engine.RegisterObserver(&metrics);
+  for (int step = 0; step < 80; ++step) {
+    engine.Step(0.125);
+  }
+
+  ASSERT_EQ(snapshots.size(), 10u);
+  EXPECT_DOUBLE_EQ(snapshots[0].time, 1.0);
+  EXPECT_DOUBLE_EQ(snapshots[9].time, 10.0);
+  EXPECT_EQ(snapshots[9].steps, 80u);
+
+  const MetricsSnapshot snapshot = metrics.GetSnapshot();
+  EXPECT_DOUBLE_EQ(snapshot.elapsed, 10.0);
+  EXPECT_EQ(snapshot.robots, 3u);
+  EXPECT_EQ(snapshot.speed.count, 240u);
+  EXPECT_LE(snapshot.speed.max, 1.0 + 1e-9);
+  EXPECT_EQ(snapshot.mergeArrivals, 2u);
+  EXPECT_DOUBLE_EQ(snapshot.throughput, 0.2);
+
+  // The waiting robot stood for two seconds plus the first 0.1 m/s of its start
+  ASSERT_EQ(snapshot.mergeWait.count, 2u);
+  EXPECT_DOUBLE_EQ(snapshot.mergeWait.min, 0.0);
+  EXPECT_NEAR(snapshot.mergeWait.max, 2.1, 0.125);
+
+  // Robots spent about 1 + 2 + sqrt(2) seconds in the start zone
+  ASSERT_EQ(snapshot.zones.size(), 2u);
+  EXPECT_EQ(snapshot.zones[0].name, "start");
+  EXPECT_NEAR(snapshot.zones[0].meanOccupancy * snapshot.elapsed, 3.0 + std::sqrt(2.0), 0.25);
+  EXPECT_EQ(snapshot.zones[0].mergeArrivals, 0u);
+  EXPECT_GT(snapshot.collisions, 0u);
+  EXPECT_EQ(snapshot.zones[1].collisions, snapshot.collisions);
+  EXPECT_DOUBLE_EQ(snapshot.collisionRate, snapshot.collisions / 30.0);
+
+  std::ostringstream json;
+  ASSERT_TRUE(snapshot.WriteJson(json));
+  EXPECT_NE(json.str().find("\"mergeWait\":{\"count\":2,"), std::string::npos);
+  EXPECT_NE(json.str().find("\"name\":\"obstacle\""), std::string::npos);
+
+  metrics.Reset(engine.GetTime());
+  engine.Step(0.125);
+  const MetricsSnapshot restarted = metrics.GetSnapshot();
+  EXPECT_EQ(restarted.steps, 1u);
+  EXPECT_DOUBLE_EQ(restarted.elapsed, 0.125);
+  EXPECT_EQ(restarted.mergeWait.count, 0u);
+  engine.UnregisterObserver(&metrics);
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
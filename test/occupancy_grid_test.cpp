@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/occupancy_grid.h"
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// Writes a PGM whose pixel (column x, image row r) is black when predicate(x, r) holds
+template <typename Predicate>
+std::string WritePgm(const std::string& name, int width, int height, Predicate predicate) {
+  const std::string path = ::testing::TempDir() + name;
+  std::ofstream file(path, std::ios::binary);
+  file << "P5\n# test map\n" << width << " " << height << "\n255\n";
+  for (int row = 0; row < height; ++row) {
+    for (int x = 0; x < width; ++x) {
+      file.put(predicate(x, row) ? static_cast<char>(0) : static_cast<char>(254));
+    }
+  }
+  return path;
+}
+
+}  // namespace
+
+// Test loading a PGM map and point lookups
+TEST(OccupancyGridTest, LoadPgm) {
+  // A wall along the top image row and a single pixel at column 70
+  const std::string path = WritePgm("occupancy_grid_test.pgm", 100, 20, [](int x, int row) {
+    return row == 0 || (x == 70 && row == 10);
+  });
+
+  OccupancyGrid grid;
+  ASSERT_TRUE(grid.LoadPgm(path, 0.5, Eigen::Vector2d(-10.0, 0.0)));
+  EXPECT_EQ(grid.GetWidth(), 100);
+  EXPECT_EQ(grid.GetHeight(), 20);
+
+  // The top image row is the last grid row
+  EXPECT_TRUE(grid.IsOccupied(0, 19));
+  EXPECT_TRUE(grid.IsOccupied(99, 19));
+  EXPECT_FALSE(grid.IsOccupied(0, 0));
+  EXPECT_TRUE(grid.IsOccupied(70, 9));
+  EXPECT_FALSE(grid.IsOccupied(69, 9));
+  EXPECT_FALSE(grid.IsOccupied(-1, 19));
+  EXPECT_FALSE(grid.IsOccupied(100, 19));
+
+  // World lookups account for origin and resolution
+  EXPECT_TRUE(grid.CheckCollision(Eigen::Vector2d(-10.0 + 35.25, 4.75)));
+  EXPECT_FALSE(grid.CheckCollision(Eigen::Vector2d(-10.0 + 34.75, 4.75)));
+  EXPECT_FALSE(grid.CheckCollision(Eigen::Vector2d(1000.0, 1000.0)));
+
+  OccupancyGrid broken;
+  EXPECT_FALSE(broken.LoadPgm(::testing::TempDir() + "missing.pgm", 1.0, Eigen::Vector2d::Zero()));
+}
+
+// Test the raw format round trip and zero-copy mapping
+TEST(OccupancyGridTest, RawRoundTrip) {
+  OccupancyGrid grid(130, 70, 0.1, Eigen::Vector2d(1.0, 2.0));
+  grid.SetOccupied(0, 0, true);
+  grid.SetOccupied(129, 69, true);
+  grid.SetOccupied(64, 33, true);
+  grid.BuildMipLevels();
+
+  const std::string path = ::testing::TempDir() + "occupancy_grid_test.occ";
+  ASSERT_TRUE(grid.SaveRaw(path));
+
+  OccupancyGrid mapped;
+  ASSERT_TRUE(mapped.LoadRaw(path));
+  EXPECT_TRUE(mapped.IsMapped());
+  EXPECT_EQ(mapped.GetLevelCount(), grid.GetLevelCount());
+  EXPECT_DOUBLE_EQ(mapped.GetResolution(), 0.1);
+  EXPECT_TRUE(mapped.GetOrigin().isApprox(Eigen::Vector2d(1.0, 2.0)));
+  for (int y = 0; y < 70; ++y) {
+    for (int x = 0; x < 130; ++x) {
+      EXPECT_EQ(mapped.IsOccupied(x, y), grid.IsOccupied(x, y));
+    }
+  }
+
+  // Modifying a mapped grid copies it first
+  mapped.SetOccupied(1, 1, true);
+  EXPECT_FALSE(mapped.IsMapped());
+  EXPECT_TRUE(mapped.IsOccupied(1, 1));
+  EXPECT_EQ(mapped.GetLevelCount(), 1);
+
+  // The state names the source so the map can be reloaded
+  OccupancyGrid fromState;
+  OccupancyGrid source;
+  ASSERT_TRUE(source.LoadRaw(path));
+  EXPECT_TRUE(fromState.LoadState(source.GetState()));
+  EXPECT_TRUE(fromState.IsOccupied(64, 33));
+
+  // Headers that do not describe the file are rejected before any level is built
+  std::ifstream input(path, std::ios::binary);
+  const std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  input.close();
+  const auto loadPatched = [&](size_t offset, const auto& value) {
+    std::string patched = bytes;
+    std::memcpy(&patched[offset], &value, sizeof(value));
+    std::ofstream(path, std::ios::binary).write(patched.data(), patched.size());
+    OccupancyGrid broken;
+    return broken.LoadRaw(path);
+  };
+  EXPECT_TRUE(loadPatched(40, uint32_t{9}));
+  EXPECT_FALSE(loadPatched(40, uint32_t{10}));           // More levels than halvings
+  EXPECT_FALSE(loadPatched(40, uint32_t{0xFFFFFFFF}));
+  EXPECT_FALSE(loadPatched(8, uint32_t{0x80000000}));    // Width beyond int
+  EXPECT_FALSE(loadPatched(12, uint32_t{100000}));       // Levels beyond the file
+  EXPECT_FALSE(loadPatched(16, 0.0));                    // Resolution
+  EXPECT_FALSE(loadPatched(16, std::nan("")));
+  EXPECT_FALSE(loadPatched(24, HUGE_VAL));               // Origin
+  std::remove(path.c_str());
+}
+
+// Test that mip-accelerated region queries match a brute-force scan
+TEST(OccupancyGridTest, AnyOccupiedMatchesBruteForce) {
+  OccupancyGrid grid(300, 200, 1.0, Eigen::Vector2d::Zero());
+  OccupancyGrid withMips(300, 200, 1.0, Eigen::Vector2d::Zero());
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> column(0, 299);
+  std::uniform_int_distribution<int> row(0, 199);
+  for (int i = 0; i < 40; ++i) {
+    const int x = column(rng);
+    const int y = row(rng);
+    grid.SetOccupied(x, y, true);
+    withMips.SetOccupied(x, y, true);
+  }
+  withMips.BuildMipLevels();
+  EXPECT_GT(withMips.GetLevelCount(), 1);
+
+  std::uniform_real_distribution<double> coordinate(-20.0, 320.0);
+  std::uniform_real_distribution<double> extent(0.0, 40.0);
+  for (int query = 0; query < 500; ++query) {
+    const Eigen::Vector2d corner(coordinate(rng), coordinate(rng));
+    const Eigen::AlignedBox2d region(corner, corner + Eigen::Vector2d(extent(rng), extent(rng)));
+
+    bool expected = false;
+    for (int y = 0; y < 200 && !expected; ++y) {
+      for (int x = 0; x < 300 && !expected; ++x) {
+        const Eigen::AlignedBox2d cell(Eigen::Vector2d(x, y), Eigen::Vector2d(x + 1, y + 1));
+        expected = grid.IsOccupied(x, y) && cell.intersects(region);
+      }
+    }
+
+    EXPECT_EQ(grid.AnyOccupied(region), expected);
+    EXPECT_EQ(withMips.AnyOccupied(region), expected);
+  }
+}
+
+// Test that in-memory states never report success while keeping a different layout
+TEST(OccupancyGridTest, InMemoryState) {
+  OccupancyGrid grid(10, 10, 1.0, Eigen::Vector2d::Zero());
+  grid.SetOccupied(3, 4, true);
+  const OccupancyGrid other(20, 5, 0.5, Eigen::Vector2d(1.0, 1.0));
+
+  // A matching layout keeps the cells, a different one is rejected untouched
+  EXPECT_TRUE(grid.LoadState(grid.GetState()));
+  EXPECT_TRUE(grid.IsOccupied(3, 4));
+  EXPECT_FALSE(grid.LoadState(other.GetState()));
+  EXPECT_EQ(grid.GetWidth(), 10);
+  EXPECT_TRUE(grid.IsOccupied(3, 4));
+
+  // An empty grid takes the saved layout
+  OccupancyGrid empty;
+  ASSERT_TRUE(empty.LoadState(other.GetState()));
+  EXPECT_EQ(empty.GetWidth(), 20);
+  EXPECT_EQ(empty.GetHeight(), 5);
+  EXPECT_DOUBLE_EQ(empty.GetResolution(), 0.5);
+  EXPECT_EQ(empty.GetState(), other.GetState());
+
+  // A mapped grid keeps its map for its own state and rejects an in-memory one
+  const std::string path = ::testing::TempDir() + "occupancy_grid_state.occ";
+  ASSERT_TRUE(grid.SaveRaw(path));
+  OccupancyGrid mapped;
+  ASSERT_TRUE(mapped.LoadRaw(path));
+  EXPECT_TRUE(mapped.LoadState(mapped.GetState()));
+  EXPECT_FALSE(mapped.LoadState(other.GetState()));
+  EXPECT_TRUE(mapped.IsMapped());
+  std::remove(path.c_str());
+}
+
+// Test the grid as an environment element
+TEST(OccupancyGridTest, EnvironmentCollision) {
+  auto grid = std::make_unique<OccupancyGrid>(10, 10, 1.0, Eigen::Vector2d::Zero());
+  grid->SetOccupied(3, 4, true);
+  const OccupancyGrid* gridPtr = grid.get();
+
+  Environment env;
+  env.AddElement(std::move(grid));
+  env.BuildStaticIndex();
+  EXPECT_EQ(env.GetStaticElementCount(), 1);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(3.5, 4.5)), gridPtr);
+  EXPECT_EQ(env.CheckCollision(Eigen::Vector2d(4.5, 4.5)), nullptr);
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
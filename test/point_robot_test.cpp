@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
 #include "mobilerobotsim/point_robot.h"
 
 namespace mobilerobotsim {
@@ -71,5 +73,55 @@ TEST(PointRobotTest, Movement) {
   EXPECT_NEAR(robot->GetOrientation(), 0.0, 0.001);
 }
 
+// Test that the closed-form advance matches fine integration
+TEST(PointRobotTest, AdvanceMatchesFineSteps) {
+  PointRobot exact(1.0, 2.0, 0.0, 0.5, 0.0);
+  PointRobot stepped(1.0, 2.0, 0.0, 0.5, 0.0);
+  exact.SetTargetVelocity(-1.0, 2.0);
+  stepped.SetTargetVelocity(-1.0, 2.0);
+
+  // The ramp takes |(-1.5, 2)| / 1 = 2.5 s; advance across its end
+  ASSERT_TRUE(exact.Advance(1.0));
+  ASSERT_TRUE(exact.Advance(3.0));
+  for (int i = 0; i < 40000; ++i) {
+    stepped.UpdateState(1e-4);
+  }
+
+  EXPECT_NEAR((exact.GetPosition() - stepped.GetPosition()).norm(), 0.0, 1e-3);
+  EXPECT_EQ(exact.GetVelocity(), Eigen::Vector2d(-1.0, 2.0));
+  EXPECT_DOUBLE_EQ(exact.GetSpeedBound(), std::sqrt(5.0));
+
+  // Noisy robots have no closed form
+  exact.SetVelocityNoise(0.1);
+  EXPECT_FALSE(exact.Advance(1.0));
+}
+
+// Test the float robot against the double robot over a one hour run
+TEST(PointRobotTest, FloatErrorOverOneHour) {
+  PointRobot reference(100.0, -50.0);
+  PointRobotF single(100.0f, -50.0f);
+  double maxError = 0.0;
+  for (int step = 0; step < 72000; ++step) {
+    if (step % 1200 == 0) {
+      const double vx = 2.0 * std::sin(0.001 * step);
+      const double vy = 1.5 * std::cos(0.0013 * step);
+      reference.SetTargetVelocity(vx, vy);
+      single.SetTargetVelocity(static_cast<float>(vx), static_cast<float>(vy));
+    }
+    reference.UpdateState(0.05);
+    single.UpdateState(0.05);
+    maxError = std::max(maxError, (reference.GetPosition() - single.GetPosition()).norm());
+  }
+
+  // Far below the documented worst case of 1.1 m
+  EXPECT_LT(maxError, 0.1);
+
+  // Float states only load into float robots
+  auto state = single.GetState();
+  EXPECT_EQ(state->GetTypeId(), "PointRobotStateF");
+  EXPECT_TRUE(PointRobotF().LoadState(*state));
+  EXPECT_FALSE(PointRobot().LoadState(*state));
+}
+
 } // namespace testing
 } // namespace mobilerobotsim
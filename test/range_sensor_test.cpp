@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/occupancy_grid.h"
+#include "mobilerobotsim/range_sensor.h"
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// 10 x 10 m room at 0.5 m whose border cells are walls
+std::unique_ptr<OccupancyGrid> MakeRoomGrid() {
+  auto grid = std::make_unique<OccupancyGrid>(20, 20, 0.5, Eigen::Vector2d::Zero());
+  for (int i = 0; i < 20; ++i) {
+    grid->SetOccupied(i, 0, true);
+    grid->SetOccupied(i, 19, true);
+    grid->SetOccupied(0, i, true);
+    grid->SetOccupied(19, i, true);
+  }
+  grid->BuildMipLevels();
+  return grid;
+}
+
+// Four beams at -pi, -pi/2, 0 and pi/2 relative to the heading
+RangeSensorConfig MakeCrossConfig() {
+  RangeSensorConfig config;
+  config.beamCount = 4;
+  config.maxRange = 20.0;
+  return config;
+}
+
+}  // namespace
+
+// Test ranges to the walls of a room
+TEST(RangeSensorTest, HitsWalls) {
+  auto grid = MakeRoomGrid();
+  Environment environment;
+  RangeSensor sensor(MakeCrossConfig());
+  sensor.SetStaticMap(grid.get());
+
+  Eigen::Matrix3Xd poses(3, 2);
+  poses.col(0) << 5.0, 5.0, 0.0;
+  poses.col(1) << 3.0, 6.0, 1.5707963267948966;
+  sensor.Scan(environment, poses);
+  ASSERT_EQ(sensor.GetScanCount(), 2u);
+
+  // Inner wall faces are at 0.5 and 9.5
+  const float* scan = sensor.GetScan(0);
+  EXPECT_NEAR(scan[0], 4.5f, 1e-4f);
+  EXPECT_NEAR(scan[1], 4.5f, 1e-4f);
+  EXPECT_NEAR(scan[2], 4.5f, 1e-4f);
+  EXPECT_NEAR(scan[3], 4.5f, 1e-4f);
+
+  // Rotated robot: beams look along -y, +x, +y and -x
+  scan = sensor.GetScan(1);
+  EXPECT_NEAR(scan[0], 5.5f, 1e-4f);
+  EXPECT_NEAR(scan[1], 6.5f, 1e-4f);
+  EXPECT_NEAR(scan[2], 3.5f, 1e-4f);
+  EXPECT_NEAR(scan[3], 2.5f, 1e-4f);
+
+  // Outside the room with nothing in range
+  poses.col(0) << 50.0, 50.0, 0.0;
+  sensor.Scan(environment, poses);
+  for (int beam = 0; beam < 4; ++beam) {
+    EXPECT_FLOAT_EQ(sensor.GetScan(0)[beam], 20.0f);
+  }
+}
+
+// Test that dynamic obstacles occlude the static map
+TEST(RangeSensorTest, HitsDynamicObstacles) {
+  auto grid = MakeRoomGrid();
+  Environment environment;
+  environment.AddElement(std::make_unique<DynamicObstacle>(7.0, 5.0, 0.5));
+  RangeSensor sensor(MakeCrossConfig());
+  sensor.SetStaticMap(grid.get());
+
+  Eigen::Matrix3Xd poses(3, 1);
+  poses.col(0) << 5.0, 5.0, 0.0;
+  sensor.Scan(environment, poses);
+  EXPECT_NEAR(sensor.GetScan(0)[2], 1.5f, 1e-4f);
+  EXPECT_NEAR(sensor.GetScan(0)[0], 4.5f, 1e-4f);
+
+  // Obstacles behind a beam's origin are not hit
+  poses.col(0) << 5.0, 5.0, 3.14159265358979323846;
+  sensor.Scan(environment, poses);
+  EXPECT_NEAR(sensor.GetScan(0)[2], 4.5f, 1e-4f);
+  EXPECT_NEAR(sensor.GetScan(0)[0], 1.5f, 1e-4f);
+}
+
+// Test that parallel scans match a single-threaded scan
+TEST(RangeSensorTest, ParallelMatchesSerial) {
+  Environment environment;
+  environment.AddElement(std::make_unique<DynamicObstacle>(3.0, 3.0, 0.4));
+  environment.AddElement(std::make_unique<DynamicObstacle>(6.0, 7.0, 0.8));
+
+  RangeSensorConfig config;
+  config.beamCount = 90;
+  config.maxRange = 8.0;
+  RangeSensor serial(config, 1);
+  RangeSensor parallel(config, 4);
+  auto grid = MakeRoomGrid();
+  serial.SetStaticMap(grid.get());
+  parallel.SetStaticMap(grid.get());
+
+  Eigen::Matrix3Xd poses = Eigen::Matrix3Xd::Random(3, 37);
+  poses.topRows<2>() = (poses.topRows<2>().array() + 1.0) * 4.5 + 0.5;
+  poses.row(2) *= 3.0;
+  parallel.Reserve(static_cast<size_t>(poses.cols()));
+  serial.Scan(environment, poses);
+  parallel.Scan(environment, poses);
+
+  EXPECT_EQ(serial.GetRanges(), parallel.GetRanges());
+  for (float range : serial.GetRanges()) {
+    EXPECT_GE(range, 0.0f);
+    EXPECT_LE(range, 8.0f);
+  }
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/renderer.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/occupancy_grid.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/simulation_engine.h"
+#include "mobilerobotsim/system_state.h"
+#include "test_helpers.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// Builds an engine with a merge point, an obstacle and one robot
+std::unique_ptr<SimulationEngine> MakeScene(double robotX, double robotVx) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(0.0, 0.0, 2.0));
+  environment->AddElement(std::make_unique<DynamicObstacle>(5.0, 0.0, 1.0));
+  return MakeRobotGrid(1, 1, Eigen::Vector2d(robotX, 0.0), robotVx, std::move(environment));
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+bool IsColor(const RgbImage& image, int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+  const uint8_t* pixel = image.At(x, y);
+  return pixel[0] == r && pixel[1] == g && pixel[2] == b;
+}
+
+}  // namespace
+
+// Test that robots and elements land where the viewport puts them
+TEST(RendererTest, DrawsRobotsAndElements) {
+  const auto engine = MakeScene(-3.0, 0.0);
+  Renderer renderer(&engine->GetEnvironment());
+  renderer.SetImageSize(120, 80);
+  renderer.SetViewport(Eigen::AlignedBox2d(Eigen::Vector2d(-6.0, -4.0), Eigen::Vector2d(6.0, 4.0)));
+
+  // 10 pixels per metre with the world origin at pixel (60, 40)
+  const RgbImage image = renderer.Render(*engine->GetState());
+  ASSERT_EQ(image.width, 120);
+  ASSERT_EQ(image.height, 80);
+  EXPECT_TRUE(IsColor(image, 30, 40, 30, 90, 200));    // Robot
+  EXPECT_TRUE(IsColor(image, 110, 40, 90, 90, 90));    // Obstacle
+  EXPECT_TRUE(IsColor(image, 79, 40, 70, 130, 180));   // Merge point outline
+  EXPECT_TRUE(IsColor(image, 60, 40, 245, 245, 245));  // Inside the merge point
+  EXPECT_TRUE(IsColor(image, 5, 5, 245, 245, 245));
+}
+
+// Test that the camera culls robots and elements outside the image
+TEST(RendererTest, CullsToCamera) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(50.0, 50.0, 1.0));
+  environment->AddElement(std::make_unique<MergePoint>(150.0, 150.0, 1.0));
+  const auto engine = MakeRobotGrid(200, 200, Eigen::Vector2d::Zero(), 0.0, std::move(environment));
+
+  Renderer renderer(&engine->GetEnvironment());
+  renderer.SetImageSize(200, 200);
+  renderer.SetCamera({Eigen::Vector2d(50.5, 50.5), 20.0});
+
+  // A 10 m square around the camera holds 10 x 10 robots and one merge point
+  const RgbImage image = renderer.Render(*engine->GetState());
+  const Renderer::CaptureStats stats = renderer.GetCaptureStats();
+  EXPECT_EQ(stats.robotsDrawn, 100u);
+  EXPECT_EQ(stats.robotsAggregated, 0u);
+  EXPECT_EQ(stats.robotsCulled, 200u * 200u - 100u);
+  EXPECT_EQ(stats.shapes, 1u);
+  EXPECT_TRUE(IsColor(image, 88, 112, 30, 90, 200));  // Robot at (50, 50)
+  EXPECT_TRUE(IsColor(image, 80, 100, 245, 245, 245));
+}
+
+// Test that sub-pixel robots are counted into density tiles
+TEST(RendererTest, AggregatesSubPixelRobots) {
+  const auto engine = MakeRobotGrid(200, 200);
+  Renderer renderer;
+  renderer.SetImageSize(200, 200);
+  renderer.SetCamera({Eigen::Vector2d(99.5, 99.5), 1.0});
+
+  // Every 4 x 4 tile holds 16 robots, so every tile has the full robot colour
+  RgbImage image = renderer.Render(*engine->GetState());
+  Renderer::CaptureStats stats = renderer.GetCaptureStats();
+  EXPECT_EQ(stats.robotsDrawn, 0u);
+  EXPECT_EQ(stats.robotsAggregated, 200u * 200u);
+  EXPECT_TRUE(IsColor(image, 50, 50, 30, 90, 200));
+  EXPECT_TRUE(IsColor(image, 199, 199, 30, 90, 200));
+
+  // Zoomed out, the lattice covers the middle quarter and the rest stays blank
+  renderer.SetCamera({Eigen::Vector2d(99.5, 99.5), 0.5});
+  image = renderer.Render(*engine->GetState());
+  stats = renderer.GetCaptureStats();
+  EXPECT_EQ(stats.robotsAggregated, 200u * 200u);
+  EXPECT_TRUE(IsColor(image, 100, 100, 30, 90, 200));
+  EXPECT_TRUE(IsColor(image, 10, 10, 245, 245, 245));
+
+  // Without aggregation every robot is drawn as a disc again
+  renderer.SetDensityThreshold(0.0, 4);
+  renderer.Render(*engine->GetState());
+  EXPECT_EQ(renderer.GetCaptureStats().robotsDrawn, 200u * 200u);
+}
+
+// Test that fine occupancy grids are sampled about once per pixel
+TEST(RendererTest, SamplesFineOccupancyGrids) {
+  // Every other column of a 20 m grid with 1 cm cells is occupied
+  auto grid = std::make_unique<OccupancyGrid>(2000, 2000, 0.01, Eigen::Vector2d::Zero());
+  for (int y = 0; y < 2000; ++y) {
+    for (int x = 0; x < 2000; x += 2) {
+      grid->SetOccupied(x, y, true);
+    }
+  }
+  Environment environment;
+  environment.AddElement(std::move(grid));
+
+  // Ten cells to a pixel: each row of blocks becomes a single run
+  Renderer renderer(&environment);
+  renderer.SetImageSize(200, 200);
+  renderer.SetCamera({Eigen::Vector2d(10.0, 10.0), 10.0});
+  const RgbImage image = renderer.Render(SystemState());
+  EXPECT_EQ(renderer.GetCaptureStats().shapes, 200u);
+  EXPECT_TRUE(IsColor(image, 100, 100, 40, 40, 40));
+  EXPECT_TRUE(IsColor(image, 100, 5, 40, 40, 40));
+}
+
+// Test that the background thread draws every n-th step and writes the frames
+TEST(RendererTest, WritesDecimatedFramesInBackground) {
+  const auto engine = MakeScene(3.95, 1.0);
+  Renderer renderer(&engine->GetEnvironment());
+  renderer.SetImageSize(64, 48);
+  renderer.SetFrameInterval(3);
+  const std::string prefix = ::testing::TempDir() + "renderer_frame_";
+  renderer.SetOutput(prefix, Renderer::ImageFormat::kPpm);
+  engine->RegisterObserver(&renderer);
+
+  // The robot hits the obstacle during the first step
+  engine->Step(0.1);
+  renderer.Flush();
+  const RgbImage first = renderer.GetLastImage();
+  bool red = false;
+  for (size_t i = 0; i + 2 < first.pixels.size(); i += 3) {
+    red = red || (first.pixels[i] == 220 && first.pixels[i + 1] == 30 && first.pixels[i + 2] == 30);
+  }
+  EXPECT_TRUE(red);
+
+  for (int step = 1; step < 10; ++step) {
+    engine->Step(0.1);
+  }
+  renderer.Flush();
+  EXPECT_EQ(renderer.GetFramesRendered() + renderer.GetFramesDropped(), 4u);
+
+  // Steps 0, 3, 6 and 9 are captured; the last one is always drawn
+  const std::string ppm = ReadFile(prefix + "000009.ppm");
+  EXPECT_EQ(ppm.substr(0, 13), "P6\n64 48\n255\n");
+  EXPECT_EQ(ppm.size(), 13u + 64 * 48 * 3);
+  EXPECT_TRUE(ReadFile(prefix + "000001.ppm").empty());
+
+  engine->UnregisterObserver(&renderer);
+  renderer.Shutdown();
+  for (int step = 0; step < 10; ++step) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%06d.ppm", step);
+    std::remove((prefix + name).c_str());
+  }
+}
+
+// Test that PNG files carry a valid header and uncompressed image data
+TEST(RendererTest, WritesPng) {
+  RgbImage image;
+  image.Resize(300, 200);
+  for (size_t i = 0; i < image.pixels.size(); ++i) {
+    image.pixels[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  const std::string path = ::testing::TempDir() + "renderer_image.png";
+  ASSERT_TRUE(image.WritePng(path));
+  const std::string png = ReadFile(path);
+  ASSERT_GT(png.size(), 33u);
+  EXPECT_EQ(png.substr(0, 8), std::string("\x89PNG\r\n\x1a\n", 8));
+  EXPECT_EQ(png.substr(12, 4), "IHDR");
+  EXPECT_EQ(png.substr(16, 8), std::string("\0\0\x01\x2c\0\0\0\xc8", 8));
+  EXPECT_EQ(png.substr(png.size() - 8, 4), "IEND");
+
+  // Rows of 901 bytes in stored blocks of at most 65535 bytes
+  const size_t raw = 200 * 901;
+  const size_t blocks = (raw + 65534) / 65535;
+  EXPECT_EQ(png.size(), 8 + 25 + 12 + 2 + blocks * 5 + raw + 4 + 12);
+  std::remove(path.c_str());
+}
+
+} // namespace testing
+} // namespace mobilerobotsim
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/scenario_loader.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/robot_state.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// Writes a scenario with a row of merge points, two obstacles, a source and some robots
+std::string WriteScenario(const std::string& name, int robotCount) {
+  const std::string path = ::testing::TempDir() + name;
+  std::ofstream file(path);
+  file << "{\"worldBounds\": [-50, -50, 150, 50], \"staticIndexCellSize\": 4.0,\n"
+       << " \"elements\": [\n";
+  for (int i = 0; i < 20; ++i) {
+    file << "  {\"type\": \"MergePoint\", \"state\": {\"x\": " << 5 * i
+         << ", \"y\": 0, \"radius\": 1.5}},\n";
+  }
+  file << "  {\"type\": \"DynamicObstacle\", \"state\": {\"x\": 12, \"y\": 3, \"radius\": 1,"
+       << " \"vx\": -0.5, \"vy\": 0}},\n"
+       << "  {\"type\": \"RobotSink\", \"state\": {\"x\": 100, \"y\": 0, \"radius\": 2}},\n"
+       << "  {\"type\": \"RobotSource\", \"state\": {\"x\": 0, \"y\": 0, \"interval\": 0.5,"
+       << " \"startTime\": 0, \"robotType\": \"PointRobotStateF\","
+       << " \"spawnState\": \"{\\\"x\\\": 0, \\\"vx\\\": 2}\"}}\n"
+       << " ],\n \"robots\": [\n";
+  for (int i = 0; i < robotCount; ++i) {
+    file << "  {\"type\": \"PointRobotState\", \"state\": {\"x\": " << 0.1 * i
+         << ", \"y\": -2, \"orientation\": 0, \"vx\": 1, \"vy\": 0}}"
+         << (i + 1 < robotCount ? ",\n" : "\n");
+  }
+  file << " ]}\n";
+  return path;
+}
+
+}  // namespace
+
+// Test that a cached load rebuilds exactly what parsing built
+TEST(ScenarioLoaderTest, CacheMatchesParsedScenario) {
+  const std::string scenario = WriteScenario("scenario.json", 100);
+  const std::string cache = ::testing::TempDir() + "scenario.cache";
+  std::remove(cache.c_str());
+
+  ScenarioLoader loader;
+  ASSERT_TRUE(loader.Load(scenario));
+  EXPECT_FALSE(loader.IsFromCache());
+  const std::unique_ptr<Environment> parsed = loader.TakeEnvironment();
+  const std::vector<std::unique_ptr<RobotState>> parsedRobots = loader.TakeRobotStates();
+  ASSERT_NE(parsed, nullptr);
+  EXPECT_EQ(parsed->GetStaticElementCount(), 22u);
+  EXPECT_EQ(parsed->GetDynamicElementCount(), 1u);
+  EXPECT_TRUE(parsed->HasStaticIndex());
+  EXPECT_EQ(parsed->GetStaticIndex()->GetCellSize(), 4.0);
+  EXPECT_EQ(parsed->GetWorldBounds().max().x(), 150.0);
+  ASSERT_EQ(parsedRobots.size(), 100u);
+
+  // The first cached load compiles the cache, the second one maps it
+  ASSERT_TRUE(loader.Load(scenario, cache));
+  EXPECT_FALSE(loader.IsFromCache());
+  ASSERT_TRUE(loader.Load(scenario, cache));
+  EXPECT_TRUE(loader.IsFromCache());
+  const std::unique_ptr<Environment> cached = loader.TakeEnvironment();
+  const std::vector<std::unique_ptr<RobotState>> cachedRobots = loader.TakeRobotStates();
+
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->GetState()->Serialize(), parsed->GetState()->Serialize());
+  EXPECT_TRUE(cached->HasStaticIndex());
+  EXPECT_EQ(cached->GetStaticIndex()->GetCellSize(), 4.0);
+  EXPECT_EQ(cached->GetWorldBounds().max().x(), 150.0);
+  EXPECT_NE(cached->FindRobotSink(Eigen::Vector2d(100.5, 0.0)), nullptr);
+  EXPECT_NE(cached->CheckCollision(Eigen::Vector2d(12.0, 3.0)), nullptr);
+  ASSERT_EQ(cachedRobots.size(), parsedRobots.size());
+  for (size_t i = 0; i < cachedRobots.size(); ++i) {
+    EXPECT_EQ(cachedRobots[i]->Serialize(), parsedRobots[i]->Serialize());
+  }
+
+  // Editing the scenario invalidates the cache
+  WriteScenario("scenario.json", 50);
+  ASSERT_TRUE(loader.Load(scenario, cache));
+  EXPECT_FALSE(loader.IsFromCache());
+  EXPECT_EQ(loader.TakeRobotStates().size(), 50u);
+
+  // A truncated cache falls back to parsing
+  std::ifstream input(cache, std::ios::binary);
+  const std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  input.close();
+  std::ofstream(cache, std::ios::binary).write(bytes.data(), bytes.size() / 2);
+  ASSERT_TRUE(loader.Load(scenario, cache));
+  EXPECT_FALSE(loader.IsFromCache());
+  EXPECT_EQ(loader.TakeRobotStates().size(), 50u);
+
+  std::remove(scenario.c_str());
+  std::remove(cache.c_str());
+}
+
+// Test that a cached grid whose source file changed gets a fresh static index
+TEST(ScenarioLoaderTest, CacheRebuildsIndexOfGridSources) {
+  const std::string map = ::testing::TempDir() + "scenario_map.pgm";
+  const auto writeMap = [&](int width) {
+    std::ofstream file(map, std::ios::binary);
+    file << "P5\n" << width << " 4\n255\n" << std::string(width * 4, '\0');
+  };
+  writeMap(4);
+
+  const std::string scenario = ::testing::TempDir() + "grid_scenario.json";
+  std::ofstream(scenario) << "{\"staticIndexCellSize\": 2.0, \"elements\": ["
+                          << "{\"type\": \"OccupancyGrid\", \"state\": {\"width\": 0,"
+                          << " \"height\": 0, \"resolution\": 1, \"originX\": 0, \"originY\": 0,"
+                          << " \"occupiedThreshold\": 0.5, \"source\": \"" << map << "\","
+                          << " \"format\": \"pgm\"}}]}";
+  const std::string cache = ::testing::TempDir() + "grid_scenario.cache";
+  std::remove(cache.c_str());
+
+  ScenarioLoader loader;
+  ASSERT_TRUE(loader.Load(scenario, cache));
+  EXPECT_EQ(loader.TakeEnvironment()->CheckCollision(Eigen::Vector2d(15.0, 2.0)), nullptr);
+  std::ifstream temporary(cache + ".tmp");
+  EXPECT_FALSE(temporary.is_open());
+
+  // The map grows without touching the scenario
+  writeMap(20);
+  ASSERT_TRUE(loader.Load(scenario, cache));
+  EXPECT_TRUE(loader.IsFromCache());
+  const std::unique_ptr<Environment> environment = loader.TakeEnvironment();
+  EXPECT_NE(environment->CheckCollision(Eigen::Vector2d(15.0, 2.0)), nullptr);
+  EXPECT_EQ(environment->GetStaticIndex()->GetCellSize(), 2.0);
+
+  std::remove(map.c_str());
+  std::remove(scenario.c_str());
+  std::remove(cache.c_str());
+}
+
+// Test that invalid scenarios are rejected
+TEST(ScenarioLoaderTest, RejectsInvalidScenarios) {
+  ScenarioLoader loader;
+  EXPECT_FALSE(loader.Load(::testing::TempDir() + "missing_scenario.json"));
+
+  const std::string path = ::testing::TempDir() + "invalid_scenario.json";
+  std::ofstream(path) << "{\"elements\": [{\"type\": \"Unknown\", \"state\": {}}]}";
+  EXPECT_FALSE(loader.Load(path));
+  EXPECT_EQ(loader.TakeEnvironment(), nullptr);
+
+  std::ofstream(path) << "{\"robots\": [{\"type\": \"PointRobotState\", \"state\": {}}";
+  EXPECT_FALSE(loader.Load(path));
+
+  // Well-formed JSON with a member of the wrong type is rejected, not thrown
+  for (const char* element : {
+           "{\"type\": \"MergePoint\", \"state\": {\"x\": \"a\"}}",
+           "{\"type\": \"RobotSink\", \"state\": {\"radius\": [1]}}",
+           "{\"type\": \"DynamicObstacle\", \"state\": {\"vx\": true}}",
+           "{\"type\": \"RobotSource\", \"state\": {\"robotType\": 1}}",
+           "{\"type\": \"OccupancyGrid\", \"state\": {\"width\": \"8\"}}"}) {
+    std::ofstream(path) << "{\"elements\": [" << element << "]}";
+    EXPECT_FALSE(loader.Load(path)) << element;
+  }
+  std::remove(path.c_str());
+}
+
+} // namespace testing
+} // namespace mobilerobotsim
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/occupancy_grid.h"
+#include "mobilerobotsim/signed_distance_field.h"
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// 100 x 100 m grid at 0.5 m with a 10 x 10 m block centered at (50, 50)
+std::unique_ptr<OccupancyGrid> MakeBlockGrid() {
+  auto grid = std::make_unique<OccupancyGrid>(200, 200, 0.5, Eigen::Vector2d::Zero());
+  for (int y = 90; y < 110; ++y) {
+    for (int x = 90; x < 110; ++x) {
+      grid->SetOccupied(x, y, true);
+    }
+  }
+  return grid;
+}
+
+}  // namespace
+
+// Test distances and gradients against the analytic distance to the block
+TEST(SignedDistanceFieldTest, MatchesAnalyticDistance) {
+  auto grid = MakeBlockGrid();
+  SignedDistanceField field;
+  ASSERT_TRUE(field.Build(*grid));
+
+  // Straight out from a face
+  EXPECT_NEAR(field.Distance(Eigen::Vector2d(65.0, 50.0)), 10.0, 0.5);
+  // Diagonally out from a corner
+  EXPECT_NEAR(field.Distance(Eigen::Vector2d(55.0, 55.0) + Eigen::Vector2d(3.0, 4.0)), 5.0, 0.5);
+  // Inside the block
+  EXPECT_NEAR(field.Distance(Eigen::Vector2d(50.0, 50.0)), -5.0, 0.5);
+  EXPECT_LT(field.Distance(Eigen::Vector2d(52.0, 50.0)), 0.0);
+
+  // The gradient points away from the block
+  Eigen::Vector2d gradient;
+  field.DistanceAndGradient(Eigen::Vector2d(70.0, 50.2), gradient);
+  EXPECT_NEAR(gradient.x(), 1.0, 0.05);
+  EXPECT_NEAR(gradient.y(), 0.0, 0.05);
+  field.DistanceAndGradient(Eigen::Vector2d(50.2, 30.0), gradient);
+  EXPECT_NEAR(gradient.x(), 0.0, 0.05);
+  EXPECT_NEAR(gradient.y(), -1.0, 0.05);
+}
+
+// Test that batched queries match single queries
+TEST(SignedDistanceFieldTest, BatchMatchesSingle) {
+  auto grid = MakeBlockGrid();
+  SignedDistanceField field;
+  ASSERT_TRUE(field.Build(*grid));
+
+  Eigen::Matrix2Xd positions = Eigen::Matrix2Xd::Random(2, 64) * 60.0;
+  positions.array() += 50.0;
+  Eigen::VectorXd distances;
+  Eigen::Matrix2Xd gradients;
+  field.DistanceBatch(positions, distances, &gradients);
+  ASSERT_EQ(distances.size(), 64);
+  for (int i = 0; i < 64; ++i) {
+    Eigen::Vector2d gradient;
+    EXPECT_DOUBLE_EQ(distances[i], field.DistanceAndGradient(positions.col(i), gradient));
+    EXPECT_DOUBLE_EQ(gradients(0, i), gradient.x());
+    EXPECT_DOUBLE_EQ(gradients(1, i), gradient.y());
+  }
+}
+
+// Test building from the environment and reusing the cache
+TEST(SignedDistanceFieldTest, EnvironmentCache) {
+  const std::string cachePath = ::testing::TempDir() + "sdf_test.cache";
+  std::remove(cachePath.c_str());
+  const Eigen::AlignedBox2d region(Eigen::Vector2d::Zero(), Eigen::Vector2d(100.0, 100.0));
+
+  Environment env;
+  env.AddElement(MakeBlockGrid());
+  env.BuildStaticIndex();
+  EXPECT_EQ(env.GetDistanceField(), nullptr);
+  ASSERT_TRUE(env.BuildDistanceField(region, 0.5, cachePath));
+  ASSERT_NE(env.GetDistanceField(), nullptr);
+  const double built = env.GetDistanceField()->Distance(Eigen::Vector2d(65.0, 50.0));
+  EXPECT_NEAR(built, 10.0, 0.5);
+
+  // A second environment with the same geometry loads the cache
+  Environment same;
+  same.AddElement(MakeBlockGrid());
+  ASSERT_TRUE(same.BuildDistanceField(region, 0.5, cachePath));
+  EXPECT_DOUBLE_EQ(same.GetDistanceField()->Distance(Eigen::Vector2d(65.0, 50.0)), built);
+
+  // Changing one cell changes the key even though the grid metadata is identical
+  auto edited = MakeBlockGrid();
+  edited->SetOccupied(120, 100, true);
+  Environment changed;
+  changed.AddElement(std::move(edited));
+  ASSERT_TRUE(changed.BuildDistanceField(region, 0.5, cachePath));
+  EXPECT_NEAR(changed.GetDistanceField()->Distance(Eigen::Vector2d(65.0, 50.0)), 4.75, 0.5);
+
+  // The cache is keyed by content, so different geometry does not match it
+  SignedDistanceField field;
+  EXPECT_FALSE(field.LoadCache(cachePath, 0));
+  Environment different;
+  different.AddElement(std::make_unique<OccupancyGrid>(10, 10, 1.0, Eigen::Vector2d::Zero()));
+  EXPECT_NE(different.ComputeStaticHash(), env.ComputeStaticHash());
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
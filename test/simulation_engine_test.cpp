@@ -1,10 +1,149 @@
 #include <gtest/gtest.h>
 #include "mobilerobotsim/simulation_engine.h"
 #include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/system_state.h"
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/dynamic_obstacle.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/robot_sink.h"
+#include "mobilerobotsim/robot_source.h"
+#include "mobilerobotsim/simulation_observer.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string>
+#include <utility>
 
 namespace mobilerobotsim {
 namespace testing {
 
+namespace {
+
+// State of a robot type no engine registers
+class UnregisteredState : public RobotState {
+ public:
+  std::string GetTypeId() const override { return "UnregisteredState"; }
+  std::unique_ptr<RobotState> Clone() const override {
+    return std::make_unique<UnregisteredState>();
+  }
+  std::string Serialize() const override { return "{}"; }
+  bool Deserialize(const std::string& /*serialized*/) override { return true; }
+};
+
+// Records the order of collision and merge point events
+class EventRecorder : public SimulationObserver {
+ public:
+  void OnStep(const SystemState& /*state*/) override {}
+
+  void OnCollision(const MobileRobotBase* robot, const void* /*object*/) override {
+    events.emplace_back('c', robot);
+  }
+
+  void OnMergePoint(const MobileRobotBase* robot,
+                    const EnvironmentElement* /*mergePoint*/) override {
+    events.emplace_back('m', robot);
+  }
+
+  std::vector<std::pair<char, const MobileRobotBase*>> events;
+};
+
+// Runs a noisy crowd through obstacles and merge points, returning the state
+// hash and the event sequence as (type, robot index) pairs
+std::pair<uint64_t, std::vector<std::pair<char, size_t>>> RunCrowd(size_t threadCount) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(5.0, 0.0, 1.5));
+  environment->AddElement(std::make_unique<MergePoint>(10.0, 4.0, 1.5));
+  environment->AddElement(std::make_unique<DynamicObstacle>(12.0, 0.0, 1.0, -0.5, 0.0));
+  environment->AddElement(std::make_unique<DynamicObstacle>(8.0, 6.0, 1.0, 0.0, -0.5));
+
+  SimulationEngine engine(std::move(environment));
+  engine.SetSeed(42);
+  engine.SetThreadCount(threadCount);
+
+  std::vector<const MobileRobotBase*> robots;
+  for (int i = 0; i < 64; ++i) {
+    auto robot = std::make_unique<PointRobot>(0.0, 0.25 * (i % 32) - 4.0);
+    robot->SetTargetVelocity(1.0 + 0.01 * i, 0.02 * (i % 7) - 0.06);
+    robot->SetVelocityNoise(0.05);
+    robots.push_back(robot.get());
+    engine.AddRobot(std::move(robot));
+  }
+
+  EventRecorder recorder;
+  engine.RegisterObserver(&recorder);
+  for (int step = 0; step < 200; ++step) {
+    engine.Step(0.05);
+  }
+
+  std::vector<std::pair<char, size_t>> events;
+  for (const auto& event : recorder.events) {
+    const auto it = std::find(robots.begin(), robots.end(), event.second);
+    events.emplace_back(event.first, static_cast<size_t>(it - robots.begin()));
+  }
+  return {engine.ComputeStateHash(), events};
+}
+
+// Steers towards the centre of the other robots, read from the fleet snapshot
+class CohesiveRobot : public PointRobot {
+ public:
+  using PointRobot::PointRobot;
+  using PointRobot::UpdateState;
+
+  void UpdateState(double dt, const FleetView& fleet) override {
+    Eigen::Vector2d centre = Eigen::Vector2d::Zero();
+    size_t count = 0;
+    for (size_t i = 0; i < fleet.size(); ++i) {
+      if (fleet.GetHandle(i) != GetHandle()) {
+        centre += fleet.GetPosition(i);
+        ++count;
+      }
+    }
+    if (count > 0) {
+      const Eigen::Vector2d heading = centre / static_cast<double>(count) - GetPosition();
+      SetTargetVelocity(heading.x(), heading.y());
+    }
+    UpdateState(dt);
+  }
+};
+
+// Runs a cohesive swarm, returning the final positions in creation order
+std::vector<Eigen::Vector2d> RunSwarm(size_t threadCount, bool reversed) {
+  SimulationEngine engine;
+  engine.SetThreadCount(threadCount);
+
+  std::vector<int> order(32);
+  for (int i = 0; i < 32; ++i) {
+    order[i] = reversed ? 31 - i : i;
+  }
+  std::vector<RobotHandle> handles(order.size());
+  for (int i : order) {
+    handles[i] = engine.AddRobot(std::make_unique<CohesiveRobot>(0.5 * i, (i * 7) % 11 - 5.0));
+  }
+
+  for (int step = 0; step < 50; ++step) {
+    engine.Step(0.05);
+    if (step == 20) {
+      // Removal reorders the robots behind the scenes
+      engine.RemoveRobot(handles[reversed ? 0 : 31]);
+      engine.RemoveRobot(handles[reversed ? 31 : 0]);
+    }
+  }
+
+  std::vector<Eigen::Vector2d> positions;
+  for (size_t i = 1; i + 1 < handles.size(); ++i) {
+    positions.push_back(engine.GetRobot(handles[i])->GetPosition());
+  }
+  return positions;
+}
+
+}  // namespace
+
 // Basic test to check if SimulationEngine can be created
 TEST(SimulationEngineTest, Creation) {
   auto engine = std::make_unique<SimulationEngine>();
@@ -39,5 +178,482 @@ TEST(SimulationEngineTest, StateManagement) {
   EXPECT_EQ(state->GetRobotStateCount(), 1);
 }
 
+// Test that results are bit-identical for any thread count
+TEST(SimulationEngineTest, DeterministicAcrossThreadCounts) {
+  const auto serial = RunCrowd(1);
+  const auto parallel = RunCrowd(4);
+  EXPECT_EQ(serial.first, parallel.first);
+  EXPECT_EQ(serial.second, parallel.second);
+
+  // The scenario must actually produce both kinds of events
+  const auto has = [&](char type) {
+    return std::any_of(serial.second.begin(), serial.second.end(),
+                       [&](const auto& event) { return event.first == type; });
+  };
+  EXPECT_TRUE(has('c'));
+  EXPECT_TRUE(has('m'));
+}
+
+// Test that robots reading their neighbours get the same result in any order
+TEST(SimulationEngineTest, NeighbourAwareUpdatesAreOrderIndependent) {
+  const std::vector<Eigen::Vector2d> serial = RunSwarm(1, false);
+  EXPECT_EQ(RunSwarm(4, false), serial);
+
+  // Storage order only changes the order in which neighbours are summed
+  const std::vector<Eigen::Vector2d> reversed = RunSwarm(4, true);
+  ASSERT_EQ(reversed.size(), serial.size());
+  for (size_t i = 0; i < serial.size(); ++i) {
+    EXPECT_TRUE(reversed[i].isApprox(serial[i], 1e-9));
+  }
+
+  // The swarm must actually have contracted from its initial 14.5 m spread
+  EXPECT_LT((serial.back() - serial.front()).norm(), 10.0);
+}
+
+// Test that the seed changes noisy results
+TEST(SimulationEngineTest, SeedSelectsRandomStreams) {
+  auto run = [](uint64_t seed) {
+    SimulationEngine engine;
+    engine.SetSeed(seed);
+    auto robot = std::make_unique<PointRobot>(0.0, 0.0);
+    robot->SetVelocityNoise(0.1);
+    engine.AddRobot(std::move(robot));
+    for (int step = 0; step < 10; ++step) {
+      engine.Step(0.1);
+    }
+    return engine.ComputeStateHash();
+  };
+
+  EXPECT_EQ(run(1), run(1));
+  EXPECT_NE(run(1), run(2));
+}
+
+// Counts steps, asking for the state of every n-th one
+class StepCounter : public SimulationObserver {
+ public:
+  void OnStep(const SystemState& /*state*/) override { ++steps; }
+  bool NeedsStepState() override { return asked++ % interval == 0; }
+  void OnCollision(const MobileRobotBase* /*robot*/, const void* /*object*/) override {}
+  void OnMergePoint(const MobileRobotBase* /*robot*/,
+                    const EnvironmentElement* /*mergePoint*/) override {
+    ++mergePoints;
+  }
+
+  int interval = 1;
+  int asked = 0;
+  int steps = 0;
+  int mergePoints = 0;
+};
+
+// Test that observers are asked once per step and only get the steps they ask for
+TEST(SimulationEngineTest, ObserversSkipStepStates) {
+  SimulationEngine engine;
+  engine.AddRobot(std::make_unique<PointRobot>(0.0, 0.0, 0.0, 1.0, 0.0));
+  StepCounter every;
+  StepCounter third;
+  third.interval = 3;
+  engine.RegisterObserver(&third);
+  engine.RegisterObserver(&every);
+  for (int step = 0; step < 9; ++step) {
+    engine.Step(0.1);
+  }
+  EXPECT_EQ(every.asked, 9);
+  EXPECT_EQ(every.steps, 9);
+  EXPECT_EQ(third.asked, 9);
+  EXPECT_EQ(third.steps, 3);
+}
+
+// Test that AdvanceTo() jumps between events in a handful of steps
+TEST(SimulationEngineTest, AdvanceToSkipsToEvents) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(500.0, 0.0, 1.0));
+  SimulationEngine engine(std::move(environment));
+
+  auto robot = std::make_unique<PointRobot>(0.0, 0.0, 0.0, 1.0, 0.0);
+  PointRobot* driver = robot.get();
+  const RobotHandle handle = engine.AddRobot(std::move(robot));
+  engine.ScheduleCommand(1000.0, handle, [](MobileRobotBase& target) {
+    static_cast<PointRobot&>(target).SetTargetVelocity(0.0, 0.0);
+  });
+
+  StepCounter counter;
+  engine.RegisterObserver(&counter);
+  engine.AdvanceTo(2000.0);
+
+  // Cruise 1000 m, then brake to a stop over 0.5 m
+  EXPECT_DOUBLE_EQ(engine.GetTime(), 2000.0);
+  EXPECT_NEAR(driver->GetPosition().x(), 1000.5, 1e-9);
+  EXPECT_EQ(counter.mergePoints, 1);
+  EXPECT_LT(counter.steps, 20);
+}
+
+// Test that a fast rate group substeps while the rest take whole steps
+TEST(SimulationEngineTest, MultiRateGroups) {
+  // Small zones that 50 ms steps at 1 m/s jump over
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(0.125, 0.0, 0.02));
+  environment->AddElement(std::make_unique<MergePoint>(0.125, 5.0, 0.02));
+  SimulationEngine engine(std::move(environment));
+  const RobotHandle fast = engine.AddRobot(std::make_unique<PointRobot>(0.0, 0.0, 0.0, 1.0, 0.0));
+  const RobotHandle slow = engine.AddRobot(std::make_unique<PointRobot>(0.0, 5.0, 0.0, 1.0, 0.0));
+  engine.SetRobotRateGroup(fast, engine.AddRateGroup(0.001));
+
+  EventRecorder recorder;
+  engine.RegisterObserver(&recorder);
+  for (int step = 0; step < 4; ++step) {
+    engine.Step(0.05);
+  }
+
+  // Only the fast robot sees its zone; time advances once per step
+  ASSERT_EQ(recorder.events.size(), 1u);
+  EXPECT_EQ(recorder.events[0].second->GetPosition().y(), 0.0);
+  EXPECT_NEAR(engine.GetTime(), 0.2, 1e-12);
+
+  // The slow robot's pose is interpolated within the last step
+  Eigen::Vector2d position;
+  ASSERT_TRUE(engine.GetRobotPosition(slow, 0.175, position));
+  EXPECT_NEAR(position.x(), 0.175, 1e-9);
+  ASSERT_TRUE(engine.GetRobotPosition(fast, 0.175, position));
+  EXPECT_NEAR(position.x(), 0.2, 1e-9);
+}
+
+// Test that parked robots sleep and wake on commands and nearby motion
+TEST(SimulationEngineTest, SleepsIdleRobots) {
+  SimulationEngine engine;
+  std::vector<PointRobot*> robots;
+  for (int i = 0; i < 10; ++i) {
+    auto robot = std::make_unique<PointRobot>(10.0 * i, 0.0);
+    robots.push_back(robot.get());
+    engine.AddRobot(std::move(robot));
+  }
+
+  engine.Step(0.1);
+  SchedulerStats stats = engine.GetSchedulerStats();
+  EXPECT_EQ(stats.activeRobots, 0u);
+  EXPECT_EQ(stats.sleepingRobots, 10u);
+  EXPECT_EQ(stats.sleepCount, 10u);
+
+  // A command wakes only the commanded robot
+  robots[0]->SetTargetVelocity(1.0, 0.0);
+  engine.Step(0.1);
+  stats = engine.GetSchedulerStats();
+  EXPECT_EQ(stats.activeRobots, 1u);
+  EXPECT_EQ(stats.wakeCount, 1u);
+  double x, y;
+  robots[0]->GetPosition(x, y);
+  EXPECT_GT(x, 0.0);
+
+  // Driving up to the next robot wakes it
+  for (int step = 0; step < 150 && !robots[0]->IsAtRest(); ++step) {
+    robots[0]->GetPosition(x, y);
+    if (x > 9.5) {
+      robots[0]->SetTargetVelocity(0.0, 0.0);
+    }
+    engine.Step(0.1);
+  }
+  EXPECT_GE(engine.GetSchedulerStats().wakeCount, 2u);
+
+  // Once everything is parked again, every robot sleeps
+  for (int step = 0; step < 5; ++step) {
+    engine.Step(0.1);
+  }
+  EXPECT_EQ(engine.GetSchedulerStats().sleepingRobots, 10u);
+}
+
+// Test that handles survive removal of other robots and never go stale silently
+TEST(SimulationEngineTest, StableRobotHandles) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(1.0, 0.0, 0.5));
+  SimulationEngine engine(std::move(environment));
+
+  std::vector<RobotHandle> handles;
+  for (int i = 0; i < 4; ++i) {
+    handles.push_back(engine.AddRobot(std::make_unique<PointRobot>(0.0, 10.0 * i)));
+  }
+  static_cast<PointRobot*>(engine.GetRobot(handles[0]))->SetTargetVelocity(1.0, 0.0);
+  engine.Step(0.1);
+  EXPECT_EQ(engine.GetSchedulerStats().sleepingRobots, 3u);
+
+  // Removing a sleeping robot moves the last robot into its place
+  EXPECT_TRUE(engine.RemoveRobot(handles[1]));
+  EXPECT_FALSE(engine.RemoveRobot(handles[1]));
+  EXPECT_EQ(engine.GetRobot(handles[1]), nullptr);
+  EXPECT_EQ(engine.GetRobotCount(), 3u);
+  EXPECT_EQ(engine.GetRobotHandle(1), handles[3]);
+  EXPECT_EQ(engine.GetSchedulerStats().sleepingRobots, 2u);
+  EXPECT_FALSE(engine.ScheduleCommand(1.0, handles[1], [](MobileRobotBase&) {}));
+
+  // A reused slot gets a new handle
+  const RobotHandle added = engine.AddRobot(std::make_unique<PointRobot>(0.0, -10.0));
+  EXPECT_NE(added, handles[1]);
+  EXPECT_EQ(engine.GetRobot(handles[1]), nullptr);
+  ASSERT_NE(engine.GetRobot(handles[3]), nullptr);
+  EXPECT_EQ(engine.GetRobot(handles[3])->GetPosition().y(), 30.0);
+
+  // Observers and system states report the same handles
+  EventRecorder recorder;
+  engine.RegisterObserver(&recorder);
+  for (int step = 0; step < 20; ++step) {
+    engine.Step(0.1);
+  }
+  ASSERT_EQ(recorder.events.size(), 1u);
+  EXPECT_EQ(recorder.events[0].second->GetHandle(), handles[0]);
+
+  const auto state = engine.GetState();
+  ASSERT_EQ(state->GetRobotStateCount(), 4u);
+  for (size_t i = 0; i < state->GetRobotStateCount(); ++i) {
+    EXPECT_EQ(state->GetRobotHandle(i), engine.GetRobotHandle(i));
+  }
+}
+
+// Removes the first robots it is told about, optionally adding replacements
+class RobotRemover : public SimulationObserver {
+ public:
+  RobotRemover(SimulationEngine& engine, int limit, bool replace)
+      : engine(engine), limit(limit), replace(replace) {}
+
+  void OnStep(const SystemState& /*state*/) override {}
+
+  void OnCollision(const MobileRobotBase* robot, const void* /*object*/) override {
+    Remove(robot);
+  }
+
+  void OnMergePoint(const MobileRobotBase* robot,
+                    const EnvironmentElement* /*mergePoint*/) override {
+    Remove(robot);
+  }
+
+  void Remove(const MobileRobotBase* robot) {
+    ASSERT_NE(robot, nullptr);
+    if (removed == limit) {
+      return;
+    }
+    EXPECT_TRUE(engine.RemoveRobot(robot->GetHandle()));
+    ++removed;
+    if (replace) {
+      engine.AddRobot(std::make_unique<PointRobot>(-100.0, 10.0 * removed));
+    }
+  }
+
+  SimulationEngine& engine;
+  int limit;
+  bool replace;
+  int removed = 0;
+};
+
+// Test that observers may remove and add robots while events are dispatched
+TEST(SimulationEngineTest, ObserversEditRobotsDuringEvents) {
+  auto environment = std::make_unique<Environment>();
+  for (int i = 0; i < 4; ++i) {
+    environment->AddElement(std::make_unique<MergePoint>(1.0, 10.0 * i, 0.5));
+  }
+  SimulationEngine engine(std::move(environment));
+  for (int i = 0; i < 4; ++i) {
+    engine.AddRobot(std::make_unique<PointRobot>(0.0, 10.0 * i, 0.0, 10.0, 0.0));
+  }
+
+  // Later observers are not told about robots an earlier one removed
+  RobotRemover remover(engine, 4, true);
+  EventRecorder recorder;
+  engine.RegisterObserver(&remover);
+  engine.RegisterObserver(&recorder);
+  engine.Step(0.1);
+  EXPECT_EQ(remover.removed, 4);
+  EXPECT_TRUE(recorder.events.empty());
+
+  ASSERT_EQ(engine.GetRobotCount(), 4u);
+  for (size_t i = 0; i < engine.GetRobotCount(); ++i) {
+    EXPECT_EQ(engine.GetRobot(engine.GetRobotHandle(i))->GetPosition().x(), -100.0);
+  }
+  engine.Step(0.1);
+  EXPECT_EQ(remover.removed, 4);
+}
+
+// Test that sinks retire the right robots after an observer removed others
+TEST(SimulationEngineTest, SinksAfterObserverRemovals) {
+  auto environment = std::make_unique<Environment>();
+  for (int i = 0; i < 4; ++i) {
+    environment->AddElement(std::make_unique<MergePoint>(1.0, 10.0 * i, 0.5));
+    environment->AddElement(std::make_unique<RobotSink>(1.0, 10.0 * i, 0.5));
+  }
+  environment->AddElement(std::make_unique<MergePoint>(1.0, 40.0, 0.5));
+  SimulationEngine engine(std::move(environment));
+  for (int i = 0; i < 5; ++i) {
+    engine.AddRobot(std::make_unique<PointRobot>(0.0, 10.0 * i, 0.0, 10.0, 0.0));
+  }
+
+  // The observer removes the first robot; the sinks take the next three and
+  // the last robot, outside any sink, stays
+  RobotRemover remover(engine, 1, false);
+  engine.RegisterObserver(&remover);
+  engine.Step(0.1);
+  EXPECT_EQ(remover.removed, 1);
+  ASSERT_EQ(engine.GetRobotCount(), 1u);
+  EXPECT_EQ(engine.GetRobot(engine.GetRobotHandle(0))->GetPosition().y(), 40.0);
+}
+
+// Test that sources and sinks recycle pooled robots without creating new ones
+TEST(SimulationEngineTest, SpawnsAndRetiresPooledRobots) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<RobotSource>(
+      0.0, 0.0, 0.5, std::make_unique<PointRobotState>(0.0, 0.0, 0.0, 2.0, 0.0),
+      [](MobileRobotBase& robot) { static_cast<PointRobot&>(robot).SetTargetVelocity(2.0, 0.0); }));
+  environment->AddElement(std::make_unique<RobotSink>(10.0, 0.0, 0.5));
+  SimulationEngine engine(std::move(environment));
+  ASSERT_TRUE(engine.ReservePooledRobots("PointRobotState", 16));
+  engine.ReserveRobots(16);
+  EXPECT_EQ(engine.GetRobotPool().GetCreatedCount(), 16u);
+
+  engine.Step(0.05);
+  ASSERT_EQ(engine.GetRobotCount(), 1u);
+  const RobotHandle first = engine.GetRobotHandle(0);
+
+  // 2 m/s over 10 m with a spawn every 0.5 s keeps about 10 robots alive
+  for (int step = 1; step < 1200; ++step) {
+    engine.Step(0.05);
+  }
+  EXPECT_EQ(engine.GetRobot(first), nullptr);
+  EXPECT_GE(engine.GetRobotCount(), 9u);
+  EXPECT_LE(engine.GetRobotCount(), 11u);
+  EXPECT_EQ(engine.GetRobotPool().GetCreatedCount(), 16u);
+  for (size_t i = 0; i < engine.GetRobotCount(); ++i) {
+    const Eigen::Vector2d position = engine.GetRobot(engine.GetRobotHandle(i))->GetPosition();
+    EXPECT_LT(position.x(), 10.0);
+    EXPECT_EQ(position.y(), 0.0);
+  }
+
+  // Bulk adds go through the same pool
+  std::vector<std::unique_ptr<RobotState>> states;
+  states.push_back(std::make_unique<PointRobotState>(0.0, 5.0, 0.0, 0.0, 0.0));
+  states.push_back(std::make_unique<PointRobotStateF>(0.0f, 6.0f, 0.0f, 0.0f, 0.0f));
+  const std::vector<RobotHandle> handles = engine.AddRobots(states);
+  ASSERT_EQ(handles.size(), 2u);
+  EXPECT_NE(dynamic_cast<PointRobotF*>(engine.GetRobot(handles[1])), nullptr);
+  EXPECT_EQ(engine.GetRobot(handles[0])->GetPosition().y(), 5.0);
+}
+
+// Test that spawns of an unregistered robot type are counted rather than lost silently
+TEST(SimulationEngineTest, CountsFailedSpawns) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(
+      std::make_unique<RobotSource>(0.0, 0.0, 0.5, std::make_unique<UnregisteredState>()));
+  environment->AddElement(std::make_unique<RobotSource>(
+      5.0, 0.0, 1.0, std::make_unique<PointRobotState>(5.0, 0.0, 0.0, 0.0, 0.0)));
+  SimulationEngine engine(std::move(environment));
+
+  // Spawns are due at 0, 0.5, ..., 2.0 and at 0, 1, 2
+  for (int step = 0; step < 20; ++step) {
+    engine.Step(0.1);
+  }
+  EXPECT_EQ(engine.GetFailedSpawnCount(), 5u);
+  EXPECT_EQ(engine.GetRobotCount(), 3u);
+}
+
+// Test that a state saved to a file resumes bit-identically
+TEST(SimulationEngineTest, SavesAndLoadsStateFile) {
+  auto environment = std::make_unique<Environment>();
+  environment->AddElement(std::make_unique<MergePoint>(3.0, 0.0, 1.0));
+  environment->AddElement(std::make_unique<DynamicObstacle>(8.0, 1.0, 0.5, -0.5, 0.0));
+  SimulationEngine engine(std::move(environment));
+  for (int i = 0; i < 8; ++i) {
+    auto robot = std::make_unique<PointRobot>(0.0, 0.5 * i - 2.0);
+    robot->SetTargetVelocity(1.0 + 0.1 * i, 0.05 * (i % 3));
+    engine.AddRobot(std::move(robot));
+  }
+  for (int step = 0; step < 20; ++step) {
+    engine.Step(0.05);
+  }
+
+  const std::string filename = ::testing::TempDir() + "simulation_engine_state.json";
+  ASSERT_TRUE(engine.SaveStateToFile(filename));
+  const double savedTime = engine.GetTime();
+  for (int step = 0; step < 20; ++step) {
+    engine.Step(0.05);
+  }
+  const uint64_t hash = engine.ComputeStateHash();
+
+  // Robots added after the save are dropped again
+  engine.AddRobot(std::make_unique<PointRobot>(50.0, 50.0));
+  ASSERT_TRUE(engine.LoadStateFromFile(filename));
+  EXPECT_EQ(engine.GetTime(), savedTime);
+  EXPECT_EQ(engine.GetRobotCount(), 8u);
+  for (int step = 0; step < 20; ++step) {
+    engine.Step(0.05);
+  }
+  EXPECT_EQ(engine.ComputeStateHash(), hash);
+
+  EXPECT_FALSE(engine.LoadStateFromFile(filename + ".missing"));
+
+  // Wrongly typed members and handles beyond 32 bits are rejected, not thrown
+  for (const char* robot : {
+           "{\"type\":\"PointRobotState\",\"state\":{\"x\":\"oops\"}}",
+           "{\"type\":\"PointRobotState\",\"state\":{},\"handle\":[4294967296,1]}",
+           "{\"type\":\"PointRobotState\",\"state\":{},\"handle\":[0,-1]}"}) {
+    std::ofstream(filename) << "{\"time\":1,\"robots\":[" << robot << "]}";
+    EXPECT_FALSE(engine.LoadStateFromFile(filename)) << robot;
+  }
+  EXPECT_EQ(engine.GetRobotCount(), 8u);
+  std::remove(filename.c_str());
+}
+
+// Test that background checkpoints capture the state at the time of the call
+TEST(SimulationEngineTest, SavesCheckpointsInBackground) {
+  SimulationEngine engine;
+  for (int i = 0; i < 16; ++i) {
+    auto robot = std::make_unique<PointRobot>(0.0, 0.5 * i);
+    robot->SetTargetVelocity(1.0, 0.1 * (i % 4));
+    engine.AddRobot(std::move(robot));
+  }
+  engine.SetMaxPendingCheckpoints(2);
+  engine.SetCheckpointsWaitWhenFull(true);
+
+  std::vector<std::string> filenames;
+  std::vector<std::future<bool>> checkpoints;
+  std::vector<uint64_t> hashes;
+  for (int i = 0; i < 4; ++i) {
+    engine.Step(0.1);
+    filenames.push_back(::testing::TempDir() + "checkpoint_" + std::to_string(i) + ".json");
+    hashes.push_back(engine.ComputeStateHash());
+    checkpoints.push_back(engine.SaveStateToFileAsync(filenames.back()));
+    EXPECT_LE(engine.GetPendingCheckpointCount(), 2u);
+  }
+  engine.WaitForCheckpoints();
+  EXPECT_EQ(engine.GetPendingCheckpointCount(), 0u);
+
+  for (size_t i = 0; i < checkpoints.size(); ++i) {
+    EXPECT_TRUE(checkpoints[i].get());
+    ASSERT_TRUE(engine.LoadStateFromFile(filenames[i]));
+    EXPECT_EQ(engine.ComputeStateHash(), hashes[i]);
+    std::remove(filenames[i].c_str());
+  }
+
+  EXPECT_FALSE(engine.SaveStateToFileAsync(::testing::TempDir() + "missing/checkpoint.json").get());
+  EXPECT_EQ(engine.GetSkippedCheckpointCount(), 0u);
+}
+
+// Test that a checkpoint submitted while the writer is busy is skipped by default
+TEST(SimulationEngineTest, SkipsCheckpointsWhenFull) {
+  SimulationEngine engine;
+  engine.AddRobot(std::make_unique<PointRobot>(0.0, 0.0));
+
+  // The writer blocks opening the FIFO until it is read from
+  const std::string filename = ::testing::TempDir() + "checkpoint_fifo.json";
+  std::remove((filename + ".tmp").c_str());
+  ASSERT_EQ(mkfifo((filename + ".tmp").c_str(), 0600), 0);
+  std::future<bool> blocked = engine.SaveStateToFileAsync(filename);
+  std::future<bool> skipped = engine.SaveStateToFileAsync(filename);
+  ASSERT_EQ(skipped.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  EXPECT_FALSE(skipped.get());
+  EXPECT_EQ(engine.GetSkippedCheckpointCount(), 1u);
+  EXPECT_EQ(engine.GetPendingCheckpointCount(), 1u);
+
+  std::ifstream fifo(filename + ".tmp");
+  const std::string written((std::istreambuf_iterator<char>(fifo)),
+                            std::istreambuf_iterator<char>());
+  EXPECT_TRUE(blocked.get());
+  EXPECT_NE(written.find("\"robots\""), std::string::npos);
+  std::remove(filename.c_str());
+}
+
 } // namespace testing
 } // namespace mobilerobotsim
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "mobilerobotsim/slot_map.h"
+
+namespace mobilerobotsim {
+namespace testing {
+
+// Test that handles keep resolving correctly under random churn
+TEST(SlotMapTest, MatchesReferenceUnderChurn) {
+  SlotMap<int> map;
+  std::map<uint32_t, std::pair<SlotHandle, int>> reference;  // by slot index
+  std::vector<SlotHandle> erased;
+
+  std::mt19937 rng(7);
+  for (int op = 0; op < 5000; ++op) {
+    if (reference.empty() || rng() % 3 != 0) {
+      const SlotHandle handle = map.Insert(op);
+      ASSERT_EQ(reference.count(handle.index), 0u);
+      reference[handle.index] = {handle, op};
+    } else {
+      auto it = reference.begin();
+      std::advance(it, rng() % reference.size());
+      ASSERT_TRUE(map.Erase(it->second.first));
+      erased.push_back(it->second.first);
+      reference.erase(it);
+    }
+  }
+
+  ASSERT_EQ(map.size(), reference.size());
+  for (const auto& entry : reference) {
+    const int* value = map.Find(entry.second.first);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, entry.second.second);
+    EXPECT_EQ(map.GetHandle(map.IndexOf(entry.second.first)), entry.second.first);
+  }
+  for (const SlotHandle& handle : erased) {
+    EXPECT_FALSE(map.Contains(handle));
+    EXPECT_FALSE(map.Erase(handle));
+  }
+  EXPECT_FALSE(map.Contains(SlotHandle()));
+
+  map.Clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.Find(reference.begin()->second.first), nullptr);
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
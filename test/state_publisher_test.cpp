@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/state_publisher.h"
+#include "test_helpers.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <thread>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+std::string SegmentName(const std::string& test) {
+  return "/mobilerobotsim_" + test + "_" + std::to_string(::getpid());
+}
+
+}  // namespace
+
+// Test that readers see the latest steps and lose those the ring wrapped over
+TEST(StatePublisherTest, RingKeepsLatestSteps) {
+  const std::string name = SegmentName("ring");
+  StatePublisher publisher;
+  ASSERT_TRUE(publisher.Open(name, 4, 2));
+  StateReader reader;
+  ASSERT_TRUE(reader.Open(name));
+  EXPECT_EQ(reader.GetSlotCount(), 4u);
+  EXPECT_EQ(reader.GetCapacity(), 2u);
+
+  StateReader::Snapshot snapshot;
+  EXPECT_FALSE(reader.ReadLatest(snapshot));
+
+  const auto engine = MakeRobotGrid(3, 1, Eigen::Vector2d::Zero(), 1.0);
+  const RobotHandle first = engine->GetRobotHandle(0);
+  engine->RegisterObserver(&publisher);
+  for (int step = 0; step < 6; ++step) {
+    engine->Step(0.5);
+  }
+  EXPECT_EQ(reader.GetPublishedCount(), 6u);
+
+  // Three robots but room for two
+  ASSERT_TRUE(reader.ReadLatest(snapshot));
+  EXPECT_EQ(snapshot.sequence, 5u);
+  EXPECT_DOUBLE_EQ(snapshot.time, 3.0);
+  EXPECT_EQ(snapshot.robotCount, 3u);
+  ASSERT_EQ(snapshot.poses.size(), 2u);
+  EXPECT_EQ(snapshot.poses[0].index, first.index);
+  EXPECT_EQ(snapshot.poses[0].generation, first.generation);
+  EXPECT_DOUBLE_EQ(snapshot.poses[0].x, 3.0);
+  EXPECT_DOUBLE_EQ(snapshot.poses[1].x, 4.0);
+
+  // Steps 0 and 1 were overwritten, step 6 is not published yet
+  EXPECT_FALSE(reader.Read(1, snapshot));
+  EXPECT_FALSE(reader.Read(6, snapshot));
+  ASSERT_TRUE(reader.Read(2, snapshot));
+  EXPECT_DOUBLE_EQ(snapshot.time, 1.5);
+
+  double sum = 0.0;
+  EXPECT_TRUE(reader.Visit(3, [&](const PublishedPose* poses, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      sum += poses[i].x;
+    }
+  }));
+  EXPECT_DOUBLE_EQ(sum, 2.0 + 3.0);
+
+  // Closing removes the name; the mapping stays readable
+  engine->UnregisterObserver(&publisher);
+  publisher.Close();
+  StateReader late;
+  EXPECT_FALSE(late.Open(name));
+  EXPECT_TRUE(reader.Read(5, snapshot));
+}
+
+// Test that a reader polling a running publisher never sees a torn step
+TEST(StatePublisherTest, ConcurrentReadsAreConsistent) {
+  const std::string name = SegmentName("concurrent");
+  StatePublisher publisher;
+  ASSERT_TRUE(publisher.Open(name, 2, 64));
+  StateReader reader;
+  ASSERT_TRUE(reader.Open(name));
+
+  const auto engine = MakeRobotGrid(64, 1, Eigen::Vector2d::Zero(), 1.0);
+  engine->RegisterObserver(&publisher);
+
+  std::atomic<bool> done{false};
+  size_t reads = 0;
+  size_t torn = 0;
+  std::thread consumer([&] {
+    StateReader::Snapshot snapshot;
+    while (!done.load()) {
+      if (!reader.ReadLatest(snapshot)) {
+        continue;
+      }
+      ++reads;
+      // Every robot of one step has moved by the same time
+      for (size_t i = 0; i < snapshot.poses.size(); ++i) {
+        if (std::abs(snapshot.poses[i].x - static_cast<double>(i) - snapshot.time) > 1e-9) {
+          ++torn;
+          break;
+        }
+      }
+    }
+  });
+
+  for (int step = 0; step < 20000; ++step) {
+    engine->Step(0.01);
+  }
+  done.store(true);
+  consumer.join();
+  engine->UnregisterObserver(&publisher);
+
+  EXPECT_GT(reads, 0u);
+  EXPECT_EQ(torn, 0u);
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
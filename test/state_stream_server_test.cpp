@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/state_stream_server.h"
+#include "test_helpers.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+std::string SocketPath(const std::string& test) {
+  return ::testing::TempDir() + "mobilerobotsim_" + test + "_" + std::to_string(::getpid()) +
+         ".sock";
+}
+
+// Connects a blocking client that gives up reading after five seconds
+int Connect(const std::string& path) {
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  timeval timeout{5, 0};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return fd;
+}
+
+bool Subscribe(int fd, uint32_t decimation, const Eigen::AlignedBox2d& region) {
+  StreamSubscription subscription;
+  subscription.decimation = decimation;
+  if (!region.isEmpty()) {
+    subscription.minX = region.min().x();
+    subscription.minY = region.min().y();
+    subscription.maxX = region.max().x();
+    subscription.maxY = region.max().y();
+  }
+  return ::send(fd, &subscription, sizeof(subscription), 0) == sizeof(subscription);
+}
+
+bool ReadExactly(int fd, void* data, size_t size) {
+  auto* bytes = static_cast<uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t received = ::recv(fd, bytes, size, 0);
+    if (received <= 0) {
+      return false;
+    }
+    bytes += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+bool ReadFrame(int fd, StreamFrameHeader& header, std::vector<PublishedPose>& poses) {
+  if (!ReadExactly(fd, &header, sizeof(header)) || header.magic != StreamFrameHeader::kMagic) {
+    return false;
+  }
+  poses.resize(header.robotCount);
+  return ReadExactly(fd, poses.data(), poses.size() * sizeof(PublishedPose));
+}
+
+// Counts the steps the engine hands to the server
+class CountingServer : public StateStreamServer {
+ public:
+  void OnStep(const SystemState& state) override {
+    ++steps;
+    StateStreamServer::OnStep(state);
+  }
+
+  int steps = 0;
+};
+
+// Polls a condition for up to five seconds
+bool WaitFor(const std::function<bool()>& condition) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace
+
+// Test that each client gets frames at its own rate and for its own region
+TEST(StateStreamServerTest, DecimatesAndFiltersPerClient) {
+  const std::string path = SocketPath("filter");
+  StateStreamServer server;
+  ASSERT_TRUE(server.Open(path));
+
+  const int everything = Connect(path);
+  const int window = Connect(path);
+  ASSERT_GE(everything, 0);
+  ASSERT_GE(window, 0);
+  ASSERT_TRUE(Subscribe(everything, 1, Eigen::AlignedBox2d()));
+  ASSERT_TRUE(Subscribe(window, 2, Eigen::AlignedBox2d(Eigen::Vector2d(2.5, -1.0),
+                                                       Eigen::Vector2d(5.5, 1.0))));
+  ASSERT_TRUE(WaitFor([&] { return server.GetSubscriberCount() == 2; }));
+
+  const auto engine = MakeRobotGrid(10, 1);
+  engine->RegisterObserver(&server);
+  StreamFrameHeader header{};
+  std::vector<PublishedPose> poses;
+  for (uint64_t step = 0; step < 6; ++step) {
+    engine->Step(0.1);
+    ASSERT_TRUE(ReadFrame(everything, header, poses));
+    EXPECT_EQ(header.sequence, step);
+    EXPECT_NEAR(header.time, 0.1 * (step + 1), 1e-12);
+    EXPECT_EQ(header.robotCount, 10u);
+  }
+
+  for (uint64_t step = 0; step < 6; step += 2) {
+    ASSERT_TRUE(ReadFrame(window, header, poses));
+    EXPECT_EQ(header.sequence, step);
+    ASSERT_EQ(poses.size(), 3u);
+    EXPECT_DOUBLE_EQ(poses[0].x, 3.0);
+    EXPECT_DOUBLE_EQ(poses[2].x, 5.0);
+  }
+  EXPECT_EQ(server.GetFramesSent(), 9u);
+  EXPECT_EQ(server.GetFramesDropped(), 0u);
+
+  engine->UnregisterObserver(&server);
+  server.Close();
+  EXPECT_FALSE(ReadFrame(everything, header, poses));
+  ::close(everything);
+  ::close(window);
+  EXPECT_LT(Connect(path), 0);
+}
+
+// Test that steps no client wants are never captured but still numbered
+TEST(StateStreamServerTest, CapturesOnlyDueSteps) {
+  const std::string path = SocketPath("due");
+  CountingServer server;
+  ASSERT_TRUE(server.Open(path));
+
+  const auto engine = MakeRobotGrid(10, 1);
+  engine->RegisterObserver(&server);
+  for (int step = 0; step < 3; ++step) {
+    engine->Step(0.1);
+  }
+  EXPECT_EQ(server.steps, 0);
+
+  const int client = Connect(path);
+  ASSERT_TRUE(Subscribe(client, 3, Eigen::AlignedBox2d()));
+  ASSERT_TRUE(WaitFor([&] { return server.GetSubscriberCount() == 1; }));
+
+  StreamFrameHeader header{};
+  std::vector<PublishedPose> poses;
+  for (uint64_t step = 3; step < 10; ++step) {
+    engine->Step(0.1);
+    if (step % 3 == 0) {
+      ASSERT_TRUE(ReadFrame(client, header, poses));
+      EXPECT_EQ(header.sequence, step);
+    }
+  }
+  EXPECT_EQ(server.steps, 3);
+
+  engine->UnregisterObserver(&server);
+  server.Close();
+  ::close(client);
+}
+
+// Test that a client that stops reading loses frames without holding up others
+TEST(StateStreamServerTest, SlowClientDropsFrames) {
+  const std::string path = SocketPath("slow");
+  StateStreamServer server;
+  ASSERT_TRUE(server.Open(path));
+
+  const int slow = Connect(path);
+  const int fast = Connect(path);
+  ASSERT_TRUE(Subscribe(slow, 1, Eigen::AlignedBox2d()));
+  ASSERT_TRUE(Subscribe(fast, 1, Eigen::AlignedBox2d()));
+  ASSERT_TRUE(WaitFor([&] { return server.GetSubscriberCount() == 2; }));
+
+  // Frames of 64 kB fill the slow client's socket after a few steps
+  const auto engine = MakeRobotGrid(2000, 1);
+  engine->RegisterObserver(&server);
+  StreamFrameHeader header{};
+  std::vector<PublishedPose> poses;
+  for (uint64_t step = 0; step < 100; ++step) {
+    engine->Step(0.1);
+    ASSERT_TRUE(ReadFrame(fast, header, poses));
+    EXPECT_EQ(header.sequence, step);
+    ASSERT_TRUE(WaitFor(
+        [&] { return server.GetFramesSent() + server.GetFramesDropped() == 2 * (step + 1); }));
+  }
+  EXPECT_GT(server.GetFramesDropped(), 50u);
+  EXPECT_EQ(server.GetSubscriberCount(), 2u);
+
+  // The slow client still reads whole frames once it catches up
+  ASSERT_TRUE(ReadFrame(slow, header, poses));
+  EXPECT_EQ(header.sequence, 0u);
+  EXPECT_EQ(poses.size(), 2000u);
+
+  engine->UnregisterObserver(&server);
+  server.Close();
+  ::close(slow);
+  ::close(fast);
+}
+
+// Test that Open() replaces a stale socket but never another file
+TEST(StateStreamServerTest, ReplacesOnlyStaleSockets) {
+  const std::string path = SocketPath("stale");
+  std::ofstream(path) << "keep";
+  StateStreamServer server;
+  EXPECT_FALSE(server.Open(path));
+  std::ifstream kept(path);
+  std::string contents;
+  kept >> contents;
+  EXPECT_EQ(contents, "keep");
+  ::unlink(path.c_str());
+
+  // A socket left behind by a server that did not close
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  const int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(::bind(stale, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+  ::close(stale);
+  ASSERT_TRUE(server.Open(path));
+  const int client = Connect(path);
+  EXPECT_GE(client, 0);
+  ::close(client);
+  server.Close();
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
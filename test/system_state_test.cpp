@@ -2,6 +2,10 @@
 #include "mobilerobotsim/system_state.h"
 #include "mobilerobotsim/robot_state.h"
 #include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/merge_point.h"
+#include "mobilerobotsim/point_robot.h"
+
+#include <sstream>
 
 namespace mobilerobotsim {
 namespace testing {
@@ -17,7 +21,7 @@ class TestRobotState : public RobotState {
     return std::make_unique<TestRobotState>(id_);
   }
   std::string Serialize() const override { return "{}"; }
-  bool Deserialize(const std::string& serialized) override { return true; }
+  bool Deserialize(const std::string& /*serialized*/) override { return true; }
   
   int GetId() const { return id_; }
   
@@ -97,5 +101,67 @@ TEST(SystemStateTest, CopyAndMove) {
   // state3 should now be in a valid but unspecified state after move
 }
 
+// Test that a state written as JSON reads back unchanged
+TEST(SystemStateTest, JsonRoundTrip) {
+  SystemState state(12.5);
+  state.AddRobotState(std::make_unique<PointRobotState>(1.0 / 3.0, -2.0, 0.5, 1e-12, 3.0),
+                      SlotHandle{4, 7});
+  state.AddRobotState(std::make_unique<PointRobotStateF>(0.1f, 0.2f, 0.3f, 0.4f, 0.5f));
+  auto environmentState = std::make_unique<EnvironmentState>();
+  environmentState->AddElementState("MergePoint", MergePoint(5.0, 0.0, 1.5).GetState());
+  environmentState->AddElementState("Custom", "not \"json\"");
+  environmentState->AddElementState("Literal", "\"open\"");
+  environmentState->AddElementState("Number", "1.50");
+  state.SetEnvironmentState(std::move(environmentState));
+
+  std::stringstream stream;
+  ASSERT_TRUE(state.Write(stream));
+  SystemState loaded;
+  ASSERT_TRUE(loaded.Read(stream));
+
+  EXPECT_EQ(loaded.GetTime(), 12.5);
+  ASSERT_EQ(loaded.GetRobotStateCount(), 2u);
+  const auto* first = dynamic_cast<const PointRobotState*>(loaded.GetRobotState(0));
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(first->x, 1.0 / 3.0);
+  EXPECT_EQ(first->y, -2.0);
+  EXPECT_EQ(first->vx, 1e-12);
+  EXPECT_EQ(loaded.GetRobotHandle(0), (SlotHandle{4, 7}));
+  const auto* second = dynamic_cast<const PointRobotStateF*>(loaded.GetRobotState(1));
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(second->x, 0.1f);
+  EXPECT_EQ(second->vy, 0.5f);
+  EXPECT_FALSE(loaded.GetRobotHandle(1).IsValid());
+
+  ASSERT_NE(loaded.GetEnvironmentState(), nullptr);
+  ASSERT_EQ(loaded.GetEnvironmentState()->GetElementStateCount(), 4u);
+  std::string typeId;
+  std::string elementState;
+  loaded.GetEnvironmentState()->GetElementState(0, typeId, elementState);
+  EXPECT_EQ(typeId, "MergePoint");
+  EXPECT_EQ(elementState, MergePoint(5.0, 0.0, 1.5).GetState());
+  loaded.GetEnvironmentState()->GetElementState(1, typeId, elementState);
+  EXPECT_EQ(elementState, "not \"json\"");
+
+  // States that are JSON scalars keep their exact text
+  loaded.GetEnvironmentState()->GetElementState(2, typeId, elementState);
+  EXPECT_EQ(elementState, "\"open\"");
+  loaded.GetEnvironmentState()->GetElementState(3, typeId, elementState);
+  EXPECT_EQ(elementState, "1.50");
+
+  // Unknown robot types and truncated documents are rejected
+  SystemState unknown;
+  unknown.AddRobotState(std::make_unique<TestRobotState>(1));
+  EXPECT_FALSE(loaded.Deserialize(unknown.Serialize()));
+  EXPECT_EQ(loaded.GetRobotStateCount(), 0u);
+  const std::string serialized = state.Serialize();
+  EXPECT_FALSE(loaded.Deserialize(serialized.substr(0, serialized.size() / 2)));
+
+  SystemState::RegisterRobotStateType("TestRobotState",
+                                      [] { return std::make_unique<TestRobotState>(0); });
+  EXPECT_TRUE(loaded.Deserialize(unknown.Serialize()));
+  EXPECT_EQ(loaded.GetRobotStateCount(), 1u);
+}
+
 } // namespace testing
 } // namespace mobilerobotsim
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include <Eigen/Dense>
+
+#include "mobilerobotsim/environment.h"
+#include "mobilerobotsim/point_robot.h"
+#include "mobilerobotsim/simulation_engine.h"
+
+namespace mobilerobotsim {
+namespace testing {
+
+/**
+ * @brief Builds an engine with a point robot on every point of a 1 m lattice.
+ *
+ * Robots are added row by row, so robot i of a single row stands at
+ * origin + (i, 0).
+ *
+ * @param columns Robots per row
+ * @param rows Number of rows
+ * @param origin Position of the first robot
+ * @param vx Initial velocity along x of every robot
+ * @param environment The engine's environment
+ * @return The engine
+ */
+inline std::unique_ptr<SimulationEngine> MakeRobotGrid(
+    int columns, int rows, const Eigen::Vector2d& origin = Eigen::Vector2d::Zero(),
+    double vx = 0.0, std::unique_ptr<Environment> environment = std::make_unique<Environment>()) {
+  auto engine = std::make_unique<SimulationEngine>(std::move(environment));
+  for (int y = 0; y < rows; ++y) {
+    for (int x = 0; x < columns; ++x) {
+      engine->AddRobot(
+          std::make_unique<PointRobot>(origin.x() + x, origin.y() + y, 0.0, vx, 0.0));
+    }
+  }
+  return engine;
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "mobilerobotsim/vector_engine.h"
+#include "test_helpers.h"
+
+#include <vector>
+
+namespace mobilerobotsim {
+namespace testing {
+
+namespace {
+
+// Builds an engine with two resting agents in row y = environment
+std::unique_ptr<SimulationEngine> MakeRow(size_t environment, uint64_t /*seed*/) {
+  return MakeRobotGrid(2, 1, Eigen::Vector2d(0.0, static_cast<double>(environment)));
+}
+
+// Builds an engine with one agent at a position drawn from the episode seed
+std::unique_ptr<SimulationEngine> MakeSeeded(size_t /*environment*/, uint64_t seed) {
+  auto engine = std::make_unique<SimulationEngine>(std::make_unique<Environment>());
+  CounterRng rng(seed);
+  engine->AddRobot(std::make_unique<PointRobot>(rng.NextUniform(), rng.NextUniform(), 0.0,
+                                                0.0, 0.0));
+  return engine;
+}
+
+}  // namespace
+
+// Test that actions drive the agents and finished episodes restart in place
+TEST(VectorEngineTest, StepsAndAutoResets) {
+  VectorEngine vector(8, 3, MakeRow, 4);
+  std::vector<double> actions(8 * 3 * VectorEngine::kActionSize, 0.0);
+  EXPECT_FALSE(vector.Step(actions.data(), actions.size(), 0.1));
+  ASSERT_TRUE(vector.Reset(1));
+  EXPECT_EQ(vector.GetEpisodeCount(), 8u);
+
+  // The third agent does not exist and observes zeros
+  const std::vector<double>& observations = vector.GetObservations();
+  ASSERT_EQ(observations.size(), 8 * 3 * VectorEngine::kObservationSize);
+  EXPECT_DOUBLE_EQ(observations[(5 * 3 + 1) * 4 + 0], 1.0);
+  EXPECT_DOUBLE_EQ(observations[(5 * 3 + 1) * 4 + 1], 5.0);
+  EXPECT_DOUBLE_EQ(observations[(5 * 3 + 2) * 4 + 0], 0.0);
+
+  // Episodes end after three steps, or as soon as the first agent passes x = 0.015
+  vector.SetMaxEpisodeSteps(3);
+  vector.SetRewardFunction(
+      [](const SimulationEngine& engine, const VectorStepEvents& events, bool& terminal) {
+        EXPECT_EQ(events.collisions, 0u);
+        const double x = engine.GetRobot(engine.GetRobotHandle(0))->GetPosition().x();
+        terminal = x > 0.015;
+        return x;
+      });
+  for (size_t e = 0; e < 8; ++e) {
+    actions[e * 3 * 2] = e == 0 ? 10.0 : 0.04;
+  }
+  EXPECT_FALSE(vector.Step(actions.data(), actions.size() - 1, 0.1));
+  for (int step = 0; step < 2; ++step) {
+    ASSERT_TRUE(vector.Step(actions.data(), actions.size(), 0.1));
+  }
+  EXPECT_EQ(vector.GetDones()[0], 1);
+  EXPECT_EQ(vector.GetDones()[1], 0);
+  EXPECT_GT(vector.GetRewards()[0], vector.GetRewards()[1]);
+  EXPECT_GT(vector.GetRewards()[1], 0.0);
+  EXPECT_GT(vector.GetFinalObservations()[0], 0.015);
+  EXPECT_DOUBLE_EQ(observations[0], 0.0);  // Already the next episode
+  EXPECT_GT(observations[3 * 4 + 2], 0.0);
+  EXPECT_DOUBLE_EQ(observations[3 * 4 + 3], 0.0);
+
+  ASSERT_TRUE(vector.Step(actions.data(), actions.size(), 0.1));
+  for (size_t e = 1; e < 8; ++e) {
+    EXPECT_EQ(vector.GetDones()[e], 1);
+    EXPECT_DOUBLE_EQ(observations[e * 3 * 4], 0.0);
+  }
+  EXPECT_EQ(vector.GetDones()[0], 0);
+  EXPECT_EQ(vector.GetEpisodeCount(), 8u + 1u + 7u);
+  EXPECT_DOUBLE_EQ(vector.GetEngine(3)->GetTime(), 0.0);
+  EXPECT_EQ(vector.GetEngine(8), nullptr);
+}
+
+// Test that episodes depend on the seed but not on the thread count
+TEST(VectorEngineTest, DeterministicAcrossThreadCounts) {
+  std::vector<std::vector<double>> results;
+  for (const size_t threads : {1, 3}) {
+    for (const uint64_t seed : {7, 7, 8}) {
+      VectorEngine vector(16, 1, MakeSeeded, threads);
+      vector.SetMaxEpisodeSteps(2);
+      ASSERT_TRUE(vector.Reset(seed));
+      const std::vector<double> actions(16 * VectorEngine::kActionSize, 0.5);
+      std::vector<double> trace;
+      for (int step = 0; step < 5; ++step) {
+        ASSERT_TRUE(vector.Step(actions.data(), actions.size(), 0.1));
+        trace.insert(trace.end(), vector.GetObservations().begin(),
+                     vector.GetObservations().end());
+      }
+      results.push_back(trace);
+    }
+  }
+  EXPECT_EQ(results[0], results[1]);
+  EXPECT_NE(results[0], results[2]);
+  EXPECT_EQ(results[0], results[3]);
+  EXPECT_EQ(results[2], results[5]);
+
+  VectorEngine failing(2, 1, [](size_t environment, uint64_t seed) {
+    return environment == 0 ? MakeSeeded(environment, seed) : nullptr;
+  });
+  EXPECT_FALSE(failing.Reset(0));
+}
+
+}  // namespace testing
+}  // namespace mobilerobotsim